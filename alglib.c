@@ -0,0 +1,473 @@
+//
+// Algorithm library: known twist sequences, found again by a hash lookup on
+// the state instead of by a search.
+//
+// A library covers a scope, a set of positions (usually the slabs of a cell
+// or two, where the last pieces of a solve are left). An algorithm may only
+// move pieces within its scope: played on the solved puzzle it leaves every
+// position outside as it was. It then solves the scope of every state whose
+// scope holds what the algorithm's inverse puts there, whatever the rest of
+// the puzzle holds, so the key of a state is the Zobrist hash (zobrist.c) of
+// just the pieces in its scope.
+//
+// Each algorithm is entered for many contexts: relabelled by every symmetry
+// that keeps the scope (symmetry.c), and after every setup twist that only
+// turns the scope (the 4D "AUF"). The keys of all of those are worked out
+// when the library is built, so a lookup is one signature and one probe of
+// an open addressing table, however many algorithms there are.
+//
+// Building is done once and offline: alg_library_image writes the
+// algorithms and the table entries out, and alg_library_attach takes them
+// back without playing a twist.
+//
+
+#ifndef ALGLIB_C
+#define ALGLIB_C
+
+#include "symmetry.c"
+#include "zobrist.c"
+#include "moves.c"
+
+#define ALG_MAX_ALGORITHMS 1024
+#define ALG_MAX_LENGTH 64
+#define ALG_MAX_SETUPS (2 * TWISTS_PER_CELL * SIDES)
+#define ALG_NO_ENTRY 0xFFFF
+#define ALG_NO_SETUP 0xFF
+// most answers: a setup twist and the algorithm
+#define ALG_MAX_ANSWER (ALG_MAX_LENGTH + 1)
+
+#define ALG_MAGIC "R4DALG1"
+#define ALG_VERSION 1
+#define ALG_ENTRY_BYTES 13
+
+typedef struct {
+    uint64_t key;           // signature of the scope the answer solves
+    uint16_t alg;           // algorithm, or ALG_NO_ENTRY when empty
+    uint16_t sym;           // symmetry it is relabelled by
+    uint8_t setup;          // cell twist made first, or ALG_NO_SETUP
+    uint8_t length;         // twists in the answer
+} alg_entry;
+
+typedef struct {
+    uint8_t in_scope[NUM_PIECES];
+    int num_syms;
+    uint16_t syms[NUM_SYMMETRIES];      // symmetries that keep the scope
+    int num_setups;
+    uint8_t setups[ALG_MAX_SETUPS];     // twists that only turn the scope
+
+    int num_algs;
+    uint8_t alg_length[ALG_MAX_ALGORITHMS];
+    uint8_t algs[ALG_MAX_ALGORITHMS][ALG_MAX_LENGTH];
+
+    alg_entry *entries;
+    uint64_t mask;                      // table size - 1, a power of two
+    uint64_t count;
+} alg_library;
+
+// the inverse of every cell twist, from the product table of moves.c
+static uint8_t alg_twist_inverse[NUM_CELL_TWISTS];
+static int alg_tables_ready;
+
+void init_alg_tables(void) {
+    if(alg_tables_ready) {
+        return;
+    }
+    init_move_tables();
+    init_symmetry_tables();
+    init_zobrist_tables();
+
+    for(int m = 0; m < NUM_CELL_TWISTS; m++) {
+        for(int t = 0; t < TWISTS_PER_CELL; t++) {
+            if(twist_product[m][t] == NO_TWIST) {
+                alg_twist_inverse[m] = (uint8_t) (m - m % TWISTS_PER_CELL + t);
+            }
+        }
+    }
+    alg_tables_ready = 1;
+}
+
+// marks the positions of a cell's slab (every piece with a sticker in it) as scope
+void alg_scope_add_cell(uint8_t *in_scope, int cell) {
+    init_cubie_tables();
+    for(int s = cell * CUBES; s < (cell + 1) * CUBES; s++) {
+        if(sticker_piece[s] != NO_PIECE) {
+            in_scope[sticker_piece[s]] = 1;
+        }
+    }
+}
+
+// whether every piece outside the scope is home and turned right
+static int alg_outside_solved(const alg_library *lib, const cubie_state *state) {
+    for(int piece = 0; piece < NUM_PIECES; piece++) {
+        if(!lib->in_scope[piece] && (state->pos[piece] != piece || state->ori[piece] != 0)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ *  Function:    alg_signature
+ *  ----------------------
+ *  The key of a state in a library: the Zobrist keys of every piece that sits
+ *      in the scope, at its position and twist. Pieces outside play no part.
+ *
+ *  Runtime Complexity: O(NUM_PIECES)
+ */
+uint64_t alg_signature(const alg_library *lib, const cubie_state *state) {
+    uint64_t hash = 0;
+
+    for(int piece = 0; piece < NUM_PIECES; piece++) {
+        if(lib->in_scope[state->pos[piece]]) {
+            hash ^= zobrist_pos[piece][state->pos[piece]] ^ zobrist_ori[piece][state->ori[piece]];
+        }
+    }
+    return hash;
+}
+
+/*
+ *  Function:    alg_library_init
+ *  ---------------------
+ *  Sets up an empty library over a scope, with its table in `memory`. The
+ *      symmetries and setup twists every algorithm will be entered under are
+ *      worked out here.
+ *
+ *  Input params:
+ *      alg_library *lib:
+ *      void *memory:               table memory, 8 byte aligned
+ *      uint64_t bytes:             its size; the table takes the largest power
+ *                                  of two of entries that fits
+ *      const uint8_t *in_scope:    nonzero for each position in the scope
+ *
+ *  Return:
+ *      0, or -1 if the memory does not hold 16 entries or the scope is empty
+ */
+int alg_library_init(alg_library *lib, void *memory, uint64_t bytes, const uint8_t *in_scope) {
+    cubie_state state;
+    uint64_t size = 16;
+    int any = 0;
+
+    init_alg_tables();
+    if(bytes < size * sizeof(alg_entry)) {
+        return -1;
+    }
+    while(size * 2 * sizeof(alg_entry) <= bytes) {
+        size *= 2;
+    }
+    for(int at = 0; at < NUM_PIECES; at++) {
+        lib->in_scope[at] = in_scope[at] != 0;
+        any |= lib->in_scope[at];
+    }
+    if(!any) {
+        return -1;
+    }
+
+    lib->num_syms = 0;
+    for(int g = 0; g < NUM_SYMMETRIES; g++) {
+        int at, m;
+        for(at = 0; at < NUM_PIECES && (!lib->in_scope[at] || lib->in_scope[sym_piece[g][at]]); at++);
+        for(m = 0; m < NUM_CELL_TWISTS && sym_twist[g][m] != NO_TWIST; m++);
+        if(at == NUM_PIECES && m == NUM_CELL_TWISTS) {
+            lib->syms[lib->num_syms++] = (uint16_t) g;
+        }
+    }
+
+    lib->num_setups = 0;
+    for(int m = 0; m < NUM_CELL_TWISTS; m++) {
+        cubie_reset(&state);
+        cubie_twist(&state, m);
+        if(alg_outside_solved(lib, &state)) {
+            lib->setups[lib->num_setups++] = (uint8_t) m;
+        }
+    }
+
+    lib->num_algs = 0;
+    lib->entries = (alg_entry *) memory;
+    lib->mask = size - 1;
+    lib->count = 0;
+    for(uint64_t i = 0; i < size; i++) {
+        lib->entries[i].alg = ALG_NO_ENTRY;
+    }
+    return 0;
+}
+
+// the entry of a key: the one holding it, or the empty one it would go in
+static alg_entry *alg_slot(const alg_library *lib, uint64_t key) {
+    uint64_t i = key & lib->mask;
+
+    while(lib->entries[i].alg != ALG_NO_ENTRY && lib->entries[i].key != key) {
+        i = (i + 1) & lib->mask;
+    }
+    return &lib->entries[i];
+}
+
+// 0 if stored (or a shorter answer was already there), -1 if the table is 3/4 full
+static int alg_insert(alg_library *lib, const alg_entry *entry) {
+    alg_entry *slot = alg_slot(lib, entry->key);
+
+    if(slot->alg != ALG_NO_ENTRY) {
+        if(entry->length < slot->length) {
+            *slot = *entry;
+        }
+        return 0;
+    }
+    if((lib->count + 1) * 4 > (lib->mask + 1) * 3) {
+        return -1;
+    }
+    *slot = *entry;
+    lib->count++;
+    return 0;
+}
+
+// writes the answer of an entry: its setup twist, then its algorithm relabelled by its symmetry
+static int alg_answer(const alg_library *lib, const alg_entry *entry, uint8_t *twists) {
+    int n = 0;
+
+    if(entry->setup != ALG_NO_SETUP) {
+        twists[n++] = entry->setup;
+    }
+    for(int i = 0; i < lib->alg_length[entry->alg]; i++) {
+        twists[n++] = lib->algs[entry->alg][i];
+    }
+    sym_map_twists(entry->sym, twists + n - lib->alg_length[entry->alg], lib->alg_length[entry->alg]);
+    return n;
+}
+
+/*
+ *  Function:    alg_library_add
+ *  --------------------
+ *  Adds an algorithm and enters it under every symmetry and setup twist of
+ *      the library: for each, the state the answer solves is the solved
+ *      puzzle with the answer undone, and its signature is the key.
+ *
+ *  Input params:
+ *      alg_library *lib:
+ *      const uint8_t *twists:      the algorithm, in cell twists
+ *      int length:                 1 - ALG_MAX_LENGTH twists
+ *
+ *  Return:
+ *      the index of the algorithm, -1 if it moves pieces outside the scope
+ *          (or does not fit), -2 if the table ran full on the way (what was
+ *          entered stays)
+ */
+int alg_library_add(alg_library *lib, const uint8_t *twists, int length) {
+    cubie_state state;
+    uint8_t answer[ALG_MAX_ANSWER];
+    uint64_t solved_key;
+    int alg = lib->num_algs;
+
+    if(length < 1 || length > ALG_MAX_LENGTH || alg >= ALG_MAX_ALGORITHMS) {
+        return -1;
+    }
+    cubie_reset(&state);
+    for(int i = 0; i < length; i++) {
+        if(twists[i] >= NUM_CELL_TWISTS) {
+            return -1;
+        }
+        cubie_twist(&state, twists[i]);
+    }
+    if(!alg_outside_solved(lib, &state)) {
+        return -1;
+    }
+    for(int i = 0; i < length; i++) {
+        lib->algs[alg][i] = twists[i];
+    }
+    lib->alg_length[alg] = (uint8_t) length;
+    lib->num_algs++;
+
+    cubie_reset(&state);
+    solved_key = alg_signature(lib, &state);
+
+    for(int k = 0; k < lib->num_syms; k++) {
+        for(int s = -1; s < lib->num_setups; s++) {
+            alg_entry entry = {0, (uint16_t) alg, lib->syms[k], s < 0 ? ALG_NO_SETUP : lib->setups[s], 0};
+            int n = alg_answer(lib, &entry, answer);
+
+            cubie_reset(&state);
+            for(int i = n - 1; i >= 0; i--) {
+                cubie_twist(&state, alg_twist_inverse[answer[i]]);
+            }
+            entry.key = alg_signature(lib, &state);
+            entry.length = (uint8_t) n;
+            if(entry.key == solved_key) {
+                continue;
+            }
+            if(alg_insert(lib, &entry) != 0) {
+                return -2;
+            }
+        }
+    }
+    return alg;
+}
+
+/*
+ *  Function:    alg_lookup
+ *  ---------------
+ *  Finds a known algorithm that solves the scope of a state.
+ *
+ *  Input params:
+ *      const alg_library *lib:
+ *      const cubie_state *state:
+ *      uint8_t *twists:            the answer, in cell twists (ALG_MAX_ANSWER)
+ *
+ *  Return:
+ *      the number of twists, or -1 if no algorithm of the library solves it
+ *
+ *  Runtime Complexity: O(NUM_PIECES), expected, at any library size
+ */
+int alg_lookup(const alg_library *lib, const cubie_state *state, uint8_t *twists) {
+    const alg_entry *entry = alg_slot(lib, alg_signature(lib, state));
+
+    if(entry->alg == ALG_NO_ENTRY) {
+        return -1;
+    }
+    return alg_answer(lib, entry, twists);
+}
+
+// the algorithm a lookup answered with, -1 if none (for naming it)
+int alg_lookup_index(const alg_library *lib, const cubie_state *state) {
+    const alg_entry *entry = alg_slot(lib, alg_signature(lib, state));
+    return entry->alg == ALG_NO_ENTRY ? -1 : entry->alg;
+}
+
+/*
+ *  Function:    alg_library_image_size
+ *  -----------------------------
+ *  Bytes alg_library_image writes: the magic and version, the scope, every
+ *      algorithm's twists, then every table entry.
+ */
+uint64_t alg_library_image_size(const alg_library *lib) {
+    uint64_t size = 8 + 4 + NUM_PIECES + 4;
+
+    for(int alg = 0; alg < lib->num_algs; alg++) {
+        size += 1 + lib->alg_length[alg];
+    }
+    return size + 8 + lib->count * ALG_ENTRY_BYTES;
+}
+
+// writes the library into `image` (alg_library_image_size() bytes)
+void alg_library_image(const alg_library *lib, uint8_t *image) {
+    uint64_t n = 0;
+
+    for(int i = 0; i < 8; i++) {
+        image[n++] = (uint8_t) ALG_MAGIC[i];
+    }
+    for(int shift = 0; shift < 32; shift += 8) {
+        image[n++] = (uint8_t) (ALG_VERSION >> shift);
+    }
+    for(int at = 0; at < NUM_PIECES; at++) {
+        image[n++] = lib->in_scope[at];
+    }
+    for(int shift = 0; shift < 32; shift += 8) {
+        image[n++] = (uint8_t) (lib->num_algs >> shift);
+    }
+    for(int alg = 0; alg < lib->num_algs; alg++) {
+        image[n++] = lib->alg_length[alg];
+        for(int i = 0; i < lib->alg_length[alg]; i++) {
+            image[n++] = lib->algs[alg][i];
+        }
+    }
+    for(int shift = 0; shift < 64; shift += 8) {
+        image[n++] = (uint8_t) (lib->count >> shift);
+    }
+    for(uint64_t i = 0; i <= lib->mask; i++) {
+        const alg_entry *entry = &lib->entries[i];
+        if(entry->alg == ALG_NO_ENTRY) {
+            continue;
+        }
+        for(int shift = 0; shift < 64; shift += 8) {
+            image[n++] = (uint8_t) (entry->key >> shift);
+        }
+        image[n++] = (uint8_t) entry->alg;
+        image[n++] = (uint8_t) (entry->alg >> 8);
+        image[n++] = (uint8_t) entry->sym;
+        image[n++] = (uint8_t) (entry->sym >> 8);
+        image[n++] = entry->setup;
+    }
+}
+
+/*
+ *  Function:    alg_library_attach
+ *  ---------------------------
+ *  Takes a library from an image made by alg_library_image instead of
+ *      building it, into a table in `memory` (see alg_library_init). The
+ *      twists and entries are checked to be in range, not played.
+ *
+ *  Return:
+ *      0 on success, -1 if the image is not a library or does not fit the
+ *          memory
+ */
+int alg_library_attach(alg_library *lib, void *memory, uint64_t bytes, const uint8_t *image, uint64_t size) {
+    uint8_t in_scope[NUM_PIECES];
+    uint64_t n = 0, count = 0;
+    int num_algs = 0;
+
+    if(size < 8 + 4 + NUM_PIECES + 4) {
+        return -1;
+    }
+    for(int i = 0; i < 8; i++) {
+        if(image[n++] != (uint8_t) ALG_MAGIC[i]) {
+            return -1;
+        }
+    }
+    if(image[n] != ALG_VERSION || image[n + 1] || image[n + 2] || image[n + 3]) {
+        return -1;
+    }
+    n += 4;
+    for(int at = 0; at < NUM_PIECES; at++) {
+        in_scope[at] = image[n++];
+    }
+    if(alg_library_init(lib, memory, bytes, in_scope) != 0) {
+        return -1;
+    }
+    for(int shift = 0; shift < 32; shift += 8) {
+        num_algs |= image[n++] << shift;
+    }
+    if(num_algs < 0 || num_algs > ALG_MAX_ALGORITHMS) {
+        return -1;
+    }
+
+    for(int alg = 0; alg < num_algs; alg++) {
+        if(n >= size || image[n] < 1 || image[n] > ALG_MAX_LENGTH || n + 1 + image[n] > size) {
+            return -1;
+        }
+        lib->alg_length[alg] = image[n++];
+        for(int i = 0; i < lib->alg_length[alg]; i++) {
+            if(image[n] >= NUM_CELL_TWISTS) {
+                return -1;
+            }
+            lib->algs[alg][i] = image[n++];
+        }
+    }
+    lib->num_algs = num_algs;
+
+    if(n + 8 > size) {
+        return -1;
+    }
+    for(int shift = 0; shift < 64; shift += 8) {
+        count |= (uint64_t) image[n++] << shift;
+    }
+    if(count > (size - n) / ALG_ENTRY_BYTES) {
+        return -1;
+    }
+    for(uint64_t k = 0; k < count; k++, n += ALG_ENTRY_BYTES) {
+        alg_entry entry = {0, 0, 0, 0, 0};
+        for(int shift = 0; shift < 64; shift += 8) {
+            entry.key |= (uint64_t) image[n + shift / 8] << shift;
+        }
+        entry.alg = (uint16_t) (image[n + 8] | image[n + 9] << 8);
+        entry.sym = (uint16_t) (image[n + 10] | image[n + 11] << 8);
+        entry.setup = image[n + 12];
+        if(entry.alg >= num_algs || entry.sym >= NUM_SYMMETRIES ||
+           (entry.setup != ALG_NO_SETUP && entry.setup >= NUM_CELL_TWISTS)) {
+            return -1;
+        }
+        entry.length = (uint8_t) (lib->alg_length[entry.alg] + (entry.setup != ALG_NO_SETUP));
+        if(alg_insert(lib, &entry) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+#endif // ALGLIB_C
@@ -0,0 +1,64 @@
+//
+// Bump allocator for per-frame scratch. A render takes everything it only
+// needs while drawing (cube copies, sort keys, planes) from the arena and
+// drops it all at once with arena_reset, so the size of a frame is bounded by
+// the arena instead of by the wasm stack.
+//
+
+#ifndef ARENA_C
+#define ARENA_C
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define ARENA_ALIGN 8
+
+typedef struct {
+    uint8_t *base;
+    size_t capacity;
+    size_t used;
+    size_t high_water;      // most bytes in use at once since arena_init
+    int failed;             // allocations refused since arena_init
+} frame_arena;
+
+void arena_init(frame_arena *arena, void *memory, size_t capacity) {
+    arena->base = (uint8_t *) memory;
+    arena->capacity = capacity;
+    arena->used = 0;
+    arena->high_water = 0;
+    arena->failed = 0;
+}
+
+void arena_reset(frame_arena *arena) {
+    arena->used = 0;
+}
+
+/*
+ *  Function:    arena_alloc
+ *  --------------------
+ *  Hands out `size` bytes, aligned to ARENA_ALIGN, that stay valid until the
+ *      next arena_reset.
+ *
+ *  Return:
+ *      the memory, or NULL if the arena is full
+ */
+void *arena_alloc(frame_arena *arena, size_t size) {
+    // the address is rounded, not the offset: the caller's memory may start anywhere
+    uintptr_t at = (uintptr_t) (arena->base + arena->used);
+    size_t start = arena->used + (size_t) ((ARENA_ALIGN - at % ARENA_ALIGN) % ARENA_ALIGN);
+
+    if(start > arena->capacity || size > arena->capacity - start) {
+        arena->failed++;
+        return NULL;
+    }
+
+    arena->used = start + size;
+    if(arena->used > arena->high_water) {
+        arena->high_water = arena->used;
+    }
+    return arena->base + start;
+}
+
+#define ARENA_NEW(arena, T, count) ((T *) arena_alloc(arena, sizeof(T) * (size_t) (count)))
+
+#endif // ARENA_C
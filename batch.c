@@ -0,0 +1,250 @@
+//
+// Bitsliced batches: BATCH_LANES puzzles at once, stored as bit planes. Each
+// sticker has COLOR_BITS planes of BATCH_WORDS words, and bit j of them is the
+// color of that sticker in puzzle j. A move is then the same permutation of
+// planes for every puzzle, and a test like "is this cube one color" is a few
+// logic ops per word.
+//
+// Stickers are kept as oriented (the view index of orient_remap, with the
+// hidden cube not mirrored), so every move id is one fixed permutation
+// whatever orientation each puzzle is in: a twist is twist_table[select], a
+// move-in the remap of the orientation it leads to from orientation 0.
+//
+
+#ifndef BATCH_C
+#define BATCH_C
+
+#include "puzzle.c"
+
+#ifndef BATCH_WORDS
+#define BATCH_WORDS 4       // words per plane; 4 fills an AVX2 register, 256 puzzles
+#endif
+#define BATCH_LANES (64 * BATCH_WORDS)
+#define COLOR_BITS 3
+#define COUNT_BITS 5        // enough to count the 27 stickers of a cube
+
+typedef struct {
+    uint64_t plane[NUM_STICKERS][COLOR_BITS][BATCH_WORDS];
+} puzzle_batch;
+
+static uint8_t batch_move_perm[NUM_MOVES][NUM_STICKERS];
+static int batch_tables_ready;
+
+void init_batch_tables(void) {
+    if(batch_tables_ready) {
+        return;
+    }
+    init_puzzle_tables();
+
+    for(int move = 0; move < NUM_MOVES; move++) {
+        const uint8_t *perm = is_move_in(move) ? orient_remap[orient_move_in[0][move - FIRST_MOVE_IN + 1]]
+                                               : twist_table[move];
+        for(int i = 0; i < NUM_STICKERS; i++) {
+            batch_move_perm[move][i] = perm[i];
+        }
+    }
+
+    batch_tables_ready = 1;
+}
+
+// sets every puzzle of a batch to solved
+void batch_reset(puzzle_batch *batch) {
+    init_batch_tables();
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        for(int b = 0; b < COLOR_BITS; b++) {
+            uint64_t fill = ((i / CUBES) >> b) & 1 ? ~(uint64_t) 0 : 0;
+            for(int w = 0; w < BATCH_WORDS; w++) {
+                batch->plane[i][b][w] = fill;
+            }
+        }
+    }
+}
+
+// puts a puzzle in lane `lane` (0 - BATCH_LANES - 1)
+void batch_set(puzzle_batch *batch, int lane, const puzzle *p) {
+    const uint8_t *remap = orient_remap[p->orientation];
+    int w = lane / 64;
+    uint64_t bit = (uint64_t) 1 << (lane % 64);
+
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        int color = p->stickers[remap[i]];
+        for(int b = 0; b < COLOR_BITS; b++) {
+            if((color >> b) & 1) {
+                batch->plane[i][b][w] |= bit;
+            }
+            else {
+                batch->plane[i][b][w] &= ~bit;
+            }
+        }
+    }
+}
+
+// the oriented sticker colors of one lane
+void batch_get(const puzzle_batch *batch, int lane, uint8_t *colors) {
+    int w = lane / 64, shift = lane % 64;
+
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        int color = 0;
+        for(int b = 0; b < COLOR_BITS; b++) {
+            color |= (int) ((batch->plane[i][b][w] >> shift) & 1) << b;
+        }
+        colors[i] = (uint8_t) color;
+    }
+}
+
+// copies lane `from_lane` of one batch into lane `to_lane` of another
+void batch_copy_lane(puzzle_batch *to, int to_lane, const puzzle_batch *from, int from_lane) {
+    int tw = to_lane / 64, fw = from_lane / 64, shift = from_lane % 64;
+    uint64_t bit = (uint64_t) 1 << (to_lane % 64);
+
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        for(int b = 0; b < COLOR_BITS; b++) {
+            uint64_t set = 0 - ((from->plane[i][b][fw] >> shift) & 1);
+            to->plane[i][b][tw] = (to->plane[i][b][tw] & ~bit) | (set & bit);
+        }
+    }
+}
+
+/*
+ *  Function:    batch_sequence_perm
+ *  ----------------------------
+ *  Folds a move sequence into one pull permutation of oriented stickers, so
+ *      a whole sequence costs a batch one pass.
+ */
+void batch_sequence_perm(const uint8_t *moves, int length, uint8_t *perm) {
+    uint8_t next[NUM_STICKERS];
+
+    init_batch_tables();
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        perm[i] = (uint8_t) i;
+    }
+    for(int n = 0; n < length; n++) {
+        const uint8_t *step = batch_move_perm[moves[n]];
+        for(int i = 0; i < NUM_STICKERS; i++) {
+            next[i] = perm[step[i]];
+        }
+        for(int i = 0; i < NUM_STICKERS; i++) {
+            perm[i] = next[i];
+        }
+    }
+}
+
+/*
+ *  Function:    batch_permute
+ *  ----------------------
+ *  Applies a pull permutation (new[i] = old[perm[i]]) to every puzzle, in
+ *      place, one cycle at a time.
+ *
+ *  Runtime Complexity: O(NUM_STICKERS * COLOR_BITS * BATCH_WORDS)
+ */
+void batch_permute(puzzle_batch *batch, const uint8_t *perm) {
+    uint8_t done[NUM_STICKERS] = {0};
+    uint64_t held[COLOR_BITS][BATCH_WORDS];
+
+    for(int start = 0; start < NUM_STICKERS; start++) {
+        if(done[start] || perm[start] == start) {
+            continue;
+        }
+
+        int i = start;
+        for(int b = 0; b < COLOR_BITS; b++) {
+            for(int w = 0; w < BATCH_WORDS; w++) {
+                held[b][w] = batch->plane[start][b][w];
+            }
+        }
+        while(perm[i] != start) {
+            for(int b = 0; b < COLOR_BITS; b++) {
+                for(int w = 0; w < BATCH_WORDS; w++) {
+                    batch->plane[i][b][w] = batch->plane[perm[i]][b][w];
+                }
+            }
+            done[i] = 1;
+            i = perm[i];
+        }
+        for(int b = 0; b < COLOR_BITS; b++) {
+            for(int w = 0; w < BATCH_WORDS; w++) {
+                batch->plane[i][b][w] = held[b][w];
+            }
+        }
+        done[i] = 1;
+    }
+}
+
+void batch_apply_move(puzzle_batch *batch, int move) {
+    init_batch_tables();
+    batch_permute(batch, batch_move_perm[move]);
+}
+
+void batch_apply_moves(puzzle_batch *batch, const uint8_t *moves, int length) {
+    uint8_t perm[NUM_STICKERS];
+
+    batch_sequence_perm(moves, length, perm);
+    batch_permute(batch, perm);
+}
+
+/*
+ *  Function:    batch_solved
+ *  ---------------------
+ *  Finds the solved puzzles: every cube shows one color (its center's).
+ *
+ *  Input params:
+ *      const puzzle_batch *batch:
+ *      uint64_t *solved:           BATCH_WORDS words, bit j set when puzzle j
+ *                                  is solved
+ */
+void batch_solved(const puzzle_batch *batch, uint64_t *solved) {
+    for(int w = 0; w < BATCH_WORDS; w++) {
+        uint64_t wrong = 0;
+        for(int i = 0; i < NUM_STICKERS; i++) {
+            int center = i - i % CUBES + CUBES / 2;
+            for(int b = 0; b < COLOR_BITS; b++) {
+                wrong |= batch->plane[i][b][w] ^ batch->plane[center][b][w];
+            }
+        }
+        solved[w] = ~wrong;
+    }
+}
+
+/*
+ *  Function:    batch_cube_correct
+ *  ---------------------------
+ *  Counts, for every puzzle and cube, the stickers that show the cube's
+ *      center color (27 when the cube is done). The counts are kept bitsliced
+ *      too, a ripple carry adder over COUNT_BITS planes, and only unpacked at
+ *      the end.
+ *
+ *  Input params:
+ *      const puzzle_batch *batch:
+ *      uint8_t *counts:            BATCH_LANES * SIDES counts, lane major
+ */
+void batch_cube_correct(const puzzle_batch *batch, uint8_t *counts) {
+    for(int cube = 0; cube < SIDES; cube++) {
+        const int center = cube * CUBES + CUBES / 2;
+
+        for(int w = 0; w < BATCH_WORDS; w++) {
+            uint64_t count[COUNT_BITS] = {0};
+
+            for(int i = cube * CUBES; i < (cube + 1) * CUBES; i++) {
+                uint64_t carry = ~(uint64_t) 0;
+                for(int b = 0; b < COLOR_BITS; b++) {
+                    carry &= ~(batch->plane[i][b][w] ^ batch->plane[center][b][w]);
+                }
+                for(int k = 0; k < COUNT_BITS && carry; k++) {
+                    uint64_t sum = count[k] ^ carry;
+                    carry &= count[k];
+                    count[k] = sum;
+                }
+            }
+
+            for(int bit = 0; bit < 64; bit++) {
+                int value = 0;
+                for(int k = 0; k < COUNT_BITS; k++) {
+                    value |= (int) ((count[k] >> bit) & 1) << k;
+                }
+                counts[(w * 64 + bit) * SIDES + cube] = (uint8_t) value;
+            }
+        }
+    }
+}
+
+#endif // BATCH_C
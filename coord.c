@@ -0,0 +1,286 @@
+//
+// Coordinates over the cubie model: small integers that stand for part of
+// the puzzle state, with move tables so a search can apply a cell twist with
+// one lookup per tracked piece instead of permuting the whole state.
+//
+//      piece coordinate:   position and twist of one piece,
+//                          (position - first of its class) * twists + twist
+//      subset coordinate:  piece coordinates of a chosen set of pieces of one
+//                          class, ranked into a single dense integer (the
+//                          index pattern databases and tables are built on)
+//
+
+#ifndef COORD_C
+#define COORD_C
+
+#include "cubie.c"
+
+#define CORNER_CLASS 0
+#define EDGE_CLASS 1
+#define FACE_CLASS 2
+#define NUM_PIECE_CLASSES 3
+
+#define MAX_SUBSET_PIECES NUM_EDGE_PIECES
+
+typedef struct {
+    int piece_class;
+    int count;                              // number of tracked pieces
+    int track_twist;                        // 0 if only positions are tracked
+    uint8_t pieces[MAX_SUBSET_PIECES];      // tracked pieces, global piece ids
+} coord_subset;
+
+static const int class_first[NUM_PIECE_CLASSES] = {FIRST_CORNER, FIRST_EDGE, FIRST_FACE};
+static const int class_pieces[NUM_PIECE_CLASSES] = {NUM_CORNER_PIECES, NUM_EDGE_PIECES, NUM_FACE_PIECES};
+static const int class_stickers[NUM_PIECE_CLASSES] = {4, 3, 2};
+// twists a piece can show at one position. A corner's sticker permutation
+// always has the parity its position dictates, so only half of 4! are ranked.
+static const int class_twists[NUM_PIECE_CLASSES] = {12, 6, 2};
+
+static uint16_t corner_coord_move[NUM_CELL_TWISTS][NUM_CORNER_PIECES * 24];
+static uint16_t edge_coord_move[NUM_CELL_TWISTS][NUM_EDGE_PIECES * 6];
+static uint16_t face_coord_move[NUM_CELL_TWISTS][NUM_FACE_PIECES * 2];
+static uint8_t corner_twist_parity[NUM_CORNER_PIECES][NUM_CORNER_PIECES];
+static uint8_t s4_parity[MAX_PIECE_TWISTS];
+static int coord_tables_ready;
+
+int piece_class_of(int piece) {
+    if(piece < FIRST_EDGE) return CORNER_CLASS;
+    if(piece < FIRST_FACE) return EDGE_CLASS;
+    return FACE_CLASS;
+}
+
+// number of twist ranks a piece coordinate carries (the full k!)
+int coord_twists(int piece_class) {
+    return twist_count[class_stickers[piece_class]];
+}
+
+int num_piece_coords(int piece_class) {
+    return class_pieces[piece_class] * coord_twists(piece_class);
+}
+
+const uint16_t *coord_move_table(int piece_class, int move) {
+    switch(piece_class) {
+        case CORNER_CLASS:
+            return corner_coord_move[move];
+        case EDGE_CLASS:
+            return edge_coord_move[move];
+        default:
+            return face_coord_move[move];
+    }
+}
+
+void init_coord_tables(void) {
+    int c, m, piece_class;
+
+    if(coord_tables_ready) {
+        return;
+    }
+    init_cubie_tables();
+
+    for(piece_class = 0; piece_class < NUM_PIECE_CLASSES; piece_class++) {
+        int twists = coord_twists(piece_class);
+        int size = class_stickers[piece_class];
+        int first = class_first[piece_class];
+
+        for(m = 0; m < NUM_CELL_TWISTS; m++) {
+            uint16_t *table = (uint16_t *) coord_move_table(piece_class, m);
+
+            for(c = 0; c < num_piece_coords(piece_class); c++) {
+                int at = first + c / twists;
+                int to = piece_move_pos[m][at] - first;
+                int twist = twist_compose[size][c % twists][piece_move_twist[m][at]];
+                table[c] = (uint16_t) (to * twists + twist);
+            }
+        }
+    }
+
+    for(int r = 0; r < twist_count[4]; r++) {
+        int inversions = 0;
+        for(int i = 0; i < 4; i++) {
+            for(int j = i + 1; j < 4; j++) {
+                if(twist_perm[4][r][i] > twist_perm[4][r][j]) inversions++;
+            }
+        }
+        s4_parity[r] = inversions & 1;
+    }
+
+    // a corner's twist is odd exactly when its position's coordinates
+    // multiply to a different sign than its home's
+    for(int piece = 0; piece < NUM_CORNER_PIECES; piece++) {
+        for(int at = 0; at < NUM_CORNER_PIECES; at++) {
+            int home_sign = 1, at_sign = 1;
+            for(int a = 0; a < NUM_AXES; a++) {
+                home_sign *= piece_home[FIRST_CORNER + piece][a];
+                at_sign *= piece_home[FIRST_CORNER + at][a];
+            }
+            corner_twist_parity[piece][at] = home_sign != at_sign;
+        }
+    }
+
+    coord_tables_ready = 1;
+}
+
+int piece_coord(const cubie_state *state, int piece) {
+    int piece_class = piece_class_of(piece);
+    return (state->pos[piece] - class_first[piece_class]) * coord_twists(piece_class) + state->ori[piece];
+}
+
+/*
+ *  Function:    rank_partial_perm
+ *  --------------------------
+ *  Ranks k distinct values from 0 - n-1 (in order) into 0 - n!/(n-k)! - 1.
+ *
+ *  Runtime Complexity: O(k^2)
+ */
+uint64_t rank_partial_perm(const uint8_t *values, int k, int n) {
+    uint64_t rank = 0;
+    for(int i = 0; i < k; i++) {
+        int digit = values[i];
+        for(int j = 0; j < i; j++) {
+            if(values[j] < values[i]) digit--;
+        }
+        rank = rank * (uint64_t) (n - i) + (uint64_t) digit;
+    }
+    return rank;
+}
+
+void unrank_partial_perm(uint64_t rank, uint8_t *values, int k, int n) {
+    uint32_t used = 0;
+    int i;
+
+    // digits come out last first
+    for(i = k - 1; i >= 0; i--) {
+        values[i] = (uint8_t) (rank % (uint64_t) (n - i));
+        rank /= (uint64_t) (n - i);
+    }
+    for(i = 0; i < k; i++) {
+        int digit = values[i];
+        int v = 0;
+        for(;; v++) {
+            if(used & (1u << v)) continue;
+            if(digit-- == 0) break;
+        }
+        values[i] = (uint8_t) v;
+        used |= 1u << v;
+    }
+}
+
+/*
+ *  Function:    subset_size
+ *  --------------------
+ *  Number of values a subset coordinate can take, or 0 if it does not fit
+ *      in 64 bits.
+ */
+uint64_t subset_size(const coord_subset *subset) {
+    uint64_t size = 1;
+    int n = class_pieces[subset->piece_class];
+
+    for(int i = 0; i < subset->count; i++) {
+        uint64_t factor = (uint64_t) (n - i);
+        if(subset->track_twist) {
+            factor *= (uint64_t) class_twists[subset->piece_class];
+        }
+        if(size > UINT64_MAX / factor) {
+            return 0;
+        }
+        size *= factor;
+    }
+    return size;
+}
+
+void subset_coords(const coord_subset *subset, const cubie_state *state, uint16_t *coords) {
+    for(int i = 0; i < subset->count; i++) {
+        coords[i] = (uint16_t) piece_coord(state, subset->pieces[i]);
+    }
+}
+
+/*
+ *  Function:    subset_move
+ *  --------------------
+ *  Applies cell twist `move` to the piece coordinates of a subset.
+ *
+ *  Runtime Complexity: O(count), one table lookup per piece
+ */
+void subset_move(const coord_subset *subset, uint16_t *coords, int move) {
+    const uint16_t *table = coord_move_table(subset->piece_class, move);
+    for(int i = 0; i < subset->count; i++) {
+        coords[i] = table[coords[i]];
+    }
+}
+
+// twist as ranked in a subset coordinate (corners drop the parity bit)
+int rank_piece_twist(int piece_class, int twist) {
+    return piece_class == CORNER_CLASS ? twist >> 1 : twist;
+}
+
+int unrank_piece_twist(int piece_class, int piece, int at, int ranked) {
+    if(piece_class != CORNER_CLASS) {
+        return ranked;
+    }
+    int twist = ranked << 1;
+    if(s4_parity[twist] != corner_twist_parity[piece - FIRST_CORNER][at]) {
+        twist |= 1;
+    }
+    return twist;
+}
+
+/*
+ *  Function:    subset_rank
+ *  --------------------
+ *  Ranks the piece coordinates of a subset: the positions as a partial
+ *      permutation, followed by the twists (if tracked) as base
+ *      class_twists digits.
+ */
+uint64_t subset_rank(const coord_subset *subset, const uint16_t *coords) {
+    uint8_t at[MAX_SUBSET_PIECES];
+    int piece_class = subset->piece_class;
+    int twists = coord_twists(piece_class);
+
+    for(int i = 0; i < subset->count; i++) {
+        at[i] = (uint8_t) (coords[i] / twists);
+    }
+    uint64_t rank = rank_partial_perm(at, subset->count, class_pieces[piece_class]);
+
+    if(subset->track_twist) {
+        for(int i = 0; i < subset->count; i++) {
+            rank = rank * (uint64_t) class_twists[piece_class] + (uint64_t) rank_piece_twist(piece_class, coords[i] % twists);
+        }
+    }
+    return rank;
+}
+
+// pieces left untracked by a position only subset come back untwisted (or with
+// the smallest twist their position allows)
+void subset_unrank(const coord_subset *subset, uint64_t rank, uint16_t *coords) {
+    uint8_t at[MAX_SUBSET_PIECES];
+    int ranked[MAX_SUBSET_PIECES];
+    int piece_class = subset->piece_class;
+    int twists = coord_twists(piece_class);
+    int i;
+
+    for(i = subset->count - 1; i >= 0; i--) {
+        ranked[i] = 0;
+        if(subset->track_twist) {
+            ranked[i] = (int) (rank % (uint64_t) class_twists[piece_class]);
+            rank /= (uint64_t) class_twists[piece_class];
+        }
+    }
+    unrank_partial_perm(rank, at, subset->count, class_pieces[piece_class]);
+
+    for(i = 0; i < subset->count; i++) {
+        int twist = unrank_piece_twist(piece_class, subset->pieces[i], at[i], ranked[i]);
+        coords[i] = (uint16_t) (at[i] * twists + twist);
+    }
+}
+
+// fills a subset with the first `count` pieces of a class
+void subset_of_class(coord_subset *subset, int piece_class, int count, int track_twist) {
+    subset->piece_class = piece_class;
+    subset->count = count;
+    subset->track_twist = track_twist;
+    for(int i = 0; i < count; i++) {
+        subset->pieces[i] = (uint8_t) (class_first[piece_class] + i);
+    }
+}
+
+#endif // COORD_C
@@ -0,0 +1,532 @@
+//
+// Piece level (cubie) model of the puzzle: where each piece is and how it is
+// twisted, instead of the color of every sticker.
+//
+// Everything here lives in the physical frame of puzzle.c. A sticker belongs
+// to the piece at a point of {-1, 0, 1}^4 and faces one of the 8 cells:
+//      corners:    4 stickers, 16 pieces
+//      edges:      3 stickers, 32 pieces
+//      faces:      2 stickers, 24 pieces
+//      centers:    1 sticker, never moved by a twist. Where they are seen is
+//                  the puzzle orientation, so that is what the state keeps.
+//
+
+#ifndef CUBIE_C
+#define CUBIE_C
+
+#include "puzzle.c"
+
+#define W_AXIS 3
+#define NUM_AXES 4
+
+#define NUM_CORNER_PIECES 16
+#define NUM_EDGE_PIECES 32
+#define NUM_FACE_PIECES 24
+#define NUM_CENTER_PIECES 8
+
+#define FIRST_CORNER 0
+#define FIRST_EDGE (FIRST_CORNER + NUM_CORNER_PIECES)
+#define FIRST_FACE (FIRST_EDGE + NUM_EDGE_PIECES)
+#define NUM_PIECES (FIRST_FACE + NUM_FACE_PIECES)
+#define NO_PIECE 0xFF
+
+#define MAX_PIECE_STICKERS 4
+// a piece's twist is the rank of the permutation of its stickers, so up to 4!
+#define MAX_PIECE_TWISTS 24
+
+// distinct twists of one cell: 3 of the 6 center selects in each direction,
+// the 6 edge selects that are not repeats (s and 26 - s turn the same way),
+// and all 8 corner selects
+#define TWISTS_PER_CELL 20
+#define NUM_CELL_TWISTS (SIDES * TWISTS_PER_CELL)
+#define NO_TWIST 0xFF
+// a cell twist takes at most 2 move-ins (to the opposite cell) and the twist
+#define MAX_CELL_TWIST_MOVES 3
+
+typedef struct {
+    uint8_t pos[NUM_PIECES];    // position each piece is at (positions are numbered like pieces)
+    uint8_t ori[NUM_PIECES];    // rank of which of its stickers sits in each slot of that position
+    uint8_t orientation;        // puzzle orientation, see puzzle.c
+} cubie_state;
+
+static const int cell_axis[SIDES] = {W_AXIS, Y_AXIS, Z_AXIS, X_AXIS, Z_AXIS, X_AXIS, Y_AXIS, W_AXIS};
+static const int cell_sign[SIDES] = {-1, -1, 1, 1, -1, -1, 1, 1};
+
+static const int cell_twist_select[TWISTS_PER_CELL] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12,
+                                                        14, 16, 18, 20, 22, 24, 26};
+
+static int8_t piece_home[NUM_PIECES][NUM_AXES];
+static uint8_t piece_size[NUM_PIECES];
+static uint8_t piece_stickers[NUM_PIECES][MAX_PIECE_STICKERS];
+static uint8_t piece_colors[NUM_PIECES][MAX_PIECE_STICKERS];
+static uint8_t position_piece[81];
+static uint8_t sticker_piece[NUM_STICKERS];
+static uint8_t sticker_slot[NUM_STICKERS];
+
+static uint8_t twist_perm[MAX_PIECE_STICKERS + 1][MAX_PIECE_TWISTS][MAX_PIECE_STICKERS];
+static uint8_t twist_compose[MAX_PIECE_STICKERS + 1][MAX_PIECE_TWISTS][MAX_PIECE_TWISTS];
+static int twist_count[MAX_PIECE_STICKERS + 1];
+
+static uint8_t cell_twist_perm[NUM_CELL_TWISTS][NUM_STICKERS];
+static uint8_t piece_move_pos[NUM_CELL_TWISTS][NUM_PIECES];
+static uint8_t piece_move_twist[NUM_CELL_TWISTS][NUM_PIECES];
+static uint8_t view_twist[NUM_ORIENTATIONS][CUBES];
+static int cubie_tables_ready;
+
+int point_key(const int8_t *point) {
+    return (point[0] + 1) * 27 + (point[1] + 1) * 9 + (point[2] + 1) * 3 + (point[3] + 1);
+}
+
+/*
+ *  Function:    sticker_point
+ *  ----------------------
+ *  Gives the 4D point of the piece a (physical) sticker belongs to. The
+ *      center cube is the w = -1 cell, the hidden cube is w = +1 (kept
+ *      mirrored along y, see hidden_slot), and the 6 others have the layer
+ *      closest to the center cube at w = -1.
+ *
+ *  Input params:
+ *      int sticker:        physical sticker index
+ *      int8_t *point:      where the x, y, z, w coordinates are stored
+ */
+void sticker_point(int sticker, int8_t *point) {
+    int cell = sticker / CUBES;
+    int slot = sticker % CUBES;
+    int8_t local[DIMENSION] = {(int8_t) (slot / 9 - 1), (int8_t) ((slot / 3) % 3 - 1), (int8_t) (slot % 3 - 1)};
+    int a;
+
+    for(a = 0; a < DIMENSION; a++) {
+        point[a] = local[a];
+    }
+
+    if(cell == CORE_CUBE) {
+        point[W_AXIS] = -1;
+    }
+    else if(cell == HIDDEN_CUBE) {
+        point[Y_AXIS] = (int8_t) -local[Y_AXIS];
+        point[W_AXIS] = 1;
+    }
+    else {
+        a = cell_axis[cell];
+        point[W_AXIS] = (int8_t) (local[a] * cell_sign[cell]);
+        point[a] = (int8_t) cell_sign[cell];
+    }
+}
+
+// slot of the sticker facing `axis` among the (axis ordered) stickers of a piece
+int axis_slot(const int8_t *point, int axis) {
+    int slot = 0;
+    for(int a = 0; a < axis; a++) {
+        if(point[a]) slot++;
+    }
+    return slot;
+}
+
+int axis_cell(int axis, int sign) {
+    for(int c = 0; c < SIDES; c++) {
+        if(cell_axis[c] == axis && cell_sign[c] == sign) {
+            return c;
+        }
+    }
+    return -1;
+}
+
+int rank_twist(const uint8_t *perm, int size) {
+    for(int r = 0; r < twist_count[size]; r++) {
+        int i;
+        for(i = 0; i < size; i++) {
+            if(twist_perm[size][r][i] != perm[i]) break;
+        }
+        if(i == size) {
+            return r;
+        }
+    }
+    return -1;
+}
+
+void init_twist_tables(void) {
+    int size, i, a, b;
+
+    for(size = 1; size <= MAX_PIECE_STICKERS; size++) {
+        // lexicographic, so rank 0 is the identity
+        uint8_t perm[MAX_PIECE_STICKERS];
+        int count = 0;
+        int limit = 1;
+        for(i = 0; i < size; i++) limit *= size;
+
+        for(int code = 0; code < limit; code++) {
+            int used = 0, ok = 1, c = code;
+            for(i = size - 1; i >= 0; i--) {
+                perm[i] = c % size;
+                c /= size;
+            }
+            for(i = 0; i < size; i++) {
+                if(used & (1 << perm[i])) ok = 0;
+                used |= 1 << perm[i];
+            }
+            if(ok) {
+                for(i = 0; i < size; i++) twist_perm[size][count][i] = perm[i];
+                count++;
+            }
+        }
+        twist_count[size] = count;
+
+        for(a = 0; a < count; a++) {
+            for(b = 0; b < count; b++) {
+                for(i = 0; i < size; i++) {
+                    perm[i] = twist_perm[size][a][twist_perm[size][b][i]];
+                }
+                twist_compose[size][a][b] = rank_twist(perm, size);
+            }
+        }
+    }
+}
+
+void init_piece_tables(void) {
+    int8_t point[NUM_AXES];
+    int next[MAX_PIECE_STICKERS + 1] = {0, 0, FIRST_FACE, FIRST_EDGE, FIRST_CORNER};
+    int i, a;
+
+    for(i = 0; i < 81; i++) {
+        position_piece[i] = NO_PIECE;
+    }
+
+    for(i = 0; i < 81; i++) {
+        int size = 0;
+        int code = i;
+        for(a = NUM_AXES - 1; a >= 0; a--) {
+            point[a] = (int8_t) (code % 3 - 1);
+            code /= 3;
+            if(point[a]) size++;
+        }
+        if(size < 2) {
+            continue;
+        }
+
+        int piece = next[size]++;
+        for(a = 0; a < NUM_AXES; a++) {
+            piece_home[piece][a] = point[a];
+            if(point[a]) {
+                piece_colors[piece][axis_slot(point, a)] = axis_cell(a, point[a]);
+            }
+        }
+        piece_size[piece] = size;
+        position_piece[i] = piece;
+    }
+
+    for(i = 0; i < NUM_STICKERS; i++) {
+        sticker_point(i, point);
+        int piece = position_piece[point_key(point)];
+        sticker_piece[i] = piece;
+        sticker_slot[i] = 0;
+        if(piece != NO_PIECE) {
+            int slot = axis_slot(point, cell_axis[i / CUBES]);
+            sticker_slot[i] = slot;
+            piece_stickers[piece][slot] = i;
+        }
+    }
+}
+
+// physical pull permutation of turning the viewed center cube by `select`
+void view_twist_perm(int o, int select, uint8_t *perm) {
+    const uint8_t *remap = orient_remap[o];
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        perm[remap[i]] = remap[twist_table[select][i]];
+    }
+}
+
+/*
+ *  Function:    init_cubie_tables
+ *  --------------------------
+ *  Builds the cell twists and the piece move tables from the sticker tables
+ *      of puzzle.c (which come from rotate() and change_center()).
+ *
+ *      Cell twist c * TWISTS_PER_CELL + t turns physical cell c by
+ *      cell_twist_select[t], as seen from the first orientation that has c in
+ *      the center. view_twist[o][select] is the cell twist that the select
+ *      performs while the puzzle is in orientation o.
+ */
+void init_cubie_tables(void) {
+    uint8_t perm[NUM_STICKERS];
+    uint8_t inverse[NUM_STICKERS];
+    uint8_t slots[MAX_PIECE_STICKERS];
+    int o, m, i, t;
+
+    if(cubie_tables_ready) {
+        return;
+    }
+
+    init_puzzle_tables();
+    init_twist_tables();
+    init_piece_tables();
+
+    for(int cell = 0; cell < SIDES; cell++) {
+        for(o = 0; o < num_orientations; o++) {
+            if(orient_remap[o][CORE_CUBE * CUBES + CUBES / 2] / CUBES == cell) break;
+        }
+        for(t = 0; t < TWISTS_PER_CELL; t++) {
+            view_twist_perm(o, cell_twist_select[t], cell_twist_perm[cell * TWISTS_PER_CELL + t]);
+        }
+    }
+
+    for(o = 0; o < num_orientations; o++) {
+        int cell = orient_remap[o][CORE_CUBE * CUBES + CUBES / 2] / CUBES;
+
+        for(int select = 0; select < CUBES; select++) {
+            view_twist[o][select] = NO_TWIST;
+            if(select == CUBES / 2) {
+                continue;
+            }
+
+            view_twist_perm(o, select, perm);
+            for(t = 0; t < TWISTS_PER_CELL; t++) {
+                const uint8_t *candidate = cell_twist_perm[cell * TWISTS_PER_CELL + t];
+                for(i = 0; i < NUM_STICKERS; i++) {
+                    if(candidate[i] != perm[i]) break;
+                }
+                if(i == NUM_STICKERS) {
+                    view_twist[o][select] = cell * TWISTS_PER_CELL + t;
+                    break;
+                }
+            }
+        }
+    }
+
+    for(m = 0; m < NUM_CELL_TWISTS; m++) {
+        for(i = 0; i < NUM_STICKERS; i++) {
+            inverse[cell_twist_perm[m][i]] = i;
+        }
+
+        for(int piece = 0; piece < NUM_PIECES; piece++) {
+            int size = piece_size[piece];
+
+            // where each sticker of the position goes, and so where the slot order maps
+            for(t = 0; t < size; t++) {
+                int to = inverse[piece_stickers[piece][t]];
+                piece_move_pos[m][piece] = sticker_piece[to];
+                slots[sticker_slot[to]] = t;
+            }
+            piece_move_twist[m][piece] = rank_twist(slots, size);
+        }
+    }
+
+    cubie_tables_ready = 1;
+}
+
+void cubie_reset(cubie_state *state) {
+    for(int i = 0; i < NUM_PIECES; i++) {
+        state->pos[i] = i;
+        state->ori[i] = 0;
+    }
+    state->orientation = 0;
+}
+
+/*
+ *  Function:    cubie_twist
+ *  --------------------
+ *  Applies cell twist `move` (0 - NUM_CELL_TWISTS - 1) to every piece.
+ *
+ *  Runtime Complexity: O(NUM_PIECES)
+ */
+void cubie_twist(cubie_state *state, int move) {
+    const uint8_t *to = piece_move_pos[move];
+    const uint8_t *turn = piece_move_twist[move];
+
+    for(int i = 0; i < NUM_PIECES; i++) {
+        int at = state->pos[i];
+        state->pos[i] = to[at];
+        state->ori[i] = twist_compose[piece_size[i]][state->ori[i]][turn[at]];
+    }
+}
+
+// applies a move id from puzzle.c (a viewed twist or a move-in)
+void cubie_apply_move(cubie_state *state, int move) {
+    if(is_move_in(move)) {
+        state->orientation = orient_move_in[state->orientation][move - FIRST_MOVE_IN + 1];
+    }
+    else if(view_twist[state->orientation][move] != NO_TWIST) {
+        cubie_twist(state, view_twist[state->orientation][move]);
+    }
+}
+
+int cubie_solved(const cubie_state *state) {
+    for(int i = 0; i < NUM_PIECES; i++) {
+        if(state->pos[i] != i || state->ori[i] != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ *  Function:    stickers_to_cubies
+ *  ---------------------------
+ *  Reads the pieces off a physical sticker array (color index per sticker).
+ *
+ *  Input params:
+ *      const uint8_t *colors:  NUM_STICKERS color indices, physical frame
+ *      int orientation:        puzzle orientation the colors were taken in
+ *      cubie_state *state:     where the pieces are stored
+ *
+ *  Return:
+ *      0 on success, -1 if some position holds no valid piece, a piece shows
+ *          up twice or a center is the wrong color
+ */
+int stickers_to_cubies(const uint8_t *colors, int orientation, cubie_state *state) {
+    uint8_t seen[NUM_PIECES] = {0};
+    uint8_t perm[MAX_PIECE_STICKERS];
+    int8_t home[NUM_AXES];
+    int i, t, a;
+
+    for(i = 0; i < SIDES; i++) {
+        if(colors[i * CUBES + CUBES / 2] != i) {
+            return -1;
+        }
+    }
+
+    for(int at = 0; at < NUM_PIECES; at++) {
+        int size = piece_size[at];
+
+        for(a = 0; a < NUM_AXES; a++) {
+            home[a] = 0;
+        }
+        for(t = 0; t < size; t++) {
+            int color = colors[piece_stickers[at][t]];
+            if(color >= SIDES || home[cell_axis[color]]) {
+                return -1;
+            }
+            home[cell_axis[color]] = (int8_t) cell_sign[color];
+        }
+
+        int piece = position_piece[point_key(home)];
+        if(piece == NO_PIECE || seen[piece]) {
+            return -1;
+        }
+        seen[piece] = 1;
+
+        for(t = 0; t < size; t++) {
+            perm[t] = axis_slot(home, cell_axis[colors[piece_stickers[at][t]]]);
+        }
+        state->pos[piece] = at;
+        state->ori[piece] = rank_twist(perm, size);
+    }
+
+    state->orientation = orientation;
+    return 0;
+}
+
+/*
+ *  Function:    cubies_to_stickers
+ *  ---------------------------
+ *  Writes the physical sticker colors for a piece state.
+ */
+void cubies_to_stickers(const cubie_state *state, uint8_t *colors) {
+    for(int i = 0; i < SIDES; i++) {
+        colors[i * CUBES + CUBES / 2] = i;
+    }
+
+    for(int piece = 0; piece < NUM_PIECES; piece++) {
+        int size = piece_size[piece];
+        const uint8_t *perm = twist_perm[size][state->ori[piece]];
+        const uint8_t *at = piece_stickers[state->pos[piece]];
+
+        for(int t = 0; t < size; t++) {
+            colors[at[t]] = piece_colors[piece][perm[t]];
+        }
+    }
+}
+
+/*
+ *  Function:    state_perm
+ *  -------------------
+ *  The sticker permutation (pull form) that takes the solved puzzle to a piece
+ *      state, so the state can be sifted or multiplied like any group element.
+ */
+void state_perm(const cubie_state *state, uint8_t *perm) {
+    for(int cell = 0; cell < SIDES; cell++) {
+        perm[cell * CUBES + CUBES / 2] = (uint8_t) (cell * CUBES + CUBES / 2);
+    }
+    for(int piece = 0; piece < NUM_PIECES; piece++) {
+        int size = piece_size[piece];
+        const uint8_t *slots = twist_perm[size][state->ori[piece]];
+        const uint8_t *at = piece_stickers[state->pos[piece]];
+
+        for(int t = 0; t < size; t++) {
+            perm[at[t]] = piece_stickers[piece][slots[t]];
+        }
+    }
+}
+
+/*
+ *  Function:    cell_twist_moves
+ *  -------------------------
+ *  Turns a cell twist back into move ids the front end can play: the fewest
+ *      move-ins that bring its cell to the center, then the twist as seen from
+ *      there (at most MAX_CELL_TWIST_MOVES ids).
+ *
+ *  Input params:
+ *      int *orientation:   orientation before, updated to the one after
+ *      int move:           cell twist (0 - NUM_CELL_TWISTS - 1)
+ *      uint8_t *moves:     where the move ids go
+ *
+ *  Return:
+ *      the number of move ids written, or -1 if no orientation can make the twist
+ */
+int cell_twist_moves(int *orientation, int move, uint8_t *moves) {
+    uint8_t parent[NUM_ORIENTATIONS];
+    uint8_t via[NUM_ORIENTATIONS];
+    uint8_t queue[NUM_ORIENTATIONS];
+    int head = 0, tail = 0, o, n;
+
+    for(o = 0; o < num_orientations; o++) {
+        parent[o] = NO_TWIST;
+    }
+    parent[*orientation] = (uint8_t) *orientation;
+    queue[tail++] = (uint8_t) *orientation;
+
+    while(head < tail) {
+        o = queue[head++];
+        for(int select = 0; select < CUBES; select++) {
+            if(view_twist[o][select] != move) {
+                continue;
+            }
+
+            // walk back to count the move-ins, then write them front to back
+            int count = 0;
+            for(int at = o; at != *orientation; at = parent[at]) {
+                count++;
+            }
+            n = count;
+            moves[n] = (uint8_t) select;
+            for(int at = o; at != *orientation; at = parent[at]) {
+                moves[--n] = (uint8_t) (FIRST_MOVE_IN + via[at] - 1);
+            }
+            *orientation = o;
+            return count + 1;
+        }
+
+        for(int k = 1; k < HIDDEN_CUBE; k++) {
+            int next = orient_move_in[o][k];
+            if(parent[next] == NO_TWIST) {
+                parent[next] = (uint8_t) o;
+                via[next] = (uint8_t) k;
+                queue[tail++] = (uint8_t) next;
+            }
+        }
+    }
+    return -1;
+}
+
+// a puzzle's current stickers as pieces
+int puzzle_to_cubies(const puzzle *p, cubie_state *state) {
+    init_cubie_tables();
+    return stickers_to_cubies(p->stickers, p->orientation, state);
+}
+
+void cubies_to_puzzle(const cubie_state *state, puzzle *p) {
+    init_cubie_tables();
+    cubies_to_stickers(state, p->stickers);
+    p->orientation = state->orientation;
+}
+
+#endif // CUBIE_C
@@ -0,0 +1,209 @@
+//
+// Order and cycle structure of a move sequence: what it does to the puzzle
+// as one permutation, without playing it over and over.
+//
+// A sequence is played once on the solved piece state (cubie.c), which gives
+// where every piece goes and how it turns. Following the positions gives the
+// cycles, and a cycle of L positions whose pieces come back turned by t
+// returns after L times the order of t; the order of the whole sequence is
+// the least common multiple of those. Stickers are followed the same way
+// through state_perm.
+//
+// Move ids (puzzle.c) may also turn the whole puzzle with their move-ins. A
+// sequence that ends in another orientation plays different cell twists the
+// next time round, so it is played until the orientation is back (at most
+// NUM_ORIENTATIONS times) and that longer sequence is the one analysed.
+//
+
+#ifndef CYCLES_C
+#define CYCLES_C
+
+#include "coord.c"
+
+typedef struct {
+    uint8_t piece_class;
+    uint8_t length;         // positions on the cycle
+    uint8_t twist;          // how a piece comes back to where it started, as a twist rank
+    uint8_t twist_order;    // times round before it also comes back turned right
+    uint8_t first;          // the smallest position on it
+} piece_cycle;
+
+typedef struct {
+    int repetitions;                        // of the sequence in the state below: 1, or until the orientation is back
+    uint64_t order;                         // repetitions of the sequence that give the start again (UINT64_MAX if that overflows)
+    int stickers_moved;
+    int sticker_cycles;                     // of 2 or more stickers
+    int sticker_parity;                     // of the sticker permutation
+    int pieces_moved[NUM_PIECE_CLASSES];    // moved or turned in place
+    int parity[NUM_PIECE_CLASSES];          // of the permutation of the positions
+    int twisted[NUM_PIECE_CLASSES];         // turned in place
+    int num_cycles;
+    piece_cycle cycles[NUM_PIECES];         // every cycle that changes something, by first position
+    cubie_state state;                      // what `repetitions` repetitions do to the solved puzzle
+} cycle_report;
+
+static uint64_t gcd_u64(uint64_t a, uint64_t b) {
+    while(b != 0) {
+        uint64_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+// least common multiple, UINT64_MAX once it does not fit
+static uint64_t lcm_u64(uint64_t a, uint64_t b) {
+    if(a == UINT64_MAX || b == UINT64_MAX) {
+        return UINT64_MAX;
+    }
+    uint64_t m = a / gcd_u64(a, b);
+    return m > UINT64_MAX / b ? UINT64_MAX : m * b;
+}
+
+// times twist t must be made before it is no twist
+static int twist_order(int size, int t) {
+    int order = 1;
+    for(int at = t; at != 0; at = twist_compose[size][at][t]) {
+        order++;
+    }
+    return order;
+}
+
+/*
+ *  Function:    analyze_state
+ *  ----------------------
+ *  Fills the cycles, order and parities of a report from report->state and
+ *      report->repetitions.
+ *
+ *  Runtime Complexity: O(NUM_STICKERS)
+ */
+static void analyze_state(cycle_report *report) {
+    const cubie_state *state = &report->state;
+    uint8_t seen[NUM_STICKERS] = {0};
+    uint8_t perm[NUM_STICKERS];
+    uint64_t order = 1;
+
+    report->num_cycles = 0;
+    for(int piece_class = 0; piece_class < NUM_PIECE_CLASSES; piece_class++) {
+        report->pieces_moved[piece_class] = 0;
+        report->parity[piece_class] = 0;
+        report->twisted[piece_class] = 0;
+    }
+
+    for(int first = 0; first < NUM_PIECES; first++) {
+        int size = piece_size[first], piece_class = piece_class_of(first);
+        int length = 0, twist = 0;
+
+        if(seen[first]) {
+            continue;
+        }
+        // the piece that starts at `first` goes round; its turns add up as it goes
+        for(int at = first; !seen[at]; at = state->pos[at]) {
+            seen[at] = 1;
+            twist = twist_compose[size][twist][state->ori[at]];
+            length++;
+        }
+        if(length == 1 && twist == 0) {
+            continue;
+        }
+
+        piece_cycle *cycle = &report->cycles[report->num_cycles++];
+        cycle->piece_class = (uint8_t) piece_class;
+        cycle->length = (uint8_t) length;
+        cycle->twist = (uint8_t) twist;
+        cycle->twist_order = (uint8_t) twist_order(size, twist);
+        cycle->first = (uint8_t) first;
+
+        report->pieces_moved[piece_class] += length;
+        report->parity[piece_class] ^= (length - 1) & 1;
+        report->twisted[piece_class] += length == 1;
+        order = lcm_u64(order, (uint64_t) length * cycle->twist_order);
+    }
+    report->order = order == UINT64_MAX || order > UINT64_MAX / (uint64_t) report->repetitions ?
+                    UINT64_MAX : order * (uint64_t) report->repetitions;
+
+    state_perm(state, perm);
+    report->stickers_moved = 0;
+    report->sticker_cycles = 0;
+    report->sticker_parity = 0;
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        seen[i] = 0;
+    }
+    for(int first = 0; first < NUM_STICKERS; first++) {
+        int length = 0;
+
+        for(int at = first; !seen[at]; at = perm[at]) {
+            seen[at] = 1;
+            length++;
+        }
+        if(length > 1) {
+            report->stickers_moved += length;
+            report->sticker_cycles++;
+            report->sticker_parity ^= (length - 1) & 1;
+        }
+    }
+}
+
+/*
+ *  Function:    analyze_twists
+ *  -----------------------
+ *  Order and cycles of a sequence of cell twists (cubie.c).
+ *
+ *  Return:
+ *      0, or -1 if some twist is out of range
+ *
+ *  Runtime Complexity: O(length * NUM_PIECES + NUM_STICKERS)
+ */
+int analyze_twists(const uint8_t *twists, int length, cycle_report *report) {
+    init_coord_tables();
+    cubie_reset(&report->state);
+    for(int i = 0; i < length; i++) {
+        if(twists[i] >= NUM_CELL_TWISTS) {
+            return -1;
+        }
+        cubie_twist(&report->state, twists[i]);
+    }
+    report->repetitions = 1;
+    analyze_state(report);
+    return 0;
+}
+
+/*
+ *  Function:    analyze_moves
+ *  ----------------------
+ *  Order and cycles of a sequence of move ids played from `orientation`.
+ *      The order counts plays of the sequence until the stickers and the
+ *      orientation are both back.
+ *
+ *  Return:
+ *      0, or -1 if some move id or the orientation is out of range
+ *
+ *  Runtime Complexity: O(repetitions * length * NUM_PIECES), repetitions at most the
+ *      orientations
+ */
+int analyze_moves(const uint8_t *moves, int length, int orientation, cycle_report *report) {
+    init_coord_tables();
+    if(orientation < 0 || orientation >= num_orientations) {
+        return -1;
+    }
+    for(int i = 0; i < length; i++) {
+        if(moves[i] >= NUM_MOVES) {
+            return -1;
+        }
+    }
+
+    cubie_reset(&report->state);
+    report->state.orientation = orientation;
+    report->repetitions = 0;
+    do {
+        for(int i = 0; i < length; i++) {
+            cubie_apply_move(&report->state, moves[i]);
+        }
+        report->repetitions++;
+    } while(report->state.orientation != orientation);
+
+    analyze_state(report);
+    return 0;
+}
+
+#endif // CYCLES_C
@@ -0,0 +1,391 @@
+//
+// Stabilizer chain of the puzzle group, built with the randomized
+// Schreier-Sims algorithm over the sticker permutations of the cell twists.
+//
+// Level i of the chain fixes the base points of levels 0 - i-1 and knows, for
+// every sticker b_i can still be sent to, a permutation taking it back to b_i.
+// With that:
+//      membership:     sift a permutation level by level, it belongs to the
+//                      group exactly when it ends at the identity
+//      random states:  one random coset representative per level, multiplied
+//                      together, is a uniformly random element
+//      order:          the product of the orbit sizes
+//
+// Permutations are "pull" arrays like cell_twist_perm: new[i] = old[perm[i]],
+// and composing p then q gives r[i] = p[q[i]].
+//
+
+#ifndef GROUP_C
+#define GROUP_C
+
+#include "cubie.c"
+#include "rng.c"
+
+#define MAX_CHAIN_LEVELS NUM_STICKERS
+#define MAX_CHAIN_GENERATORS 256
+#define MAX_CHAIN_REPS 8192
+#define NO_REP 0xFFFF
+
+// consecutive random elements that must sift to the identity before the chain
+// is taken as complete. A missing level lets one through with probability at
+// most 1/2, so this is a 2^-CHAIN_SIFT_ROUNDS chance of a wrong chain
+#define CHAIN_SIFT_ROUNDS 64
+
+#define PRODUCT_SLOTS 10
+
+typedef struct {
+    int num_levels;
+    uint8_t base[MAX_CHAIN_LEVELS];
+    uint16_t orbit_size[MAX_CHAIN_LEVELS];
+    uint8_t orbit[MAX_CHAIN_LEVELS][NUM_STICKERS];      // orbit points, in the order found
+    uint16_t rep[MAX_CHAIN_LEVELS][NUM_STICKERS];       // index into reps of the way back, or NO_REP
+
+    int num_reps;
+    uint8_t reps[MAX_CHAIN_REPS][NUM_STICKERS];         // reps[rep[i][x]] takes x to base[i]
+
+    int num_generators;
+    uint8_t generator_level[MAX_CHAIN_GENERATORS];      // deepest level whose subgroup it is in
+    uint8_t generators[MAX_CHAIN_GENERATORS][NUM_STICKERS];
+    uint8_t generator_inverse[MAX_CHAIN_GENERATORS][NUM_STICKERS];
+} stabilizer_chain;
+
+static stabilizer_chain puzzle_chain;
+static int puzzle_chain_ready;
+
+// r = p then q (r may be p or q)
+void perm_compose(const uint8_t *p, const uint8_t *q, uint8_t *r) {
+    uint8_t out[NUM_STICKERS];
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        out[i] = p[q[i]];
+    }
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        r[i] = out[i];
+    }
+}
+
+void perm_invert(const uint8_t *p, uint8_t *r) {
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        r[p[i]] = (uint8_t) i;
+    }
+}
+
+void perm_identity(uint8_t *p) {
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        p[i] = (uint8_t) i;
+    }
+}
+
+int perm_is_identity(const uint8_t *p) {
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        if(p[i] != i) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int perm_equal(const uint8_t *p, const uint8_t *q) {
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        if(p[i] != q[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// where the sticker at `point` ends up after p
+static int perm_image(const uint8_t *p, int point) {
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        if(p[i] == point) {
+            return i;
+        }
+    }
+    return point;
+}
+
+/*
+ *  Function:    chain_sift
+ *  -------------------
+ *  Strips p down level by level, leaving the residue in p.
+ *
+ *  Return:
+ *      the level the residue got stuck at (its image of that base point has no
+ *          representative), or num_levels if it went all the way through
+ */
+int chain_sift(const stabilizer_chain *chain, uint8_t *p) {
+    for(int level = 0; level < chain->num_levels; level++) {
+        int at = perm_image(p, chain->base[level]);
+        uint16_t r = chain->rep[level][at];
+
+        if(r == NO_REP) {
+            return level;
+        }
+        perm_compose(p, chain->reps[r], p);
+    }
+    return chain->num_levels;
+}
+
+int chain_contains(const stabilizer_chain *chain, const uint8_t *p) {
+    uint8_t residue[NUM_STICKERS];
+
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        residue[i] = p[i];
+    }
+    return chain_sift(chain, residue) == chain->num_levels && perm_is_identity(residue);
+}
+
+// extends the orbit of one level with whatever its generators now reach
+static int chain_extend_orbit(stabilizer_chain *chain, int level) {
+    uint16_t *rep = chain->rep[level];
+
+    for(int n = 0; n < chain->orbit_size[level]; n++) {
+        int from = chain->orbit[level][n];
+
+        for(int g = 0; g < chain->num_generators; g++) {
+            if(chain->generator_level[g] < level) {
+                continue;
+            }
+            int to = chain->generator_inverse[g][from];
+            if(rep[to] != NO_REP) {
+                continue;
+            }
+            if(chain->num_reps == MAX_CHAIN_REPS) {
+                return -1;
+            }
+
+            // back from `to`: undo the generator, then the way back from `from`
+            rep[to] = (uint16_t) chain->num_reps;
+            perm_compose(chain->generator_inverse[g], chain->reps[rep[from]], chain->reps[chain->num_reps]);
+            chain->num_reps++;
+            chain->orbit[level][chain->orbit_size[level]++] = (uint8_t) to;
+        }
+    }
+    return 0;
+}
+
+static int chain_add_level(stabilizer_chain *chain, int base_point) {
+    int level = chain->num_levels;
+
+    if(chain->num_reps == MAX_CHAIN_REPS) {
+        return -1;
+    }
+    chain->base[level] = (uint8_t) base_point;
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        chain->rep[level][i] = NO_REP;
+    }
+    chain->rep[level][base_point] = (uint16_t) chain->num_reps;
+    perm_identity(chain->reps[chain->num_reps++]);
+    chain->orbit[level][0] = (uint8_t) base_point;
+    chain->orbit_size[level] = 1;
+    chain->num_levels++;
+    return 0;
+}
+
+/*
+ *  Function:    chain_add_residue
+ *  --------------------------
+ *  Adds a residue that stopped at `level` as a new strong generator, opening new
+ *      levels (taking base points from base_order) while it still fixes every
+ *      base point, then grows the orbits it is part of.
+ */
+static int chain_add_residue(stabilizer_chain *chain, const uint8_t *residue, int level, const uint8_t *base_order) {
+    int g = chain->num_generators;
+
+    if(g == MAX_CHAIN_GENERATORS) {
+        return -1;
+    }
+
+    if(level == chain->num_levels) {
+        int i = 0;
+        while(i < NUM_STICKERS && residue[base_order[i]] == base_order[i]) {
+            i++;
+        }
+        if(chain_add_level(chain, base_order[i]) != 0) {
+            return -1;
+        }
+    }
+
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        chain->generators[g][i] = residue[i];
+    }
+    perm_invert(residue, chain->generator_inverse[g]);
+    chain->generator_level[g] = (uint8_t) level;
+    chain->num_generators++;
+
+    for(int i = 0; i <= level; i++) {
+        if(chain_extend_orbit(chain, i) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ *  Function:    build_chain
+ *  --------------------
+ *  Builds the chain of the group generated by `count` permutations.
+ *
+ *  Input params:
+ *      stabilizer_chain *chain:    chain to build
+ *      const uint8_t *generators:  count * NUM_STICKERS permutations
+ *      int count:                  number of generators
+ *      const uint8_t *base_order:  every sticker, in the order base points are
+ *                                  preferred (earlier stickers get solved first
+ *                                  by anything that walks the chain)
+ *      uint64_t seed:              seed of the random elements
+ *
+ *  Return:
+ *      0 on success, -1 if a table filled up
+ */
+int build_chain(stabilizer_chain *chain, const uint8_t *generators, int count, const uint8_t *base_order, uint64_t seed) {
+    static uint8_t slots[PRODUCT_SLOTS][NUM_STICKERS];
+    uint8_t accumulator[NUM_STICKERS];
+    uint8_t residue[NUM_STICKERS];
+    rng_state rng;
+    int i, rounds;
+
+    chain->num_levels = 0;
+    chain->num_reps = 0;
+    chain->num_generators = 0;
+    rng_seed(&rng, seed);
+
+    // random elements by product replacement, started from the generators and
+    // mixed with a random one each step so all of them take part
+    for(i = 0; i < PRODUCT_SLOTS; i++) {
+        const uint8_t *from = generators + (size_t) (i % count) * NUM_STICKERS;
+        for(int j = 0; j < NUM_STICKERS; j++) {
+            slots[i][j] = from[j];
+        }
+    }
+    perm_identity(accumulator);
+
+    // the generators themselves go in first, so the chain is right even if the
+    // random elements are slow to cover them
+    for(i = 0; i < count; i++) {
+        for(int j = 0; j < NUM_STICKERS; j++) {
+            residue[j] = generators[(size_t) i * NUM_STICKERS + j];
+        }
+        int level = chain_sift(chain, residue);
+        if(!perm_is_identity(residue) && chain_add_residue(chain, residue, level, base_order) != 0) {
+            return -1;
+        }
+    }
+
+    for(rounds = 0; rounds < CHAIN_SIFT_ROUNDS; rounds++) {
+        int a = (int) rng_below(&rng, PRODUCT_SLOTS);
+        int b = (int) rng_below(&rng, PRODUCT_SLOTS - 1);
+        if(b >= a) b++;
+
+        perm_compose(slots[a], slots[b], slots[a]);
+        perm_compose(slots[a], generators + (size_t) rng_below(&rng, (uint32_t) count) * NUM_STICKERS, slots[a]);
+        perm_compose(accumulator, slots[a], accumulator);
+
+        for(i = 0; i < NUM_STICKERS; i++) {
+            residue[i] = accumulator[i];
+        }
+        int level = chain_sift(chain, residue);
+        if(!perm_is_identity(residue)) {
+            if(chain_add_residue(chain, residue, level, base_order) != 0) {
+                return -1;
+            }
+            rounds = -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ *  Function:    chain_random_element
+ *  -----------------------------
+ *  Uniformly random element of the group: one random representative from every
+ *      level. Every element is one such product in exactly one way.
+ *
+ *  Runtime Complexity: O(num_levels * NUM_STICKERS)
+ */
+void chain_random_element(const stabilizer_chain *chain, rng_state *rng, uint8_t *p) {
+    perm_identity(p);
+    for(int level = 0; level < chain->num_levels; level++) {
+        int at = chain->orbit[level][rng_below(rng, chain->orbit_size[level])];
+        perm_compose(p, chain->reps[chain->rep[level][at]], p);
+    }
+}
+
+/*
+ *  Function:    chain_order
+ *  ----------------
+ *  Writes the order of the group as a decimal string.
+ *
+ *  Return:
+ *      number of digits, or -1 if `size` is too small
+ */
+int chain_order(const stabilizer_chain *chain, char *out, int size) {
+    int digits = 1;
+    int i, level;
+
+    if(size < 2) {
+        return -1;
+    }
+    out[0] = 1;     // little endian digits, reversed into text at the end
+    for(level = 0; level < chain->num_levels; level++) {
+        int carry = 0;
+        for(i = 0; i < digits; i++) {
+            int v = out[i] * chain->orbit_size[level] + carry;
+            out[i] = (char) (v % 10);
+            carry = v / 10;
+        }
+        while(carry) {
+            if(digits == size - 1) {
+                return -1;
+            }
+            out[digits++] = (char) (carry % 10);
+            carry /= 10;
+        }
+    }
+    for(i = 0; i < digits / 2; i++) {
+        char t = out[i];
+        out[i] = out[digits - 1 - i];
+        out[digits - 1 - i] = t;
+    }
+    for(i = 0; i < digits; i++) {
+        out[i] = (char) (out[i] + '0');
+    }
+    out[digits] = '\0';
+    return digits;
+}
+
+/*
+ *  Function:    init_puzzle_chain
+ *  -----------------------
+ *  Builds the chain of every physical twist, with base points taken piece by
+ *      piece: the corners, then the edges, then the faces.
+ *
+ *  Return:
+ *      0 on success, -1 if a table filled up
+ */
+int init_puzzle_chain(void) {
+    static uint8_t base_order[NUM_STICKERS];
+    int n = 0;
+
+    if(puzzle_chain_ready) {
+        return 0;
+    }
+    init_cubie_tables();
+
+    for(int piece = 0; piece < NUM_PIECES; piece++) {
+        for(int t = 0; t < piece_size[piece]; t++) {
+            base_order[n++] = piece_stickers[piece][t];
+        }
+    }
+    // centers never move, but every sticker has to be listed
+    for(int cell = 0; cell < SIDES; cell++) {
+        base_order[n++] = (uint8_t) (cell * CUBES + CUBES / 2);
+    }
+
+    if(build_chain(&puzzle_chain, &cell_twist_perm[0][0], NUM_CELL_TWISTS, base_order, 0x4D3C) != 0) {
+        return -1;
+    }
+    puzzle_chain_ready = 1;
+    return 0;
+}
+
+#endif // GROUP_C
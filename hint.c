@@ -0,0 +1,365 @@
+//
+// Hints: a few plies of lookahead from the sticker state, scored with a cheap
+// count instead of a search to solved. Every move id is tried, then every
+// canonical line (moves.c) of up to HINT_MAX_DEPTH moves, and each first move
+// is ranked by the best score any line starting with it reaches.
+//
+// The lines of one level are packed into bitsliced batches (batch.c), one
+// line per lane, so the next level is one pass per move id over the whole
+// batch and is scored 64 lanes at a time. Only the 32 first moves are made
+// one puzzle at a time; at depth 3 the 342 lines of the second level take
+// 33 passes over one batch and the 6552 of the third 66 over two.
+//
+// Score: stickers showing their cube's center color, plus HINT_PIECE_WEIGHT
+// for each piece that is home and turned the right way. Neither changes on a
+// move-in, so a move-in on its own is never better than staying put; it is
+// the lines after it that make it worth suggesting.
+//
+
+#ifndef HINT_C
+#define HINT_C
+
+#include "batch.c"
+#include "moves.c"
+
+#define HINT_MAX_DEPTH 3
+#define HINT_PIECE_WEIGHT 3
+#define HINT_PACKED_NODES 512       // lines of the levels before the last
+#define HINT_PACKED_BATCHES ((HINT_PACKED_NODES + BATCH_LANES - 1) / BATCH_LANES)
+#define HINT_MAX_SCORE (NUM_STICKERS + HINT_PIECE_WEIGHT * NUM_PIECES)
+
+#define STICKER_COUNT_BITS 8
+#define PIECE_COUNT_BITS 7
+
+typedef struct {
+    uint8_t move;                   // move id to make now
+    uint8_t depth;                  // length of the best line found, this move included
+    int16_t score;                  // what that line reaches
+    uint8_t line[HINT_MAX_DEPTH];
+} hint;
+
+typedef struct {
+    uint8_t line[HINT_MAX_DEPTH];
+    uint8_t run;                    // how many times in a row the last move was made
+} hint_node;
+
+typedef struct {
+    puzzle_batch packed[2][HINT_PACKED_BATCHES];     // lines of the level before, and the new ones
+    puzzle_batch moved;
+    hint_node nodes[2][HINT_PACKED_NODES];
+    hint by_move[NUM_MOVES];
+    hint hints[NUM_MOVES];          // ranked, best first
+    int count;
+    int depth;                      // deepest level searched in full
+    int root_score;
+    uint64_t evaluated;             // positions scored
+} hint_search;
+
+static uint8_t hint_first_moves[NUM_MOVES];
+static int num_hint_first_moves;
+static int hint_tables_ready;
+
+void init_hint_tables(void) {
+    if(hint_tables_ready) {
+        return;
+    }
+    init_batch_tables();
+    init_cubie_tables();
+    init_move_tables();
+
+    uint64_t first = next_moves(NUM_MOVES, 0);
+    for(int m = 0; m < NUM_MOVES; m++) {
+        if((first >> m) & 1) {
+            hint_first_moves[num_hint_first_moves++] = (uint8_t) m;
+        }
+    }
+
+    hint_tables_ready = 1;
+}
+
+/*
+ *  Function:    hint_score
+ *  -------------------
+ *  The hint score of one puzzle, the way the batches count it.
+ */
+int hint_score(const puzzle *p) {
+    int score = 0;
+
+    init_hint_tables();
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        score += p->stickers[i] == i / CUBES;
+    }
+    for(int piece = 0; piece < NUM_PIECES; piece++) {
+        int k;
+        for(k = 0; k < piece_size[piece]; k++) {
+            int s = piece_stickers[piece][k];
+            if(p->stickers[s] != s / CUBES) {
+                break;
+            }
+        }
+        score += k == piece_size[piece] ? HINT_PIECE_WEIGHT : 0;
+    }
+    return score;
+}
+
+// adds one bit per lane to a bitsliced counter
+static void count_lanes(uint64_t *count, int bits, uint64_t carry) {
+    for(int k = 0; k < bits && carry; k++) {
+        uint64_t sum = count[k] ^ carry;
+        carry &= count[k];
+        count[k] = sum;
+    }
+}
+
+/*
+ *  Function:    score_word
+ *  -------------------
+ *  Scores the 64 lanes of word `w` of a batch at once and unpacks the
+ *      `valid` ones. Pieces are found by their stickers in the view frame;
+ *      every orientation maps pieces onto pieces, so the stickers of a piece
+ *      at orientation 0 are the stickers of a piece in every lane.
+ *
+ *  Input params:
+ *      int *scores:    64 scores, one per lane of the word
+ */
+static void score_word(const puzzle_batch *batch, int w, uint64_t valid, int *scores) {
+    uint64_t correct[NUM_STICKERS];
+    uint64_t stickers[STICKER_COUNT_BITS] = {0};
+    uint64_t pieces[PIECE_COUNT_BITS] = {0};
+
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        int center = i - i % CUBES + CUBES / 2;
+        uint64_t same = ~(uint64_t) 0;
+        for(int b = 0; b < COLOR_BITS; b++) {
+            same &= ~(batch->plane[i][b][w] ^ batch->plane[center][b][w]);
+        }
+        correct[i] = same;
+        count_lanes(stickers, STICKER_COUNT_BITS, same);
+    }
+    for(int piece = 0; piece < NUM_PIECES; piece++) {
+        uint64_t home = ~(uint64_t) 0;
+        for(int k = 0; k < piece_size[piece]; k++) {
+            home &= correct[piece_stickers[piece][k]];
+        }
+        count_lanes(pieces, PIECE_COUNT_BITS, home);
+    }
+
+    for(int lane = 0; lane < 64; lane++) {
+        if(!((valid >> lane) & 1)) {
+            continue;
+        }
+        int s = 0, n = 0;
+        for(int k = 0; k < STICKER_COUNT_BITS; k++) {
+            s |= (int) ((stickers[k] >> lane) & 1) << k;
+        }
+        for(int k = 0; k < PIECE_COUNT_BITS; k++) {
+            n |= (int) ((pieces[k] >> lane) & 1) << k;
+        }
+        scores[lane] = s + HINT_PIECE_WEIGHT * n;
+    }
+}
+
+// whether a is a better hint than b: higher score, then a shorter line, then the smaller move id
+static int hint_before(const hint *a, const hint *b) {
+    if(a->score != b->score) {
+        return a->score > b->score;
+    }
+    if(a->depth != b->depth) {
+        return a->depth < b->depth;
+    }
+    return a->move < b->move;
+}
+
+// moves that may follow a node
+static uint64_t node_next(const hint_node *node, int depth) {
+    return depth == 0 ? next_moves(NUM_MOVES, 0) : next_moves(node->line[depth - 1], node->run);
+}
+
+// keeps the line if it is the best yet for its first move
+static void hint_record(hint_search *search, const hint_node *node, int depth, int score) {
+    hint *h = &search->by_move[node->line[0]];
+
+    if(score > h->score) {
+        h->score = (int16_t) score;
+        h->depth = (uint8_t) depth;
+        for(int i = 0; i < depth; i++) {
+            h->line[i] = node->line[i];
+        }
+    }
+}
+
+static hint_node hint_child(const hint_node *parent, int depth, int move) {
+    hint_node child = *parent;
+
+    child.line[depth - 1] = (uint8_t) move;
+    child.run = depth > 1 && parent->line[depth - 2] == move ? parent->run + 1 : 1;
+    return child;
+}
+
+/*
+ *  Function:    expand_root
+ *  --------------------
+ *  Makes and scores the first moves one puzzle at a time (a pass over a
+ *      batch would carry one lane) and, with `pack`, packs them for the next
+ *      level.
+ *
+ *  Return:
+ *      the number of lines kept
+ */
+static int expand_root(hint_search *search, const puzzle *p, int pack) {
+    hint_node *children = search->nodes[1];
+    int made = 0;
+
+    for(int i = 0; i < num_hint_first_moves; i++) {
+        int move = hint_first_moves[i];
+        hint_node child = hint_child(&search->nodes[0][0], 1, move);
+        puzzle q = *p;
+
+        apply_move(&q, move);
+        hint_record(search, &child, 1, hint_score(&q));
+        if(pack) {
+            batch_set(&search->packed[1][0], made, &q);
+            children[made++] = child;
+        }
+    }
+    return made;
+}
+
+/*
+ *  Function:    expand_batched
+ *  -----------------------
+ *  Makes and scores the lines of level `depth` from the packed lines before
+ *      them: one pass over each batch per move id, which every lane that may
+ *      make that move takes at once. With `pack` the new lines are kept and
+ *      copied lane by lane into batches of their own.
+ *
+ *  Return:
+ *      the number of lines kept
+ */
+static int expand_batched(hint_search *search, int depth, int count, int pack) {
+    const hint_node *parents = search->nodes[(depth - 1) & 1];
+    hint_node *children = search->nodes[depth & 1];
+    puzzle_batch *from = search->packed[(depth - 1) & 1];
+    puzzle_batch *to = search->packed[depth & 1];
+    int scores[64];
+    int made = 0;
+
+    for(int b = 0; b * BATCH_LANES < count; b++) {
+        // the lanes that may make each move
+        uint64_t valid[NUM_MOVES][BATCH_WORDS] = {{0}};
+        for(int lane = 0; lane < BATCH_LANES && b * BATCH_LANES + lane < count; lane++) {
+            uint64_t next = node_next(&parents[b * BATCH_LANES + lane], depth - 1);
+            for(int move = 0; move < NUM_MOVES; move++) {
+                valid[move][lane / 64] |= ((next >> move) & 1) << (lane % 64);
+            }
+        }
+
+        for(int move = 0; move < NUM_MOVES; move++) {
+            int any = 0;
+            for(int w = 0; w < BATCH_WORDS; w++) {
+                any |= valid[move][w] != 0;
+            }
+            if(!any) {
+                continue;
+            }
+
+            search->moved = from[b];
+            batch_apply_move(&search->moved, move);
+            for(int w = 0; w < BATCH_WORDS; w++) {
+                if(!valid[move][w]) {
+                    continue;
+                }
+                score_word(&search->moved, w, valid[move][w], scores);
+                for(int lane = 0; lane < 64; lane++) {
+                    if(!((valid[move][w] >> lane) & 1)) {
+                        continue;
+                    }
+                    hint_node child = hint_child(&parents[b * BATCH_LANES + w * 64 + lane], depth, move);
+                    hint_record(search, &child, depth, scores[lane]);
+                    if(pack) {
+                        batch_copy_lane(&to[made / BATCH_LANES], made % BATCH_LANES, &search->moved, w * 64 + lane);
+                        children[made++] = child;
+                    }
+                }
+            }
+        }
+    }
+    return made;
+}
+
+/*
+ *  Function:    hint_moves
+ *  -------------------
+ *  Ranks every move of `p` by the best score a line of up to `max_depth`
+ *      moves starting with it reaches. Levels are searched whole, one after
+ *      the other; the first always is, a deeper one only if it fits in what
+ *      is left of `budget` positions, so the time taken is bounded and the
+ *      ranking never favours the moves that happened to be tried first.
+ *
+ *  Input params:
+ *      hint_search *search:    results in search->hints[0 .. count - 1]
+ *      const puzzle *p:
+ *      int max_depth:          1 - HINT_MAX_DEPTH
+ *      uint64_t budget:        most positions to score
+ *
+ *  Return:
+ *      the number of hints, one per move id
+ */
+int hint_moves(hint_search *search, const puzzle *p, int max_depth, uint64_t budget) {
+    int count = 1;
+
+    init_hint_tables();
+    if(max_depth < 1) max_depth = 1;
+    if(max_depth > HINT_MAX_DEPTH) max_depth = HINT_MAX_DEPTH;
+
+    search->root_score = hint_score(p);
+    search->evaluated = 0;
+    search->depth = 0;
+    for(int m = 0; m < NUM_MOVES; m++) {
+        search->by_move[m] = (hint) {(uint8_t) m, 0, -1, {0}};
+    }
+    search->nodes[0][0] = (hint_node) {{0}, 0};
+
+    for(int depth = 1; depth <= max_depth; depth++) {
+        const hint_node *parents = search->nodes[(depth - 1) & 1];
+        uint64_t size = 0;
+
+        for(int i = 0; i < count; i++) {
+            for(uint64_t next = node_next(&parents[i], depth - 1); next; next &= next - 1) {
+                size++;
+            }
+        }
+        if(depth > 1 && search->evaluated + size > budget) {
+            break;
+        }
+
+        // the last level is never kept, so it can be as large as it likes
+        int last = depth == max_depth || size > HINT_PACKED_NODES;
+        if(depth == 1) {
+            count = expand_root(search, p, !last);
+        }
+        else {
+            count = expand_batched(search, depth, count, !last);
+        }
+        search->evaluated += size;
+        search->depth = depth;
+        if(last) {
+            break;
+        }
+    }
+
+    // rank the moves that were tried, by insertion
+    search->count = 0;
+    for(int i = 0; i < num_hint_first_moves; i++) {
+        hint h = search->by_move[hint_first_moves[i]];
+        int at = search->count++;
+        while(at > 0 && hint_before(&h, &search->hints[at - 1])) {
+            search->hints[at] = search->hints[at - 1];
+            at--;
+        }
+        search->hints[at] = h;
+    }
+    return search->count;
+}
+
+#endif // HINT_C
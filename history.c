@@ -0,0 +1,175 @@
+//
+// Undo and redo: the moves made on a puzzle, a byte each, with a copy of the
+// puzzle every `interval` moves.
+//
+// Undo plays the inverse of the last move (inverse_move, scramble.c) and redo
+// plays it again, so both are one move. A jump to any step starts from the
+// checkpoint at or before it, or from where the puzzle is when that is
+// nearer, and plays fewer than `interval` moves either way: its cost does not
+// grow with the history. A move made after undoing drops the moves that could
+// have been redone. With the default interval of 256, the checkpoints add
+// under a byte a move.
+//
+// When the move buffer is full the oldest `interval` moves are dropped, so a
+// history holds the last `capacity` moves or so and steps count from the
+// oldest move kept.
+//
+
+#ifndef HISTORY_C
+#define HISTORY_C
+
+#include "scramble.c"
+
+#define HISTORY_INTERVAL 256
+
+typedef struct {
+    puzzle current;             // after the first `position` moves
+    uint8_t *moves;             // move ids, the caller's: `capacity` of them
+    puzzle *checkpoints;        // the caller's: checkpoints[k] is the puzzle after k * interval moves
+    uint32_t capacity;          // a multiple of interval
+    uint32_t interval;
+    uint32_t length;            // moves kept, the ones that can be redone included
+    uint32_t position;          // moves in effect
+    uint64_t dropped;           // moves dropped from the front to make room
+} history;
+
+// checkpoints a history of `capacity` moves needs
+#define HISTORY_CHECKPOINTS(capacity, interval) ((capacity) / (interval) + 1)
+
+/*
+ *  Function:    history_init
+ *  ---------------------
+ *  Starts an empty history from a puzzle.
+ *
+ *  Input params:
+ *      history *h:
+ *      const puzzle *start:
+ *      uint8_t *moves:         room for `capacity` move ids
+ *      uint32_t capacity:      a multiple of interval, at least twice it
+ *      puzzle *checkpoints:    room for HISTORY_CHECKPOINTS(capacity, interval)
+ *      uint32_t interval:      moves between checkpoints
+ *
+ *  Return:
+ *      0, or -1 if the capacity does not suit the interval
+ */
+int history_init(history *h, const puzzle *start, uint8_t *moves, uint32_t capacity, puzzle *checkpoints,
+                 uint32_t interval) {
+    if(interval == 0 || capacity < 2 * interval || capacity % interval != 0) {
+        return -1;
+    }
+    init_scramble_tables();
+    h->current = *start;
+    h->moves = moves;
+    h->checkpoints = checkpoints;
+    h->capacity = capacity;
+    h->interval = interval;
+    h->length = 0;
+    h->position = 0;
+    h->dropped = 0;
+    h->checkpoints[0] = *start;
+    return 0;
+}
+
+// the axis the last move-in before `step` left, which an inverse move-in does not give back
+static int history_axis(const history *h, uint32_t step) {
+    uint32_t first = step / h->interval * h->interval;
+
+    for(uint32_t i = step; i > first; i--) {
+        if(is_move_in(h->moves[i - 1])) {
+            return move_in_axis(h->moves[i - 1] - FIRST_MOVE_IN + 1);
+        }
+    }
+    return h->checkpoints[step / h->interval].last_move_in_axis;
+}
+
+// drops the oldest `interval` moves and their checkpoint
+static void history_drop(history *h) {
+    uint32_t checkpoints = h->length / h->interval + 1;
+
+    for(uint32_t i = h->interval; i < h->length; i++) {
+        h->moves[i - h->interval] = h->moves[i];
+    }
+    for(uint32_t k = 1; k < checkpoints; k++) {
+        h->checkpoints[k - 1] = h->checkpoints[k];
+    }
+    h->length -= h->interval;
+    h->position -= h->interval;
+    h->dropped += h->interval;
+}
+
+// makes a move (0 - NUM_MOVES - 1), dropping the moves that could have been redone
+void history_push(history *h, int move) {
+    h->length = h->position;
+    if(h->length == h->capacity) {
+        history_drop(h);
+    }
+    h->moves[h->length++] = (uint8_t) move;
+    h->position++;
+    apply_move(&h->current, move);
+    if(h->position % h->interval == 0) {
+        h->checkpoints[h->position / h->interval] = h->current;
+    }
+}
+
+// takes back the last move; the move undone, or -1 if there is none
+int history_undo(history *h) {
+    if(h->position == 0) {
+        return -1;
+    }
+    int move = h->moves[--h->position];
+    apply_move(&h->current, inverse_move(move));
+    if(is_move_in(move)) {
+        h->current.last_move_in_axis = history_axis(h, h->position);
+    }
+    return move;
+}
+
+// makes the last move undone again; that move, or -1 if there is none
+int history_redo(history *h) {
+    if(h->position == h->length) {
+        return -1;
+    }
+    int move = h->moves[h->position++];
+    apply_move(&h->current, move);
+    return move;
+}
+
+/*
+ *  Function:    history_jump
+ *  ---------------------
+ *  Puts the puzzle where it was after `step` moves, undoing or redoing as
+ *      many as that takes. Later moves stay there to be redone.
+ *
+ *  Return:
+ *      0, or -1 if the step is past the last move
+ *
+ *  Runtime Complexity: O(interval) moves
+ */
+int history_jump(history *h, uint32_t step) {
+    if(step > h->length) {
+        return -1;
+    }
+    uint32_t from_checkpoint = step % h->interval;
+
+    if(step >= h->position && step - h->position <= from_checkpoint) {
+        while(h->position < step) {
+            history_redo(h);
+        }
+        return 0;
+    }
+    if(step < h->position && h->position - step <= from_checkpoint) {
+        while(h->position > step) {
+            h->position--;
+            apply_move(&h->current, inverse_move(h->moves[h->position]));
+        }
+        h->current.last_move_in_axis = history_axis(h, step);
+        return 0;
+    }
+    h->current = h->checkpoints[step / h->interval];
+    for(h->position = step - from_checkpoint; h->position < step; h->position++) {
+        apply_move(&h->current, h->moves[h->position]);
+    }
+    return 0;
+}
+
+#endif // HISTORY_C
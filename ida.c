@@ -0,0 +1,279 @@
+//
+// Iterative deepening A* over the cell twists of the cubie model. Each
+// iteration is a depth first search that gives up on a branch as soon as the
+// moves made plus the heuristic pass the bound; the bound goes up by one
+// until a solution shows up, so the first one found is as short as possible
+// (in twists, move-ins are free).
+//
+// Heuristics are pluggable: any function that never overestimates the twists
+// left. The search takes the largest of the ones it is given.
+//
+
+#ifndef IDA_C
+#define IDA_C
+
+#include "pdb.c"
+#include "moves.c"
+
+#define IDA_MAX_DEPTH 24
+#define MAX_HEURISTICS 8
+
+#define IDA_NOT_FOUND 0
+#define IDA_FOUND 1
+#define IDA_STOPPED -1
+
+typedef int (*heuristic_fn)(const void *data, const cubie_state *state);
+// whether a state ends the search; the heuristics must all be 0 there
+typedef int (*ida_goal_fn)(const void *data, const cubie_state *state);
+
+typedef struct {
+    heuristic_fn estimate;
+    const void *data;
+} heuristic;
+
+typedef struct {
+    uint64_t nodes[IDA_MAX_DEPTH + 1];              // nodes visited at each depth, all iterations
+    uint64_t iteration_nodes[IDA_MAX_DEPTH + 1];    // nodes visited by the iteration with each bound
+    double iteration_seconds[IDA_MAX_DEPTH + 1];    // filled in by drivers that have a clock
+    uint64_t total;
+    uint64_t steals;                                // tasks taken from another thread's slice
+    int first_bound;
+    int last_bound;
+} ida_stats;
+
+typedef struct {
+    heuristic heuristics[MAX_HEURISTICS];
+    int num_heuristics;
+    int bound;
+    uint64_t node_limit;        // stop after this many nodes, 0 for no limit
+    volatile int *stop;         // the search stops once this is nonzero (may be NULL)
+    ida_goal_fn goal;           // NULL to search for solved
+    const void *goal_data;
+    ida_stats stats;
+    uint8_t path[IDA_MAX_DEPTH + 1];
+} ida_search;
+
+static int class_most_moved[NUM_PIECE_CLASSES];
+static int ida_tables_ready;
+
+void init_ida_tables(void) {
+    if(ida_tables_ready) {
+        return;
+    }
+    init_coord_tables();
+    init_move_tables();
+
+    for(int m = 0; m < NUM_CELL_TWISTS; m++) {
+        int moved[NUM_PIECE_CLASSES] = {0};
+        for(int piece = 0; piece < NUM_PIECES; piece++) {
+            if(piece_move_pos[m][piece] != piece || piece_move_twist[m][piece] != 0) {
+                moved[piece_class_of(piece)]++;
+            }
+        }
+        for(int c = 0; c < NUM_PIECE_CLASSES; c++) {
+            if(moved[c] > class_most_moved[c]) {
+                class_most_moved[c] = moved[c];
+            }
+        }
+    }
+
+    ida_tables_ready = 1;
+}
+
+/*
+ *  Function:    misplaced_estimate
+ *  ---------------------------
+ *  Heuristic that needs no tables: a twist fixes at most class_most_moved
+ *      pieces of a class, so the pieces of a class that are out of place or
+ *      twisted, divided by that (rounded up), is a lower bound.
+ */
+int misplaced_estimate(const void *data, const cubie_state *state) {
+    int wrong[NUM_PIECE_CLASSES] = {0};
+    int best = 0;
+
+    (void) data;
+    for(int piece = 0; piece < NUM_PIECES; piece++) {
+        if(state->pos[piece] != piece || state->ori[piece] != 0) {
+            wrong[piece_class_of(piece)]++;
+        }
+    }
+    for(int c = 0; c < NUM_PIECE_CLASSES; c++) {
+        int needed = (wrong[c] + class_most_moved[c] - 1) / class_most_moved[c];
+        if(needed > best) {
+            best = needed;
+        }
+    }
+    return best;
+}
+
+// heuristic over a pattern database, data is the pattern_db
+int pdb_estimate(const void *data, const cubie_state *state) {
+    return pdb_lookup((const pattern_db *) data, state);
+}
+
+void init_ida_search(ida_search *search, const heuristic *heuristics, int count) {
+    init_ida_tables();
+
+    search->num_heuristics = 0;
+    for(int i = 0; i < count && i < MAX_HEURISTICS; i++) {
+        search->heuristics[search->num_heuristics++] = heuristics[i];
+    }
+    search->bound = 0;
+    search->node_limit = 0;
+    search->stop = NULL;
+    search->goal = NULL;
+    search->goal_data = NULL;
+    for(int d = 0; d <= IDA_MAX_DEPTH; d++) {
+        search->stats.nodes[d] = 0;
+        search->stats.iteration_nodes[d] = 0;
+        search->stats.iteration_seconds[d] = 0;
+    }
+    search->stats.total = 0;
+    search->stats.steals = 0;
+    search->stats.first_bound = 0;
+    search->stats.last_bound = 0;
+}
+
+int ida_estimate(const ida_search *search, const cubie_state *state) {
+    int best = 0;
+    for(int i = 0; i < search->num_heuristics; i++) {
+        int h = search->heuristics[i].estimate(search->heuristics[i].data, state);
+        if(h > best) {
+            best = h;
+        }
+    }
+    return best;
+}
+
+// whether a state the heuristics put at 0 is where the search ends
+int ida_at_goal(const ida_search *search, const cubie_state *state) {
+    return search->goal != NULL ? search->goal(search->goal_data, state) : cubie_solved(state);
+}
+
+// whether a search may make twist `move` right after `last` (NO_TWIST at the
+// start): only canonical sequences are searched, see moves.c
+int ida_allows(int last, int move) {
+    return twist_allowed(last, move);
+}
+
+/*
+ *  Function:    ida_bounded
+ *  --------------------
+ *  Depth first search below `state`, reached after `depth` twists (the last
+ *      being `last`), for a solution of at most search->bound twists. The
+ *      twists that lead here must already be in search->path.
+ *
+ *  Return:
+ *      IDA_FOUND with the solution in search->path (search->bound long at most,
+ *          see ida_solution_length), IDA_NOT_FOUND, or IDA_STOPPED
+ */
+int ida_bounded(ida_search *search, const cubie_state *state, int depth, int last) {
+    ida_stats *stats = &search->stats;
+    cubie_state next;
+
+    stats->nodes[depth]++;
+    stats->iteration_nodes[search->bound]++;
+    stats->total++;
+    if((search->stop != NULL && *search->stop) || (search->node_limit && stats->total > search->node_limit)) {
+        return IDA_STOPPED;
+    }
+
+    int h = ida_estimate(search, state);
+    if(depth + h > search->bound) {
+        return IDA_NOT_FOUND;
+    }
+    if(h == 0 && ida_at_goal(search, state)) {
+        search->path[depth] = NO_TWIST;
+        return IDA_FOUND;
+    }
+    if(depth == search->bound) {
+        return IDA_NOT_FOUND;
+    }
+
+    for(int m = 0; m < NUM_CELL_TWISTS; m++) {
+        if(!ida_allows(last, m)) {
+            continue;
+        }
+        next = *state;
+        cubie_twist(&next, m);
+        search->path[depth] = (uint8_t) m;
+
+        int result = ida_bounded(search, &next, depth + 1, m);
+        if(result != IDA_NOT_FOUND) {
+            return result;
+        }
+    }
+    return IDA_NOT_FOUND;
+}
+
+// length of the solution left in search->path by ida_bounded
+int ida_solution_length(const ida_search *search) {
+    int n = 0;
+    while(n < search->bound && search->path[n] != NO_TWIST) {
+        n++;
+    }
+    return n;
+}
+
+/*
+ *  Function:    ida_solve
+ *  ------------------
+ *  Finds a shortest sequence of cell twists that solves `start`.
+ *
+ *  Input params:
+ *      ida_search *search:         set up by init_ida_search (node_limit and
+ *                                  stop are honored), stats are kept here
+ *      const cubie_state *start:   state to solve
+ *      int max_depth:              longest solution to look for
+ *      uint8_t *solution:          max_depth cell twists
+ *
+ *  Return:
+ *      the solution length, or -1 if there is none within max_depth or the
+ *          search was stopped
+ */
+int ida_solve(ida_search *search, const cubie_state *start, int max_depth, uint8_t *solution) {
+    if(max_depth > IDA_MAX_DEPTH) {
+        max_depth = IDA_MAX_DEPTH;
+    }
+
+    search->stats.first_bound = ida_estimate(search, start);
+    for(search->bound = search->stats.first_bound; search->bound <= max_depth; search->bound++) {
+        search->stats.last_bound = search->bound;
+
+        int result = ida_bounded(search, start, 0, NO_TWIST);
+        if(result == IDA_STOPPED) {
+            return -1;
+        }
+        if(result == IDA_FOUND) {
+            int length = ida_solution_length(search);
+            for(int i = 0; i < length; i++) {
+                solution[i] = search->path[i];
+            }
+            return length;
+        }
+    }
+    return -1;
+}
+
+/*
+ *  Function:    solution_to_moves
+ *  --------------------------
+ *  Turns cell twists into move ids (move-ins and viewed twists) that play them
+ *      from `orientation`, for the front end to animate.
+ *
+ *  Return:
+ *      the number of move ids, at most length * MAX_CELL_TWIST_MOVES
+ */
+int solution_to_moves(int orientation, const uint8_t *solution, int length, uint8_t *moves) {
+    int n = 0;
+    for(int i = 0; i < length; i++) {
+        int written = cell_twist_moves(&orientation, solution[i], moves + n);
+        if(written < 0) {
+            return -1;
+        }
+        n += written;
+    }
+    return n;
+}
+
+#endif // IDA_C
@@ -0,0 +1,288 @@
+//
+// Multithreaded driver for ida.c (native builds only, needs pthreads).
+//
+// Every iteration first lists the twist sequences of length split_depth that
+// survive the bound (the tasks), hands each worker an equal slice, and lets
+// the workers search below their tasks. A worker that runs out steals the
+// back half of the biggest slice left, so the threads stay busy even though
+// some subtrees are far bigger than others.
+//
+
+#ifndef IDA_THREADS_C
+#define IDA_THREADS_C
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ida.c"
+
+#define MAX_IDA_THREADS 64
+#define MAX_SPLIT_DEPTH 4
+
+typedef struct {
+    pthread_mutex_t lock;
+    long next;              // first task not taken yet
+    long end;
+} task_slice;
+
+typedef struct {
+    const cubie_state *start;
+    const uint8_t *tasks;   // split_depth twists each
+    int split_depth;
+    int bound;
+    int num_threads;
+    task_slice slices[MAX_IDA_THREADS];
+
+    volatile int stop;
+    pthread_mutex_t found_lock;
+    int found;
+    uint8_t solution[IDA_MAX_DEPTH];
+    int solution_length;
+} ida_shared;
+
+typedef struct {
+    ida_shared *shared;
+    int index;
+    ida_search search;
+} ida_worker;
+
+static double ida_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+// takes the next task of a worker's own slice, or steals half of the biggest other one
+static long take_task(ida_worker *worker) {
+    ida_shared *shared = worker->shared;
+    task_slice *own = &shared->slices[worker->index];
+    long task = -1;
+
+    pthread_mutex_lock(&own->lock);
+    if(own->next < own->end) {
+        task = own->next++;
+    }
+    pthread_mutex_unlock(&own->lock);
+    if(task >= 0) {
+        return task;
+    }
+
+    for(;;) {
+        int victim = -1;
+        long most = 0;
+
+        for(int i = 0; i < shared->num_threads; i++) {
+            if(i == worker->index) {
+                continue;
+            }
+            pthread_mutex_lock(&shared->slices[i].lock);
+            long left = shared->slices[i].end - shared->slices[i].next;
+            pthread_mutex_unlock(&shared->slices[i].lock);
+            if(left > most) {
+                most = left;
+                victim = i;
+            }
+        }
+        if(victim < 0) {
+            return -1;
+        }
+
+        task_slice *from = &shared->slices[victim];
+        long begin = -1, end = -1;
+        // it may have shrunk since it was looked at
+        pthread_mutex_lock(&from->lock);
+        if(from->next < from->end) {
+            long half = (from->end - from->next + 1) / 2;
+            end = from->end;
+            begin = end - half;
+            from->end = begin;
+        }
+        pthread_mutex_unlock(&from->lock);
+        if(begin < 0) {
+            continue;
+        }
+
+        worker->search.stats.steals++;
+        pthread_mutex_lock(&own->lock);
+        own->next = begin + 1;
+        own->end = end;
+        pthread_mutex_unlock(&own->lock);
+        return begin;
+    }
+}
+
+static void *ida_worker_main(void *arg) {
+    ida_worker *worker = (ida_worker *) arg;
+    ida_shared *shared = worker->shared;
+    ida_search *search = &worker->search;
+    long task;
+
+    search->bound = shared->bound;
+    while(!shared->stop && (task = take_task(worker)) >= 0) {
+        const uint8_t *prefix = shared->tasks + task * shared->split_depth;
+        cubie_state state = *shared->start;
+
+        for(int d = 0; d < shared->split_depth; d++) {
+            cubie_twist(&state, prefix[d]);
+            search->path[d] = prefix[d];
+        }
+
+        if(ida_bounded(search, &state, shared->split_depth, prefix[shared->split_depth - 1]) == IDA_FOUND) {
+            pthread_mutex_lock(&shared->found_lock);
+            if(!shared->found) {
+                shared->found = 1;
+                shared->solution_length = ida_solution_length(search);
+                for(int i = 0; i < shared->solution_length; i++) {
+                    shared->solution[i] = search->path[i];
+                }
+            }
+            shared->stop = 1;
+            pthread_mutex_unlock(&shared->found_lock);
+        }
+    }
+    return NULL;
+}
+
+// lists the prefixes of length split_depth that the bound does not cut off
+static long list_tasks(ida_search *search, const cubie_state *state, int depth, int last, int split_depth,
+                       uint8_t *prefix, uint8_t *tasks, long count, long capacity) {
+    if(depth + ida_estimate(search, state) > search->bound) {
+        return count;
+    }
+    if(depth == split_depth) {
+        if(tasks != NULL && count < capacity) {
+            for(int d = 0; d < split_depth; d++) {
+                tasks[count * split_depth + d] = prefix[d];
+            }
+        }
+        return count + 1;
+    }
+
+    for(int m = 0; m < NUM_CELL_TWISTS; m++) {
+        if(!ida_allows(last, m)) {
+            continue;
+        }
+        cubie_state next = *state;
+        cubie_twist(&next, m);
+        prefix[depth] = (uint8_t) m;
+        count = list_tasks(search, &next, depth + 1, m, split_depth, prefix, tasks, count, capacity);
+    }
+    return count;
+}
+
+/*
+ *  Function:    ida_solve_parallel
+ *  ---------------------------
+ *  ida_solve on several threads. Bounds up to split_depth are searched on the
+ *      calling thread, deeper ones are split as described at the top.
+ *
+ *  Input params:
+ *      const cubie_state *start:       state to solve
+ *      const heuristic *heuristics:    heuristics to take the largest of
+ *      int num_heuristics:
+ *      int max_depth:                  longest solution to look for
+ *      int threads:                    worker threads (1 - MAX_IDA_THREADS)
+ *      int split_depth:                length of the task prefixes (1 - MAX_SPLIT_DEPTH)
+ *      uint8_t *solution:              max_depth cell twists
+ *      ida_stats *stats:               nodes per depth and per iteration, summed
+ *                                      over the threads, with iteration times
+ *
+ *  Return:
+ *      the solution length, or -1 if there is none within max_depth
+ */
+int ida_solve_parallel(const cubie_state *start, const heuristic *heuristics, int num_heuristics, int max_depth,
+                       int threads, int split_depth, uint8_t *solution, ida_stats *stats) {
+    static ida_shared shared;
+    static ida_worker workers[MAX_IDA_THREADS];
+    pthread_t ids[MAX_IDA_THREADS];
+    ida_search root;
+    uint8_t prefix[MAX_SPLIT_DEPTH];
+    int result = -1;
+
+    if(threads < 1) threads = 1;
+    if(threads > MAX_IDA_THREADS) threads = MAX_IDA_THREADS;
+    if(split_depth < 1) split_depth = 1;
+    if(split_depth > MAX_SPLIT_DEPTH) split_depth = MAX_SPLIT_DEPTH;
+    if(max_depth > IDA_MAX_DEPTH) max_depth = IDA_MAX_DEPTH;
+
+    init_ida_search(&root, heuristics, num_heuristics);
+    for(int t = 0; t < threads; t++) {
+        init_ida_search(&workers[t].search, heuristics, num_heuristics);
+        workers[t].shared = &shared;
+        workers[t].index = t;
+        workers[t].search.stop = &shared.stop;
+    }
+    pthread_mutex_init(&shared.found_lock, NULL);
+    for(int t = 0; t < threads; t++) {
+        pthread_mutex_init(&shared.slices[t].lock, NULL);
+    }
+
+    root.stats.first_bound = ida_estimate(&root, start);
+    for(int bound = root.stats.first_bound; bound <= max_depth && result < 0; bound++) {
+        double begin = ida_now();
+        root.bound = bound;
+        root.stats.last_bound = bound;
+
+        if(bound <= split_depth) {
+            if(ida_bounded(&root, start, 0, NO_TWIST) == IDA_FOUND) {
+                result = ida_solution_length(&root);
+                for(int i = 0; i < result; i++) {
+                    solution[i] = root.path[i];
+                }
+            }
+            root.stats.iteration_seconds[bound] = ida_now() - begin;
+            continue;
+        }
+
+        long count = list_tasks(&root, start, 0, NO_TWIST, split_depth, prefix, NULL, 0, 0);
+        uint8_t *tasks = malloc((size_t) (count > 0 ? count : 1) * (size_t) split_depth);
+        if(tasks == NULL) {
+            break;
+        }
+        list_tasks(&root, start, 0, NO_TWIST, split_depth, prefix, tasks, 0, count);
+
+        shared.start = start;
+        shared.tasks = tasks;
+        shared.split_depth = split_depth;
+        shared.bound = bound;
+        shared.num_threads = threads;
+        shared.stop = 0;
+        shared.found = 0;
+        for(int t = 0; t < threads; t++) {
+            shared.slices[t].next = count * t / threads;
+            shared.slices[t].end = count * (t + 1) / threads;
+        }
+
+        for(int t = 0; t < threads; t++) {
+            pthread_create(&ids[t], NULL, ida_worker_main, &workers[t]);
+        }
+        for(int t = 0; t < threads; t++) {
+            pthread_join(ids[t], NULL);
+        }
+        free(tasks);
+
+        root.stats.iteration_seconds[bound] = ida_now() - begin;
+        if(shared.found) {
+            result = shared.solution_length;
+            for(int i = 0; i < result; i++) {
+                solution[i] = shared.solution[i];
+            }
+        }
+    }
+
+    *stats = root.stats;
+    for(int t = 0; t < threads; t++) {
+        for(int d = 0; d <= IDA_MAX_DEPTH; d++) {
+            stats->nodes[d] += workers[t].search.stats.nodes[d];
+            stats->iteration_nodes[d] += workers[t].search.stats.iteration_nodes[d];
+        }
+        stats->total += workers[t].search.stats.total;
+        stats->steals += workers[t].search.stats.steals;
+        pthread_mutex_destroy(&shared.slices[t].lock);
+    }
+    pthread_mutex_destroy(&shared.found_lock);
+    return result;
+}
+
+#endif // IDA_THREADS_C
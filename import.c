@@ -0,0 +1,254 @@
+//
+// State import: a puzzle from 216 sticker colors, as text or packed binary,
+// checked to be reachable by twists without searching for how.
+//
+// The colors are read into pieces (stickers_to_cubies), and a piece state is
+// reachable exactly when it passes these, every one kept by every twist:
+//      - each color shows on 27 stickers, the centers are their own color,
+//        and every piece shows up once
+//      - a corner's twist is odd or even as its position dictates (coord.c)
+//      - corners: their twists, seen as turns of the three ways to split four
+//        stickers into two pairs, add up to nothing (mod 3)
+//      - edges: an even number are turned oddly; faces: an even number are
+//        flipped
+//      - the corners are in an even permutation, and the edges' permutation
+//        is odd exactly when the faces' is
+// Together these leave the order of the group the stabilizer chain of
+// group.c counts (tools/import.c checks random states against it), so a
+// state that passes can be solved.
+//
+// Text is one digit 0 - 7 per sticker, in the physical order of puzzle.c,
+// with anything else between them skipped. Packed binary is 3 bits per
+// sticker, the first sticker in the low bits, IMPORT_PACKED_BYTES in all.
+//
+
+#ifndef IMPORT_C
+#define IMPORT_C
+
+#include "coord.c"
+
+#define IMPORT_PACKED_BYTES ((NUM_STICKERS * 3 + 7) / 8)
+
+// why a state was refused
+#define IMPORT_OK 0
+#define IMPORT_BAD_FORMAT 1         // not 216 colors
+#define IMPORT_BAD_COLOR_COUNT 2    // some color not on 27 stickers
+#define IMPORT_BAD_PIECE 3          // a center out of place, or a piece that does not exist or shows up twice
+#define IMPORT_CORNER_TWIST 4       // a corner turned as its position never allows
+#define IMPORT_CORNER_TWIST_SUM 5
+#define IMPORT_EDGE_TWIST_SUM 6
+#define IMPORT_FACE_FLIP_SUM 7
+#define IMPORT_CORNER_PARITY 8
+#define IMPORT_PERMUTATION_PARITY 9 // edges and faces of different parity
+#define IMPORT_BAD_ORIENTATION 10
+#define IMPORT_NUM_RESULTS 11
+
+// twist_sign[size][rank]: whether the twist is an odd permutation of the slots
+static uint8_t twist_sign[MAX_PIECE_STICKERS + 1][MAX_PIECE_TWISTS];
+// how a corner twist turns the three pairings {01|23}, {02|13}, {03|12}, mod 3
+static uint8_t corner_turn[MAX_PIECE_TWISTS];
+static int import_tables_ready;
+
+// the pairing (0 - 2, see corner_turn) that puts slots a and b together
+static int corner_pairing(int a, int b) {
+    if(a == 0 || b == 0) {
+        return a + b - 1;
+    }
+    return 5 - a - b;
+}
+
+void init_import_tables(void) {
+    if(import_tables_ready) {
+        return;
+    }
+    init_coord_tables();
+
+    for(int size = 2; size <= MAX_PIECE_STICKERS; size++) {
+        for(int r = 0; r < twist_count[size]; r++) {
+            int inversions = 0;
+            for(int i = 0; i < size; i++) {
+                for(int j = i + 1; j < size; j++) {
+                    inversions += twist_perm[size][r][i] > twist_perm[size][r][j];
+                }
+            }
+            twist_sign[size][r] = (uint8_t) (inversions & 1);
+        }
+    }
+
+    // an even twist rotates the pairings, and the pairing {01|23} goes to
+    // the one holding what slots 0 and 1 show. An odd one is counted as if
+    // slots 2 and 3 were swapped first, which changes nothing of that
+    for(int r = 0; r < twist_count[4]; r++) {
+        corner_turn[r] = (uint8_t) corner_pairing(twist_perm[4][r][0], twist_perm[4][r][1]);
+    }
+
+    import_tables_ready = 1;
+}
+
+// parity of a class's permutation of positions
+static int class_parity(const cubie_state *state, int piece_class) {
+    uint8_t seen[NUM_PIECES] = {0};
+    int parity = 0;
+
+    for(int first = class_first[piece_class]; first < class_first[piece_class] + class_pieces[piece_class]; first++) {
+        int length = 0;
+        for(int at = first; !seen[at]; at = state->pos[at]) {
+            seen[at] = 1;
+            length++;
+        }
+        if(length > 0) {
+            parity ^= (length - 1) & 1;
+        }
+    }
+    return parity;
+}
+
+/*
+ *  Function:    validate_cubies
+ *  ------------------------
+ *  Checks a piece state against the invariants of the twists (see the top of
+ *      the file); the pieces are taken to each show up once.
+ *
+ *  Return:
+ *      IMPORT_OK, or the first invariant it breaks
+ *
+ *  Runtime Complexity: O(NUM_PIECES)
+ */
+int validate_cubies(const cubie_state *state) {
+    int turns = 0, edge_signs = 0, flips = 0;
+
+    init_import_tables();
+    for(int piece = FIRST_CORNER; piece < FIRST_EDGE; piece++) {
+        int ori = state->ori[piece];
+        if(s4_parity[ori] != corner_twist_parity[piece - FIRST_CORNER][state->pos[piece] - FIRST_CORNER]) {
+            return IMPORT_CORNER_TWIST;
+        }
+        // corners of the other home sign are turned the other way round by every twist
+        turns += corner_twist_parity[piece - FIRST_CORNER][0] ? 3 - corner_turn[ori] : corner_turn[ori];
+    }
+    if(turns % 3 != 0) {
+        return IMPORT_CORNER_TWIST_SUM;
+    }
+    for(int piece = FIRST_EDGE; piece < FIRST_FACE; piece++) {
+        edge_signs ^= twist_sign[3][state->ori[piece]];
+    }
+    if(edge_signs) {
+        return IMPORT_EDGE_TWIST_SUM;
+    }
+    for(int piece = FIRST_FACE; piece < NUM_PIECES; piece++) {
+        flips ^= state->ori[piece];
+    }
+    if(flips) {
+        return IMPORT_FACE_FLIP_SUM;
+    }
+    if(class_parity(state, CORNER_CLASS)) {
+        return IMPORT_CORNER_PARITY;
+    }
+    if(class_parity(state, EDGE_CLASS) != class_parity(state, FACE_CLASS)) {
+        return IMPORT_PERMUTATION_PARITY;
+    }
+    return IMPORT_OK;
+}
+
+/*
+ *  Function:    import_stickers
+ *  ------------------------
+ *  Reads and checks a physical sticker array.
+ *
+ *  Input params:
+ *      const uint8_t *colors:  NUM_STICKERS color indices, physical frame
+ *      int orientation:        puzzle orientation to give the result
+ *      puzzle *p:              the puzzle, written only when the state is reachable
+ *
+ *  Return:
+ *      IMPORT_OK, or why the state was refused
+ */
+int import_stickers(const uint8_t *colors, int orientation, puzzle *p) {
+    uint8_t count[SIDES] = {0};
+    cubie_state state;
+
+    init_import_tables();
+    if(orientation < 0 || orientation >= num_orientations) {
+        return IMPORT_BAD_ORIENTATION;
+    }
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        if(colors[i] >= SIDES) {
+            return IMPORT_BAD_FORMAT;
+        }
+        count[colors[i]]++;
+    }
+    for(int color = 0; color < SIDES; color++) {
+        if(count[color] != CUBES) {
+            return IMPORT_BAD_COLOR_COUNT;
+        }
+    }
+    if(stickers_to_cubies(colors, orientation, &state) != 0) {
+        return IMPORT_BAD_PIECE;
+    }
+    int result = validate_cubies(&state);
+    if(result != IMPORT_OK) {
+        return result;
+    }
+
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        p->stickers[i] = colors[i];
+    }
+    p->orientation = orientation;
+    p->last_move_in_axis = NO_AXIS;
+    return IMPORT_OK;
+}
+
+// reads a text state (a digit per sticker, anything else skipped) and checks it like import_stickers
+int import_text(const char *text, int length, int orientation, puzzle *p) {
+    uint8_t colors[NUM_STICKERS];
+    int n = 0;
+
+    for(int i = 0; i < length; i++) {
+        if(text[i] >= '0' && text[i] <= '9') {
+            if(n == NUM_STICKERS) {
+                return IMPORT_BAD_FORMAT;
+            }
+            colors[n++] = (uint8_t) (text[i] - '0');
+        }
+    }
+    if(n != NUM_STICKERS) {
+        return IMPORT_BAD_FORMAT;
+    }
+    return import_stickers(colors, orientation, p);
+}
+
+// writes the text of a puzzle's stickers (NUM_STICKERS digits, no terminator)
+void export_text(const puzzle *p, char *text) {
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        text[i] = (char) ('0' + p->stickers[i]);
+    }
+}
+
+// reads a packed state (IMPORT_PACKED_BYTES) and checks it like import_stickers
+int import_packed(const uint8_t *packed, int orientation, puzzle *p) {
+    uint8_t colors[NUM_STICKERS];
+
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        int bit = i * 3;
+        int bits = packed[bit >> 3] | (bit + 3 > ((bit >> 3) + 1) * 8 ? packed[(bit >> 3) + 1] << 8 : 0);
+        colors[i] = (uint8_t) ((bits >> (bit & 7)) & 7);
+    }
+    return import_stickers(colors, orientation, p);
+}
+
+// packs a puzzle's stickers into IMPORT_PACKED_BYTES bytes
+void export_packed(const puzzle *p, uint8_t *packed) {
+    for(int i = 0; i < IMPORT_PACKED_BYTES; i++) {
+        packed[i] = 0;
+    }
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        int bit = i * 3;
+        int bits = p->stickers[i] << (bit & 7);
+        packed[bit >> 3] |= (uint8_t) bits;
+        if(bits >> 8) {
+            packed[(bit >> 3) + 1] |= (uint8_t) (bits >> 8);
+        }
+    }
+}
+
+#endif // IMPORT_C
@@ -0,0 +1,162 @@
+//
+// Solves as jobs that run a slice at a time: IDA* (ida.c) with the recursion
+// unrolled into an explicit stack, so job_step can stop after any number of
+// nodes and pick up where it left off. Whoever drives a job decides where it
+// runs: a thread of its own (job_threads.c), a Web Worker that steps it
+// between messages, or a few slices per frame. Between slices the caller can
+// read the progress (the bound, which no solution is shorter than, and the
+// nodes so far) and cancel.
+//
+// A job never touches the puzzle it was started from, so the front end can
+// go on moving it; it just cancels a job that no longer fits.
+//
+
+#ifndef JOB_C
+#define JOB_C
+
+#include "ida.c"
+
+#define JOB_IDLE 0
+#define JOB_RUNNING 1
+#define JOB_DONE 2
+#define JOB_FAILED 3        // no solution within max_depth
+#define JOB_CANCELLED 4
+
+typedef struct {
+    ida_search search;                          // only the heuristics and goal are used
+    cubie_state states[IDA_MAX_DEPTH + 1];
+    uint8_t path[IDA_MAX_DEPTH];
+    uint8_t next_move[IDA_MAX_DEPTH + 1];       // next twist to try at each depth
+    int depth;
+    int entered;                                // the node at depth still has to be looked at
+    int max_depth;
+    int orientation;                            // of the puzzle the job started from
+    uint8_t solution[IDA_MAX_DEPTH];
+    int solution_length;
+
+    // read by other threads while the job runs
+    volatile int status;
+    volatile int cancel;
+    volatile int bound;
+    volatile uint64_t nodes;
+} solve_job;
+
+/*
+ *  Function:    job_start
+ *  ------------------
+ *  Sets a job up to solve `start`; nothing is searched until job_step.
+ *
+ *  Input params:
+ *      solve_job *job:
+ *      const cubie_state *start:
+ *      const heuristic *heuristics:    as for init_ida_search
+ *      int count:
+ *      int max_depth:                  longest solution to look for
+ */
+void job_start(solve_job *job, const cubie_state *start, const heuristic *heuristics, int count, int max_depth) {
+    init_ida_search(&job->search, heuristics, count);
+    job->states[0] = *start;
+    job->depth = 0;
+    job->entered = 1;
+    job->max_depth = max_depth > IDA_MAX_DEPTH ? IDA_MAX_DEPTH : max_depth;
+    job->orientation = start->orientation;
+    job->solution_length = 0;
+    job->cancel = 0;
+    job->nodes = 0;
+    job->bound = ida_estimate(&job->search, start);
+    job->status = job->bound > job->max_depth ? JOB_FAILED : JOB_RUNNING;
+}
+
+// leaves the node at job->depth; past the root the next bound starts
+static void job_back_up(solve_job *job) {
+    if(job->depth > 0) {
+        job->depth--;
+        return;
+    }
+    if(job->bound + 1 > job->max_depth) {
+        job->status = JOB_FAILED;
+        return;
+    }
+    job->bound = job->bound + 1;
+    job->entered = 1;
+}
+
+/*
+ *  Function:    job_step
+ *  -----------------
+ *  Searches at most `budget` more nodes, in the same order as ida_solve.
+ *
+ *  Return:
+ *      the job's status: still JOB_RUNNING if the budget ran out first
+ */
+int job_step(solve_job *job, uint64_t budget) {
+    uint64_t nodes = job->nodes, limit = job->nodes + budget;
+
+    while(job->status == JOB_RUNNING) {
+        int depth = job->depth;
+
+        if(job->cancel) {
+            job->status = JOB_CANCELLED;
+            break;
+        }
+        if(job->entered) {
+            if(nodes == limit) {
+                break;
+            }
+            nodes++;
+            job->entered = 0;
+
+            int h = ida_estimate(&job->search, &job->states[depth]);
+            if(h == 0 && ida_at_goal(&job->search, &job->states[depth])) {
+                for(int i = 0; i < depth; i++) {
+                    job->solution[i] = job->path[i];
+                }
+                job->solution_length = depth;
+                job->status = JOB_DONE;
+                break;
+            }
+            if(depth + h > job->bound || depth == job->bound) {
+                job_back_up(job);
+                continue;
+            }
+            job->next_move[depth] = 0;
+        }
+
+        int last = depth > 0 ? job->path[depth - 1] : NO_TWIST;
+        int m = job->next_move[depth];
+        while(m < NUM_CELL_TWISTS && !ida_allows(last, m)) {
+            m++;
+        }
+        if(m == NUM_CELL_TWISTS) {
+            job_back_up(job);
+            continue;
+        }
+        job->next_move[depth] = (uint8_t) (m + 1);
+        job->path[depth] = (uint8_t) m;
+        job->states[depth + 1] = job->states[depth];
+        cubie_twist(&job->states[depth + 1], m);
+        job->depth = depth + 1;
+        job->entered = 1;
+        if((nodes & 1023) == 0) {
+            job->nodes = nodes;
+        }
+    }
+
+    job->nodes = nodes;
+    return job->status;
+}
+
+// asks a job to stop; it does at its next node, or its next job_step
+void job_cancel(solve_job *job) {
+    job->cancel = 1;
+}
+
+// the solution of a finished job as move ids from the orientation it started in, or -1
+int job_moves(const solve_job *job, uint8_t *moves) {
+    if(job->status != JOB_DONE) {
+        return -1;
+    }
+    return solution_to_moves(job->orientation, job->solution, job->solution_length, moves);
+}
+
+#endif // JOB_C
@@ -0,0 +1,64 @@
+//
+// Runs a job (job.c) on a thread of its own (native builds only, needs
+// pthreads). The caller's loop goes on as before and polls: progress can be
+// read at any time, results once job_thread_poll has said the job is over
+// (it joins the thread first, so everything the job wrote is visible).
+//
+
+#ifndef JOB_THREADS_C
+#define JOB_THREADS_C
+
+#include <pthread.h>
+
+#include "job.c"
+
+// nodes per job_step; a cancel waits at most this long
+#define JOB_SLICE 4096
+
+typedef struct {
+    solve_job *job;
+    pthread_t thread;
+    int running;
+} job_thread;
+
+static void *job_thread_main(void *arg) {
+    solve_job *job = arg;
+    while(job_step(job, JOB_SLICE) == JOB_RUNNING);
+    return NULL;
+}
+
+/*
+ *  Function:    job_thread_start
+ *  -------------------------
+ *  Runs a job, set up by job_start, on a new thread.
+ *
+ *  Return:
+ *      0, or -1 if no thread could be made
+ */
+int job_thread_start(job_thread *t, solve_job *job) {
+    t->job = job;
+    t->running = pthread_create(&t->thread, NULL, job_thread_main, job) == 0;
+    return t->running ? 0 : -1;
+}
+
+// the job's status; once it is not JOB_RUNNING the thread is gone and the results can be read
+int job_thread_poll(job_thread *t) {
+    int status = t->job->status;
+
+    if(status != JOB_RUNNING && t->running) {
+        pthread_join(t->thread, NULL);
+        t->running = 0;
+    }
+    return status;
+}
+
+// cancels the job and waits for its thread
+void job_thread_cancel(job_thread *t) {
+    job_cancel(t->job);
+    if(t->running) {
+        pthread_join(t->thread, NULL);
+        t->running = 0;
+    }
+}
+
+#endif // JOB_THREADS_C
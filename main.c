@@ -5,23 +5,24 @@
 //#include <stdio.h>
 #include "graphi.c"
 #include "math.c"
+#include "puzzle.c"
+#include "cubie.c"
+#include "scramble.c"
+#include "arena.c"
+#include "job.c"
+#include "hint.c"
+#include "alglib.c"
+#include "cycles.c"
+#include "import.c"
+#include "replay.c"
+#include "history.c"
+#include "notation.c"
 
 #define WIDTH 800
 #define HEIGHT 600
 
-#define CUBES 27
-#define SIDES 8
-#define NUM_CORNERS 8
-#define DIMENSION 3
 #define NUM_PLANES 6
 #define PLANE_CORNERS 4
-#define CORE_CUBE 0
-
-#define TO_REVERSE 1
-
-#define X_AXIS 0
-#define Y_AXIS 1
-#define Z_AXIS 2
 
 #define PI 3.14159265359
 #define RT_2 1.41421356237
@@ -33,6 +34,11 @@
 
 #define BG_COLOR BLACK
 
+// per-frame scratch of the default context. A frame takes about 48 KB
+#ifndef FRAME_SCRATCH_SIZE
+#define FRAME_SCRATCH_SIZE (64 * 1024)
+#endif
+
 // type as in what axis to rotate on
 // It will be clockwise when looking at cube from said direction
 
@@ -68,26 +74,11 @@
 
 #define MOVE_IN 26
 
-static uint32_t pixels[WIDTH * HEIGHT];
-
-float A, B, C;
-
-
-typedef struct {
-    float x, y, z;
-} Point_3D;
 
 typedef struct {
     float x, y;
 } Point_2D;
 
-typedef struct {
-    Point_3D points[NUM_CORNERS];
-    uint32_t color;
-    int selected;
-    int id;
-} cube;
-
 typedef struct {
     Point_3D pointA;
     Point_3D pointB;
@@ -102,19 +93,33 @@ typedef struct {
     uint32_t color;
 } plane;
 
-void compute_hidden(cube *cubes, int moving_in);
+// everything one rendered puzzle needs, so a process can host any number of them
+typedef struct {
+    puzzle state;
+    float A, B, C;          // view angles
+    int move_in_cube;       // cube being moved in, while that is animated
+    uint32_t *pixels;       // WIDTH * HEIGHT canvas
+    frame_arena scratch;    // reset at the start of every frame
+} render_context;
+
+static uint32_t pixels[WIDTH * HEIGHT];
+static uint8_t frame_scratch[FRAME_SCRATCH_SIZE];
+static render_context default_context;
 
 
-float calculateX(float i, float j, float k) {
+float calculateX(const render_context *ctx, float i, float j, float k) {
+    float A = ctx->A, B = ctx->B, C = ctx->C;
     return j * sin(A) * sin(B) * cos(C) - k * cos(A) * sin(B) * cos(C) +
            j * cos(A) * sin(C) + k * sin(A) * sin(C) + i * cos(B) * cos(C);
 }
-float calculateY(float i, float j, float k) {
+float calculateY(const render_context *ctx, float i, float j, float k) {
+    float A = ctx->A, B = ctx->B, C = ctx->C;
     return j * cos(A) * cos(C) + k * sin(A) * cos(C) -
            j * sin(A) * sin(B) * sin(C) + k * cos(A) * sin(B) * sin(C) -
            i * cos(B) * sin(C);
 }
-float calculateZ(float i, float j, float k) {
+float calculateZ(const render_context *ctx, float i, float j, float k) {
+    float A = ctx->A, B = ctx->B;
     return k * cos(A) * cos(B) - j * sin(A) * cos(B) + i * sin(B);
 }
 
@@ -577,37 +582,26 @@ void generateCorners(cube *cubes, float magnitude, float camera_distance, float
 }
 
 /*
- *  Function:    resetFaces
- *  -----------------------
- *  Sets all cubes to default, solved state
+ *  Function:    loadFaces
+ *  ----------------------
+ *  Fills the cubes for this frame with the colors of the stickers, as seen
+ *      through the current orientation (see view_sticker)
  *
  *  Input params:
- *      struct cube *cubes:     pointer to every cube that makes the
- *      int num_cubes:
- *
- *  Return:
- *      uint32_t *pixels: a 2D array containing the pixels to be drawn
- *          onto the screen.
+ *      puzzle *p:              puzzle to take the stickers from
+ *      struct cube *cubes:     pointer to every cube that makes the puzzle
+ *      int num_cubes:          number of cubes (CUBES * SIDES)
+ *      const uint32_t *colors: color of each side
  */
-void resetFaces(cube *cubes, int num_cubes, const uint32_t *colors) {
+void loadFaces(const puzzle *p, cube *cubes, int num_cubes, const uint32_t *colors) {
     int i;
-    int curr_color = -1;
     for(i=0; i<num_cubes; i++) {
-        if(i % 27 == 0) {
-            ++curr_color;
-        }
-
-        cubes[i].color = colors[curr_color];
+        cubes[i].color = colors[view_sticker(p, i)];
         cubes[i].selected = 0;
         cubes[i].id = i;
-
     }
 }
 
-void move_color(cube *dest, cube *src) {
-    dest->color = src->color;
-}
-
 /*
  *  Function:    copy_cube
  *  ----------------------
@@ -637,7 +631,9 @@ void copy_cube(cube *dest, cube *src) {
  *      is painted in the right order.
  *
  *  Input params:
+ *      render_context *ctx:    puzzle being drawn (for the view angles)
  *      struct cube* cubes:     array of cubes that the generated cubes will be stored in
+ *      float *sort_keys:       scratch for the depth of each cube (num_cubes of them)
  *      int num_cubes:          number of cubes in the Rubik's Cube
  *      float magnitude:        how long the dimensions of each cube is
  *      float camera_distance:  how far away the camera is from the cube
@@ -646,8 +642,9 @@ void copy_cube(cube *dest, cube *src) {
  *      Returns a translated array of cubes that takes into account the orientation and
  *          distance the cube with respect to the camera.
  */
-cube *generateCubes(cube *cubes, cube *translated_cubes, int num_cubes, float magnitude, float camera_distance,
-                    uint32_t *colors, int angle_percent, int type, int select, int move_in_cube) {
+cube *generateCubes(const render_context *ctx, cube *cubes, cube *translated_cubes, float *sort_keys, int num_cubes,
+                    float magnitude, float camera_distance, uint32_t *colors, int angle_percent, int type, int select,
+                    int move_in_cube) {
     int i, j, k;
 
     // copy
@@ -683,9 +680,6 @@ cube *generateCubes(cube *cubes, cube *translated_cubes, int num_cubes, float ma
     Point_3D offsetVector7 = {0, 0, 0};
 
     if(type == MOVE_IN) {
-
-        compute_hidden(cubes, move_in_cube);
-
         switch(move_in_cube) {
             case 1:
                 offsetVector7.y = -separation * 2;
@@ -763,28 +757,37 @@ cube *generateCubes(cube *cubes, cube *translated_cubes, int num_cubes, float ma
 
     for(i = 0; i < num_cubes; i++) {
         for(j = 0; j < NUM_CORNERS; j++) {
-            Point_3D new_point = {calculateX(translated_cubes[i].points[j].x, translated_cubes[i].points[j].y, translated_cubes[i].points[j].z - camera_distance),
-                                  calculateY(translated_cubes[i].points[j].x, translated_cubes[i].points[j].y, translated_cubes[i].points[j].z - camera_distance),
-                                  calculateZ(translated_cubes[i].points[j].x, translated_cubes[i].points[j].y, translated_cubes[i].points[j].z - camera_distance) + camera_distance};
+            Point_3D new_point = {calculateX(ctx, translated_cubes[i].points[j].x, translated_cubes[i].points[j].y, translated_cubes[i].points[j].z - camera_distance),
+                                  calculateY(ctx, translated_cubes[i].points[j].x, translated_cubes[i].points[j].y, translated_cubes[i].points[j].z - camera_distance),
+                                  calculateZ(ctx, translated_cubes[i].points[j].x, translated_cubes[i].points[j].y, translated_cubes[i].points[j].z - camera_distance) + camera_distance};
             translated_cubes[i].points[j] = new_point;
         }
     }
 
+    for(i = 0; i < num_cubes; i++) {
+        sort_keys[i] = get_cube_z_sum(translated_cubes[i].points);
+    }
+
     // selection sort
     int min;
     for(i = 0; i < num_cubes-1; i++) {
         min = i;
         for(j = i + 1; j < num_cubes; j++) {
-            if(get_cube_z_sum(translated_cubes[j].points) > get_cube_z_sum(translated_cubes[min].points)) {
+            if(sort_keys[j] > sort_keys[min]) {
                 min = j;
             }
         }
 
+        float temp_key;
         Point_3D temp;
         uint32_t temp_color;
         int temp_selected;
         int temp_id;
         if(min != i) {
+            temp_key = sort_keys[min];
+            sort_keys[min] = sort_keys[i];
+            sort_keys[i] = temp_key;
+
             for(j = 0; j < NUM_CORNERS; j++) {
                 temp = translated_cubes[min].points[j];
                 translated_cubes[min].points[j] = translated_cubes[i].points[j];
@@ -894,23 +897,23 @@ void draw_planes(uint32_t *canvas, int width, int height, plane *p, int count) {
 }
 
 
-void draw_outline(Point_2D *points) {
+void draw_outline(uint32_t *canvas, Point_2D *points) {
     int i;
 
     // 01 04 02 57 76 73 15 54 46
 
-    draw_line(pixels, WIDTH, HEIGHT, (int) points[0].x, (int) points[0].y, (int) points[1].x, (int) points[1].y, HOTPINK); // 01
-    draw_line(pixels, WIDTH, HEIGHT, (int) points[0].x, (int) points[0].y, (int) points[4].x, (int) points[4].y, HOTPINK); // 04
-    draw_line(pixels, WIDTH, HEIGHT, (int) points[0].x, (int) points[0].y, (int) points[2].x, (int) points[2].y, HOTPINK); // 02
-    draw_line(pixels, WIDTH, HEIGHT, (int) points[5].x, (int) points[5].y, (int) points[7].x, (int) points[7].y, HOTPINK); // 57
-    draw_line(pixels, WIDTH, HEIGHT, (int) points[7].x, (int) points[7].y, (int) points[6].x, (int) points[6].y, HOTPINK); // 76
-    draw_line(pixels, WIDTH, HEIGHT, (int) points[7].x, (int) points[7].y, (int) points[3].x, (int) points[3].y, HOTPINK); // 73
-    draw_line(pixels, WIDTH, HEIGHT, (int) points[1].x, (int) points[1].y, (int) points[5].x, (int) points[5].y, HOTPINK); // 15
-    draw_line(pixels, WIDTH, HEIGHT, (int) points[5].x, (int) points[5].y, (int) points[4].x, (int) points[4].y, HOTPINK); // 54
-    draw_line(pixels, WIDTH, HEIGHT, (int) points[4].x, (int) points[4].y, (int) points[6].x, (int) points[6].y, HOTPINK); // 46
-    draw_line(pixels, WIDTH, HEIGHT, (int) points[2].x, (int) points[2].y, (int) points[6].x, (int) points[6].y, HOTPINK); // 26
-    draw_line(pixels, WIDTH, HEIGHT, (int) points[3].x, (int) points[3].y, (int) points[2].x, (int) points[2].y, HOTPINK); // 34
-    draw_line(pixels, WIDTH, HEIGHT, (int) points[1].x, (int) points[1].y, (int) points[3].x, (int) points[3].y, HOTPINK); // 13
+    draw_line(canvas, WIDTH, HEIGHT, (int) points[0].x, (int) points[0].y, (int) points[1].x, (int) points[1].y, HOTPINK); // 01
+    draw_line(canvas, WIDTH, HEIGHT, (int) points[0].x, (int) points[0].y, (int) points[4].x, (int) points[4].y, HOTPINK); // 04
+    draw_line(canvas, WIDTH, HEIGHT, (int) points[0].x, (int) points[0].y, (int) points[2].x, (int) points[2].y, HOTPINK); // 02
+    draw_line(canvas, WIDTH, HEIGHT, (int) points[5].x, (int) points[5].y, (int) points[7].x, (int) points[7].y, HOTPINK); // 57
+    draw_line(canvas, WIDTH, HEIGHT, (int) points[7].x, (int) points[7].y, (int) points[6].x, (int) points[6].y, HOTPINK); // 76
+    draw_line(canvas, WIDTH, HEIGHT, (int) points[7].x, (int) points[7].y, (int) points[3].x, (int) points[3].y, HOTPINK); // 73
+    draw_line(canvas, WIDTH, HEIGHT, (int) points[1].x, (int) points[1].y, (int) points[5].x, (int) points[5].y, HOTPINK); // 15
+    draw_line(canvas, WIDTH, HEIGHT, (int) points[5].x, (int) points[5].y, (int) points[4].x, (int) points[4].y, HOTPINK); // 54
+    draw_line(canvas, WIDTH, HEIGHT, (int) points[4].x, (int) points[4].y, (int) points[6].x, (int) points[6].y, HOTPINK); // 46
+    draw_line(canvas, WIDTH, HEIGHT, (int) points[2].x, (int) points[2].y, (int) points[6].x, (int) points[6].y, HOTPINK); // 26
+    draw_line(canvas, WIDTH, HEIGHT, (int) points[3].x, (int) points[3].y, (int) points[2].x, (int) points[2].y, HOTPINK); // 34
+    draw_line(canvas, WIDTH, HEIGHT, (int) points[1].x, (int) points[1].y, (int) points[3].x, (int) points[3].y, HOTPINK); // 13
 }
 
 uint32_t shade(uint32_t color, int percent_change) {
@@ -964,7 +967,7 @@ double d_max(double a, double b) {
     return b;
 }
 
-void draw_cube(uint32_t *canvas, int width, int height, cube *curr_cube, Point_3D *points, uint32_t color,
+void draw_cube(uint32_t *canvas, int width, int height, plane *planes, cube *curr_cube, Point_3D *points, uint32_t color,
                Point_3D camera, int mouseX, int mouseY, int cube_index, int num_cubes, int type, int angle_percent) {
     if((type != MOVE_IN || angle_percent == 0) && curr_cube->id >= num_cubes - CUBES) {
         return;
@@ -975,20 +978,17 @@ void draw_cube(uint32_t *canvas, int width, int height, cube *curr_cube, Point_3
     convert_3D_to_2D(c_2D, width, height, points, camera);
 
 
-    plane p0123 = {points[0], points[1], points[2], points[3],
-                          c_2D[0], c_2D[1], c_2D[2], c_2D[3], BG_COLOR};
-    plane p5140 = {points[5], points[1], points[4], points[0],
-                          c_2D[5], c_2D[1], c_2D[4], c_2D[0], BG_COLOR};
-    plane p4062 = {points[4], points[0], points[6], points[2],
-                          c_2D[4], c_2D[0], c_2D[6], c_2D[2],BG_COLOR};
-    plane p5476 = {points[5], points[4], points[7], points[6],
-                          c_2D[5], c_2D[4], c_2D[7], c_2D[6],BG_COLOR};
-    plane p5173 = {points[5], points[1], points[7], points[3],
-                          c_2D[5], c_2D[1], c_2D[7], c_2D[3],BG_COLOR};
-    plane p7362 = {points[7], points[3], points[6], points[2],
-                          c_2D[7], c_2D[3], c_2D[6], c_2D[2],BG_COLOR};
+    // corners of each of the 6 planes, filled into the caller's scratch
+    static const uint8_t plane_corners[NUM_PLANES][PLANE_CORNERS] = {
+            {0, 1, 2, 3}, {5, 1, 4, 0}, {4, 0, 6, 2}, {5, 4, 7, 6}, {5, 1, 7, 3}, {7, 3, 6, 2}
+    };
 
-    plane planes[NUM_PLANES] = {p0123, p5140, p4062, p5476, p5173, p7362};
+    for(int i = 0; i < NUM_PLANES; i++) {
+        const uint8_t *c = plane_corners[i];
+        plane p = {points[c[0]], points[c[1]], points[c[2]], points[c[3]],
+                   c_2D[c[0]], c_2D[c[1]], c_2D[c[2]], c_2D[c[3]], BG_COLOR};
+        planes[i] = p;
+    }
 
 //    if(mouseX != -1 && mouseY != -1) set_hovered(curr_cube, planes, mouseX, mouseY);
 
@@ -1033,640 +1033,35 @@ void f_modulo(float *x, float y) {
     *x = *x - y * (float) (int) (*x/y);
 }
 
-void process_key(int input) {
+void process_key(render_context *ctx, int input) {
     float magnitude = (float) 0.01;
 
     switch(input) {
         // w
-        case 1: A += magnitude;
+        case 1: ctx->A += magnitude;
         // a
-        case 2: B -= magnitude;
+        case 2: ctx->B -= magnitude;
         // s
-        case 3: A -= magnitude;
+        case 3: ctx->A -= magnitude;
         // d
-        case 4: B += magnitude;
+        case 4: ctx->B += magnitude;
 
         // j
-        case 5: C += magnitude;
-
-        case 6: C -= magnitude;
-    }
-
-    f_modulo(&A, 2 * (float) PI);
-    f_modulo(&B, 2 * (float) PI);
-    f_modulo(&C, 2 * (float) PI);
-
-
-}
-
-
-
-
-
-void rotate_center(cube *cubes, int select, int order, int **anchors) {
-
-    // order is 4 digit: 3210
-    int side_1 = (order / 1000) % 10;
-    int side_2 = (order / 100) % 10;
-    int side_3 = (order / 10) % 10;
-    int side_4 = order % 10;
-
-    int i, j, count;
-    cube temp_cubes[DIMENSION * DIMENSION];
-
-    count = 0;
-    for(i = 0; i < DIMENSION; i++) {
-        for(j = 0; j < DIMENSION; j++) {
-            move_color(&temp_cubes[count], &cubes[anchors[side_1][i] + anchors[side_1][3] * j]);
-            count++;
-        }
-    }
-
-
-    for(i = 0; i < DIMENSION; i++) {
-        for(j = 0; j < DIMENSION; j++) {
-            move_color(&cubes[anchors[side_1][i] + anchors[side_1][3] * j], &cubes[anchors[side_2][i] + anchors[side_2][3] * j]);
-        }
-    }
-
-
-    for(i = 0; i < DIMENSION; i++) {
-        for(j = 0; j < DIMENSION; j++) {
-            move_color(&cubes[anchors[side_2][i] + anchors[side_2][3] * j], &cubes[anchors[side_3][i] + anchors[side_3][3] * j]);
-        }
-    }
-
-    for(i = 0; i < DIMENSION; i++) {
-        for(j = 0; j < DIMENSION; j++) {
-            move_color(&cubes[anchors[side_3][i] + anchors[side_3][3] * j], &cubes[anchors[side_4][i] + anchors[side_4][3] * j]);
-        }
-    }
-
-    count = 0;
-    for(i = 0; i < DIMENSION; i++) {
-        for(j = 0; j < DIMENSION; j++) {
-            move_color(&cubes[anchors[side_4][i] + anchors[side_4][3] * j], &temp_cubes[count]);
-            count++;
-        }
-    }
-}
-
-void flip(int *to_reverse) {
-    // swap indexes 0 and 3; 1 and 2
-    int temp;
-
-    temp = to_reverse[0];
-    to_reverse[0] = to_reverse[3];
-    to_reverse[3] = temp;
-
-    temp = to_reverse[1];
-    to_reverse[1] = to_reverse[2];
-    to_reverse[2] = temp;
-}
-
-void rotate_self(cube *cubes, int cube_num, int corner_anchors[4], int edge_anchors[4], int increment, int reverse) {
-    // rotate corners
-    int i, j, count;
-    cube temp_cubes[DIMENSION];
-
-    int anchor_corners[5] = {cube_num * CUBES + corner_anchors[0], cube_num * CUBES + corner_anchors[1],
-                             cube_num * CUBES + corner_anchors[2], cube_num * CUBES + corner_anchors[3],
-                             increment};
-
-    int anchor_edges[5] = {cube_num * CUBES + edge_anchors[0], cube_num * CUBES + edge_anchors[1],
-                           cube_num * CUBES + edge_anchors[2], cube_num * CUBES + edge_anchors[3],
-                           increment};
-
-    if(reverse) {
-        flip(anchor_corners);
-        flip(anchor_edges);
-    }
-
-    count = 0;
-    for(i = 0; i < DIMENSION; i++) {
-        move_color(&temp_cubes[count], &cubes[anchor_corners[0] + anchor_corners[4] * i]);
-        count++;
-    }
-    for(i = 0; i < DIMENSION; i++) {
-        move_color(&cubes[anchor_corners[0] + anchor_corners[4] * i], &cubes[anchor_corners[1] + anchor_corners[4] * i]);
-    }
-    for(i = 0; i < DIMENSION; i++) {
-        move_color(&cubes[anchor_corners[1] + anchor_corners[4] * i], &cubes[anchor_corners[2] + anchor_corners[4] * i]);
-    }
-    for(i = 0; i < DIMENSION; i++) {
-        move_color(&cubes[anchor_corners[2] + anchor_corners[4] * i], &cubes[anchor_corners[3] + anchor_corners[4] * i]);
-    }
-    count = 0;
-    for(i = 0; i < DIMENSION; i++) {
-        move_color(&cubes[anchor_corners[3] + anchor_corners[4] * i], &temp_cubes[count]);
-        count++;
-    }
-
-
-    // rotate edges
-    count = 0;
-    for(i = 0; i < DIMENSION; i++) {
-        move_color(&temp_cubes[count], &cubes[anchor_edges[0] + anchor_edges[4] * i]);
-        count++;
-    }
-    for(i = 0; i < DIMENSION; i++) {
-        move_color(&cubes[anchor_edges[0] + anchor_edges[4] * i], &cubes[anchor_edges[1] + anchor_edges[4] * i]);
-    }
-    for(i = 0; i < DIMENSION; i++) {
-        move_color(&cubes[anchor_edges[1] + anchor_edges[4] * i], &cubes[anchor_edges[2] + anchor_edges[4] * i]);
-    }
-    for(i = 0; i < DIMENSION; i++) {
-        move_color(&cubes[anchor_edges[2] + anchor_edges[4] * i], &cubes[anchor_edges[3] + anchor_edges[4] * i]);
-    }
-    count = 0;
-    for(i = 0; i < DIMENSION; i++) {
-        move_color(&cubes[anchor_edges[3] + anchor_edges[4] * i], &temp_cubes[count]);
-        count++;
-    }
-
-}
-
-int last_move_in_axis = NO_TYPE;
-
-void compute_hidden(cube *cubes, int moving_in) {
-
-    if(last_move_in_axis == NO_TYPE) {
-        return;
-    }
-
-    int reverse;
-
-    int corner_anchors_x[4] = {0, 6, 8, 2};
-    int edge_anchors_x[4] = {3, 7, 5, 1};
-    int increment_x = 9;
-
-    int corner_anchors_y[4] = {0, 2, 20, 18};
-    int edge_anchors_y[4] = {1, 11, 19, 9};
-    int increment_y = 3;
-
-    int corner_anchors_z[4] = {18, 24, 6, 0};
-    int edge_anchors_z[4] = {9, 21, 15, 3};
-    int increment_z = 1;
-
-    if(moving_in == 1 || moving_in == 6) {
-        reverse = (moving_in == 1);
-
-        if (Y_AXIS != last_move_in_axis) {
-            if (last_move_in_axis == X_AXIS) {
-                rotate_self(cubes, 7, corner_anchors_z, edge_anchors_z, increment_z, reverse);
-                rotate_self(cubes, 7, corner_anchors_z, edge_anchors_z, increment_z, reverse);
-            } else if (last_move_in_axis == Z_AXIS) {
-                rotate_self(cubes, 7, corner_anchors_x, edge_anchors_x, increment_x, reverse);
-                rotate_self(cubes, 7, corner_anchors_x, edge_anchors_x, increment_x, reverse);
-            }
-            last_move_in_axis = Y_AXIS;
-        }
-    }
-
-    if(moving_in == 2 || moving_in == 4) {
-        reverse = (moving_in == 2);
-
-        if (Z_AXIS != last_move_in_axis) {
-            if(last_move_in_axis == X_AXIS) {
-                rotate_self(cubes, 7, corner_anchors_y, edge_anchors_y, increment_y, reverse);
-                rotate_self(cubes, 7, corner_anchors_y, edge_anchors_y, increment_y, reverse);
-            } else if(last_move_in_axis == Y_AXIS) {
-                rotate_self(cubes, 7, corner_anchors_x, edge_anchors_x, increment_x, reverse);
-                rotate_self(cubes, 7, corner_anchors_x, edge_anchors_x, increment_x, reverse);
-            }
-            last_move_in_axis = Z_AXIS;
-        }
-    }
-
-    if(moving_in == 3 || moving_in == 5) {
-        reverse = (moving_in == 3);
-
-        if (X_AXIS != last_move_in_axis) {
-            if(last_move_in_axis == Y_AXIS) {
-                rotate_self(cubes, 7, corner_anchors_z, edge_anchors_z, increment_z, reverse);
-                rotate_self(cubes, 7, corner_anchors_z, edge_anchors_z, increment_z, reverse);
-            } else if(last_move_in_axis == Z_AXIS) {
-                rotate_self(cubes, 7, corner_anchors_y, edge_anchors_y, increment_y, reverse);
-                rotate_self(cubes, 7, corner_anchors_y, edge_anchors_y, increment_y, reverse);
-            }
-            last_move_in_axis = X_AXIS;
-        }
-    }
-
-
-
-}
-
-void change_center(cube *cubes, const int *cube_order) {
-
-    int moving_in = cube_order[0];
-
-    int corner_anchors_x[4] = {0, 6, 8, 2};
-    int edge_anchors_x[4] = {3, 7, 5, 1};
-    int increment_x = 9;
-
-    int corner_anchors_y[4] = {0, 2, 20, 18};
-    int edge_anchors_y[4] = {1, 11, 19, 9};
-    int increment_y = 3;
-
-    int corner_anchors_z[4] = {18, 24, 6, 0};
-    int edge_anchors_z[4] = {9, 21, 15, 3};
-    int increment_z = 1;
-
-    int reverse;
-
-
-    // i think the 7th cube also rotates here.. need to figure out what axis and direction
-    if(moving_in == 1 || moving_in == 6) {
-        if(last_move_in_axis == NO_TYPE) {
-            last_move_in_axis = Y_AXIS;
-        }
-
-        reverse = (moving_in == 1);
-
-        rotate_self(cubes, 2, corner_anchors_x, edge_anchors_x, increment_x, reverse);
-        rotate_self(cubes, 4, corner_anchors_x, edge_anchors_x, increment_x, !reverse);
-
-        rotate_self(cubes, 3, corner_anchors_z, edge_anchors_z, increment_z, !reverse);
-        rotate_self(cubes, 5, corner_anchors_z, edge_anchors_z, increment_z, reverse);
-    }
-
-    if(moving_in == 2 || moving_in == 4) {
-        if(last_move_in_axis == NO_TYPE) {
-            last_move_in_axis = Z_AXIS;
-        }
-
-        reverse = (moving_in == 2);
+        case 5: ctx->C += magnitude;
 
-        rotate_self(cubes, 1, corner_anchors_x, edge_anchors_x, increment_x, !reverse);
-        rotate_self(cubes, 6, corner_anchors_x, edge_anchors_x, increment_x, reverse);
-
-        rotate_self(cubes, 3, corner_anchors_y, edge_anchors_y, increment_y, !reverse);
-        rotate_self(cubes, 5, corner_anchors_y, edge_anchors_y, increment_y, reverse);
+        case 6: ctx->C -= magnitude;
     }
 
-    if(moving_in == 3 || moving_in == 5) {
-        if(last_move_in_axis == NO_TYPE) {
-            last_move_in_axis = X_AXIS;
-        }
-
-
-        reverse = (moving_in == 3);
+    f_modulo(&ctx->A, 2 * (float) PI);
+    f_modulo(&ctx->B, 2 * (float) PI);
+    f_modulo(&ctx->C, 2 * (float) PI);
 
-        rotate_self(cubes, 1, corner_anchors_z, edge_anchors_z, increment_z, reverse);
-        rotate_self(cubes, 6, corner_anchors_z, edge_anchors_z, increment_z, !reverse);
-
-        rotate_self(cubes, 2, corner_anchors_y, edge_anchors_y, increment_y, reverse);
-        rotate_self(cubes, 4, corner_anchors_y, edge_anchors_y, increment_y, !reverse);
-    }
-
-    int i;
-    cube temp_cubes[CUBES];
-    int count = 0;
-
-
-    for(i = cube_order[0] * CUBES; i < (cube_order[0] + 1) * CUBES; i++) {
-        move_color(&temp_cubes[count], &cubes[i]);
-        count++;
-    }
-
-    count = cube_order[0] * CUBES;
-    for(i = cube_order[1] * CUBES; i < (cube_order[1] + 1) * CUBES; i++) {
-        move_color(&cubes[count], &cubes[i]);
-        count++;
-    }
-
-    count = cube_order[1] * CUBES;
-    for(i = cube_order[2] * CUBES; i < (cube_order[2] + 1) * CUBES; i++) {
-        move_color(&cubes[count], &cubes[i]);
-        count++;
-    }
-
-    count = cube_order[2] * CUBES;
-    for(i = cube_order[3] * CUBES; i < (cube_order[3] + 1) * CUBES; i++) {
-        move_color(&cubes[count], &cubes[i]);
-        count++;
-    }
-
-    count = 0;
-    for(i = cube_order[3] * CUBES; i < (cube_order[3] + 1) * CUBES; i++) {
-        move_color(&cubes[i], &temp_cubes[count]);
-        count++;
-    }
 
 }
 
-void rotate_sandwich(cube *cubes, int bread, int anchor_1[8], int anchor_2[8], int reversed) {
-    if(reversed) {
-        flip(anchor_1);
-        flip(&anchor_1[4]);
-        flip(anchor_2);
-        flip(&anchor_2[4]);
-    }
-
-    cube temp_cube;
-
-    move_color(&temp_cube, &cubes[anchor_1[0]]);
-    move_color(&cubes[anchor_1[0]], &cubes[anchor_1[1]]);
-    move_color(&cubes[anchor_1[1]], &cubes[anchor_1[2]]);
-    move_color(&cubes[anchor_1[2]], &cubes[anchor_1[3]]);
-    move_color(&cubes[anchor_1[3]], &temp_cube);
 
-    move_color(&temp_cube, &cubes[anchor_1[4]]);
-    move_color(&cubes[anchor_1[4]], &cubes[anchor_1[5]]);
-    move_color(&cubes[anchor_1[5]], &cubes[anchor_1[6]]);
-    move_color(&cubes[anchor_1[6]], &cubes[anchor_1[7]]);
-    move_color(&cubes[anchor_1[7]], &temp_cube);
 
 
-    move_color(&temp_cube, &cubes[anchor_2[0]]);
-    move_color(&cubes[anchor_2[0]], &cubes[anchor_2[1]]);
-    move_color(&cubes[anchor_2[1]], &cubes[anchor_2[2]]);
-    move_color(&cubes[anchor_2[2]], &cubes[anchor_2[3]]);
-    move_color(&cubes[anchor_2[3]], &temp_cube);
-
-    move_color(&temp_cube, &cubes[anchor_2[4]]);
-    move_color(&cubes[anchor_2[4]], &cubes[anchor_2[5]]);
-    move_color(&cubes[anchor_2[5]], &cubes[anchor_2[6]]);
-    move_color(&cubes[anchor_2[6]], &cubes[anchor_2[7]]);
-    move_color(&cubes[anchor_2[7]], &temp_cube);
-}
-
-void rotate_edge(cube *cubes, int select, const int anchor_a[4], const int anchor_b[4]) {
-    
-    int i, j;
-    cube temp_cube;
-
-    for(i=0; i < DIMENSION; i++) {
-        for(j=0; j < DIMENSION; j++) {
-            move_color(&temp_cube, &cubes[anchor_a[i] + anchor_a[3] * j]);
-            move_color(&cubes[anchor_a[i] + anchor_a[3] * j], &cubes[anchor_b[i] + anchor_b[3] * j]);
-            move_color(&cubes[anchor_b[i] + anchor_b[3] * j], &temp_cube);
-        }
-    }
-
-}
-
-void rotate_center_piece(cube *cubes, int select) {
-    int order;
-    int bread;
-
-    // for rotate self
-    int corner_anchors_x[4] = {0, 6, 8, 2};
-    int edge_anchors_x[4] = {3, 7, 5, 1};
-    int increment_x = 9;
-
-    int corner_anchors_y[4] = {0, 2, 20, 18};
-    int edge_anchors_y[4] = {1, 11, 19, 9};
-    int increment_y = 3;
-
-    int corner_anchors_z[4] = {18, 24, 6, 0};
-    int edge_anchors_z[4] = {9, 21, 15, 3};
-    int increment_z = 1;
-
-    // for sandwich turns
-    int sandwich_1[8] = {1 * CUBES + 6, 1 * CUBES + 8, 1 * CUBES + 26, 1 * CUBES + 24, 1 * CUBES + 7, 1 * CUBES + 17, 1 * CUBES + 25, 1 * CUBES + 15};
-    int sandwich_2[8] = {2 * CUBES + 6, 2 * CUBES + 0, 2 * CUBES + 18, 2 * CUBES + 24, 2 * CUBES + 3, 2 * CUBES + 9, 2 * CUBES + 21, 2 * CUBES + 15};
-    int sandwich_3[8] = {3 * CUBES + 2, 3 * CUBES + 0, 3 * CUBES + 6, 3 * CUBES + 8, 3 * CUBES + 5, 3 * CUBES + 1, 3 * CUBES + 3, 3 * CUBES + 7};
-    int sandwich_4[8] = {4 * CUBES + 2, 4 * CUBES + 20, 4 * CUBES + 26, 4 * CUBES + 8, 4 * CUBES + 5, 4 * CUBES + 11, 4 * CUBES + 23, 4 * CUBES + 17};
-    int sandwich_5[8] = {5 * CUBES + 20, 5 * CUBES + 18, 5 * CUBES + 24, 5 * CUBES + 26, 5 * CUBES + 23, 5 * CUBES + 19, 5 * CUBES + 21, 5 * CUBES + 25};
-    int sandwich_6[8] = {6 * CUBES + 0, 6 * CUBES + 2, 6 * CUBES + 20, 6 * CUBES + 18, 6 * CUBES + 1, 6 * CUBES + 11, 6 * CUBES + 19, 6 * CUBES + 9};
-
-
-
-    switch(select) {
-        case 4:
-            // about x
-            order = 1462;
-            bread = 35;
-
-            int anchor_1_x[4] = {1 * CUBES + 8, 1 * CUBES + 7, 1 * CUBES + 6, 9};
-            int anchor_4_x[4] = {4 * CUBES + 2, 4 * CUBES + 5, 4 * CUBES + 8, 9};
-            int anchor_6_x[4] = {6 * CUBES + 0, 6 * CUBES + 1, 6 * CUBES + 2, 9};
-            int anchor_2_x[4] = {2 * CUBES + 6, 2 * CUBES + 3, 2 * CUBES + 0, 9};
-            int *anchors_x[7] = {NULL, anchor_1_x, anchor_2_x, NULL, anchor_4_x, NULL, anchor_6_x};
-
-            rotate_center(cubes, select, order, anchors_x);
-            rotate_sandwich(cubes, bread, sandwich_3, sandwich_5, !TO_REVERSE);
-            rotate_self(cubes, 0, corner_anchors_x, edge_anchors_x, increment_x, !TO_REVERSE); // correct
-
-            break;
-        case 10:
-            // about y
-            order = 5234;
-            bread = 35;
-
-            int anchor_5_y[4] = {5 * CUBES + 18, 5 * CUBES + 19, 5 * CUBES + 20, 3};
-            int anchor_2_y[4] = {2 * CUBES + 0, 2 * CUBES + 9, 2 * CUBES + 18, 3};
-            int anchor_3_y[4] = {3 * CUBES + 2, 3 * CUBES + 1, 3 * CUBES + 0, 3};
-            int anchor_4_y[4] = {4 * CUBES + 20, 4 * CUBES + 11, 4 * CUBES + 2, 3};
-            int *anchors_y[7] = {NULL, NULL, anchor_2_y, anchor_3_y, anchor_4_y, anchor_5_y, NULL};
-
-            rotate_center(cubes, select, order, anchors_y);
-            rotate_sandwich(cubes, bread, sandwich_1, sandwich_6, !TO_REVERSE);
-            rotate_self(cubes, 0, corner_anchors_y, edge_anchors_y, increment_y, !TO_REVERSE); // correct
-
-            break;
-        case 12:
-            // about z
-            order = 5136;
-            bread = 0;
-
-            int anchor_5_z[4] = {5 * CUBES + 26, 5 * CUBES + 23, 5 * CUBES + 20, -1};
-            int anchor_1_z[4] = {1 * CUBES + 8, 1 * CUBES + 17, 1 * CUBES + 26, -1};
-            int anchor_3_z[4] = {3 * CUBES + 2, 3 * CUBES + 5, 3 * CUBES + 8, -1};
-            int anchor_6_z[4] = {6 * CUBES + 20, 6 * CUBES + 11, 6 * CUBES + 2, -1};
-            int *anchors_z[7] = {NULL, anchor_1_z, NULL, anchor_3_z, NULL, anchor_5_z, anchor_6_z};
-
-            rotate_center(cubes, select, order, anchors_z);
-
-            rotate_sandwich(cubes, bread, sandwich_2, sandwich_4, !TO_REVERSE);
-
-            rotate_self(cubes, 0, corner_anchors_z, edge_anchors_z, increment_z, !TO_REVERSE); // correct
-            break;
-        case 14:
-            // about z
-            order = 6315;
-
-            int anchor_5_z_[4] = {5 * CUBES + 26, 5 * CUBES + 23, 5 * CUBES + 20, -1};
-            int anchor_1_z_[4] = {1 * CUBES + 8, 1 * CUBES + 17, 1 * CUBES + 26, -1};
-            int anchor_3_z_[4] = {3 * CUBES + 2, 3 * CUBES + 5, 3 * CUBES + 8, -1};
-            int anchor_6_z_[4] = {6 * CUBES + 20, 6 * CUBES + 11, 6 * CUBES + 2, -1};
-            int *anchors_z_[7] = {NULL, anchor_1_z_, NULL, anchor_3_z_, NULL, anchor_5_z_, anchor_6_z_};
-
-            rotate_center(cubes, select, order, anchors_z_);
-
-            rotate_sandwich(cubes, bread, sandwich_2, sandwich_4, TO_REVERSE);
-
-            rotate_self(cubes, 0, corner_anchors_z, edge_anchors_z, increment_z, TO_REVERSE); // reverse
-            break;
-        case 16:
-            // about y
-            order = 4325;
-
-            int anchor_5_y_[4] = {5 * CUBES + 18, 5 * CUBES + 19, 5 * CUBES + 20, 3};
-            int anchor_2_y_[4] = {2 * CUBES + 0, 2 * CUBES + 9, 2 * CUBES + 18, 3};
-            int anchor_3_y_[4] = {3 * CUBES + 2, 3 * CUBES + 1, 3 * CUBES + 0, 3};
-            int anchor_4_y_[4] = {4 * CUBES + 20, 4 * CUBES + 11, 4 * CUBES + 2, 3};
-            int *anchors_y_[7] = {NULL, NULL, anchor_2_y_, anchor_3_y_, anchor_4_y_, anchor_5_y_, NULL};
-
-            rotate_center(cubes, select, order, anchors_y_);
-
-            rotate_sandwich(cubes, bread, sandwich_1, sandwich_6, TO_REVERSE);
-
-            rotate_self(cubes, 0, corner_anchors_y, edge_anchors_y, increment_y, TO_REVERSE); // reverse
-            break;
-        case 22:
-            // about x
-            order = 2641;
-
-            int anchor_1_x_[4] = {1 * CUBES + 8, 1 * CUBES + 7, 1 * CUBES + 6, 9};
-            int anchor_4_x_[4] = {4 * CUBES + 2, 4 * CUBES + 5, 4 * CUBES + 8, 9};
-            int anchor_6_x_[4] = {6 * CUBES + 0, 6 * CUBES + 1, 6 * CUBES + 2, 9};
-            int anchor_2_x_[4] = {2 * CUBES + 6, 2 * CUBES + 3, 2 * CUBES + 0, 9};
-            int *anchors_x_[7] = {NULL, anchor_1_x_, anchor_2_x_, NULL, anchor_4_x_, NULL, anchor_6_x_};
-
-            rotate_center(cubes, select, order, anchors_x_);
-
-            rotate_sandwich(cubes, bread, sandwich_3, sandwich_5, TO_REVERSE);
-
-            rotate_self(cubes, 0, corner_anchors_x, edge_anchors_x, increment_x, TO_REVERSE); // reverse
-            break;
-        default:
-            order = 0;
-    }
-}
-
-
-
-void rotate(cube *cubes, int select) {
-    // 3 types: corner, edge, center. and core
-
-    // for rotate self
-    int corner_anchors_x[4] = {0, 6, 8, 2};
-    int edge_anchors_x[4] = {3, 7, 5, 1};
-    int increment_x = 9;
-
-    int corner_anchors_y[4] = {0, 2, 20, 18};
-    int edge_anchors_y[4] = {1, 11, 19, 9};
-    int increment_y = 3;
-
-    int corner_anchors_z[4] = {18, 24, 6, 0};
-    int edge_anchors_z[4] = {9, 21, 15, 3};
-    int increment_z = 1;
-
-
-    // core
-    if(select == 13) {
-        return;
-    }
-    int reverse = 1;
-    // edge
-    if(select % 2 == 1) {
-        switch(select) {
-            case 3:
-            case 23:
-                rotate_center_piece(cubes, 10);
-                rotate_center_piece(cubes, 12);
-                rotate_center_piece(cubes, 12);
-                break;
-
-            case 5:
-            case 21:
-                rotate_center_piece(cubes, 10);
-                rotate_center_piece(cubes, 4);
-                rotate_center_piece(cubes, 4);
-                break;
-
-            case 9:
-            case 17:
-                rotate_center_piece(cubes, 4);
-                rotate_center_piece(cubes, 10);
-                rotate_center_piece(cubes, 10);
-                break;
-
-            case 11:
-            case 15:
-                rotate_center_piece(cubes, 4);
-                rotate_center_piece(cubes, 12);
-                rotate_center_piece(cubes, 12);
-                break;
-
-            case 1:
-            case 25:
-                rotate_center_piece(cubes, 12);
-                rotate_center_piece(cubes, 4);
-                rotate_center_piece(cubes, 4);
-
-                break;
-
-            case 7:
-            case 19:
-                rotate_center_piece(cubes, 12);
-                rotate_center_piece(cubes, 10);
-                rotate_center_piece(cubes, 10);
-
-                break;
-
-            default:
-                break;
-        }
-    }
-    // center
-    else if(select == 4 || select == 10 || select == 12 || select == 14 || select == 16 || select == 22) {
-        rotate_center_piece(cubes, select);
-    }
-    else {
-        switch(select) {
-            case 0:
-                rotate_center_piece(cubes, 12);
-                rotate_center_piece(cubes, 4);
-
-                break;
-
-            case 2:
-                rotate_center_piece(cubes, 10);
-                rotate_center_piece(cubes, 4);
-
-                break;
-
-            case 6:
-                rotate_center_piece(cubes, 12);
-                rotate_center_piece(cubes, 16);
-
-                break;
-
-            case 8:
-                rotate_center_piece(cubes, 16);
-                rotate_center_piece(cubes, 14);
-                break;
-
-            case 18:
-                rotate_center_piece(cubes, 10);
-                rotate_center_piece(cubes, 22);
-                break;
-
-            case 20:
-                rotate_center_piece(cubes, 14);
-                rotate_center_piece(cubes, 22);
-                break;
-
-            case 24:
-                rotate_center_piece(cubes, 22);
-                rotate_center_piece(cubes, 16);
-                break;
-
-            case 26:
-                rotate_center_piece(cubes, 22);
-                rotate_center_piece(cubes, 14);
-                break;
-
-            default:
-                break;
-        }
-    }
-
-}
 
 int select_current_type(int select) {
     switch(select) {
@@ -1760,92 +1155,98 @@ int select_current_type(int select) {
 
 
 
-int move_in_cube;
+/*
+ *  Function:    init_render_context
+ *  ----------------------------
+ *  Sets up a context in caller provided memory (render_context_size() bytes,
+ *      so the host of the wasm module can place as many as it wants) with a
+ *      solved puzzle.
+ *
+ *  Input params:
+ *      render_context *ctx:    context to set up
+ *      uint32_t *canvas:       WIDTH * HEIGHT pixels the context draws into
+ *      void *scratch:          memory for per-frame buffers
+ *      int scratch_size:       bytes of scratch, FRAME_SCRATCH_SIZE is plenty
+ */
+void init_render_context(render_context *ctx, uint32_t *canvas, void *scratch, int scratch_size) {
+    reset_puzzle(&ctx->state);
+    ctx->A = 0;
+    ctx->B = 0;
+    ctx->C = 0;
+    ctx->move_in_cube = 0;
+    ctx->pixels = canvas;
+    arena_init(&ctx->scratch, scratch, (size_t) scratch_size);
+}
 
-uint32_t *render(int dt, int keyboard_input, float a, float b, float c, int x, int y, int select, int to_rotate,
-                 int angle_percent, int type) {
+int render_context_size(void) {
+    return sizeof(render_context);
+}
+
+// most scratch bytes a frame of this context has needed so far
+int frame_scratch_high_water(const render_context *ctx) {
+    return (int) ctx->scratch.high_water;
+}
+
+// scratch allocations refused so far (a frame that runs out is left blank)
+int frame_scratch_failures(const render_context *ctx) {
+    return ctx->scratch.failed;
+}
+
+uint32_t *render_frame(render_context *ctx, int dt, int keyboard_input, float a, float b, float c, int x, int y,
+                       int select, int to_rotate, int angle_percent, int type) {
 
-//    process_key(keyboard_input);
+//    process_key(ctx, keyboard_input);
 //    found_hovered = 0;
-    A = a;
-    B = b;
-    C = c;
+    ctx->A = a;
+    ctx->B = b;
+    ctx->C = c;
 
-    f_modulo(&A, 2 * (float) PI);
-    f_modulo(&B, 2 * (float) PI);
-    f_modulo(&C, 2 * (float) PI);
+    f_modulo(&ctx->A, 2 * (float) PI);
+    f_modulo(&ctx->B, 2 * (float) PI);
+    f_modulo(&ctx->C, 2 * (float) PI);
 
     int num_cubes = CUBES * SIDES;
-    cube cubes[num_cubes];
-    cube translated_cubes[num_cubes];
 
-    int current_type;
+    arena_reset(&ctx->scratch);
+    cube *cubes = ARENA_NEW(&ctx->scratch, cube, num_cubes);
+    cube *translated_cubes = ARENA_NEW(&ctx->scratch, cube, num_cubes);
+    float *sort_keys = ARENA_NEW(&ctx->scratch, float, num_cubes);
+    plane *planes = ARENA_NEW(&ctx->scratch, plane, NUM_PLANES);
+
+    int current_type = NO_TYPE;
 
     uint32_t colors[SIDES] = {PURPLE, WHITE, CADMIUM_ORANGE, BLUE, RED, GREEN, YELLOW, PINK};
 
     if(dt == 0) {
-        resetFaces(cubes, num_cubes, colors);
+        reset_puzzle(&ctx->state);
     }
 
     if(to_rotate) {
         if(select >= CUBES) {
-            int cube_order[4];
-            switch(select/CUBES) {
-                case 1:
-                    cube_order[0] = 1;
-                    cube_order[1] = 7;
-                    cube_order[2] = 6;
-                    cube_order[3] = 0;
-                    break;
-                case 2:
-                    cube_order[0] = 2;
-                    cube_order[1] = 7;
-                    cube_order[2] = 4;
-                    cube_order[3] = 0;
-                    break;
-                case 3:
-                    cube_order[0] = 3;
-                    cube_order[1] = 7;
-                    cube_order[2] = 5;
-                    cube_order[3] = 0;
-                    break;
-                case 4:
-                    cube_order[0] = 4;
-                    cube_order[1] = 7;
-                    cube_order[2] = 2;
-                    cube_order[3] = 0;
-                    break;
-                case 5:
-                    cube_order[0] = 5;
-                    cube_order[1] = 7;
-                    cube_order[2] = 3;
-                    cube_order[3] = 0;
-                    break;
-                case 6:
-                    cube_order[0] = 6;
-                    cube_order[1] = 7;
-                    cube_order[2] = 1;
-                    cube_order[3] = 0;
-                    break;
-                default:
-                    break;
-            }
-            change_center(cubes, cube_order);
+            move_in(&ctx->state, select / CUBES);
         }
         else {
-            rotate(cubes, select);
+            twist(&ctx->state, select);
         }
     }
     else {
         if(select >= CUBES) {
             current_type = MOVE_IN;
-            move_in_cube = select / CUBES;
+            ctx->move_in_cube = select / CUBES;
+            preview_move_in(&ctx->state, ctx->move_in_cube);
         }
         else {
             current_type = select_current_type(select);
         }
     }
 
+    if(cubes == NULL || translated_cubes == NULL || sort_keys == NULL || planes == NULL) {
+        fill_screen(ctx->pixels, WIDTH, HEIGHT, BG_COLOR);
+        return ctx->pixels;
+    }
+
+    loadFaces(&ctx->state, cubes, num_cubes, colors);
+
     if(select >= 0 && select < num_cubes) {
         for(int i=0; i<num_cubes; i++) {
             if(cubes[i].id == select) {
@@ -1858,18 +1259,19 @@ uint32_t *render(int dt, int keyboard_input, float a, float b, float c, int x, i
     }
 
 
-    fill_screen(pixels, WIDTH, HEIGHT, BG_COLOR);
+    fill_screen(ctx->pixels, WIDTH, HEIGHT, BG_COLOR);
 
     float magnitude = SCALE - GAP;
     float camera_distance = 200;
 
     Point_3D camera = {0, 0, 0};
-    generateCubes(cubes, translated_cubes, num_cubes, magnitude, camera_distance, colors, angle_percent, current_type, select, move_in_cube);
+    generateCubes(ctx, cubes, translated_cubes, sort_keys, num_cubes, magnitude, camera_distance, colors,
+                  angle_percent, current_type, select, ctx->move_in_cube);
 
 
 
     for(int i = 0; i < num_cubes; i++) {
-        draw_cube(pixels, WIDTH, HEIGHT, &translated_cubes[i], translated_cubes[i].points, translated_cubes[i].color, camera,
+        draw_cube(ctx->pixels, WIDTH, HEIGHT, planes, &translated_cubes[i], translated_cubes[i].points, translated_cubes[i].color, camera,
                   x, y, i, num_cubes, current_type, angle_percent);
     }
 
@@ -1879,12 +1281,527 @@ uint32_t *render(int dt, int keyboard_input, float a, float b, float c, int x, i
             Point_2D c_2D[NUM_CORNERS];
             convert_3D_to_2D(c_2D, WIDTH, HEIGHT, translated_cubes[i].points, camera);
 
-            draw_outline(c_2D);
+            draw_outline(ctx->pixels, c_2D);
             break;
         }
     }
 
-    return pixels;
+    return ctx->pixels;
+}
+
+// Session recording, for script.js: every move the page makes goes into a
+// replay file (replay.c) as it is made, starting over from the puzzle as it is
+// whenever it is reset, scrambled or imported. session_save ends a copy of
+// the file for 'v' to download; recording goes on after it.
+#define SESSION_BYTES (1 << 19)
+#define SESSION_INTERVAL 256
+
+typedef struct {
+    uint8_t *bytes;
+    uint32_t size;
+    uint32_t capacity;
+    int overflowed;         // bytes were dropped, so the file is no good
+} session_buffer;
+
+static replay_writer session;
+static uint8_t session_bytes[SESSION_BYTES];
+static uint8_t session_saved_bytes[SESSION_BYTES + REPLAY_MAX_BLOCK_BYTES + REPLAY_TRAILER_BYTES];
+static session_buffer session_log = {session_bytes, 0, sizeof(session_bytes), 0};
+static session_buffer session_saved = {session_saved_bytes, 0, sizeof(session_saved_bytes), 0};
+static int session_ready;
+
+static void session_sink(void *data, const uint8_t *bytes, uint32_t count) {
+    session_buffer *b = data;
+    if(b->overflowed || count > b->capacity - b->size) {
+        b->overflowed = 1;
+        return;
+    }
+    for(uint32_t i = 0; i < count; i++) {
+        b->bytes[b->size + i] = bytes[i];
+    }
+    b->size += count;
+}
+
+static void session_begin(void) {
+    session_log.size = 0;
+    session_log.overflowed = 0;
+    session_ready = replay_start(&session, &default_context.state, SESSION_INTERVAL, session_sink, &session_log) == 0;
+}
+
+// finishes a copy of the session at session_file; its length, or -1 if the session outgrew SESSION_BYTES
+int session_save(void) {
+    static replay_writer ending;
+
+    if(!session_ready) {
+        return -1;
+    }
+    session_saved.size = 0;
+    session_saved.overflowed = 0;
+    session_sink(&session_saved, session_log.bytes, session_log.size);
+    ending = session;
+    ending.sink_data = &session_saved;
+    replay_finish(&ending);
+    return session_log.overflowed || session_saved.overflowed ? -1 : (int) session_saved.size;
+}
+
+uint8_t *session_file(void) {
+    return session_saved_bytes;
+}
+
+// moves recorded since the session started
+double session_moves(void) {
+    return session_ready ? (double) session.moves : 0;
+}
+
+// Undo and redo, for script.js: the moves made since the puzzle was last
+// reset, scrambled or imported (history.c). 'z' and 'y' take one back and make
+// it again; both go into the session like any other move. A jump to a step
+// starts the session over from where it lands.
+#define PAGE_HISTORY_MOVES (1 << 17)
+
+static history page_history;
+static uint8_t page_history_moves[PAGE_HISTORY_MOVES];
+static puzzle page_history_checkpoints[HISTORY_CHECKPOINTS(PAGE_HISTORY_MOVES, HISTORY_INTERVAL)];
+static int page_history_ready;
+
+static void history_begin(void) {
+    page_history_ready = history_init(&page_history, &default_context.state, page_history_moves,
+                                      PAGE_HISTORY_MOVES, page_history_checkpoints, HISTORY_INTERVAL) == 0;
+}
+
+// takes back the last move; the move undone, or -1 if there is none
+int undo_move(void) {
+    int move = page_history_ready ? history_undo(&page_history) : -1;
+    if(move >= 0) {
+        default_context.state = page_history.current;
+        if(session_ready) {
+            replay_write(&session, inverse_move(move));
+        }
+    }
+    return move;
+}
+
+// makes the last move undone again; the move, or -1 if there is none
+int redo_move(void) {
+    int move = page_history_ready ? history_redo(&page_history) : -1;
+    if(move >= 0) {
+        default_context.state = page_history.current;
+        if(session_ready) {
+            replay_write(&session, move);
+        }
+    }
+    return move;
+}
+
+// moves that can be undone
+int history_position(void) {
+    return page_history_ready ? (int) page_history.position : 0;
+}
+
+// moves kept, the ones that can be redone included
+int history_length(void) {
+    return page_history_ready ? (int) page_history.length : 0;
+}
+
+// puts the puzzle where it was after `step` moves; 0, or -1 if there is no such step
+int history_jump_to(int step) {
+    if(!page_history_ready || step < 0 || history_jump(&page_history, (uint32_t) step) != 0) {
+        return -1;
+    }
+    default_context.state = page_history.current;
+    session_begin();
+    return 0;
+}
+
+/*
+ *  Function:    scramble_context
+ *  -------------------------
+ *  Scrambles the puzzle of a context, the same way for the same seed.
+ *
+ *  Input params:
+ *      render_context *ctx:    context to scramble
+ *      uint32_t seed:          seed of the random moves
+ *      int length:             number of random moves, or 0 for a uniformly
+ *                              random reachable state
+ */
+void scramble_context(render_context *ctx, uint32_t seed, int length) {
+    rng_state rng;
+
+    rng_seed(&rng, seed);
+    if(length == 0) {
+        random_puzzle(&ctx->state, &rng);
+    }
+    else {
+        scramble_puzzle(&ctx->state, &rng, length, SCRAMBLE_MOVE_INS, NULL);
+    }
+}
+
+void scramble(uint32_t seed, int length) {
+    if(default_context.pixels == NULL) {
+        init_render_context(&default_context, pixels, frame_scratch, FRAME_SCRATCH_SIZE);
+    }
+    scramble_context(&default_context, seed, length);
+    session_begin();
+    history_begin();
+}
+
+// the puzzle script.js hands to worker.js, which solves in its own copy of the module
+uint8_t *puzzle_stickers(void) {
+    return default_context.state.stickers;
+}
+
+int puzzle_orientation(void) {
+    return default_context.state.orientation;
+}
+
+// Analysis, for worker.js: it writes the stickers to analysis_input, starts a
+// solve and steps it a slice at a time, so a cancel from the page gets
+// through between slices and frames never wait on a search.
+static puzzle analysis_puzzle;
+static solve_job analysis_job;
+static uint8_t analysis_moves[IDA_MAX_DEPTH * MAX_CELL_TWIST_MOVES];
+
+uint8_t *analysis_input(void) {
+    return analysis_puzzle.stickers;
+}
+
+/*
+ *  Function:    analysis_start
+ *  -----------------------
+ *  Starts a shortest solve of the stickers at analysis_input, seen from
+ *      `orientation`, with the misplaced piece count as heuristic.
+ *
+ *  Return:
+ *      the job status, JOB_FAILED if the stickers are not a reachable state
+ */
+int analysis_start(int orientation, int max_depth) {
+    static const heuristic misplaced = {misplaced_estimate, NULL};
+    cubie_state start;
+
+    init_ida_tables();
+    analysis_puzzle.orientation = orientation;
+    analysis_puzzle.last_move_in_axis = NO_AXIS;
+    if(orientation < 0 || orientation >= num_orientations || puzzle_to_cubies(&analysis_puzzle, &start) != 0) {
+        analysis_job.status = JOB_FAILED;
+        return JOB_FAILED;
+    }
+    job_start(&analysis_job, &start, &misplaced, 1, max_depth);
+    return analysis_job.status;
+}
+
+int analysis_step(int budget) {
+    return job_step(&analysis_job, (uint64_t) budget);
+}
+
+void analysis_cancel(void) {
+    job_cancel(&analysis_job);
+}
+
+int analysis_bound(void) {
+    return analysis_job.bound;
+}
+
+double analysis_nodes(void) {
+    return (double) analysis_job.nodes;
+}
+
+// move ids that solve the analysed puzzle (see analysis_result), or -1 while there are none
+int analysis_length(void) {
+    return job_moves(&analysis_job, analysis_moves);
+}
+
+uint8_t *analysis_result(void) {
+    return analysis_moves;
+}
+
+// Hints, for script.js: every move ranked by the best score a few moves of
+// lookahead reach from it (hint.c). Cheap enough to ask for after every move;
+// script.js tunes `budget` to the time it measures.
+static hint_search suggestions;
+
+/*
+ *  Function:    suggest
+ *  ----------------
+ *  Ranks the moves of the current puzzle, looking up to `max_depth` moves
+ *      ahead as far as `budget` scored positions allow.
+ *
+ *  Return:
+ *      the number of suggestions, read with suggestion_move and friends
+ */
+int suggest(int max_depth, int budget) {
+    if(default_context.pixels == NULL) {
+        init_render_context(&default_context, pixels, frame_scratch, FRAME_SCRATCH_SIZE);
+    }
+    return hint_moves(&suggestions, &default_context.state, max_depth, budget < 0 ? 0 : (uint64_t) budget);
+}
+
+// move id of the suggestion ranked `rank` (0 is the best)
+int suggestion_move(int rank) {
+    return suggestions.hints[rank].move;
+}
+
+// how much the best line after it raises the score, 0 or less when nothing helps
+int suggestion_gain(int rank) {
+    return suggestions.hints[rank].score - suggestions.root_score;
+}
+
+// moves in that line, this one included
+int suggestion_depth(int rank) {
+    return suggestions.hints[rank].depth;
+}
+
+// how many moves ahead the last suggest() looked
+int suggestion_lookahead(void) {
+    return suggestions.depth;
+}
+
+// Known algorithms, for script.js: it fetches a library image made by
+// tools/alglib.c into algorithms_input and attaches it, and can then ask for
+// the algorithm that finishes the library's scope at any time; a lookup is a
+// hash probe, not a search.
+#define PAGE_ALG_IMAGE (1 << 20)
+#define PAGE_ALG_ENTRIES (1 << 16)
+
+static alg_library page_algorithms;
+static alg_entry page_algorithm_table[PAGE_ALG_ENTRIES];
+static uint8_t page_algorithm_image[PAGE_ALG_IMAGE];
+static uint8_t page_algorithm_moves[ALG_MAX_ANSWER * MAX_CELL_TWIST_MOVES];
+static int page_algorithms_ready;
+
+uint8_t *algorithms_input(void) {
+    return page_algorithm_image;
+}
+
+int algorithms_input_size(void) {
+    return PAGE_ALG_IMAGE;
+}
+
+// attaches the image written to algorithms_input; 0, or -1 if it is not a library that fits
+int algorithms_attach(int size) {
+    page_algorithms_ready = 0;
+    if(size < 0 || size > PAGE_ALG_IMAGE ||
+       alg_library_attach(&page_algorithms, page_algorithm_table, sizeof(page_algorithm_table),
+                          page_algorithm_image, (uint64_t) size) != 0) {
+        return -1;
+    }
+    page_algorithms_ready = 1;
+    return 0;
+}
+
+/*
+ *  Function:    algorithm_lookup
+ *  -------------------------
+ *  Looks the current puzzle up in the attached library.
+ *
+ *  Return:
+ *      the number of move ids (read at algorithm_result) that play the known
+ *          algorithm from the current view, or -1 if none is known
+ */
+int algorithm_lookup(void) {
+    uint8_t twists[ALG_MAX_ANSWER];
+    cubie_state state;
+
+    if(!page_algorithms_ready || puzzle_to_cubies(&default_context.state, &state) != 0) {
+        return -1;
+    }
+    int length = alg_lookup(&page_algorithms, &state, twists);
+    if(length < 0) {
+        return -1;
+    }
+    return solution_to_moves(default_context.state.orientation, twists, length, page_algorithm_moves);
+}
+
+uint8_t *algorithm_result(void) {
+    return page_algorithm_moves;
+}
+
+// Cycles, for script.js: the order and cycle structure of move ids written to
+// cycles_input, played from the current orientation (cycles.c). Cheap enough
+// to ask on every key press instead of pressing 'r' until the puzzle is back.
+#define CYCLES_MAX_MOVES 1024
+
+static uint8_t cycles_moves[CYCLES_MAX_MOVES];
+static cycle_report cycles;
+
+uint8_t *cycles_input(void) {
+    return cycles_moves;
+}
+
+// analyses the first `length` moves of cycles_input; 0, or -1 if they are not move ids
+int cycles_analyze(int length) {
+    if(length < 0 || length > CYCLES_MAX_MOVES) {
+        return -1;
+    }
+    return analyze_moves(cycles_moves, length, default_context.state.orientation, &cycles);
+}
+
+// writes the move the select makes to cycles_input, for analysing it alone; -1 if it makes none
+int cycles_select(int select) {
+    int move = select_move(select);
+    if(move < 0) {
+        return -1;
+    }
+    cycles_moves[0] = (uint8_t) move;
+    return 0;
+}
+
+// plays of the sequence until the puzzle is back (a double, it can pass 2^53)
+double cycles_order(void) {
+    return (double) cycles.order;
+}
+
+int cycles_stickers_moved(void) {
+    return cycles.stickers_moved;
+}
+
+int cycles_pieces_moved(int piece_class) {
+    return cycles.pieces_moved[piece_class];
+}
+
+int cycles_twisted(int piece_class) {
+    return cycles.twisted[piece_class];
+}
+
+int cycles_parity(int piece_class) {
+    return cycles.parity[piece_class];
+}
+
+int cycles_count(void) {
+    return cycles.num_cycles;
+}
+
+// length of a cycle, times the order of the twist its pieces come back with
+int cycles_period(int n) {
+    return cycles.cycles[n].length * cycles.cycles[n].twist_order;
+}
+
+// State import, for script.js: a text state (import.c) written to
+// state_text becomes the current puzzle if it is reachable, and the current
+// puzzle can be written there to be shared.
+#define STATE_TEXT_SIZE 1024
+
+static char state_text[STATE_TEXT_SIZE];
+
+char *state_input(void) {
+    return state_text;
+}
+
+int state_input_size(void) {
+    return STATE_TEXT_SIZE;
+}
+
+// imports the first `length` characters of state_input; IMPORT_OK, or why the puzzle was kept as it is
+int import_state(int length, int orientation) {
+    if(default_context.pixels == NULL) {
+        init_render_context(&default_context, pixels, frame_scratch, FRAME_SCRATCH_SIZE);
+    }
+    if(length < 0 || length > STATE_TEXT_SIZE) {
+        return IMPORT_BAD_FORMAT;
+    }
+    int result = import_text(state_text, length, orientation, &default_context.state);
+    if(result == IMPORT_OK) {
+        session_begin();
+        history_begin();
+    }
+    return result;
+}
+
+// writes the current puzzle to state_input as NUM_STICKERS digits; returns that length
+int export_state(void) {
+    export_text(&default_context.state, state_text);
+    return NUM_STICKERS;
+}
+
+// Notation, for script.js: moves written as text (notation.c) to
+// notation_input are played on the current puzzle, into the session and the
+// history like moves made by hand, and the moves that can be undone can be
+// written there as text to be shared.
+#define NOTATION_TEXT_SIZE 4096
+
+static char notation_text[NOTATION_TEXT_SIZE];
+static uint8_t notation_moves[NOTATION_FEED_ROOM(NOTATION_TEXT_SIZE)];
+static notation_parser page_notation;
+
+char *notation_input(void) {
+    return notation_text;
+}
+
+int notation_input_size(void) {
+    return NOTATION_TEXT_SIZE;
+}
+
+/*
+ *  Function:    play_notation
+ *  ----------------------
+ *  Plays the moves written in the first `length` characters of
+ *      notation_input. Nothing is played unless all of it can be read.
+ *
+ *  Return:
+ *      NOTATION_OK, or why a token was refused (its offset is
+ *          notation_error_offset)
+ */
+int play_notation(int length) {
+    if(default_context.pixels == NULL) {
+        init_render_context(&default_context, pixels, frame_scratch, FRAME_SCRATCH_SIZE);
+    }
+    if(length < 0 || length > NOTATION_TEXT_SIZE) {
+        return NOTATION_TOO_LONG;
+    }
+    notation_parser_init(&page_notation);
+    int count = notation_feed(&page_notation, notation_text, (uint32_t) length, notation_moves);
+    count += notation_finish(&page_notation, notation_moves + count);
+    if(page_notation.error != NOTATION_OK) {
+        return page_notation.error;
+    }
+    for(int i = 0; i < count; i++) {
+        apply_move(&default_context.state, notation_moves[i]);
+        if(session_ready) {
+            replay_write(&session, notation_moves[i]);
+        }
+        if(page_history_ready) {
+            history_push(&page_history, notation_moves[i]);
+        }
+    }
+    return NOTATION_OK;
+}
+
+int notation_error_offset(void) {
+    return (int) page_notation.error_offset;
+}
+
+// writes the moves that can be undone to notation_input, the last ones if they are too many; returns the length
+int export_notation(void) {
+    int count = history_position(), first = 0;
+
+    if(count > NOTATION_TEXT_SIZE / NOTATION_MAX_TOKEN_CHARS) {
+        first = count - NOTATION_TEXT_SIZE / NOTATION_MAX_TOKEN_CHARS;
+    }
+    int length = notation_emit(page_history_moves + first, count - first, notation_text);
+    return length > 0 ? length - 1 : 0;
+}
+
+// what script.js calls: one puzzle drawn into the module's own canvas
+uint32_t *render(int dt, int keyboard_input, float a, float b, float c, int x, int y, int select, int to_rotate,
+                 int angle_percent, int type) {
+    if(default_context.pixels == NULL) {
+        init_render_context(&default_context, pixels, frame_scratch, FRAME_SCRATCH_SIZE);
+    }
+
+    uint32_t *canvas = render_frame(&default_context, dt, keyboard_input, a, b, c, x, y, select, to_rotate,
+                                    angle_percent, type);
+    if(dt == 0) {
+        session_begin();
+        history_begin();
+    }
+    else if(to_rotate && select_move(select) >= 0) {
+        if(session_ready) {
+            replay_write(&session, select_move(select));
+        }
+        if(page_history_ready) {
+            history_push(&page_history, select_move(select));
+        }
+    }
+    return canvas;
 }
 
 
@@ -0,0 +1,217 @@
+//
+// Canonical move sequences: tables of which moves commute and which pairs
+// collapse into one move or none, and the masks of moves that may come next
+// so that searches and scrambles only ever write one ordering of a sequence.
+//
+// Cell twists (searches): b may not follow a when
+//      - both turn the same cell and together are one twist or none
+//      - they commute and b < a; of all the orderings of commuting twists
+//        only the one with the smaller twist first is kept
+// Every shortest sequence can be rewritten into one that passes, so searches
+// lose nothing.
+//
+// Move ids (scrambles): viewed twists between two move-ins all turn the
+// center cube, and any turn of one cube is a single twist or a quarter turn
+// made twice. So a twist may only follow a twist as the second half of a
+// doubled quarter turn (written with the select below the core, 4 4 and
+// never 22 22), and never follow such a pair. A move-in may not follow one
+// when the two turn the whole puzzle like one move-in or none, or when a pair
+// with smaller ids turns it the same way (which also orders commuting
+// move-ins), and a quarter turn is not made three times.
+//
+
+#ifndef MOVES_C
+#define MOVES_C
+
+#include "cubie.c"
+
+#define MASK_WORDS ((NUM_CELL_TWISTS + 63) / 64)
+#define START_OF_SEQUENCE NUM_CELL_TWISTS
+#define KEEP_BOTH 0xFE
+
+typedef struct {
+    uint64_t bits[MASK_WORDS];
+} twist_mask;
+
+static uint8_t twist_commutes[NUM_CELL_TWISTS][NUM_CELL_TWISTS];
+static uint8_t twist_collapses[NUM_CELL_TWISTS][NUM_CELL_TWISTS];
+// twist_product[a][t]: the one twist that is a then twist t of the same cell
+// (NO_TWIST when that is nothing), or KEEP_BOTH
+static uint8_t twist_product[NUM_CELL_TWISTS][TWISTS_PER_CELL];
+static twist_mask twist_next[NUM_CELL_TWISTS + 1];
+// move_next[last][doubled]: move ids allowed after `last` (NUM_MOVES at the
+// start), doubled when last was just made twice in a row
+static uint64_t move_next[NUM_MOVES + 1][2];
+// the same moves as a list in increasing order, so a scramble draws one in O(1)
+static uint8_t move_next_list[NUM_MOVES + 1][2][NUM_MOVES];
+static uint8_t move_next_count[NUM_MOVES + 1][2];
+static int move_tables_ready;
+
+static int twist_in_mask(const twist_mask *mask, int move) {
+    return (int) ((mask->bits[move >> 6] >> (move & 63)) & 1);
+}
+
+// whether the sticker permutation is one twist of the select list, or none
+static int single_select(const uint8_t *perm) {
+    for(int select = 0; select < CUBES; select++) {
+        int i;
+        for(i = 0; i < NUM_STICKERS && perm[i] == twist_table[select][i]; i++);
+        if(i == NUM_STICKERS) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// whether move-ins a then b turn the puzzle like one move-in or none
+static int move_ins_collapse(int a, int b) {
+    int both = orient_move_in[orient_move_in[0][a]][b];
+    if(both == 0) {
+        return 1;
+    }
+    for(int k = 1; k < SIDES - 1; k++) {
+        if(both == orient_move_in[0][k]) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// whether move-ins a then b are the pair with the smallest ids that makes their turn
+static int move_ins_canonical(int a, int b) {
+    int both = orient_move_in[orient_move_in[0][a]][b];
+    for(int x = 1; x <= a; x++) {
+        for(int y = 1; y < SIDES - 1 && (x < a || y < b); y++) {
+            if(orient_move_in[orient_move_in[0][x]][y] == both) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static void init_move_id_masks(void) {
+    uint8_t square[NUM_STICKERS];
+
+    for(int last = 0; last <= NUM_MOVES; last++) {
+        for(int doubled = 0; doubled < 2; doubled++) {
+            uint64_t mask = 0;
+            int count = 0;
+
+            for(int move = 0; move < NUM_MOVES; move++) {
+                int allowed = move != CUBES / 2;
+
+                if(last == NUM_MOVES || is_move_in(last) != is_move_in(move)) {
+                    // anything but the no-op, at the start or across a move-in
+                }
+                else if(!is_move_in(move)) {
+                    for(int i = 0; i < NUM_STICKERS; i++) {
+                        square[i] = twist_table[move][twist_table[move][i]];
+                    }
+                    allowed = allowed && !doubled && move == last && move < CUBES - 1 - move && !single_select(square);
+                }
+                else {
+                    int a = last - FIRST_MOVE_IN + 1, b = move - FIRST_MOVE_IN + 1;
+                    allowed = !(doubled && a == b) && !move_ins_collapse(a, b) && move_ins_canonical(a, b);
+                }
+
+                if(allowed) {
+                    mask |= (uint64_t) 1 << move;
+                    move_next_list[last][doubled][count++] = (uint8_t) move;
+                }
+            }
+            move_next[last][doubled] = mask;
+            move_next_count[last][doubled] = (uint8_t) count;
+        }
+    }
+}
+
+/*
+ *  Function:    init_move_tables
+ *  -------------------------
+ *  Builds the commutation, product and collapse tables of the cell twists, and from
+ *      them and the sticker tables of puzzle.c the next move masks.
+ */
+void init_move_tables(void) {
+    uint8_t ab[NUM_STICKERS], ba[NUM_STICKERS];
+
+    if(move_tables_ready) {
+        return;
+    }
+    init_cubie_tables();
+
+    for(int a = 0; a < NUM_CELL_TWISTS; a++) {
+        for(int b = 0; b < NUM_CELL_TWISTS; b++) {
+            int i;
+            // a then b, and b then a, in the pull form of cell_twist_perm
+            for(i = 0; i < NUM_STICKERS; i++) {
+                ab[i] = cell_twist_perm[a][cell_twist_perm[b][i]];
+                ba[i] = cell_twist_perm[b][cell_twist_perm[a][i]];
+            }
+            for(i = 0; i < NUM_STICKERS && ab[i] == ba[i]; i++);
+            twist_commutes[a][b] = i == NUM_STICKERS;
+
+            twist_collapses[a][b] = 0;
+            if(a / TWISTS_PER_CELL == b / TWISTS_PER_CELL) {
+                int first = a - a % TWISTS_PER_CELL;
+                uint8_t *product = &twist_product[a][b % TWISTS_PER_CELL];
+
+                for(i = 0; i < NUM_STICKERS && ab[i] == i; i++);
+                *product = i == NUM_STICKERS ? NO_TWIST : KEEP_BOTH;
+                for(int c = first; c < first + TWISTS_PER_CELL && *product == KEEP_BOTH; c++) {
+                    for(i = 0; i < NUM_STICKERS && ab[i] == cell_twist_perm[c][i]; i++);
+                    if(i == NUM_STICKERS) {
+                        *product = (uint8_t) c;
+                    }
+                }
+                twist_collapses[a][b] = *product != KEEP_BOTH;
+            }
+        }
+    }
+
+    for(int last = 0; last <= NUM_CELL_TWISTS; last++) {
+        for(int w = 0; w < MASK_WORDS; w++) {
+            twist_next[last].bits[w] = 0;
+        }
+        for(int m = 0; m < NUM_CELL_TWISTS; m++) {
+            if(last != START_OF_SEQUENCE &&
+               (twist_collapses[last][m] || (twist_commutes[last][m] && m < last))) {
+                continue;
+            }
+            twist_next[last].bits[m >> 6] |= (uint64_t) 1 << (m & 63);
+        }
+    }
+
+    init_move_id_masks();
+    move_tables_ready = 1;
+}
+
+// cell twists that may follow `last` (START_OF_SEQUENCE or NO_TWIST at the start)
+const twist_mask *next_twists(int last) {
+    return &twist_next[last >= NUM_CELL_TWISTS ? START_OF_SEQUENCE : last];
+}
+
+int twist_allowed(int last, int move) {
+    return twist_in_mask(next_twists(last), move);
+}
+
+/*
+ *  Function:    next_moves
+ *  -------------------
+ *  Move ids that may follow `last` in a canonical sequence, as a bit mask.
+ *
+ *  Input params:
+ *      int last:   the move before, or NUM_MOVES at the start
+ *      int run:    how many times in a row last was made
+ */
+uint64_t next_moves(int last, int run) {
+    return move_next[last][run >= 2];
+}
+
+// the moves of next_moves as a list in increasing order; sets *count to its length
+const uint8_t *next_move_list(int last, int run, uint32_t *count) {
+    *count = move_next_count[last][run >= 2];
+    return move_next_list[last][run >= 2];
+}
+
+#endif // MOVES_C
@@ -0,0 +1,690 @@
+//
+// Text notation for moves, in the style other 4D cube programs log twists in:
+// a cell, then the direction it turns about, named by the faces it points
+// through.
+//
+//      IR  IUF  IUFR   the center cell (I) turned about its right face, up
+//                      front edge or up front right corner: clockwise as seen
+//                      from that side, a quarter, half or third of a turn
+//      RU  RO  FIL     another cell, as the page draws it; its directions
+//                      along the line to the center are I (toward it) and O
+//                      (away), and U D F B R L as on screen otherwise
+//      IR2  IR'  IR2'  the turn twice, or the other way round
+//      @R              the cell moved into the center (a move-in)
+//      .               the twist of the core, which does nothing (move id 13)
+// Cells are I, O (the hidden one) and R L U D F B around the center as seen
+// from the current view. The puzzle only turns the center cell, so a twist of
+// another cell is three move ids: that cell moved in, the twist, and the
+// move-in that takes it back; twists of O are refused. Tokens are upper case
+// and separated by white space or commas; '#' comments to the end of a line.
+//
+// Which twist and move-in ids make each turn is not written down here: the
+// tables below are found by playing every twist (and every cell moved in,
+// twisted and moved back) on labelled stickers and matching what the cell's
+// 27 slots do against the 24 rotations of a cube.
+//
+// The parser takes text in pieces of any size and copies nothing but a token
+// cut in two by the end of a piece; it stops at the first token it cannot
+// read.
+//
+
+#ifndef NOTATION_C
+#define NOTATION_C
+
+#include "scramble.c"
+
+#define NOTATION_MAX_TOKEN 8
+#define NOTATION_MAX_TOKEN_MOVES 4      // a cell moved in, a twist twice, moved back
+#define NOTATION_MAX_TOKEN_CHARS 5      // what the emitter writes for a move, its space included
+#define NOTATION_TWIST_CELLS 7          // cells a twist can be written for: the center and the six around it
+#define NOTATION_NO_TWIST 0xFF
+
+// move ids notation_feed may write for a piece: a token gives no more moves than it has characters and one,
+// and the moves of a token are copied four at a time
+#define NOTATION_FEED_ROOM(length) ((length) + 2 * NOTATION_MAX_TOKEN_MOVES)
+
+// why a token was refused
+#define NOTATION_OK 0
+#define NOTATION_BAD_CHARACTER 1
+#define NOTATION_BAD_CELL 2
+#define NOTATION_BAD_DIRECTION 3        // no direction, a letter the cell has no direction for, or an axis twice
+#define NOTATION_BAD_SUFFIX 4
+#define NOTATION_HIDDEN_CELL 5          // a twist of O
+#define NOTATION_TOO_LONG 6
+#define NOTATION_NUM_RESULTS 7
+
+typedef struct {
+    char token[NOTATION_MAX_TOKEN];     // a token cut by the end of the last piece
+    int token_length;
+    int in_comment;
+    uint64_t offset;                    // characters taken so far
+    uint64_t tokens;
+    int error;                          // NOTATION_OK, or why the parser stopped
+    uint64_t error_offset;              // where the token it stopped at starts
+} notation_parser;
+
+// letter of each cube as the page lays them out (cube 0 is the center, 7 the hidden one)
+static const char cell_letters[SIDES] = {'I', 'U', 'B', 'R', 'F', 'L', 'D', 'O'};
+// the screen direction (x right, y down, z away) of each cube 1 - 6 from the center: axis * 2 + (sign > 0)
+static const uint8_t cell_direction[SIDES] = {0, 2, 5, 1, 4, 0, 3, 0};
+
+// notation_twist[cell][select of a screen axis]: the twist that turns the cell clockwise about that axis
+static uint8_t notation_twist[NOTATION_TWIST_CELLS][CUBES];
+// select of the screen axis each twist turns the center cell about (the name it is written with)
+static uint8_t twist_axis[CUBES];
+// letter_direction[cell][letter]: the screen direction a letter names in that cell, or -1
+static int8_t letter_direction[NOTATION_TWIST_CELLS][128];
+static int8_t cell_of_letter[128];
+static uint8_t notation_character[256];     // 0: not allowed, 1: part of a token, 2: separator, 3: comment
+static int notation_tables_ready;
+
+// every token that can be read, with its moves, so a token is one probe (about a third full)
+#define NOTATION_TABLE_SIZE 8192
+
+typedef struct {
+    uint64_t key;                                   // the characters, the first in the low byte (0: empty)
+    uint8_t count;
+    uint8_t moves[NOTATION_MAX_TOKEN_MOVES];
+} notation_entry;
+
+static notation_entry notation_table[NOTATION_TABLE_SIZE];
+
+// the 24 rotations of a cube, as signed permutation matrices
+static int8_t cube_rotations[24][3][3];
+
+static void rotate_vector(const int8_t m[3][3], const int *v, int *out) {
+    for(int r = 0; r < 3; r++) {
+        out[r] = m[r][0] * v[0] + m[r][1] * v[1] + m[r][2] * v[2];
+    }
+}
+
+static int vector_select(const int *v) {
+    return (v[0] + 1) * DIMENSION * DIMENSION + (v[1] + 1) * DIMENSION + v[2] + 1;
+}
+
+static void select_vector(int select, int *v) {
+    v[0] = select / (DIMENSION * DIMENSION) - 1;
+    v[1] = select / DIMENSION % DIMENSION - 1;
+    v[2] = select % DIMENSION - 1;
+}
+
+static void init_cube_rotations(void) {
+    static const int orders[6][3] = {{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}};
+    int count = 0;
+
+    for(int p = 0; p < 6; p++) {
+        for(int signs = 0; signs < 8; signs++) {
+            int8_t m[3][3] = {{0}};
+            for(int r = 0; r < 3; r++) {
+                m[r][orders[p][r]] = (int8_t) (signs >> r & 1 ? -1 : 1);
+            }
+            int det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+                      m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+                      m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+            if(det == 1) {
+                for(int r = 0; r < 3; r++) {
+                    for(int c = 0; c < 3; c++) {
+                        cube_rotations[count][r][c] = m[r][c];
+                    }
+                }
+                count++;
+            }
+        }
+    }
+}
+
+// the rotation about the axis through select a quarter (face), half (edge) or third (corner) turn clockwise seen from it
+static int clockwise_rotation(int select) {
+    int a[3], v[3] = {1, 0, 0}, moved[3], twice[3];
+    int nonzero, order;
+
+    select_vector(select, a);
+    nonzero = (a[0] != 0) + (a[1] != 0) + (a[2] != 0);
+    order = nonzero == 1 ? 4 : nonzero == 2 ? 2 : 3;
+    if(a[1] == 0 && a[2] == 0) {
+        v[0] = 0;
+        v[1] = 1;
+    }
+    for(int r = 0; r < 24; r++) {
+        const int8_t (*m)[3] = cube_rotations[r];
+        int n = 1;
+
+        rotate_vector(m, a, moved);
+        if(moved[0] != a[0] || moved[1] != a[1] || moved[2] != a[2]) {
+            continue;
+        }
+        // the order of m, seen on a vector it moves
+        rotate_vector(m, v, moved);
+        int at[3] = {moved[0], moved[1], moved[2]};
+        while(at[0] != v[0] || at[1] != v[1] || at[2] != v[2]) {
+            rotate_vector(m, at, twice);
+            at[0] = twice[0];
+            at[1] = twice[1];
+            at[2] = twice[2];
+            n++;
+        }
+        // clockwise seen from a: v, m v and a are left handed
+        int turn = a[0] * (v[1] * moved[2] - v[2] * moved[1]) + a[1] * (v[2] * moved[0] - v[0] * moved[2]) +
+                   a[2] * (v[0] * moved[1] - v[1] * moved[0]);
+        if(n == order && (order == 2 || turn < 0)) {
+            return r;
+        }
+    }
+    return -1;
+}
+
+// the move ids of one token, or minus why it was refused
+static int notation_token(const char *t, int n, uint8_t *moves) {
+    int v[3] = {0, 0, 0}, letters = 0, turns = 1, inverse = 0;
+
+    if(n == 1 && t[0] == '.') {
+        moves[0] = CUBES / 2;
+        return 1;
+    }
+    // the characters of a token are all ASCII (notation_character)
+    int cell = cell_of_letter[(int) t[0]];
+    if(t[0] == '@') {
+        cell = n == 2 ? cell_of_letter[(int) t[1]] : -1;
+        if(cell < 1 || cell >= HIDDEN_CUBE) {
+            return -NOTATION_BAD_CELL;
+        }
+        moves[0] = (uint8_t) (FIRST_MOVE_IN + cell - 1);
+        return 1;
+    }
+    if(cell < 0) {
+        return -NOTATION_BAD_CELL;
+    }
+    if(cell == HIDDEN_CUBE) {
+        return -NOTATION_HIDDEN_CELL;
+    }
+
+    int i = 1;
+    for(; i < n && t[i] >= 'A' && t[i] <= 'Z'; i++) {
+        int d = letter_direction[cell][(int) t[i]];
+        if(d < 0 || v[d / 2] != 0) {
+            return -NOTATION_BAD_DIRECTION;
+        }
+        v[d / 2] = d & 1 ? 1 : -1;
+        letters++;
+    }
+    if(letters == 0) {
+        return -NOTATION_BAD_DIRECTION;
+    }
+    for(; i < n; i++) {
+        if(t[i] == '2' && turns == 1) {
+            turns = 2;
+        }
+        else if(t[i] == '\'' && !inverse) {
+            inverse = 1;
+        }
+        else {
+            return -NOTATION_BAD_SUFFIX;
+        }
+    }
+
+    int select = notation_twist[cell][vector_select(v)];
+    int count = 0;
+    if(inverse) {
+        select = CUBES - 1 - select;
+    }
+    if(cell > 0) {
+        moves[count++] = (uint8_t) (FIRST_MOVE_IN + cell - 1);
+    }
+    for(int k = 0; k < turns; k++) {
+        moves[count++] = (uint8_t) select;
+    }
+    if(cell > 0) {
+        moves[count++] = (uint8_t) inverse_move(FIRST_MOVE_IN + cell - 1);
+    }
+    return count;
+}
+
+static uint32_t notation_hash(uint64_t key) {
+    return (uint32_t) ((key * 0x9E3779B97F4A7C15ULL) >> 51) & (NOTATION_TABLE_SIZE - 1);
+}
+
+static uint64_t notation_key(const char *t, int n) {
+    uint64_t key = 0;
+    for(int i = 0; i < n; i++) {
+        key |= (uint64_t) (uint8_t) t[i] << (8 * i);
+    }
+    return key;
+}
+
+// puts a token in the table, with the moves notation_token reads from it
+static void notation_insert(const char *t, int n) {
+    uint8_t moves[NOTATION_MAX_TOKEN_MOVES];
+    int count = notation_token(t, n, moves);
+    uint64_t key = notation_key(t, n);
+    uint32_t at = notation_hash(key);
+
+    while(notation_table[at].key != 0) {
+        at = (at + 1) & (NOTATION_TABLE_SIZE - 1);
+    }
+    notation_table[at].key = key;
+    notation_table[at].count = (uint8_t) count;
+    for(int i = 0; i < count; i++) {
+        notation_table[at].moves[i] = moves[i];
+    }
+}
+
+// the moves of a token in the table, or -1 if it is not there
+static int notation_lookup(uint64_t key, uint8_t *moves) {
+    for(uint32_t at = notation_hash(key);; at = (at + 1) & (NOTATION_TABLE_SIZE - 1)) {
+        const notation_entry *e = &notation_table[at];
+        if(e->key == key) {
+            // all four, unused ones too: a fixed copy, not one as long as the token
+            moves[0] = e->moves[0];
+            moves[1] = e->moves[1];
+            moves[2] = e->moves[2];
+            moves[3] = e->moves[3];
+            return e->count;
+        }
+        if(e->key == 0) {
+            return -1;
+        }
+    }
+}
+
+// every token of a cell: each direction with its letters in every order, and every suffix
+static void insert_cell_tokens(int cell) {
+    static const char *suffixes[5] = {"", "2", "'", "2'", "'2"};
+    static const int orders[6][3] = {{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}};
+    int own_axis = cell > 0 ? cell_direction[cell] / 2 : -1;
+
+    for(int axis = 0; axis < CUBES; axis++) {
+        char letters[3];
+        int v[3], count = 0;
+
+        if(axis == CUBES / 2) {
+            continue;
+        }
+        select_vector(axis, v);
+        for(int a = 0; a < 3; a++) {
+            if(v[a] != 0) {
+                int d = a * 2 + (v[a] > 0);
+                letters[count++] = a != own_axis ? "LRUDFB"[d] : d == cell_direction[cell] ? 'O' : 'I';
+            }
+        }
+        for(int order = 0; order < 6; order++) {
+            // the orders of one or two letters, once each
+            int repeated = 0;
+            for(int k = 0; k < count; k++) {
+                repeated |= orders[order][k] >= count;
+            }
+            if(repeated || (count == 1 && order > 0)) {
+                continue;
+            }
+            for(int suffix = 0; suffix < 5; suffix++) {
+                char t[NOTATION_MAX_TOKEN];
+                int n = 0;
+                t[n++] = cell_letters[cell];
+                for(int k = 0; k < count; k++) {
+                    t[n++] = letters[orders[order][k]];
+                }
+                for(const char *c = suffixes[suffix]; *c != '\0'; c++) {
+                    t[n++] = *c;
+                }
+                notation_insert(t, n);
+            }
+        }
+    }
+}
+
+/*
+ *  Function:    init_notation_tables
+ *  -----------------------------
+ *  Finds the twist behind every cell and direction (see the top of the file).
+ *
+ *  Return:
+ *      0, or -1 if some turn is made by no twist (the tables would be wrong)
+ */
+int init_notation_tables(void) {
+    static const char direction_letters[6] = {'L', 'R', 'U', 'D', 'F', 'B'};
+
+    if(notation_tables_ready) {
+        return 0;
+    }
+    init_scramble_tables();
+    init_cube_rotations();
+
+    for(int cell = 0; cell < NOTATION_TWIST_CELLS; cell++) {
+        for(int axis = 0; axis < CUBES; axis++) {
+            notation_twist[cell][axis] = NOTATION_NO_TWIST;
+        }
+    }
+    for(int select = 0; select < CUBES; select++) {
+        twist_axis[select] = NOTATION_NO_TWIST;
+    }
+
+    for(int cell = 0; cell < NOTATION_TWIST_CELLS; cell++) {
+        for(int select = 0; select < CUBES; select++) {
+            puzzle p;
+
+            if(select == CUBES / 2) {
+                continue;
+            }
+            for(int i = 0; i < NUM_STICKERS; i++) {
+                p.stickers[i] = (uint8_t) i;
+            }
+            p.orientation = 0;
+            p.last_move_in_axis = NO_AXIS;
+            if(cell > 0) {
+                apply_move(&p, FIRST_MOVE_IN + cell - 1);
+            }
+            twist(&p, select);
+            if(cell > 0) {
+                apply_move(&p, inverse_move(FIRST_MOVE_IN + cell - 1));
+            }
+
+            for(int axis = 0; axis < CUBES; axis++) {
+                int r = axis == CUBES / 2 ? -1 : clockwise_rotation(axis);
+                int matches = r >= 0;
+
+                // the rotation takes slot v to m v, so what is at m v came from v
+                for(int slot = 0; slot < CUBES && matches; slot++) {
+                    int v[3], moved[3];
+                    select_vector(slot, v);
+                    rotate_vector(cube_rotations[r], v, moved);
+                    matches = p.stickers[orient_remap[0][cell * CUBES + vector_select(moved)]] == cell * CUBES + slot;
+                }
+                if(!matches) {
+                    continue;
+                }
+                // an edge turn is made by two twists (of opposite edges): each is written with an axis of its own
+                if(cell == 0 && twist_axis[select] == NOTATION_NO_TWIST &&
+                   notation_twist[0][axis] == NOTATION_NO_TWIST) {
+                    twist_axis[select] = (uint8_t) axis;
+                    notation_twist[0][axis] = (uint8_t) select;
+                }
+                if(cell > 0 && notation_twist[cell][axis] == NOTATION_NO_TWIST) {
+                    notation_twist[cell][axis] = (uint8_t) select;
+                }
+            }
+        }
+        for(int axis = 0; axis < CUBES; axis++) {
+            if(axis != CUBES / 2 && notation_twist[cell][axis] == NOTATION_NO_TWIST) {
+                return -1;
+            }
+        }
+    }
+
+    // directions: a letter per side of the screen axes; another cell's own axis is I and O instead
+    for(int c = 0; c < 128; c++) {
+        cell_of_letter[c] = -1;
+        for(int cell = 0; cell < NOTATION_TWIST_CELLS; cell++) {
+            letter_direction[cell][c] = -1;
+        }
+    }
+    for(int cell = 0; cell < SIDES; cell++) {
+        cell_of_letter[(int) cell_letters[cell]] = (int8_t) cell;
+    }
+    for(int cell = 0; cell < NOTATION_TWIST_CELLS; cell++) {
+        int own_axis = cell > 0 ? cell_direction[cell] / 2 : -1;
+        for(int d = 0; d < 6; d++) {
+            if(d / 2 != own_axis) {
+                letter_direction[cell][(int) direction_letters[d]] = (int8_t) d;
+            }
+        }
+        if(cell > 0) {
+            letter_direction[cell]['O'] = (int8_t) cell_direction[cell];
+            letter_direction[cell]['I'] = (int8_t) (cell_direction[cell] ^ 1);
+        }
+    }
+
+    for(int c = 0; c < 256; c++) {
+        notation_character[c] = (c >= 'A' && c <= 'Z') || c == '@' || c == '\'' || c == '2' || c == '.';
+    }
+    notation_character[' '] = notation_character['\t'] = notation_character['\r'] = notation_character['\n'] = 2;
+    notation_character[','] = 2;
+    notation_character['#'] = 3;
+
+    for(int at = 0; at < NOTATION_TABLE_SIZE; at++) {
+        notation_table[at].key = 0;
+    }
+    notation_insert(".", 1);
+    for(int cell = 1; cell < HIDDEN_CUBE; cell++) {
+        char t[2] = {'@', cell_letters[cell]};
+        notation_insert(t, 2);
+    }
+    for(int cell = 0; cell < NOTATION_TWIST_CELLS; cell++) {
+        insert_cell_tokens(cell);
+    }
+
+    notation_tables_ready = 1;
+    return 0;
+}
+
+void notation_parser_init(notation_parser *np) {
+    init_notation_tables();
+    np->token_length = 0;
+    np->in_comment = 0;
+    np->offset = 0;
+    np->tokens = 0;
+    np->error = NOTATION_OK;
+    np->error_offset = 0;
+}
+
+// bytes of a word at or below 0x20 (white space), or ',' or '#': the lowest flag marks the first of them
+#define NOTATION_ONES 0x0101010101010101ULL
+#define NOTATION_HIGHS 0x8080808080808080ULL
+
+static uint64_t notation_ends(uint64_t word) {
+    uint64_t comma = word ^ (NOTATION_ONES * ','), hash = word ^ (NOTATION_ONES * '#');
+
+    return ((word - NOTATION_ONES * 0x21) & ~word) | ((comma - NOTATION_ONES) & ~comma) |
+           ((hash - NOTATION_ONES) & ~hash);
+}
+
+// eight characters as a key, the first in the low byte
+static uint64_t notation_word(const char *t) {
+    const uint8_t *b = (const uint8_t *) t;
+    return (uint64_t) b[0] | (uint64_t) b[1] << 8 | (uint64_t) b[2] << 16 | (uint64_t) b[3] << 24 |
+           (uint64_t) b[4] << 32 | (uint64_t) b[5] << 40 | (uint64_t) b[6] << 48 | (uint64_t) b[7] << 56;
+}
+
+// the index of the lowest byte flagged in a nonzero notation_ends, without branches on it
+static int notation_first_end(uint64_t ends) {
+    uint64_t bit = (ends & (0 - ends)) >> 7;
+    return (int) ((bit * 0x0001020304050607ULL) >> 56);
+}
+
+// reads a token that starts `start` characters into the text so far; the moves, or -1 (np->error says why)
+static int notation_take(notation_parser *np, uint64_t key, const char *t, int n, uint64_t start, uint8_t *moves) {
+    int count = n > NOTATION_MAX_TOKEN ? -1 : notation_lookup(key, moves);
+
+    if(count < 0) {
+        // not a token: reading it the long way says why
+        count = n > NOTATION_MAX_TOKEN ? -NOTATION_TOO_LONG : notation_token(t, n, moves);
+        for(int i = 0; i < n; i++) {
+            // a character no token has, kept in the word read at once
+            if(notation_character[(uint8_t) t[i]] != 1) {
+                count = -NOTATION_BAD_CHARACTER;
+                start += (uint64_t) i;
+                break;
+            }
+        }
+    }
+    if(count < 0) {
+        np->error = -count;
+        np->error_offset = start;
+        return -1;
+    }
+    np->tokens++;
+    return count;
+}
+
+/*
+ *  Function:    notation_feed
+ *  ----------------------
+ *  Reads the next piece of a text. A token the piece ends in the middle of
+ *      is kept until the next piece (or notation_finish).
+ *
+ *  Input params:
+ *      notation_parser *np:
+ *      const char *text:       the piece, length characters
+ *      uint8_t *moves:         room for NOTATION_FEED_ROOM(length) move ids
+ *
+ *  Return:
+ *      the move ids written; after a token that cannot be read np->error is
+ *          set, the moves before it are returned and later pieces give none
+ *
+ *  Runtime Complexity: O(length)
+ */
+int notation_feed(notation_parser *np, const char *text, uint32_t length, uint8_t *moves) {
+    int count = 0;
+    uint32_t i = 0;
+
+    if(np->error != NOTATION_OK) {
+        return 0;
+    }
+    // the end of a token cut by the last piece
+    if(np->token_length > 0) {
+        while(i < length && notation_character[(uint8_t) text[i]] == 1) {
+            if(np->token_length == NOTATION_MAX_TOKEN) {
+                np->error = NOTATION_TOO_LONG;
+                np->error_offset = np->offset - (uint64_t) np->token_length;
+                return 0;
+            }
+            np->token[np->token_length++] = text[i++];
+        }
+        if(i == length) {
+            np->offset += length;
+            return 0;
+        }
+        int n = notation_take(np, notation_key(np->token, np->token_length), np->token, np->token_length,
+                              np->offset - (uint64_t) np->token_length, moves);
+        np->token_length = 0;
+        if(n < 0) {
+            return 0;
+        }
+        count = n;
+    }
+
+    while(i < length) {
+        uint8_t kind = notation_character[(uint8_t) text[i]];
+
+        if(np->in_comment) {
+            np->in_comment = text[i++] != '\n';
+            continue;
+        }
+        if(kind == 2) {
+            i++;
+            continue;
+        }
+        if(kind == 3) {
+            np->in_comment = 1;
+            i++;
+            continue;
+        }
+        if(kind == 0) {
+            np->error = NOTATION_BAD_CHARACTER;
+            np->error_offset = np->offset + i;
+            return count;
+        }
+
+        // a token that ends within eight characters: its key in one load, its end in a few operations
+        if(length - i >= 8) {
+            uint64_t word = notation_word(text + i);
+            uint64_t ends = notation_ends(word) & NOTATION_HIGHS;
+            if(ends != 0) {
+                int n = notation_first_end(ends);
+                int got = notation_take(np, word & ((1ULL << (8 * n)) - 1), text + i, n, np->offset + i,
+                                        moves + count);
+                if(got < 0) {
+                    return count;
+                }
+                count += got;
+                i += (uint32_t) n;
+                continue;
+            }
+        }
+
+        uint32_t start = i;
+        uint64_t key = 0;
+        while(i < length && notation_character[(uint8_t) text[i]] == 1) {
+            if(i - start < NOTATION_MAX_TOKEN) {
+                key |= (uint64_t) (uint8_t) text[i] << (8 * (i - start));
+            }
+            i++;
+        }
+        if(i == length && i - start <= NOTATION_MAX_TOKEN) {
+            // perhaps cut in two: keep it for the next piece
+            for(uint32_t k = start; k < i; k++) {
+                np->token[np->token_length++] = text[k];
+            }
+            break;
+        }
+        int n = notation_take(np, key, text + start, (int) (i - start), np->offset + start, moves + count);
+        if(n < 0) {
+            return count;
+        }
+        count += n;
+    }
+    np->offset += length;
+    return count;
+}
+
+// ends the text: reads a token left at its very end; the moves written (room for NOTATION_MAX_TOKEN_MOVES)
+int notation_finish(notation_parser *np, uint8_t *moves) {
+    int n = 0;
+
+    if(np->error == NOTATION_OK && np->token_length > 0) {
+        n = notation_take(np, notation_key(np->token, np->token_length), np->token, np->token_length,
+                          np->offset - (uint64_t) np->token_length, moves);
+    }
+    np->token_length = 0;
+    return n < 0 ? 0 : n;
+}
+
+/*
+ *  Function:    notation_emit
+ *  ----------------------
+ *  Writes move ids as notation, one token each followed by a space: "I" and
+ *      the direction of a twist, "@" and the cell of a move-in.
+ *
+ *  Input params:
+ *      const uint8_t *moves:
+ *      int count:
+ *      char *text:             room for count * NOTATION_MAX_TOKEN_CHARS
+ *
+ *  Return:
+ *      the characters written, or -1 if some move is not a move id
+ */
+int notation_emit(const uint8_t *moves, int count, char *text) {
+    int length = 0;
+
+    init_notation_tables();
+    for(int m = 0; m < count; m++) {
+        int move = moves[m];
+
+        if(move >= NUM_MOVES) {
+            return -1;
+        }
+        if(is_move_in(move)) {
+            text[length++] = '@';
+            text[length++] = cell_letters[move - FIRST_MOVE_IN + 1];
+        }
+        else if(move == CUBES / 2) {
+            text[length++] = '.';
+        }
+        else {
+            int v[3];
+            select_vector(twist_axis[move], v);
+            text[length++] = 'I';
+            if(v[1] != 0) {
+                text[length++] = v[1] < 0 ? 'U' : 'D';
+            }
+            if(v[2] != 0) {
+                text[length++] = v[2] < 0 ? 'F' : 'B';
+            }
+            if(v[0] != 0) {
+                text[length++] = v[0] < 0 ? 'L' : 'R';
+            }
+        }
+        text[length++] = ' ';
+    }
+    return length;
+}
+
+#endif // NOTATION_C
@@ -0,0 +1,480 @@
+//
+// Partial goals: a pattern says which physical stickers must show which
+// colors and leaves the rest alone ("solve cell 3", "place the 2 color
+// pieces"), and the search finds the fewest cell twists that get there, with
+// ida.c doing the searching.
+//
+// A constrained position can only be filled by pieces that have the wanted
+// colors. Pieces that are bound to a position, or to one of a few positions,
+// are grouped into pattern databases over their coordinates, built for this
+// goal with pdb_build_goal; positions left with several candidates are as
+// near as their nearest candidate (see pattern_try_prepare). The estimate is
+// the largest of all that, which stays admissible.
+//
+// Tables are built on demand into a pattern_cache and kept there, keyed by
+// the pieces they track and the coordinates they count as done, so asking
+// for the same goal again (or another one that shares pieces) builds nothing.
+//
+
+#ifndef PATTERN_C
+#define PATTERN_C
+
+#include "ida.c"
+
+#define PATTERN_ANY 0xFF                    // target of a sticker that does not matter
+#define PATTERN_NONE 0xFF
+#define PATTERN_MAX_COORDS (NUM_CORNER_PIECES * 24)
+#define PATTERN_GROUP_ENTRIES (1 << 17)     // largest table a group of forced pieces gets
+#define PATTERN_CACHE_TABLES 1024
+
+typedef struct {
+    uint8_t target[NUM_STICKERS];           // color each physical sticker must show, or PATTERN_ANY
+} sticker_pattern;
+
+typedef struct {
+    uint64_t key;
+    pattern_db db;
+} pattern_entry;
+
+typedef struct {
+    uint8_t *memory;
+    uint64_t bytes;
+    uint64_t used;
+    pattern_entry entries[PATTERN_CACHE_TABLES];
+    int count;
+    uint64_t built;                         // tables built, all time
+    uint64_t reused;                        // tables asked for that were already there
+} pattern_cache;
+
+typedef struct {
+    int count;
+    const pattern_db *tables[NUM_EDGE_PIECES];
+} pattern_choice;
+
+typedef struct {
+    // the constrained position a piece fills right at each of its
+    // coordinates, or PATTERN_NONE
+    uint8_t meets[NUM_PIECES][PATTERN_MAX_COORDS];
+    uint8_t pieces[NUM_PIECES];             // pieces that can fill some position
+    int num_pieces;
+    int num_positions;                      // constrained positions
+    const pattern_db *groups[NUM_PIECES];   // over forced pieces
+    int num_groups;
+    pattern_choice choices[NUM_PIECES];     // positions with several candidates
+    int num_choices;
+} pattern_goal;
+
+// positions as a bit set
+typedef struct {
+    uint64_t bits[2];
+} position_set;
+
+// what pdb_build_goal needs to tell a table's goal entries
+typedef struct {
+    const pattern_goal *goal;
+    const coord_subset *subset;
+    position_set allow[MAX_SUBSET_PIECES];  // where each tracked piece has to end up, filling it right
+} pattern_table_goal;
+
+static int position_in(const position_set *set, int at) {
+    return at != PATTERN_NONE && (int) ((set->bits[at >> 6] >> (at & 63)) & 1);
+}
+
+static void position_add(position_set *set, int at) {
+    set->bits[at >> 6] |= (uint64_t) 1 << (at & 63);
+}
+
+// clears a pattern: nothing is asked for
+void pattern_clear(sticker_pattern *pattern) {
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        pattern->target[i] = PATTERN_ANY;
+    }
+}
+
+// asks for every sticker of a cell in its solved color
+void pattern_add_cell(sticker_pattern *pattern, int cell) {
+    for(int i = cell * CUBES; i < (cell + 1) * CUBES; i++) {
+        pattern->target[i] = (uint8_t) cell;
+    }
+}
+
+// asks for every piece of a class (coord.c) home and turned right
+void pattern_add_class(sticker_pattern *pattern, int piece_class) {
+    init_coord_tables();
+    for(int piece = class_first[piece_class]; piece < class_first[piece_class] + class_pieces[piece_class]; piece++) {
+        for(int t = 0; t < piece_size[piece]; t++) {
+            int s = piece_stickers[piece][t];
+            pattern->target[s] = (uint8_t) (s / CUBES);
+        }
+    }
+}
+
+// the stickers of the mask (one bit per physical sticker) as the pattern wants them
+void pattern_from_mask(sticker_pattern *pattern, const uint64_t *mask, const uint8_t *colors) {
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        pattern->target[i] = (mask[i / 64] >> (i % 64)) & 1 ? colors[i] : PATTERN_ANY;
+    }
+}
+
+// whether a piece can sit at a coordinate at all (corners have a fixed twist parity per position)
+static int pattern_coord_valid(int piece, int at, int twist) {
+    if(piece_class_of(piece) != CORNER_CLASS) {
+        return 1;
+    }
+    return s4_parity[twist] == corner_twist_parity[piece - FIRST_CORNER][at - FIRST_CORNER];
+}
+
+static uint64_t pattern_mix(uint64_t key, uint64_t value) {
+    key ^= value + 0x9E3779B97F4A7C15 + (key << 6) + (key >> 2);
+    key ^= key >> 31;
+    key *= 0xBF58476D1CE4E5B9;
+    return key ^ (key >> 29);
+}
+
+static int pattern_table_accepts(const void *data, const uint16_t *coords) {
+    const pattern_table_goal *table_goal = data;
+
+    for(int i = 0; i < table_goal->subset->count; i++) {
+        if(!position_in(&table_goal->allow[i], table_goal->goal->meets[table_goal->subset->pieces[i]][coords[i]])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void pattern_cache_init(pattern_cache *cache, void *memory, uint64_t bytes) {
+    cache->memory = memory;
+    cache->bytes = bytes;
+    cache->used = 0;
+    cache->count = 0;
+    cache->built = 0;
+    cache->reused = 0;
+}
+
+/*
+ *  Function:    pattern_table
+ *  ----------------------
+ *  The table of distances until every piece of `subset` fills one of its
+ *      positions in `allow` right, from the cache or built into it.
+ *
+ *  Return:
+ *      the table, or NULL if the cache has no room left for it
+ */
+static const pattern_db *pattern_table(pattern_cache *cache, const pattern_goal *goal, const coord_subset *subset,
+                                       const position_set *allow) {
+    pattern_table_goal table_goal = {goal, subset, {{{0}}}};
+    int twists = coord_twists(subset->piece_class);
+    uint64_t key = (uint64_t) subset->count;
+
+    for(int i = 0; i < subset->count; i++) {
+        int piece = subset->pieces[i];
+        table_goal.allow[i] = allow[i];
+        key = pattern_mix(key, piece);
+        for(int c = 0; c < class_pieces[subset->piece_class] * twists; c++) {
+            if(position_in(&allow[i], goal->meets[piece][c])) {
+                key = pattern_mix(key, (uint64_t) c);
+            }
+        }
+    }
+    for(int i = 0; i < cache->count; i++) {
+        if(cache->entries[i].key == key) {
+            cache->reused++;
+            return &cache->entries[i].db;
+        }
+    }
+
+    uint64_t bytes = (pdb_table_bytes(subset) + 7) & ~(uint64_t) 7;
+    if(cache->count == PATTERN_CACHE_TABLES || bytes == 0 || cache->used + bytes > cache->bytes) {
+        return NULL;
+    }
+    pattern_entry *entry = &cache->entries[cache->count];
+    if(pdb_build_goal(&entry->db, subset, cache->memory + cache->used, pattern_table_accepts, &table_goal) != 0) {
+        return NULL;
+    }
+    entry->key = key;
+    cache->used += bytes;
+    cache->count++;
+    cache->built++;
+    return &entry->db;
+}
+
+static int pattern_add_group(pattern_goal *goal, pattern_cache *cache, const coord_subset *group,
+                             const position_set *allow) {
+    const pattern_db *table = pattern_table(cache, goal, group, allow);
+
+    if(table == NULL) {
+        return -1;
+    }
+    goal->groups[goal->num_groups++] = table;
+    return 0;
+}
+
+// the pieces that can fill a position right, leaving out the ones already bound elsewhere
+static int pattern_candidates(const uint8_t (*fits)[NUM_PIECES], const uint8_t *bound, int at, uint8_t *pieces) {
+    int count = 0;
+
+    for(int p = 0; p < NUM_PIECES; p++) {
+        if(fits[at][p] && !bound[p]) {
+            pieces[count++] = (uint8_t) p;
+        }
+    }
+    return count;
+}
+
+/*
+ *  Function:    pattern_try_prepare
+ *  ----------------------------
+ *  Sorts the constrained positions out:
+ *      - a position only one piece can fill binds that piece there, and the
+ *        piece is then no candidate anywhere else (over and over, until
+ *        nothing changes)
+ *      - the rest fall into groups of positions that share candidates. When a
+ *        group has as many candidates as positions, every candidate has to
+ *        end up in one of them, so the candidates are tracked with that goal
+ *        (the case of a whole cell: the pieces with its color can only swap
+ *        places among its positions)
+ *      - otherwise each position is as near as its nearest candidate
+ *      Pieces with a goal of their own are grouped by class into tables.
+ *
+ *  Return:
+ *      0, -1 if the pattern cannot be reached, -2 if the cache ran out of room
+ */
+static int pattern_try_prepare(pattern_goal *goal, pattern_cache *cache, const sticker_pattern *pattern) {
+    static uint8_t fits[NUM_PIECES][NUM_PIECES];    // fits[at][p]: piece p can fill position at right
+    uint8_t constrained[NUM_PIECES] = {0};
+    uint8_t bound[NUM_PIECES] = {0};                // pieces given a goal of their own
+    uint8_t settled[NUM_PIECES] = {0};              // positions dealt with
+    uint8_t pieces[NUM_PIECES];
+    position_set allow[NUM_PIECES];
+    int p, at, c, changed;
+
+    for(int i = 0; i < SIDES; i++) {
+        int target = pattern->target[i * CUBES + CUBES / 2];
+        if(target != PATTERN_ANY && target != i) {
+            return -1;
+        }
+    }
+    for(int s = 0; s < NUM_STICKERS; s++) {
+        if(pattern->target[s] != PATTERN_ANY && sticker_piece[s] != NO_PIECE) {
+            constrained[sticker_piece[s]] = 1;
+        }
+    }
+
+    goal->num_pieces = 0;
+    goal->num_positions = 0;
+    goal->num_groups = 0;
+    goal->num_choices = 0;
+    for(at = 0; at < NUM_PIECES; at++) {
+        goal->num_positions += constrained[at];
+        allow[at] = (position_set) {{0, 0}};
+        for(p = 0; p < NUM_PIECES; p++) {
+            fits[at][p] = 0;
+        }
+    }
+
+    for(p = 0; p < NUM_PIECES; p++) {
+        int piece_class = piece_class_of(p), size = piece_size[p];
+        int twists = coord_twists(piece_class);
+        int any = 0;
+
+        for(c = 0; c < PATTERN_MAX_COORDS; c++) {
+            goal->meets[p][c] = PATTERN_NONE;
+        }
+        for(c = 0; c < class_pieces[piece_class] * twists; c++) {
+            int twist = c % twists, t;
+            at = class_first[piece_class] + c / twists;
+            if(!constrained[at] || !pattern_coord_valid(p, at, twist)) {
+                continue;
+            }
+            for(t = 0; t < size; t++) {
+                int target = pattern->target[piece_stickers[at][t]];
+                if(target != PATTERN_ANY && target != piece_colors[p][twist_perm[size][twist][t]]) {
+                    break;
+                }
+            }
+            if(t == size) {
+                goal->meets[p][c] = (uint8_t) at;
+                fits[at][p] = 1;
+                any = 1;
+            }
+        }
+        if(any) {
+            goal->pieces[goal->num_pieces++] = (uint8_t) p;
+        }
+    }
+
+    for(changed = 1; changed;) {
+        changed = 0;
+        for(at = 0; at < NUM_PIECES; at++) {
+            if(!constrained[at] || settled[at]) {
+                continue;
+            }
+            int count = pattern_candidates(fits, bound, at, pieces);
+            if(count == 0) {
+                return -1;
+            }
+            if(count == 1) {
+                bound[pieces[0]] = 1;
+                position_add(&allow[pieces[0]], at);
+                settled[at] = 1;
+                changed = 1;
+            }
+        }
+    }
+
+    for(int first = 0; first < NUM_PIECES; first++) {
+        uint8_t positions[NUM_PIECES], in_group[NUM_PIECES] = {0};
+        position_set group = {{0, 0}};
+        int num_positions = 0, num_candidates = 0;
+
+        if(!constrained[first] || settled[first]) {
+            continue;
+        }
+        // the positions linked to `first` through shared candidates
+        positions[num_positions++] = (uint8_t) first;
+        settled[first] = 1;
+        for(int i = 0; i < num_positions; i++) {
+            int count = pattern_candidates(fits, bound, positions[i], pieces);
+            position_add(&group, positions[i]);
+            for(int k = 0; k < count; k++) {
+                if(!in_group[pieces[k]]) {
+                    in_group[pieces[k]] = 1;
+                    num_candidates++;
+                }
+                for(at = 0; at < NUM_PIECES; at++) {
+                    if(constrained[at] && !settled[at] && fits[at][pieces[k]]) {
+                        positions[num_positions++] = (uint8_t) at;
+                        settled[at] = 1;
+                    }
+                }
+            }
+        }
+
+        if(num_candidates == num_positions) {
+            for(p = 0; p < NUM_PIECES; p++) {
+                if(in_group[p]) {
+                    allow[p] = group;
+                }
+            }
+            continue;
+        }
+        for(int i = 0; i < num_positions; i++) {
+            pattern_choice *choice = &goal->choices[goal->num_choices++];
+            int count = pattern_candidates(fits, bound, positions[i], pieces);
+            position_set here = {{0, 0}};
+
+            position_add(&here, positions[i]);
+            choice->count = 0;
+            for(int k = 0; k < count; k++) {
+                coord_subset single = {piece_class_of(pieces[k]), 1, 1, {pieces[k]}};
+                const pattern_db *table = pattern_table(cache, goal, &single, &here);
+                if(table == NULL) {
+                    return -2;
+                }
+                choice->tables[choice->count++] = table;
+            }
+        }
+    }
+
+    // pieces with a goal of their own, grouped by class into tables as big as PATTERN_GROUP_ENTRIES allows
+    for(int piece_class = 0; piece_class < NUM_PIECE_CLASSES; piece_class++) {
+        coord_subset group = {piece_class, 0, 1, {0}};
+        position_set group_allow[MAX_SUBSET_PIECES];
+
+        for(p = class_first[piece_class]; p < class_first[piece_class] + class_pieces[piece_class]; p++) {
+            if(!allow[p].bits[0] && !allow[p].bits[1]) {
+                continue;
+            }
+            group.pieces[group.count] = (uint8_t) p;
+            group_allow[group.count++] = allow[p];
+            if(subset_size(&group) <= PATTERN_GROUP_ENTRIES) {
+                continue;
+            }
+            // p does not fit: the group is done without it, and p starts the next
+            group.count--;
+            if(pattern_add_group(goal, cache, &group, group_allow) != 0) {
+                return -2;
+            }
+            group.pieces[0] = (uint8_t) p;
+            group_allow[0] = allow[p];
+            group.count = 1;
+        }
+        if(group.count > 0 && pattern_add_group(goal, cache, &group, group_allow) != 0) {
+            return -2;
+        }
+    }
+    return 0;
+}
+
+/*
+ *  Function:    pattern_prepare
+ *  ------------------------
+ *  Works out a goal from a pattern and gets the tables it needs from the
+ *      cache, building what is not there. When the cache is full it is
+ *      emptied and the goal prepared again, so a goal only stays good until
+ *      the next pattern_prepare on the same cache.
+ *
+ *  Return:
+ *      0, or -1 if no state shows the pattern or the cache is too small for
+ *          its tables
+ */
+int pattern_prepare(pattern_goal *goal, pattern_cache *cache, const sticker_pattern *pattern) {
+    init_ida_tables();
+
+    int result = pattern_try_prepare(goal, cache, pattern);
+    if(result == -2) {
+        cache->count = 0;
+        cache->used = 0;
+        result = pattern_try_prepare(goal, cache, pattern);
+    }
+    return result == 0 ? 0 : -1;
+}
+
+// whether a state shows the pattern: every constrained position filled right
+int pattern_reached(const void *data, const cubie_state *state) {
+    const pattern_goal *goal = data;
+    int filled = 0;
+
+    for(int i = 0; i < goal->num_pieces; i++) {
+        filled += goal->meets[goal->pieces[i]][piece_coord(state, goal->pieces[i])] != PATTERN_NONE;
+    }
+    return filled == goal->num_positions;
+}
+
+// heuristic for ida.c, data is the pattern_goal
+int pattern_estimate(const void *data, const cubie_state *state) {
+    const pattern_goal *goal = data;
+    int best = 0;
+
+    for(int i = 0; i < goal->num_groups; i++) {
+        int h = pdb_lookup(goal->groups[i], state);
+        if(h > best) {
+            best = h;
+        }
+    }
+    for(int i = 0; i < goal->num_choices; i++) {
+        const pattern_choice *choice = &goal->choices[i];
+        int nearest = PDB_MAX_DEPTH;
+        for(int k = 0; k < choice->count && nearest > best; k++) {
+            int h = pdb_lookup(choice->tables[k], state);
+            if(h < nearest) {
+                nearest = h;
+            }
+        }
+        if(nearest > best) {
+            best = nearest;
+        }
+    }
+    return best;
+}
+
+// sets a search up to look for the goal instead of solved; then ida_solve as usual
+void pattern_search_init(ida_search *search, const pattern_goal *goal) {
+    heuristic estimate = {pattern_estimate, goal};
+
+    init_ida_search(search, &estimate, 1);
+    search->goal = pattern_reached;
+    search->goal_data = goal;
+}
+
+#endif // PATTERN_C
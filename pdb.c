@@ -0,0 +1,351 @@
+//
+// Pattern databases: the exact number of cell twists needed to solve a subset
+// of the pieces (coord.c), for every state of that subset. Any full state
+// needs at least that many twists, so a lookup is an admissible heuristic.
+// Move-ins only turn the view, so they cost nothing here.
+//
+// Distances are nibble packed, two per byte, entry i in the low nibble of
+// byte i / 2 when i is even. A file is a pdb_header followed by the table,
+// little endian, so a solver can mmap it and every process shares one copy.
+//
+
+#ifndef PDB_C
+#define PDB_C
+
+#include "coord.c"
+
+#define PDB_MAGIC "R4DPDB1"
+#define PDB_VERSION 1
+#define PDB_HEADER_SIZE 256
+#define PDB_UNSEEN 0xF
+// deepest distance stored. Anything still unseen after it gets this value,
+// which stays admissible
+#define PDB_MAX_DEPTH 14
+#define PDB_HISTOGRAM 16
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t piece_class;
+    uint32_t count;
+    uint32_t track_twist;
+    uint32_t max_depth;                 // largest distance in the table
+    uint64_t entries;
+    uint64_t table_bytes;
+    uint64_t histogram[PDB_HISTOGRAM];  // entries at each distance
+    uint8_t pieces[MAX_SUBSET_PIECES];
+    uint8_t reserved[PDB_HEADER_SIZE - 208];
+} pdb_header;
+
+typedef struct {
+    pdb_header header;
+    coord_subset subset;
+    const uint8_t *table;
+    void *mapping;          // set when the table was mapped from a file
+    size_t mapping_size;
+} pattern_db;
+
+static inline int pdb_get(const uint8_t *table, uint64_t i) {
+    return (table[i >> 1] >> ((i & 1) << 2)) & 0xF;
+}
+
+static inline void pdb_set(uint8_t *table, uint64_t i, int value) {
+    int shift = (int) (i & 1) << 2;
+    table[i >> 1] = (uint8_t) ((table[i >> 1] & ~(0xF << shift)) | (value << shift));
+}
+
+// bytes of table a subset needs, or 0 if it cannot be indexed
+uint64_t pdb_table_bytes(const coord_subset *subset) {
+    uint64_t entries = subset_size(subset);
+    return entries == 0 ? 0 : (entries + 1) / 2;
+}
+
+// index of the state after `move`, from the piece coordinates of the state before
+static uint64_t pdb_neighbour(const coord_subset *subset, const uint16_t *coords, int move) {
+    uint16_t moved[MAX_SUBSET_PIECES];
+
+    for(int i = 0; i < subset->count; i++) {
+        moved[i] = coords[i];
+    }
+    subset_move(subset, moved, move);
+    return subset_rank(subset, moved);
+}
+
+// whether piece coordinates of a subset (in subset order) are a goal
+typedef int (*pdb_goal_fn)(const void *data, const uint16_t *coords);
+
+/*
+ *  Function:    pdb_build_goal
+ *  -----------------------
+ *  Breadth first search from the goal states of the subset over all cell
+ *      twists, one distance at a time. While the frontier is smaller than
+ *      what is left, it expands the frontier; after that it is cheaper to go
+ *      the other way and ask, for each unseen entry, whether a neighbour is on
+ *      the frontier (every twist has its inverse in the move set, so the two
+ *      agree).
+ *
+ *  Input params:
+ *      pattern_db *db:             filled in, table pointing at `table`
+ *      const coord_subset *subset: pieces to track
+ *      uint8_t *table:             pdb_table_bytes(subset) bytes
+ *      pdb_goal_fn goal:           which entries are at distance 0, or NULL
+ *                                  for just the solved one
+ *      const void *data:           passed to goal
+ *
+ *  Return:
+ *      0 on success, -1 if the subset is too big to index or has no goal
+ *
+ *  Runtime Complexity: O(entries * NUM_CELL_TWISTS * count^2)
+ */
+int pdb_build_goal(pattern_db *db, const coord_subset *subset, uint8_t *table, pdb_goal_fn goal, const void *data) {
+    pdb_header *header = &db->header;
+    uint64_t entries = subset_size(subset);
+    uint64_t unseen, frontier, i;
+    uint16_t coords[MAX_SUBSET_PIECES];
+    cubie_state solved;
+    int depth, m;
+
+    if(entries == 0 || entries > UINT64_MAX / 2) {
+        return -1;
+    }
+    init_coord_tables();
+
+    for(i = 0; i < sizeof(pdb_header); i++) {
+        ((uint8_t *) header)[i] = 0;
+    }
+    for(i = 0; i < sizeof(PDB_MAGIC); i++) {
+        header->magic[i] = PDB_MAGIC[i];
+    }
+    header->version = PDB_VERSION;
+    header->header_size = PDB_HEADER_SIZE;
+    header->piece_class = (uint32_t) subset->piece_class;
+    header->count = (uint32_t) subset->count;
+    header->track_twist = (uint32_t) subset->track_twist;
+    header->entries = entries;
+    header->table_bytes = (entries + 1) / 2;
+    for(i = 0; i < (uint64_t) subset->count; i++) {
+        header->pieces[i] = subset->pieces[i];
+    }
+    db->subset = *subset;
+    db->table = table;
+    db->mapping = NULL;
+    db->mapping_size = 0;
+
+    for(i = 0; i < header->table_bytes; i++) {
+        table[i] = 0xFF;
+    }
+
+    frontier = 0;
+    if(goal == NULL) {
+        cubie_reset(&solved);
+        subset_coords(subset, &solved, coords);
+        pdb_set(table, subset_rank(subset, coords), 0);
+        frontier = 1;
+    }
+    else {
+        for(i = 0; i < entries; i++) {
+            subset_unrank(subset, i, coords);
+            if(goal(data, coords)) {
+                pdb_set(table, i, 0);
+                frontier++;
+            }
+        }
+        if(frontier == 0) {
+            return -1;
+        }
+    }
+    unseen = entries - frontier;
+    header->histogram[0] = frontier;
+
+    for(depth = 0; depth < PDB_MAX_DEPTH && frontier > 0 && unseen > 0; depth++) {
+        uint64_t found = 0;
+
+        if(frontier < unseen) {
+            for(i = 0; i < entries; i++) {
+                if(pdb_get(table, i) != depth) {
+                    continue;
+                }
+                subset_unrank(subset, i, coords);
+                for(m = 0; m < NUM_CELL_TWISTS; m++) {
+                    uint64_t next = pdb_neighbour(subset, coords, m);
+                    if(pdb_get(table, next) == PDB_UNSEEN) {
+                        pdb_set(table, next, depth + 1);
+                        found++;
+                    }
+                }
+            }
+        }
+        else {
+            for(i = 0; i < entries; i++) {
+                if(pdb_get(table, i) != PDB_UNSEEN) {
+                    continue;
+                }
+                subset_unrank(subset, i, coords);
+                for(m = 0; m < NUM_CELL_TWISTS; m++) {
+                    if(pdb_get(table, pdb_neighbour(subset, coords, m)) == depth) {
+                        pdb_set(table, i, depth + 1);
+                        found++;
+                        break;
+                    }
+                }
+            }
+        }
+
+        header->histogram[depth + 1] = found;
+        frontier = found;
+        unseen -= found;
+        if(found > 0) {
+            header->max_depth = (uint32_t) depth + 1;
+        }
+    }
+
+    if(unseen > 0) {
+        for(i = 0; i < entries; i++) {
+            if(pdb_get(table, i) == PDB_UNSEEN) {
+                pdb_set(table, i, PDB_MAX_DEPTH);
+            }
+        }
+        header->histogram[PDB_MAX_DEPTH] += unseen;
+        header->max_depth = PDB_MAX_DEPTH;
+    }
+    return 0;
+}
+
+// the table of distances to the solved subset
+int pdb_build(pattern_db *db, const coord_subset *subset, uint8_t *table) {
+    return pdb_build_goal(db, subset, table, NULL, NULL);
+}
+
+/*
+ *  Function:    pdb_attach
+ *  -------------------
+ *  Points a pattern_db at a file image already in memory (read, mapped or
+ *      embedded), after checking the header against the table.
+ *
+ *  Return:
+ *      0 on success, -1 if the image is not a table this build can read
+ */
+int pdb_attach(pattern_db *db, const void *image, uint64_t size) {
+    const pdb_header *header = (const pdb_header *) image;
+    uint64_t i;
+
+    if(size < sizeof(pdb_header)) {
+        return -1;
+    }
+    for(i = 0; i < sizeof(PDB_MAGIC); i++) {
+        if(header->magic[i] != PDB_MAGIC[i]) {
+            return -1;
+        }
+    }
+    if(header->version != PDB_VERSION || header->header_size != PDB_HEADER_SIZE ||
+       header->piece_class >= NUM_PIECE_CLASSES || header->count == 0 ||
+       header->count > (uint32_t) class_pieces[header->piece_class]) {
+        return -1;
+    }
+
+    db->header = *header;
+    db->subset.piece_class = (int) header->piece_class;
+    db->subset.count = (int) header->count;
+    db->subset.track_twist = header->track_twist != 0;
+    for(i = 0; i < header->count; i++) {
+        if(piece_class_of(header->pieces[i]) != (int) header->piece_class) {
+            return -1;
+        }
+        db->subset.pieces[i] = header->pieces[i];
+    }
+    if(subset_size(&db->subset) != header->entries || header->table_bytes != (header->entries + 1) / 2 ||
+       size - sizeof(pdb_header) < header->table_bytes) {
+        return -1;
+    }
+
+    init_coord_tables();
+    db->table = (const uint8_t *) image + sizeof(pdb_header);
+    db->mapping = NULL;
+    db->mapping_size = 0;
+    return 0;
+}
+
+int pdb_distance(const pattern_db *db, uint64_t index) {
+    return pdb_get(db->table, index);
+}
+
+// distance of the subset's pieces in a full state
+int pdb_lookup(const pattern_db *db, const cubie_state *state) {
+    uint16_t coords[MAX_SUBSET_PIECES];
+
+    subset_coords(&db->subset, state, coords);
+    return pdb_get(db->table, subset_rank(&db->subset, coords));
+}
+
+#ifndef __wasm__
+// file io for the native tools and solvers
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+int pdb_save(const pattern_db *db, const char *path) {
+    FILE *file = fopen(path, "wb");
+    int ok;
+
+    if(file == NULL) {
+        return -1;
+    }
+    ok = fwrite(&db->header, sizeof(pdb_header), 1, file) == 1 &&
+         fwrite(db->table, 1, (size_t) db->header.table_bytes, file) == db->header.table_bytes;
+    if(fclose(file) != 0) {
+        ok = 0;
+    }
+    return ok ? 0 : -1;
+}
+
+/*
+ *  Function:    pdb_load
+ *  -----------------
+ *  Maps a table file read only and shared, so every process that loads the
+ *      same file reads the same pages out of the page cache.
+ *
+ *  Return:
+ *      0 on success, -1 if the file cannot be mapped or is not a table
+ */
+int pdb_load(pattern_db *db, const char *path) {
+    struct stat info;
+    void *mapping;
+    int fd = open(path, O_RDONLY);
+
+    if(fd < 0) {
+        return -1;
+    }
+    if(fstat(fd, &info) != 0 || info.st_size < (off_t) sizeof(pdb_header)) {
+        close(fd);
+        return -1;
+    }
+    mapping = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(mapping == MAP_FAILED) {
+        return -1;
+    }
+
+    if(pdb_attach(db, mapping, (uint64_t) info.st_size) != 0) {
+        munmap(mapping, (size_t) info.st_size);
+        return -1;
+    }
+    // lookups jump all over the table
+    madvise(mapping, (size_t) info.st_size, MADV_RANDOM);
+    db->mapping = mapping;
+    db->mapping_size = (size_t) info.st_size;
+    return 0;
+}
+
+void pdb_unload(pattern_db *db) {
+    if(db->mapping != NULL) {
+        munmap(db->mapping, db->mapping_size);
+    }
+    db->mapping = NULL;
+    db->table = NULL;
+}
+#endif // __wasm__
+
+#endif // PDB_C
@@ -0,0 +1,857 @@
+//
+// Sticker engine for the 4D cube: the twist/move-in primitives that act on
+// the 8 x 27 stickers, plus the orientation layer that keeps move-ins off
+// the sticker data.
+//
+
+#ifndef PUZZLE_C
+#define PUZZLE_C
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define CUBES 27
+#define SIDES 8
+#define NUM_CORNERS 8
+#define DIMENSION 3
+#define CORE_CUBE 0
+#define HIDDEN_CUBE 7
+#define NUM_STICKERS (CUBES * SIDES)
+
+#define TO_REVERSE 1
+
+#define NO_AXIS -1
+#define X_AXIS 0
+#define Y_AXIS 1
+#define Z_AXIS 2
+
+
+typedef struct {
+    float x, y, z;
+} Point_3D;
+
+typedef struct {
+    Point_3D points[NUM_CORNERS];
+    uint32_t color;
+    int selected;
+    int id;
+} cube;
+
+void move_color(cube *dest, cube *src) {
+    dest->color = src->color;
+}
+
+void rotate_center(cube *cubes, int select, int order, int **anchors) {
+
+    // order is 4 digit: 3210
+    int side_1 = (order / 1000) % 10;
+    int side_2 = (order / 100) % 10;
+    int side_3 = (order / 10) % 10;
+    int side_4 = order % 10;
+
+    int i, j, count;
+    cube temp_cubes[DIMENSION * DIMENSION];
+
+    count = 0;
+    for(i = 0; i < DIMENSION; i++) {
+        for(j = 0; j < DIMENSION; j++) {
+            move_color(&temp_cubes[count], &cubes[anchors[side_1][i] + anchors[side_1][3] * j]);
+            count++;
+        }
+    }
+
+
+    for(i = 0; i < DIMENSION; i++) {
+        for(j = 0; j < DIMENSION; j++) {
+            move_color(&cubes[anchors[side_1][i] + anchors[side_1][3] * j], &cubes[anchors[side_2][i] + anchors[side_2][3] * j]);
+        }
+    }
+
+
+    for(i = 0; i < DIMENSION; i++) {
+        for(j = 0; j < DIMENSION; j++) {
+            move_color(&cubes[anchors[side_2][i] + anchors[side_2][3] * j], &cubes[anchors[side_3][i] + anchors[side_3][3] * j]);
+        }
+    }
+
+    for(i = 0; i < DIMENSION; i++) {
+        for(j = 0; j < DIMENSION; j++) {
+            move_color(&cubes[anchors[side_3][i] + anchors[side_3][3] * j], &cubes[anchors[side_4][i] + anchors[side_4][3] * j]);
+        }
+    }
+
+    count = 0;
+    for(i = 0; i < DIMENSION; i++) {
+        for(j = 0; j < DIMENSION; j++) {
+            move_color(&cubes[anchors[side_4][i] + anchors[side_4][3] * j], &temp_cubes[count]);
+            count++;
+        }
+    }
+}
+
+void flip(int *to_reverse) {
+    // swap indexes 0 and 3; 1 and 2
+    int temp;
+
+    temp = to_reverse[0];
+    to_reverse[0] = to_reverse[3];
+    to_reverse[3] = temp;
+
+    temp = to_reverse[1];
+    to_reverse[1] = to_reverse[2];
+    to_reverse[2] = temp;
+}
+
+void rotate_self(cube *cubes, int cube_num, int corner_anchors[4], int edge_anchors[4], int increment, int reverse) {
+    // rotate corners
+    int i, j, count;
+    cube temp_cubes[DIMENSION];
+
+    int anchor_corners[5] = {cube_num * CUBES + corner_anchors[0], cube_num * CUBES + corner_anchors[1],
+                             cube_num * CUBES + corner_anchors[2], cube_num * CUBES + corner_anchors[3],
+                             increment};
+
+    int anchor_edges[5] = {cube_num * CUBES + edge_anchors[0], cube_num * CUBES + edge_anchors[1],
+                           cube_num * CUBES + edge_anchors[2], cube_num * CUBES + edge_anchors[3],
+                           increment};
+
+    if(reverse) {
+        flip(anchor_corners);
+        flip(anchor_edges);
+    }
+
+    count = 0;
+    for(i = 0; i < DIMENSION; i++) {
+        move_color(&temp_cubes[count], &cubes[anchor_corners[0] + anchor_corners[4] * i]);
+        count++;
+    }
+    for(i = 0; i < DIMENSION; i++) {
+        move_color(&cubes[anchor_corners[0] + anchor_corners[4] * i], &cubes[anchor_corners[1] + anchor_corners[4] * i]);
+    }
+    for(i = 0; i < DIMENSION; i++) {
+        move_color(&cubes[anchor_corners[1] + anchor_corners[4] * i], &cubes[anchor_corners[2] + anchor_corners[4] * i]);
+    }
+    for(i = 0; i < DIMENSION; i++) {
+        move_color(&cubes[anchor_corners[2] + anchor_corners[4] * i], &cubes[anchor_corners[3] + anchor_corners[4] * i]);
+    }
+    count = 0;
+    for(i = 0; i < DIMENSION; i++) {
+        move_color(&cubes[anchor_corners[3] + anchor_corners[4] * i], &temp_cubes[count]);
+        count++;
+    }
+
+
+    // rotate edges
+    count = 0;
+    for(i = 0; i < DIMENSION; i++) {
+        move_color(&temp_cubes[count], &cubes[anchor_edges[0] + anchor_edges[4] * i]);
+        count++;
+    }
+    for(i = 0; i < DIMENSION; i++) {
+        move_color(&cubes[anchor_edges[0] + anchor_edges[4] * i], &cubes[anchor_edges[1] + anchor_edges[4] * i]);
+    }
+    for(i = 0; i < DIMENSION; i++) {
+        move_color(&cubes[anchor_edges[1] + anchor_edges[4] * i], &cubes[anchor_edges[2] + anchor_edges[4] * i]);
+    }
+    for(i = 0; i < DIMENSION; i++) {
+        move_color(&cubes[anchor_edges[2] + anchor_edges[4] * i], &cubes[anchor_edges[3] + anchor_edges[4] * i]);
+    }
+    count = 0;
+    for(i = 0; i < DIMENSION; i++) {
+        move_color(&cubes[anchor_edges[3] + anchor_edges[4] * i], &temp_cubes[count]);
+        count++;
+    }
+
+}
+
+void change_center(cube *cubes, const int *cube_order) {
+
+    int moving_in = cube_order[0];
+
+    int corner_anchors_x[4] = {0, 6, 8, 2};
+    int edge_anchors_x[4] = {3, 7, 5, 1};
+    int increment_x = 9;
+
+    int corner_anchors_y[4] = {0, 2, 20, 18};
+    int edge_anchors_y[4] = {1, 11, 19, 9};
+    int increment_y = 3;
+
+    int corner_anchors_z[4] = {18, 24, 6, 0};
+    int edge_anchors_z[4] = {9, 21, 15, 3};
+    int increment_z = 1;
+
+    int reverse;
+
+
+    // the 7th cube is not rotated here. it keeps whatever orientation it had,
+    // which is why it is stored mirrored along the axis of the last move-in
+    // (see hidden_slot below)
+    if(moving_in == 1 || moving_in == 6) {
+        reverse = (moving_in == 1);
+
+        rotate_self(cubes, 2, corner_anchors_x, edge_anchors_x, increment_x, reverse);
+        rotate_self(cubes, 4, corner_anchors_x, edge_anchors_x, increment_x, !reverse);
+
+        rotate_self(cubes, 3, corner_anchors_z, edge_anchors_z, increment_z, !reverse);
+        rotate_self(cubes, 5, corner_anchors_z, edge_anchors_z, increment_z, reverse);
+    }
+
+    if(moving_in == 2 || moving_in == 4) {
+        reverse = (moving_in == 2);
+
+        rotate_self(cubes, 1, corner_anchors_x, edge_anchors_x, increment_x, !reverse);
+        rotate_self(cubes, 6, corner_anchors_x, edge_anchors_x, increment_x, reverse);
+
+        rotate_self(cubes, 3, corner_anchors_y, edge_anchors_y, increment_y, !reverse);
+        rotate_self(cubes, 5, corner_anchors_y, edge_anchors_y, increment_y, reverse);
+    }
+
+    if(moving_in == 3 || moving_in == 5) {
+
+        reverse = (moving_in == 3);
+
+        rotate_self(cubes, 1, corner_anchors_z, edge_anchors_z, increment_z, reverse);
+        rotate_self(cubes, 6, corner_anchors_z, edge_anchors_z, increment_z, !reverse);
+
+        rotate_self(cubes, 2, corner_anchors_y, edge_anchors_y, increment_y, reverse);
+        rotate_self(cubes, 4, corner_anchors_y, edge_anchors_y, increment_y, !reverse);
+    }
+
+    int i;
+    cube temp_cubes[CUBES];
+    int count = 0;
+
+
+    for(i = cube_order[0] * CUBES; i < (cube_order[0] + 1) * CUBES; i++) {
+        move_color(&temp_cubes[count], &cubes[i]);
+        count++;
+    }
+
+    count = cube_order[0] * CUBES;
+    for(i = cube_order[1] * CUBES; i < (cube_order[1] + 1) * CUBES; i++) {
+        move_color(&cubes[count], &cubes[i]);
+        count++;
+    }
+
+    count = cube_order[1] * CUBES;
+    for(i = cube_order[2] * CUBES; i < (cube_order[2] + 1) * CUBES; i++) {
+        move_color(&cubes[count], &cubes[i]);
+        count++;
+    }
+
+    count = cube_order[2] * CUBES;
+    for(i = cube_order[3] * CUBES; i < (cube_order[3] + 1) * CUBES; i++) {
+        move_color(&cubes[count], &cubes[i]);
+        count++;
+    }
+
+    count = 0;
+    for(i = cube_order[3] * CUBES; i < (cube_order[3] + 1) * CUBES; i++) {
+        move_color(&cubes[i], &temp_cubes[count]);
+        count++;
+    }
+
+}
+
+void rotate_sandwich(cube *cubes, int bread, int anchor_1[8], int anchor_2[8], int reversed) {
+    if(reversed) {
+        flip(anchor_1);
+        flip(&anchor_1[4]);
+        flip(anchor_2);
+        flip(&anchor_2[4]);
+    }
+
+    cube temp_cube;
+
+    move_color(&temp_cube, &cubes[anchor_1[0]]);
+    move_color(&cubes[anchor_1[0]], &cubes[anchor_1[1]]);
+    move_color(&cubes[anchor_1[1]], &cubes[anchor_1[2]]);
+    move_color(&cubes[anchor_1[2]], &cubes[anchor_1[3]]);
+    move_color(&cubes[anchor_1[3]], &temp_cube);
+
+    move_color(&temp_cube, &cubes[anchor_1[4]]);
+    move_color(&cubes[anchor_1[4]], &cubes[anchor_1[5]]);
+    move_color(&cubes[anchor_1[5]], &cubes[anchor_1[6]]);
+    move_color(&cubes[anchor_1[6]], &cubes[anchor_1[7]]);
+    move_color(&cubes[anchor_1[7]], &temp_cube);
+
+
+    move_color(&temp_cube, &cubes[anchor_2[0]]);
+    move_color(&cubes[anchor_2[0]], &cubes[anchor_2[1]]);
+    move_color(&cubes[anchor_2[1]], &cubes[anchor_2[2]]);
+    move_color(&cubes[anchor_2[2]], &cubes[anchor_2[3]]);
+    move_color(&cubes[anchor_2[3]], &temp_cube);
+
+    move_color(&temp_cube, &cubes[anchor_2[4]]);
+    move_color(&cubes[anchor_2[4]], &cubes[anchor_2[5]]);
+    move_color(&cubes[anchor_2[5]], &cubes[anchor_2[6]]);
+    move_color(&cubes[anchor_2[6]], &cubes[anchor_2[7]]);
+    move_color(&cubes[anchor_2[7]], &temp_cube);
+}
+
+void rotate_edge(cube *cubes, int select, const int anchor_a[4], const int anchor_b[4]) {
+    
+    int i, j;
+    cube temp_cube;
+
+    for(i=0; i < DIMENSION; i++) {
+        for(j=0; j < DIMENSION; j++) {
+            move_color(&temp_cube, &cubes[anchor_a[i] + anchor_a[3] * j]);
+            move_color(&cubes[anchor_a[i] + anchor_a[3] * j], &cubes[anchor_b[i] + anchor_b[3] * j]);
+            move_color(&cubes[anchor_b[i] + anchor_b[3] * j], &temp_cube);
+        }
+    }
+
+}
+
+void rotate_center_piece(cube *cubes, int select) {
+    int order;
+    int bread;
+
+    // for rotate self
+    int corner_anchors_x[4] = {0, 6, 8, 2};
+    int edge_anchors_x[4] = {3, 7, 5, 1};
+    int increment_x = 9;
+
+    int corner_anchors_y[4] = {0, 2, 20, 18};
+    int edge_anchors_y[4] = {1, 11, 19, 9};
+    int increment_y = 3;
+
+    int corner_anchors_z[4] = {18, 24, 6, 0};
+    int edge_anchors_z[4] = {9, 21, 15, 3};
+    int increment_z = 1;
+
+    // for sandwich turns
+    int sandwich_1[8] = {1 * CUBES + 6, 1 * CUBES + 8, 1 * CUBES + 26, 1 * CUBES + 24, 1 * CUBES + 7, 1 * CUBES + 17, 1 * CUBES + 25, 1 * CUBES + 15};
+    int sandwich_2[8] = {2 * CUBES + 6, 2 * CUBES + 0, 2 * CUBES + 18, 2 * CUBES + 24, 2 * CUBES + 3, 2 * CUBES + 9, 2 * CUBES + 21, 2 * CUBES + 15};
+    int sandwich_3[8] = {3 * CUBES + 2, 3 * CUBES + 0, 3 * CUBES + 6, 3 * CUBES + 8, 3 * CUBES + 5, 3 * CUBES + 1, 3 * CUBES + 3, 3 * CUBES + 7};
+    int sandwich_4[8] = {4 * CUBES + 2, 4 * CUBES + 20, 4 * CUBES + 26, 4 * CUBES + 8, 4 * CUBES + 5, 4 * CUBES + 11, 4 * CUBES + 23, 4 * CUBES + 17};
+    int sandwich_5[8] = {5 * CUBES + 20, 5 * CUBES + 18, 5 * CUBES + 24, 5 * CUBES + 26, 5 * CUBES + 23, 5 * CUBES + 19, 5 * CUBES + 21, 5 * CUBES + 25};
+    int sandwich_6[8] = {6 * CUBES + 0, 6 * CUBES + 2, 6 * CUBES + 20, 6 * CUBES + 18, 6 * CUBES + 1, 6 * CUBES + 11, 6 * CUBES + 19, 6 * CUBES + 9};
+
+
+
+    switch(select) {
+        case 4:
+            // about x
+            order = 1462;
+            bread = 35;
+
+            int anchor_1_x[4] = {1 * CUBES + 8, 1 * CUBES + 7, 1 * CUBES + 6, 9};
+            int anchor_4_x[4] = {4 * CUBES + 2, 4 * CUBES + 5, 4 * CUBES + 8, 9};
+            int anchor_6_x[4] = {6 * CUBES + 0, 6 * CUBES + 1, 6 * CUBES + 2, 9};
+            int anchor_2_x[4] = {2 * CUBES + 6, 2 * CUBES + 3, 2 * CUBES + 0, 9};
+            int *anchors_x[7] = {NULL, anchor_1_x, anchor_2_x, NULL, anchor_4_x, NULL, anchor_6_x};
+
+            rotate_center(cubes, select, order, anchors_x);
+            rotate_sandwich(cubes, bread, sandwich_3, sandwich_5, !TO_REVERSE);
+            rotate_self(cubes, 0, corner_anchors_x, edge_anchors_x, increment_x, !TO_REVERSE); // correct
+
+            break;
+        case 10:
+            // about y
+            order = 5234;
+            bread = 35;
+
+            int anchor_5_y[4] = {5 * CUBES + 18, 5 * CUBES + 19, 5 * CUBES + 20, 3};
+            int anchor_2_y[4] = {2 * CUBES + 0, 2 * CUBES + 9, 2 * CUBES + 18, 3};
+            int anchor_3_y[4] = {3 * CUBES + 2, 3 * CUBES + 1, 3 * CUBES + 0, 3};
+            int anchor_4_y[4] = {4 * CUBES + 20, 4 * CUBES + 11, 4 * CUBES + 2, 3};
+            int *anchors_y[7] = {NULL, NULL, anchor_2_y, anchor_3_y, anchor_4_y, anchor_5_y, NULL};
+
+            rotate_center(cubes, select, order, anchors_y);
+            rotate_sandwich(cubes, bread, sandwich_1, sandwich_6, !TO_REVERSE);
+            rotate_self(cubes, 0, corner_anchors_y, edge_anchors_y, increment_y, !TO_REVERSE); // correct
+
+            break;
+        case 12:
+            // about z
+            order = 5136;
+            bread = 0;
+
+            int anchor_5_z[4] = {5 * CUBES + 26, 5 * CUBES + 23, 5 * CUBES + 20, -1};
+            int anchor_1_z[4] = {1 * CUBES + 8, 1 * CUBES + 17, 1 * CUBES + 26, -1};
+            int anchor_3_z[4] = {3 * CUBES + 2, 3 * CUBES + 5, 3 * CUBES + 8, -1};
+            int anchor_6_z[4] = {6 * CUBES + 20, 6 * CUBES + 11, 6 * CUBES + 2, -1};
+            int *anchors_z[7] = {NULL, anchor_1_z, NULL, anchor_3_z, NULL, anchor_5_z, anchor_6_z};
+
+            rotate_center(cubes, select, order, anchors_z);
+
+            rotate_sandwich(cubes, bread, sandwich_2, sandwich_4, !TO_REVERSE);
+
+            rotate_self(cubes, 0, corner_anchors_z, edge_anchors_z, increment_z, !TO_REVERSE); // correct
+            break;
+        case 14:
+            // about z
+            order = 6315;
+
+            int anchor_5_z_[4] = {5 * CUBES + 26, 5 * CUBES + 23, 5 * CUBES + 20, -1};
+            int anchor_1_z_[4] = {1 * CUBES + 8, 1 * CUBES + 17, 1 * CUBES + 26, -1};
+            int anchor_3_z_[4] = {3 * CUBES + 2, 3 * CUBES + 5, 3 * CUBES + 8, -1};
+            int anchor_6_z_[4] = {6 * CUBES + 20, 6 * CUBES + 11, 6 * CUBES + 2, -1};
+            int *anchors_z_[7] = {NULL, anchor_1_z_, NULL, anchor_3_z_, NULL, anchor_5_z_, anchor_6_z_};
+
+            rotate_center(cubes, select, order, anchors_z_);
+
+            rotate_sandwich(cubes, bread, sandwich_2, sandwich_4, TO_REVERSE);
+
+            rotate_self(cubes, 0, corner_anchors_z, edge_anchors_z, increment_z, TO_REVERSE); // reverse
+            break;
+        case 16:
+            // about y
+            order = 4325;
+
+            int anchor_5_y_[4] = {5 * CUBES + 18, 5 * CUBES + 19, 5 * CUBES + 20, 3};
+            int anchor_2_y_[4] = {2 * CUBES + 0, 2 * CUBES + 9, 2 * CUBES + 18, 3};
+            int anchor_3_y_[4] = {3 * CUBES + 2, 3 * CUBES + 1, 3 * CUBES + 0, 3};
+            int anchor_4_y_[4] = {4 * CUBES + 20, 4 * CUBES + 11, 4 * CUBES + 2, 3};
+            int *anchors_y_[7] = {NULL, NULL, anchor_2_y_, anchor_3_y_, anchor_4_y_, anchor_5_y_, NULL};
+
+            rotate_center(cubes, select, order, anchors_y_);
+
+            rotate_sandwich(cubes, bread, sandwich_1, sandwich_6, TO_REVERSE);
+
+            rotate_self(cubes, 0, corner_anchors_y, edge_anchors_y, increment_y, TO_REVERSE); // reverse
+            break;
+        case 22:
+            // about x
+            order = 2641;
+
+            int anchor_1_x_[4] = {1 * CUBES + 8, 1 * CUBES + 7, 1 * CUBES + 6, 9};
+            int anchor_4_x_[4] = {4 * CUBES + 2, 4 * CUBES + 5, 4 * CUBES + 8, 9};
+            int anchor_6_x_[4] = {6 * CUBES + 0, 6 * CUBES + 1, 6 * CUBES + 2, 9};
+            int anchor_2_x_[4] = {2 * CUBES + 6, 2 * CUBES + 3, 2 * CUBES + 0, 9};
+            int *anchors_x_[7] = {NULL, anchor_1_x_, anchor_2_x_, NULL, anchor_4_x_, NULL, anchor_6_x_};
+
+            rotate_center(cubes, select, order, anchors_x_);
+
+            rotate_sandwich(cubes, bread, sandwich_3, sandwich_5, TO_REVERSE);
+
+            rotate_self(cubes, 0, corner_anchors_x, edge_anchors_x, increment_x, TO_REVERSE); // reverse
+            break;
+        default:
+            order = 0;
+    }
+}
+
+
+
+void rotate(cube *cubes, int select) {
+    // 3 types: corner, edge, center. and core
+
+    // for rotate self
+    int corner_anchors_x[4] = {0, 6, 8, 2};
+    int edge_anchors_x[4] = {3, 7, 5, 1};
+    int increment_x = 9;
+
+    int corner_anchors_y[4] = {0, 2, 20, 18};
+    int edge_anchors_y[4] = {1, 11, 19, 9};
+    int increment_y = 3;
+
+    int corner_anchors_z[4] = {18, 24, 6, 0};
+    int edge_anchors_z[4] = {9, 21, 15, 3};
+    int increment_z = 1;
+
+
+    // core
+    if(select == 13) {
+        return;
+    }
+    int reverse = 1;
+    // edge
+    if(select % 2 == 1) {
+        switch(select) {
+            case 3:
+            case 23:
+                rotate_center_piece(cubes, 10);
+                rotate_center_piece(cubes, 12);
+                rotate_center_piece(cubes, 12);
+                break;
+
+            case 5:
+            case 21:
+                rotate_center_piece(cubes, 10);
+                rotate_center_piece(cubes, 4);
+                rotate_center_piece(cubes, 4);
+                break;
+
+            case 9:
+            case 17:
+                rotate_center_piece(cubes, 4);
+                rotate_center_piece(cubes, 10);
+                rotate_center_piece(cubes, 10);
+                break;
+
+            case 11:
+            case 15:
+                rotate_center_piece(cubes, 4);
+                rotate_center_piece(cubes, 12);
+                rotate_center_piece(cubes, 12);
+                break;
+
+            case 1:
+            case 25:
+                rotate_center_piece(cubes, 12);
+                rotate_center_piece(cubes, 4);
+                rotate_center_piece(cubes, 4);
+
+                break;
+
+            case 7:
+            case 19:
+                rotate_center_piece(cubes, 12);
+                rotate_center_piece(cubes, 10);
+                rotate_center_piece(cubes, 10);
+
+                break;
+
+            default:
+                break;
+        }
+    }
+    // center
+    else if(select == 4 || select == 10 || select == 12 || select == 14 || select == 16 || select == 22) {
+        rotate_center_piece(cubes, select);
+    }
+    else {
+        switch(select) {
+            case 0:
+                rotate_center_piece(cubes, 12);
+                rotate_center_piece(cubes, 4);
+
+                break;
+
+            case 2:
+                rotate_center_piece(cubes, 10);
+                rotate_center_piece(cubes, 4);
+
+                break;
+
+            case 6:
+                rotate_center_piece(cubes, 12);
+                rotate_center_piece(cubes, 16);
+
+                break;
+
+            case 8:
+                rotate_center_piece(cubes, 16);
+                rotate_center_piece(cubes, 14);
+                break;
+
+            case 18:
+                rotate_center_piece(cubes, 10);
+                rotate_center_piece(cubes, 22);
+                break;
+
+            case 20:
+                rotate_center_piece(cubes, 14);
+                rotate_center_piece(cubes, 22);
+                break;
+
+            case 24:
+                rotate_center_piece(cubes, 22);
+                rotate_center_piece(cubes, 16);
+                break;
+
+            case 26:
+                rotate_center_piece(cubes, 22);
+                rotate_center_piece(cubes, 14);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+}
+
+
+
+// ---------------------------------------------------------------------------
+// Orientation layer
+//
+// A move-in only turns the whole puzzle, so instead of recoloring stickers it
+// updates `orientation`, an index into the 192 rotations of the tesseract.
+// Stickers stay in a fixed (physical) frame and every read goes through
+// orient_remap[orientation], which maps a view index (cube * CUBES + slot, as
+// the renderer and rotate() see it) to the physical index holding its color.
+//
+// All state of one puzzle is in a `puzzle`, so a process can hold as many as
+// it likes. The tables below are shared and never change once built.
+// ---------------------------------------------------------------------------
+
+#define NUM_ORIENTATIONS 192
+
+typedef struct {
+    uint8_t stickers[NUM_STICKERS];     // color index (0 - 7) of each physical sticker
+    int orientation;                    // index into orient_remap
+    int last_move_in_axis;              // axis the hidden cube is mirrored along when viewed
+} puzzle;
+
+static uint8_t twist_table[CUBES][NUM_STICKERS];
+static uint8_t orient_remap[NUM_ORIENTATIONS][NUM_STICKERS];
+static uint8_t orient_move_in[NUM_ORIENTATIONS][SIDES - 1];
+static int num_orientations;
+static int tables_ready;
+
+// the 4 cubes cycled by change_center for each move-in
+static const int move_in_orders[SIDES - 1][4] = {
+        {0, 0, 0, 0},
+        {1, 7, 6, 0},
+        {2, 7, 4, 0},
+        {3, 7, 5, 0},
+        {4, 7, 2, 0},
+        {5, 7, 3, 0},
+        {6, 7, 1, 0},
+};
+
+int move_in_axis(int moving_in) {
+    switch(moving_in) {
+        case 1:
+        case 6:
+            return Y_AXIS;
+        case 2:
+        case 4:
+            return Z_AXIS;
+        case 3:
+        case 5:
+            return X_AXIS;
+        default:
+            return NO_AXIS;
+    }
+}
+
+int mirror_slot(int slot, int axis) {
+    int i = slot / (DIMENSION * DIMENSION);
+    int j = (slot / DIMENSION) % DIMENSION;
+    int k = slot % DIMENSION;
+
+    if(axis == X_AXIS) i = DIMENSION - 1 - i;
+    if(axis == Y_AXIS) j = DIMENSION - 1 - j;
+    if(axis == Z_AXIS) k = DIMENSION - 1 - k;
+
+    return i * DIMENSION * DIMENSION + j * DIMENSION + k;
+}
+
+/*
+ *  Function:    hidden_slot
+ *  ------------------------
+ *  change_center never turns the hidden (7th) cube, so the slots of that cube
+ *      as seen after a move-in along `axis` are its slots mirrored along that
+ *      axis. The physical frame keeps the hidden cube mirrored along the y-axis;
+ *      this maps a slot between the two (the mapping is its own inverse).
+ *
+ *  Input params:
+ *      int slot:       slot in the hidden cube (0 - 26)
+ *      int axis:       axis the caller's view is mirrored along
+ */
+int hidden_slot(int slot, int axis) {
+    if(axis == NO_AXIS || axis == Y_AXIS) {
+        return slot;
+    }
+    return mirror_slot(mirror_slot(slot, Y_AXIS), axis);
+}
+
+int find_orientation(const uint8_t *remap) {
+    int i, o;
+    for(o = 0; o < num_orientations; o++) {
+        for(i = 0; i < NUM_STICKERS; i++) {
+            if(orient_remap[o][i] != remap[i]) {
+                break;
+            }
+        }
+        if(i == NUM_STICKERS) {
+            return o;
+        }
+    }
+    return -1;
+}
+
+/*
+ *  Function:    init_puzzle_tables
+ *  ---------------------------
+ *  Derives the lookup tables from rotate() and change_center() by running them
+ *      once on stickers labelled with their own index:
+ *          twist_table[select][i]:     view index whose color moves into i
+ *          orient_remap[o][i]:         physical index shown at view index i
+ *          orient_move_in[o][k]:       orientation after moving cube k in
+ *      The orientations are the closure of the 6 move-ins, found breadth first.
+ */
+void init_puzzle_tables(void) {
+    static cube scratch[NUM_STICKERS];
+    static uint8_t generators[SIDES - 1][NUM_STICKERS];
+    uint8_t remap[NUM_STICKERS];
+    int i, k, o, select;
+
+    if(tables_ready) {
+        return;
+    }
+
+    for(select = 0; select < CUBES; select++) {
+        for(i = 0; i < NUM_STICKERS; i++) {
+            scratch[i].color = i;
+        }
+        rotate(scratch, select);
+        for(i = 0; i < NUM_STICKERS; i++) {
+            twist_table[select][i] = scratch[i].color;
+        }
+    }
+
+    // move-ins as seen in the physical frame
+    for(k = 1; k < SIDES - 1; k++) {
+        int axis = move_in_axis(k);
+
+        for(i = 0; i < NUM_STICKERS; i++) {
+            scratch[i].color = i;
+        }
+        change_center(scratch, move_in_orders[k]);
+
+        for(i = 0; i < NUM_STICKERS; i++) {
+            int from = i;
+            if(from / CUBES == HIDDEN_CUBE) {
+                from = HIDDEN_CUBE * CUBES + hidden_slot(from % CUBES, axis);
+            }
+            from = scratch[from].color;
+            if(from / CUBES == HIDDEN_CUBE) {
+                from = HIDDEN_CUBE * CUBES + hidden_slot(from % CUBES, axis);
+            }
+            generators[k][i] = from;
+        }
+    }
+
+    for(i = 0; i < NUM_STICKERS; i++) {
+        orient_remap[0][i] = i;
+    }
+    num_orientations = 1;
+
+    for(o = 0; o < num_orientations; o++) {
+        for(k = 1; k < SIDES - 1; k++) {
+            for(i = 0; i < NUM_STICKERS; i++) {
+                remap[i] = orient_remap[o][generators[k][i]];
+            }
+
+            int found = find_orientation(remap);
+            if(found < 0) {
+                found = num_orientations++;
+                for(i = 0; i < NUM_STICKERS; i++) {
+                    orient_remap[found][i] = remap[i];
+                }
+            }
+            orient_move_in[o][k] = found;
+        }
+    }
+
+    tables_ready = 1;
+}
+
+/*
+ *  Function:    reset_puzzle
+ *  ---------------------
+ *  Puts the stickers back in the solved state, facing the default way.
+ */
+void reset_puzzle(puzzle *p) {
+    init_puzzle_tables();
+
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        p->stickers[i] = i / CUBES;
+    }
+    p->orientation = 0;
+    p->last_move_in_axis = NO_AXIS;
+}
+
+/*
+ *  Function:    view_sticker
+ *  ---------------------
+ *  Returns the color index (0 - 7) shown at a view index, i.e. the cube and
+ *      slot as they are laid out on screen.
+ */
+int view_sticker(const puzzle *p, int index) {
+    if(index / CUBES == HIDDEN_CUBE) {
+        index = HIDDEN_CUBE * CUBES + hidden_slot(index % CUBES, p->last_move_in_axis);
+    }
+    return p->stickers[orient_remap[p->orientation][index]];
+}
+
+/*
+ *  Function:    twist
+ *  --------------
+ *  Applies rotate(select) to the center cube as currently viewed.
+ *
+ *  Runtime Complexity: O(NUM_STICKERS)
+ */
+void twist(puzzle *p, int select) {
+    const uint8_t *remap = orient_remap[p->orientation];
+    const uint8_t *perm = twist_table[select];
+    uint8_t moved[NUM_STICKERS];
+    int i;
+
+    for(i = 0; i < NUM_STICKERS; i++) {
+        moved[i] = p->stickers[remap[perm[i]]];
+    }
+    for(i = 0; i < NUM_STICKERS; i++) {
+        p->stickers[remap[i]] = moved[i];
+    }
+}
+
+/*
+ *  Function:    preview_move_in
+ *  ------------------------
+ *  Called while a move-in is being animated: the hidden cube becomes visible
+ *      and is drawn mirrored along the axis of the move.
+ */
+void preview_move_in(puzzle *p, int moving_in) {
+    p->last_move_in_axis = move_in_axis(moving_in);
+}
+
+/*
+ *  Function:    move_in
+ *  ----------------
+ *  Brings cube `moving_in` (1 - 6) to the center. Only the orientation changes.
+ *
+ *  Runtime Complexity: O(1)
+ */
+void move_in(puzzle *p, int moving_in) {
+    if(moving_in < 1 || moving_in >= HIDDEN_CUBE) {
+        return;
+    }
+    p->orientation = orient_move_in[p->orientation][moving_in];
+    p->last_move_in_axis = move_in_axis(moving_in);
+}
+
+// Move ids, shared by everything that records or searches moves:
+//      0 - 26:     twist of the center cube, same as render()'s select (13 is the core, a no-op)
+//      27 - 32:    move-in of cube 1 - 6
+#define FIRST_MOVE_IN CUBES
+#define NUM_MOVES (FIRST_MOVE_IN + SIDES - 2)
+
+int is_move_in(int move) {
+    return move >= FIRST_MOVE_IN;
+}
+
+// the select value render() expects for a move
+int move_select(int move) {
+    if(is_move_in(move)) {
+        return (move - FIRST_MOVE_IN + 1) * CUBES;
+    }
+    return move;
+}
+
+// the move id render() makes of a select, -1 when it makes none
+int select_move(int select) {
+    if(select >= CUBES) {
+        int moving_in = select / CUBES;
+        return moving_in >= 1 && moving_in < HIDDEN_CUBE ? FIRST_MOVE_IN + moving_in - 1 : -1;
+    }
+    return select >= 0 ? select : -1;
+}
+
+void apply_move(puzzle *p, int move) {
+    if(is_move_in(move)) {
+        move_in(p, move - FIRST_MOVE_IN + 1);
+    }
+    else {
+        twist(p, move);
+    }
+}
+
+#endif // PUZZLE_C
@@ -0,0 +1,544 @@
+//
+// Fast, non-optimal solver: reduction through the stabilizer chain of group.c.
+//
+// Phase i takes the puzzle from the subgroup that keeps the base points of
+// levels 0 - i-1 in place to the one that also keeps base point i, with a
+// table that holds, for every sticker the base point can have moved to, a
+// twist sequence bringing it home without disturbing the earlier ones. A
+// solve is one lookup and one table word per phase, the words joined with
+// cancellation across the phases; states a few twists from solved are
+// searched for a shortest solution first. Away from solved the solutions are
+// still a couple of thousand twists long: fine to check or batch, too long to
+// animate.
+//
+// The words come from Minkwitz's method: words are sifted down the chain,
+// each one filling or shortening the entries it passes, and every level is
+// then closed under products of its own entries. Short random words fill and
+// shorten the first levels; commutators of two entries, which leave most of
+// the puzzle alone, reach the deep ones.
+//
+// Building takes seconds, so the words can be saved (reduction_image) and
+// attached again later (reduction_attach), e.g. by tools/reduce.c from a
+// file an earlier run wrote. The page does not use them.
+//
+
+#ifndef REDUCE_C
+#define REDUCE_C
+
+#include "group.c"
+#include "ida.c"
+#include "moves.c"
+#include "simplify.c"
+
+#define MAX_PHASE_ENTRIES 4096
+#define MAX_PHASE_WORD 254
+#define NO_WORD 0xFF
+
+#define SIFT_WORD_LENGTH 6          // random words are 1 - SIFT_WORD_LENGTH twists
+#define SIFT_WORDS_PER_ROUND 4000   // half random words, half commutators
+#define COMMUTATOR_LENGTH 120       // longest commutator sifted
+#define IMPROVE_ROUNDS 60           // rounds after every entry has a word, to shorten them
+#define MAX_SIFT_ROUNDS 1000
+
+#define REDUCTION_SEARCH_DEPTH 4        // states this close get a shortest solution from a search instead
+#define REDUCTION_SEARCH_NODES 200000   // the search gives up after this many nodes
+
+#define REDUCTION_MAGIC "R4DRED1"
+#define REDUCTION_VERSION 1
+
+typedef struct {
+    uint8_t perm[NUM_STICKERS];
+    uint8_t word[MAX_PHASE_WORD];
+    int length;
+} phase_element;
+
+// entries are indexed like the reps of puzzle_chain; phase_perm[e] is the
+// product of phase_word[e], with phase_inverse[e] its inverse
+static uint8_t phase_length[MAX_PHASE_ENTRIES];
+static uint8_t phase_word[MAX_PHASE_ENTRIES][MAX_PHASE_WORD];
+static uint8_t phase_perm[MAX_PHASE_ENTRIES][NUM_STICKERS];
+static uint8_t phase_inverse[MAX_PHASE_ENTRIES][NUM_STICKERS];
+static uint8_t cell_twist_inverse[NUM_CELL_TWISTS];
+static int reduction_ready;
+
+static void store_entry(int entry, const phase_element *e) {
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        phase_perm[entry][i] = e->perm[i];
+    }
+    perm_invert(e->perm, phase_inverse[entry]);
+    for(int i = 0; i < e->length; i++) {
+        phase_word[entry][i] = e->word[i];
+    }
+    phase_length[entry] = (uint8_t) e->length;
+}
+
+static void load_entry(int entry, phase_element *e) {
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        e->perm[i] = phase_perm[entry][i];
+    }
+    for(int i = 0; i < phase_length[entry]; i++) {
+        e->word[i] = phase_word[entry][i];
+    }
+    e->length = phase_length[entry];
+}
+
+// recomputes the permutation of an entry from its word
+static void entry_from_word(int entry) {
+    phase_element e;
+
+    perm_identity(e.perm);
+    e.length = phase_length[entry];
+    for(int i = 0; i < e.length; i++) {
+        e.word[i] = phase_word[entry][i];
+        perm_compose(e.perm, cell_twist_perm[e.word[i]], e.perm);
+    }
+    store_entry(entry, &e);
+}
+
+/*
+ *  Function:    phase_sift
+ *  -------------------
+ *  Sifts one word down the chain. At each level the word either fills the
+ *      empty entry of the point it brings home, or trades places with a longer
+ *      entry, and then has that entry's inverse put in front of it so it keeps
+ *      the base point in place for the levels below.
+ */
+static void phase_sift(phase_element *t) {
+    const stabilizer_chain *chain = &puzzle_chain;
+    phase_element held;
+
+    for(int level = 0; level < chain->num_levels && !perm_is_identity(t->perm); level++) {
+        int entry = chain->rep[level][t->perm[chain->base[level]]];
+        int length = phase_length[entry];
+
+        if(length == NO_WORD) {
+            store_entry(entry, t);
+            return;
+        }
+        if(t->length < length) {
+            load_entry(entry, &held);
+            store_entry(entry, t);
+            *t = held;
+            length = phase_length[entry];
+        }
+
+        // inverse of the entry, then t
+        if(length + t->length > MAX_PHASE_WORD) {
+            return;
+        }
+        for(int i = t->length - 1; i >= 0; i--) {
+            t->word[i + length] = t->word[i];
+        }
+        for(int i = 0; i < length; i++) {
+            t->word[i] = cell_twist_inverse[phase_word[entry][length - 1 - i]];
+        }
+        t->length += length;
+        perm_compose(phase_inverse[entry], t->perm, t->perm);
+    }
+}
+
+static void sift_random_word(rng_state *rng) {
+    phase_element t;
+
+    perm_identity(t.perm);
+    t.length = 1 + (int) rng_below(rng, SIFT_WORD_LENGTH);
+    for(int i = 0; i < t.length; i++) {
+        t.word[i] = (uint8_t) rng_below(rng, NUM_CELL_TWISTS);
+        perm_compose(t.perm, cell_twist_perm[t.word[i]], t.perm);
+    }
+    phase_sift(&t);
+}
+
+// sifts a b a^-1 b^-1 for two random entries a and b that have words
+static void sift_commutator(rng_state *rng) {
+    const uint8_t *word[2];
+    int length[2];
+    phase_element t;
+
+    for(int k = 0; k < 2; k++) {
+        int entry;
+        do {
+            entry = (int) rng_below(rng, (uint32_t) puzzle_chain.num_reps);
+        } while(phase_length[entry] == NO_WORD || phase_length[entry] == 0);
+        word[k] = phase_word[entry];
+        length[k] = phase_length[entry];
+    }
+    if(2 * (length[0] + length[1]) > COMMUTATOR_LENGTH) {
+        return;
+    }
+
+    t.length = 0;
+    for(int k = 0; k < 2; k++) {
+        for(int i = 0; i < length[k]; i++) {
+            t.word[t.length++] = word[k][i];
+        }
+    }
+    for(int k = 0; k < 2; k++) {
+        for(int i = length[k] - 1; i >= 0; i--) {
+            t.word[t.length++] = cell_twist_inverse[word[k][i]];
+        }
+    }
+    perm_identity(t.perm);
+    for(int i = 0; i < t.length; i++) {
+        perm_compose(t.perm, cell_twist_perm[t.word[i]], t.perm);
+    }
+    phase_sift(&t);
+}
+
+/*
+ *  Function:    close_level
+ *  --------------------
+ *  Entry z sends every point w of the orbit to some y; when y has an entry,
+ *      z then y brings w home. Repeats until no entry of the level gets a word
+ *      or a shorter one.
+ */
+static void close_level(int level) {
+    const stabilizer_chain *chain = &puzzle_chain;
+    int changed = 1;
+
+    while(changed) {
+        changed = 0;
+        for(int n = 0; n < chain->orbit_size[level]; n++) {
+            int z = chain->rep[level][chain->orbit[level][n]];
+            if(phase_length[z] == NO_WORD) {
+                continue;
+            }
+
+            for(int k = 0; k < chain->orbit_size[level]; k++) {
+                int w = chain->rep[level][chain->orbit[level][k]];
+                int y = chain->rep[level][phase_inverse[z][chain->orbit[level][k]]];
+                int length = phase_length[z] + phase_length[y];
+
+                if(phase_length[y] == NO_WORD || length > MAX_PHASE_WORD ||
+                   (phase_length[w] != NO_WORD && phase_length[w] <= length)) {
+                    continue;
+                }
+                for(int i = 0; i < phase_length[z]; i++) {
+                    phase_word[w][i] = phase_word[z][i];
+                }
+                for(int i = 0; i < phase_length[y]; i++) {
+                    phase_word[w][phase_length[z] + i] = phase_word[y][i];
+                }
+                phase_length[w] = (uint8_t) length;
+                perm_compose(phase_perm[z], phase_perm[y], phase_perm[w]);
+                perm_invert(phase_perm[w], phase_inverse[w]);
+                changed = 1;
+            }
+        }
+    }
+}
+
+static int phase_entries_missing(void) {
+    int missing = 0;
+    for(int entry = 0; entry < puzzle_chain.num_reps; entry++) {
+        if(phase_length[entry] == NO_WORD) {
+            missing++;
+        }
+    }
+    return missing;
+}
+
+// sets up the chain and the inverse of every cell twist, which the tables are built on
+static int init_phase_basics(void) {
+    if(init_puzzle_chain() != 0 || puzzle_chain.num_reps > MAX_PHASE_ENTRIES) {
+        return -1;
+    }
+    init_move_tables();
+
+    for(int m = 0; m < NUM_CELL_TWISTS; m++) {
+        for(int t = 0; t < TWISTS_PER_CELL; t++) {
+            if(twist_product[m][t] == NO_TWIST) {
+                cell_twist_inverse[m] = (uint8_t) (m - m % TWISTS_PER_CELL + t);
+            }
+        }
+    }
+    return 0;
+}
+
+/*
+ *  Function:    init_reduction_tables
+ *  ------------------------------
+ *  Builds the phase tables (and the chain they follow), unless some were
+ *      attached. Takes a few seconds, so it is done once, on first use.
+ *
+ *  Return:
+ *      0 on success, -1 if the chain could not be built or some entry never
+ *          got a word
+ */
+int init_reduction_tables(void) {
+    rng_state rng;
+    int improve = IMPROVE_ROUNDS;
+
+    if(reduction_ready) {
+        return 0;
+    }
+    if(init_phase_basics() != 0) {
+        return -1;
+    }
+
+    for(int entry = 0; entry < puzzle_chain.num_reps; entry++) {
+        phase_length[entry] = NO_WORD;
+    }
+    for(int level = 0; level < puzzle_chain.num_levels; level++) {
+        phase_length[puzzle_chain.rep[level][puzzle_chain.base[level]]] = 0;
+        entry_from_word(puzzle_chain.rep[level][puzzle_chain.base[level]]);
+    }
+
+    rng_seed(&rng, 0x5EED);
+    for(int round = 0; round < MAX_SIFT_ROUNDS && improve > 0; round++) {
+        for(int n = 0; n < SIFT_WORDS_PER_ROUND; n++) {
+            if(n & 1) {
+                sift_commutator(&rng);
+            }
+            else {
+                sift_random_word(&rng);
+            }
+        }
+        for(int level = 0; level < puzzle_chain.num_levels; level++) {
+            close_level(level);
+        }
+        if(phase_entries_missing() == 0) {
+            improve--;
+        }
+    }
+    if(improve > 0) {
+        return -1;
+    }
+
+    reduction_ready = 1;
+    return 0;
+}
+
+/*
+ *  Function:    reduction_image_size
+ *  -----------------------------
+ *  Bytes reduction_image writes: the magic and version, the chain's shape (so
+ *      a different chain is refused on attach), then every entry's word.
+ */
+int reduction_image_size(void) {
+    int size = 8 + 4 + 4 + puzzle_chain.num_levels * 3;
+    for(int entry = 0; entry < puzzle_chain.num_reps; entry++) {
+        size += 1 + phase_length[entry];
+    }
+    return size;
+}
+
+// writes the built tables into `image` (reduction_image_size() bytes)
+void reduction_image(uint8_t *image) {
+    int n = 0;
+
+    for(int i = 0; i < 8; i++) {
+        image[n++] = (uint8_t) REDUCTION_MAGIC[i];
+    }
+    for(int shift = 0; shift < 32; shift += 8) {
+        image[n++] = (uint8_t) (REDUCTION_VERSION >> shift);
+    }
+    for(int shift = 0; shift < 32; shift += 8) {
+        image[n++] = (uint8_t) (puzzle_chain.num_levels >> shift);
+    }
+    for(int level = 0; level < puzzle_chain.num_levels; level++) {
+        image[n++] = puzzle_chain.base[level];
+        image[n++] = (uint8_t) puzzle_chain.orbit_size[level];
+        image[n++] = (uint8_t) (puzzle_chain.orbit_size[level] >> 8);
+    }
+    for(int entry = 0; entry < puzzle_chain.num_reps; entry++) {
+        image[n++] = phase_length[entry];
+        for(int i = 0; i < phase_length[entry]; i++) {
+            image[n++] = phase_word[entry][i];
+        }
+    }
+}
+
+/*
+ *  Function:    reduction_attach
+ *  -------------------------
+ *  Takes the tables from an image made by reduction_image instead of building
+ *      them. Every word is checked to bring its point home.
+ *
+ *  Return:
+ *      0 on success, -1 if the image does not fit this build's chain
+ */
+int reduction_attach(const uint8_t *image, int size) {
+    int n = 0, levels = 0;
+
+    if(init_phase_basics() != 0 || size < 16) {
+        return -1;
+    }
+    for(int i = 0; i < 8; i++) {
+        if(image[n++] != (uint8_t) REDUCTION_MAGIC[i]) {
+            return -1;
+        }
+    }
+    if(image[n] != REDUCTION_VERSION || image[n + 1] || image[n + 2] || image[n + 3]) {
+        return -1;
+    }
+    n += 4;
+    for(int shift = 0; shift < 32; shift += 8) {
+        levels |= image[n++] << shift;
+    }
+    if(levels != puzzle_chain.num_levels || size < n + levels * 3) {
+        return -1;
+    }
+    for(int level = 0; level < levels; level++, n += 3) {
+        if(image[n] != puzzle_chain.base[level] ||
+           (image[n + 1] | image[n + 2] << 8) != puzzle_chain.orbit_size[level]) {
+            return -1;
+        }
+    }
+
+    for(int entry = 0; entry < puzzle_chain.num_reps; entry++) {
+        if(n >= size || image[n] == NO_WORD || n + 1 + image[n] > size) {
+            return -1;
+        }
+        phase_length[entry] = image[n++];
+        for(int i = 0; i < phase_length[entry]; i++) {
+            if(image[n] >= NUM_CELL_TWISTS) {
+                return -1;
+            }
+            phase_word[entry][i] = image[n++];
+        }
+        entry_from_word(entry);
+    }
+
+    for(int level = 0; level < levels; level++) {
+        for(int k = 0; k < puzzle_chain.orbit_size[level]; k++) {
+            int point = puzzle_chain.orbit[level][k];
+            if(phase_perm[puzzle_chain.rep[level][point]][puzzle_chain.base[level]] != point) {
+                return -1;
+            }
+        }
+    }
+
+    reduction_ready = 1;
+    return 0;
+}
+
+// appends a twist to a solution, cancelling or merging it into an earlier twist of its cell past every twist
+// in between that it commutes with, across the joins of the phases
+static void append_twist(uint8_t *twists, int *n, int move) {
+    for(int i = *n - 1; i >= 0; i--) {
+        int earlier = twists[i];
+
+        if(earlier / TWISTS_PER_CELL == move / TWISTS_PER_CELL) {
+            int merged = twist_product[earlier][move % TWISTS_PER_CELL];
+            if(merged == KEEP_BOTH) {
+                break;
+            }
+            if(merged != NO_TWIST) {
+                twists[i] = (uint8_t) merged;
+                return;
+            }
+            for(int k = i; k < *n - 1; k++) {
+                twists[k] = twists[k + 1];
+            }
+            (*n)--;
+            return;
+        }
+        if(!twist_commutes[earlier][move]) {
+            break;
+        }
+    }
+    twists[(*n)++] = (uint8_t) move;
+}
+
+/*
+ *  Function:    reduction_solve
+ *  ------------------------
+ *  Solves a piece state phase by phase, after a short bounded search (IDA*,
+ *      misplaced pieces) that gives states a few twists from solved a
+ *      shortest solution instead. The words of the phases are joined with
+ *      cancellation, see append_twist.
+ *
+ *  Input params:
+ *      const cubie_state *state:   state to solve
+ *      uint8_t *twists:            where the cell twists go
+ *      int capacity:               room in twists
+ *
+ *  Return:
+ *      the number of cell twists, or -1 if the state is not reachable (or
+ *          the solution does not fit)
+ */
+int reduction_solve(const cubie_state *state, uint8_t *twists, int capacity) {
+    const stabilizer_chain *chain = &puzzle_chain;
+    uint8_t perm[NUM_STICKERS], inverse[NUM_STICKERS];
+    static const heuristic misplaced = {misplaced_estimate, NULL};
+    static ida_search search;
+    int n = 0;
+
+    if(init_reduction_tables() != 0) {
+        return -1;
+    }
+    if(capacity >= REDUCTION_SEARCH_DEPTH) {
+        init_ida_search(&search, &misplaced, 1);
+        search.node_limit = REDUCTION_SEARCH_NODES;
+        n = ida_solve(&search, state, REDUCTION_SEARCH_DEPTH, twists);
+        if(n >= 0) {
+            return n;
+        }
+        n = 0;
+    }
+    // the state's inverse, so where each base point went is one lookup
+    state_perm(state, perm);
+    perm_invert(perm, inverse);
+
+    for(int level = 0; level < chain->num_levels; level++) {
+        int entry = chain->rep[level][inverse[chain->base[level]]];
+        if(entry == NO_REP) {
+            return -1;
+        }
+
+        for(int i = 0; i < phase_length[entry]; i++) {
+            if(n == capacity) {
+                return -1;
+            }
+            append_twist(twists, &n, phase_word[entry][i]);
+        }
+        perm_compose(phase_inverse[entry], inverse, inverse);
+    }
+    return perm_is_identity(inverse) ? n : -1;
+}
+
+/*
+ *  Function:    reduction_solve_puzzle
+ *  -------------------------------
+ *  Solves a puzzle as it is seen, as move ids, with the whole sequence run
+ *      through the simplifier of simplify.c.
+ *
+ *      Away from solved, the solutions are still around 2000 cell twists and
+ *      twice that in move ids (tools/reduce.c prints the averages): correct,
+ *      but far too long for the front end to animate. Only states the bounded
+ *      search solves come out short.
+ *
+ *  Return:
+ *      the number of move ids, or -1 if the stickers are not a reachable
+ *          state (or the solution does not fit)
+ */
+int reduction_solve_puzzle(const puzzle *p, uint8_t *moves, int capacity) {
+    static uint8_t twists[MAX_PHASE_WORD * MAX_CHAIN_LEVELS];
+    static uint8_t scratch[SIMPLIFY_SCRATCH_PER_MOVE * MAX_PHASE_WORD * MAX_CHAIN_LEVELS * MAX_CELL_TWIST_MOVES];
+    uint8_t step[MAX_CELL_TWIST_MOVES];
+    cubie_state state;
+    int orientation = p->orientation;
+    int count, n = 0;
+
+    if(puzzle_to_cubies(p, &state) != 0) {
+        return -1;
+    }
+    count = reduction_solve(&state, twists, MAX_PHASE_WORD * MAX_CHAIN_LEVELS);
+    if(count < 0) {
+        return -1;
+    }
+
+    for(int i = 0; i < count; i++) {
+        int written = cell_twist_moves(&orientation, twists[i], step);
+        if(written < 0 || n + written > capacity) {
+            return -1;
+        }
+        for(int k = 0; k < written; k++) {
+            moves[n++] = step[k];
+        }
+    }
+    return simplify_moves(moves, n, moves, scratch);
+}
+
+#endif // REDUCE_C
@@ -0,0 +1,258 @@
+//
+// Replay files: a session's move ids with a snapshot of the whole puzzle
+// every `interval` moves, so any point of a long session is one snapshot and
+// fewer than `interval` moves away.
+//
+//      header:     "R4DLOG1\0", version (u32), interval (u32)
+//      blocks:     a snapshot (the packed stickers of import.c, the
+//                  orientation, the last move-in axis + 1), then the block's
+//                  moves, 6 bits each, four to three bytes, low bits first
+//      trailer:    moves (u64), "R4DEND1\0"
+// Numbers are little endian. Every block but the last holds exactly
+// `interval` moves, so blocks have one size and the offset of move i is
+// arithmetic: the fixed layout is the index, and a file can be read straight
+// from memory (mmap) with nothing loaded first.
+//
+// A writer hands out each block as soon as it is full, so a file being
+// written is a valid file without its trailer: a reader takes the whole
+// blocks it finds. Finishing adds the last, partial block (with a snapshot of
+// the final state, even when it holds no move) and the trailer.
+//
+
+#ifndef REPLAY_C
+#define REPLAY_C
+
+#include "import.c"
+
+#define REPLAY_MAGIC "R4DLOG1"
+#define REPLAY_END_MAGIC "R4DEND1"
+#define REPLAY_VERSION 1
+#define REPLAY_HEADER_BYTES 16
+#define REPLAY_TRAILER_BYTES 16
+#define REPLAY_SNAPSHOT_BYTES (IMPORT_PACKED_BYTES + 2)
+#define REPLAY_MAX_INTERVAL 4096
+#define REPLAY_MAX_BLOCK_BYTES (REPLAY_SNAPSHOT_BYTES + REPLAY_MAX_INTERVAL / 4 * 3)
+
+// receives the bytes of a file in order
+typedef void (*replay_sink)(void *data, const uint8_t *bytes, uint32_t count);
+
+typedef struct {
+    replay_sink sink;
+    void *sink_data;
+    uint32_t interval;          // moves per block, a multiple of 4
+    uint32_t in_block;          // moves in the block being filled
+    uint64_t moves;
+    puzzle state;               // after every move written so far
+    uint8_t block[REPLAY_MAX_BLOCK_BYTES];
+} replay_writer;
+
+typedef struct {
+    const uint8_t *data;
+    uint64_t size;
+    uint32_t interval;
+    uint32_t block_bytes;       // of a full block
+    uint64_t blocks;
+    uint64_t moves;
+    int finished;               // whether the file has its trailer (else it is still being written)
+} replay_reader;
+
+static void replay_put_u32(uint8_t *out, uint32_t value) {
+    for(int i = 0; i < 4; i++) {
+        out[i] = (uint8_t) (value >> (8 * i));
+    }
+}
+
+static uint32_t replay_get_u32(const uint8_t *in) {
+    return (uint32_t) in[0] | (uint32_t) in[1] << 8 | (uint32_t) in[2] << 16 | (uint32_t) in[3] << 24;
+}
+
+static uint32_t replay_block_bytes(uint32_t moves) {
+    return REPLAY_SNAPSHOT_BYTES + (moves + 3) / 4 * 3;
+}
+
+// starts the block being filled with a snapshot of the writer's state
+static void replay_snapshot(replay_writer *w) {
+    export_packed(&w->state, w->block);
+    w->block[IMPORT_PACKED_BYTES] = (uint8_t) w->state.orientation;
+    w->block[IMPORT_PACKED_BYTES + 1] = (uint8_t) (w->state.last_move_in_axis + 1);
+    for(uint32_t i = REPLAY_SNAPSHOT_BYTES; i < replay_block_bytes(w->interval); i++) {
+        w->block[i] = 0;
+    }
+    w->in_block = 0;
+}
+
+/*
+ *  Function:    replay_start
+ *  ---------------------
+ *  Starts a file: writes the header to the sink and takes the first
+ *      snapshot.
+ *
+ *  Input params:
+ *      replay_writer *w:
+ *      const puzzle *start:    the state before the first move
+ *      uint32_t interval:      moves between snapshots, a multiple of 4 up to
+ *                              REPLAY_MAX_INTERVAL
+ *      replay_sink sink:       where the bytes go, with sink_data
+ *
+ *  Return:
+ *      0, or -1 if the interval is not one a file can have
+ */
+int replay_start(replay_writer *w, const puzzle *start, uint32_t interval, replay_sink sink, void *sink_data) {
+    uint8_t header[REPLAY_HEADER_BYTES];
+
+    if(interval < 4 || interval > REPLAY_MAX_INTERVAL || interval % 4 != 0) {
+        return -1;
+    }
+    init_import_tables();
+    w->sink = sink;
+    w->sink_data = sink_data;
+    w->interval = interval;
+    w->moves = 0;
+    w->state = *start;
+
+    for(int i = 0; i < 8; i++) {
+        header[i] = (uint8_t) REPLAY_MAGIC[i];
+    }
+    replay_put_u32(header + 8, REPLAY_VERSION);
+    replay_put_u32(header + 12, interval);
+    sink(sink_data, header, REPLAY_HEADER_BYTES);
+    replay_snapshot(w);
+    return 0;
+}
+
+// adds a move id (puzzle.c) to the file; a block that fills goes to the sink at once
+void replay_write(replay_writer *w, int move) {
+    uint8_t *group = w->block + REPLAY_SNAPSHOT_BYTES + w->in_block / 4 * 3;
+    uint32_t bits = (uint32_t) (move & 63) << (w->in_block % 4 * 6);
+
+    group[0] |= (uint8_t) bits;
+    group[1] |= (uint8_t) (bits >> 8);
+    group[2] |= (uint8_t) (bits >> 16);
+    apply_move(&w->state, move);
+    w->moves++;
+
+    if(++w->in_block == w->interval) {
+        w->sink(w->sink_data, w->block, replay_block_bytes(w->interval));
+        replay_snapshot(w);
+    }
+}
+
+// ends the file: the last block, then the trailer. The writer is done after this
+void replay_finish(replay_writer *w) {
+    uint8_t trailer[REPLAY_TRAILER_BYTES];
+
+    w->sink(w->sink_data, w->block, replay_block_bytes(w->in_block));
+    for(int i = 0; i < 8; i++) {
+        trailer[i] = (uint8_t) (w->moves >> (8 * i));
+        trailer[8 + i] = (uint8_t) REPLAY_END_MAGIC[i];
+    }
+    w->sink(w->sink_data, trailer, REPLAY_TRAILER_BYTES);
+}
+
+/*
+ *  Function:    replay_open
+ *  --------------------
+ *  Reads a file's layout from its bytes, which stay where they are. A file
+ *      without a trailer is taken as one still being written: its whole
+ *      blocks are read and the rest ignored.
+ *
+ *  Return:
+ *      0, or -1 if the bytes are not a replay file
+ */
+int replay_open(replay_reader *r, const uint8_t *data, uint64_t size) {
+    if(size < REPLAY_HEADER_BYTES) {
+        return -1;
+    }
+    for(int i = 0; i < 8; i++) {
+        if(data[i] != (uint8_t) REPLAY_MAGIC[i]) {
+            return -1;
+        }
+    }
+    r->interval = replay_get_u32(data + 12);
+    if(replay_get_u32(data + 8) != REPLAY_VERSION || r->interval < 4 || r->interval > REPLAY_MAX_INTERVAL ||
+       r->interval % 4 != 0) {
+        return -1;
+    }
+    init_import_tables();
+    r->data = data;
+    r->size = size;
+    r->block_bytes = replay_block_bytes(r->interval);
+
+    // a trailer counts only when the size agrees with it: the end of a file
+    // still being written may happen to hold its magic
+    r->finished = size >= REPLAY_HEADER_BYTES + REPLAY_SNAPSHOT_BYTES + REPLAY_TRAILER_BYTES;
+    for(int i = 0; i < 8 && r->finished; i++) {
+        r->finished = data[size - 8 + i] == (uint8_t) REPLAY_END_MAGIC[i];
+    }
+    if(r->finished) {
+        uint64_t moves = 0;
+        for(int i = 0; i < 8; i++) {
+            moves |= (uint64_t) data[size - REPLAY_TRAILER_BYTES + i] << (8 * i);
+        }
+        uint64_t full = moves / r->interval;
+        r->finished = full <= (size - REPLAY_HEADER_BYTES) / r->block_bytes &&
+                      size == REPLAY_HEADER_BYTES + full * r->block_bytes +
+                              replay_block_bytes((uint32_t) (moves % r->interval)) + REPLAY_TRAILER_BYTES;
+        r->moves = moves;
+        r->blocks = full + 1;
+    }
+    if(!r->finished) {
+        r->blocks = (size - REPLAY_HEADER_BYTES) / r->block_bytes;
+        r->moves = r->blocks * r->interval;
+    }
+    return 0;
+}
+
+// move id number `index` (0 - r->moves - 1) of the file
+int replay_move_at(const replay_reader *r, uint64_t index) {
+    uint64_t block = index / r->interval;
+    uint32_t k = (uint32_t) (index % r->interval);
+    const uint8_t *group = r->data + REPLAY_HEADER_BYTES + block * r->block_bytes + REPLAY_SNAPSHOT_BYTES + k / 4 * 3;
+    uint32_t bits = (uint32_t) group[0] | (uint32_t) group[1] << 8 | (uint32_t) group[2] << 16;
+
+    return (int) ((bits >> (k % 4 * 6)) & 63);
+}
+
+/*
+ *  Function:    replay_seek
+ *  --------------------
+ *  The state after the first `position` moves of a file: the snapshot of the
+ *      block they end in, and the moves of that block up to there.
+ *
+ *  Input params:
+ *      const replay_reader *r:
+ *      uint64_t position:      0 - r->moves
+ *      puzzle *p:              the state
+ *
+ *  Return:
+ *      0, or -1 if the position is past the end, or the snapshot or a move
+ *          is not valid
+ *
+ *  Runtime Complexity: O(interval)
+ */
+int replay_seek(const replay_reader *r, uint64_t position, puzzle *p) {
+    if(position > r->moves || r->blocks == 0) {
+        return -1;
+    }
+    uint64_t block = position / r->interval;
+    if(block >= r->blocks) {
+        block = r->blocks - 1;
+    }
+    const uint8_t *snapshot = r->data + REPLAY_HEADER_BYTES + block * r->block_bytes;
+
+    if(import_packed(snapshot, snapshot[IMPORT_PACKED_BYTES], p) != IMPORT_OK ||
+       snapshot[IMPORT_PACKED_BYTES + 1] > Z_AXIS + 1) {
+        return -1;
+    }
+    p->last_move_in_axis = snapshot[IMPORT_PACKED_BYTES + 1] - 1;
+    for(uint64_t i = block * r->interval; i < position; i++) {
+        int move = replay_move_at(r, i);
+        if(move >= NUM_MOVES) {
+            return -1;
+        }
+        apply_move(p, move);
+    }
+    return 0;
+}
+
+#endif // REPLAY_C
@@ -0,0 +1,70 @@
+//
+// Seedable pseudo random numbers for scrambles and randomized searches.
+// xoshiro256** (Blackman and Vigna), seeded through splitmix64 so that any
+// 64 bit seed, 0 included, gives a usable state. Same seed, same numbers on
+// every platform.
+//
+
+#ifndef RNG_C
+#define RNG_C
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct {
+    uint64_t s[4];
+} rng_state;
+
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+void rng_seed(rng_state *rng, uint64_t seed) {
+    for(int i = 0; i < 4; i++) {
+        rng->s[i] = splitmix64(&seed);
+    }
+}
+
+static inline uint64_t rotl64(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+uint64_t rng_next(rng_state *rng) {
+    uint64_t *s = rng->s;
+    uint64_t result = rotl64(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl64(s[3], 45);
+
+    return result;
+}
+
+/*
+ *  Function:    rng_below
+ *  ------------------
+ *  Uniform integer in 0 - bound-1 (bound > 0), without modulo bias: Lemire's
+ *      multiply and reject, which almost never needs a second draw.
+ */
+uint32_t rng_below(rng_state *rng, uint32_t bound) {
+    uint64_t m = (rng_next(rng) >> 32) * (uint64_t) bound;
+    uint32_t low = (uint32_t) m;
+
+    if(low < bound) {
+        uint32_t threshold = (uint32_t) -bound % bound;
+        while(low < threshold) {
+            m = (rng_next(rng) >> 32) * (uint64_t) bound;
+            low = (uint32_t) m;
+        }
+    }
+    return (uint32_t) (m >> 32);
+}
+
+#endif // RNG_C
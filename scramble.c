@@ -0,0 +1,184 @@
+//
+// Headless scrambles: random move sequences over the move ids of puzzle.c,
+// or uniformly random reachable states drawn from the stabilizer chain.
+//
+// Sequences with move-ins are canonical (see moves.c): no stretch of them can
+// be written shorter, or the same length with smaller ids. Twist only
+// sequences just turn the center cube, so they only skip moves that
+// trivially undo or repeat the one before:
+//      - a twist right after its inverse, or an edge twist twice
+//      - a corner twist twice (the same as its inverse once)
+//      - a face twist three times; a half turn is only written with the
+//        select below the core (4 4, never 22 22)
+//
+
+#ifndef SCRAMBLE_C
+#define SCRAMBLE_C
+
+#include "group.c"
+#include "moves.c"
+
+#define SCRAMBLE_MOVE_INS 1     // let sequences move other cubes in, not only twist
+
+static uint8_t twist_order_of[CUBES];
+static uint8_t move_in_inverse[SIDES - 1];
+static int scramble_tables_ready;
+
+void init_scramble_tables(void) {
+    if(scramble_tables_ready) {
+        return;
+    }
+    init_puzzle_tables();
+    init_move_tables();
+
+    for(int select = 0; select < CUBES; select++) {
+        uint8_t perm[NUM_STICKERS];
+        uint8_t power[NUM_STICKERS];
+        int order = 1;
+
+        for(int i = 0; i < NUM_STICKERS; i++) {
+            perm[i] = twist_table[select][i];
+            power[i] = perm[i];
+        }
+        while(!perm_is_identity(power) && order < 6) {
+            perm_compose(power, perm, power);
+            order++;
+        }
+        twist_order_of[select] = (uint8_t) order;
+    }
+
+    // a move-in is the same turn of the whole puzzle from every orientation, so
+    // its inverse can be read off the first one
+    for(int k = 1; k < HIDDEN_CUBE; k++) {
+        int turned = orient_move_in[0][k];
+        for(int back = 1; back < HIDDEN_CUBE; back++) {
+            if(orient_move_in[turned][back] == 0) {
+                move_in_inverse[k] = (uint8_t) back;
+            }
+        }
+    }
+
+    scramble_tables_ready = 1;
+}
+
+// the move that undoes `move`
+int inverse_move(int move) {
+    if(is_move_in(move)) {
+        return FIRST_MOVE_IN + move_in_inverse[move - FIRST_MOVE_IN + 1] - 1;
+    }
+    return CUBES - 1 - move;
+}
+
+static int move_order(int move) {
+    return is_move_in(move) ? 4 : twist_order_of[move];
+}
+
+/*
+ *  Function:    scramble_allows
+ *  ------------------------
+ *  Whether `move` may follow `last` in a twist only sequence, `last` having
+ *      just been made `run` times in a row (run 0: nothing before it).
+ */
+int scramble_allows(int last, int run, int move) {
+    if(move == CUBES / 2) {
+        return 0;
+    }
+    if(run == 0 || is_move_in(last) != is_move_in(move)) {
+        return 1;
+    }
+    if(move == inverse_move(last) && move != last) {
+        return 0;
+    }
+    if(move == last) {
+        // only a quarter turn may be doubled, and only one way round
+        return move_order(move) == 4 && run == 1 && move < inverse_move(move);
+    }
+    return 1;
+}
+
+// draws the next move of a sequence, given the last one and how often in a row it was made
+static int scramble_next(rng_state *rng, uint32_t choices, int *last, int *run) {
+    int move;
+
+    if(choices == NUM_MOVES) {
+        uint32_t count;
+        const uint8_t *allowed = next_move_list(*run ? *last : NUM_MOVES, *run, &count);
+
+        move = allowed[rng_below(rng, count)];
+    }
+    else {
+        do {
+            move = (int) rng_below(rng, choices);
+        } while(!scramble_allows(*last, *run, move));
+    }
+
+    *run = move == *last ? *run + 1 : 1;
+    *last = move;
+    return move;
+}
+
+/*
+ *  Function:    scramble_moves
+ *  -----------------------
+ *  Fills `moves` with a random sequence of move ids.
+ *
+ *  Input params:
+ *      rng_state *rng:     random source
+ *      uint8_t *moves:     length move ids
+ *      int length:         number of moves
+ *      int flags:          SCRAMBLE_MOVE_INS, or 0 for twists only
+ *
+ *  Runtime Complexity: O(length)
+ */
+void scramble_moves(rng_state *rng, uint8_t *moves, int length, int flags) {
+    uint32_t choices = (flags & SCRAMBLE_MOVE_INS) ? NUM_MOVES : CUBES;
+    int last = 0, run = 0;
+
+    init_scramble_tables();
+    for(int i = 0; i < length; i++) {
+        moves[i] = (uint8_t) scramble_next(rng, choices, &last, &run);
+    }
+}
+
+// scrambles a puzzle with `length` random moves, which are also stored in `moves` unless it is NULL
+void scramble_puzzle(puzzle *p, rng_state *rng, int length, int flags, uint8_t *moves) {
+    uint32_t choices = (flags & SCRAMBLE_MOVE_INS) ? NUM_MOVES : CUBES;
+    int last = 0, run = 0;
+
+    init_scramble_tables();
+    for(int i = 0; i < length; i++) {
+        int move = scramble_next(rng, choices, &last, &run);
+        apply_move(p, move);
+        if(moves != NULL) {
+            moves[i] = (uint8_t) move;
+        }
+    }
+}
+
+/*
+ *  Function:    random_puzzle
+ *  ----------------------
+ *  Sets p to a uniformly random reachable state: a random element of the
+ *      twist group (from the stabilizer chain, built on first use) seen from a
+ *      random orientation.
+ *
+ *  Return:
+ *      0 on success, -1 if the chain could not be built
+ */
+int random_puzzle(puzzle *p, rng_state *rng) {
+    uint8_t perm[NUM_STICKERS];
+
+    if(init_puzzle_chain() != 0) {
+        return -1;
+    }
+
+    chain_random_element(&puzzle_chain, rng, perm);
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        p->stickers[i] = perm[i] / CUBES;
+    }
+    p->orientation = (int) rng_below(rng, (uint32_t) num_orientations);
+    p->last_move_in_axis = NO_AXIS;
+    return 0;
+}
+
+#endif // SCRAMBLE_C
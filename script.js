@@ -32,6 +32,16 @@ let magnitude = 0.05;
 
 let rotating = false;
 
+// solves run in worker.js, so frames never wait on them
+let solver = new Worker('worker.js');
+let max_solve_depth = 6;
+
+// hints are ranked moves looked ahead a few moves; 'g' turns them on and off
+let show_hints = false;
+let hint_depth = 3;
+let hint_budget = 8000;
+let hint_time_ms = 2;
+
 
 async function startDemo() {
     const response = await fetch('out.wasm');
@@ -39,6 +49,18 @@ async function startDemo() {
     const {instance} = await WebAssembly.instantiate(bytes);
 
     render(instance);
+    loadAlgorithms(instance);
+    importFromAddress(instance);
+
+    solver.onmessage = (event) => {
+        if(event.data.type === 'progress') {
+            console.log("solving: searching " + event.data.bound + " twists deep, " + event.data.nodes + " nodes");
+        } else if(event.data.type === 'done') {
+            console.log("solution: " + event.data.moves.join(" "));
+        } else if(event.data.type === 'stopped') {
+            console.log(event.data.status === 'failed' ? "no solution within " + max_solve_depth + " twists" : "solve cancelled");
+        }
+    }
 
     // document.getElementById("app").onclick = function(e) {
     //     // e = Mouse click event.
@@ -120,10 +142,59 @@ async function startDemo() {
         //     current_face = 7;
         //     current_cube = 0;
         // }
-        else if (event.key === 'r') {
+        else if (event.key === 'h') {
+            const exports = instance.exports;
+            solver.postMessage({
+                type: 'solve',
+                stickers: new Uint8Array(exports.memory.buffer, exports.puzzle_stickers(), 216).slice(),
+                orientation: exports.puzzle_orientation(),
+                maxDepth: max_solve_depth
+            });
+        } else if (event.key === 'l') {
+            const exports = instance.exports;
+            const length = exports.algorithm_lookup();
+            if(length < 0) {
+                console.log("no known algorithm for this state");
+            } else {
+                console.log("known algorithm: " + Array.from(new Uint8Array(exports.memory.buffer, exports.algorithm_result(), length)).join(" "));
+            }
+        } else if (event.key === 'x') {
+            const exports = instance.exports;
+            const length = exports.export_state();
+            const text = new TextDecoder().decode(new Uint8Array(exports.memory.buffer, exports.state_input(), length));
+            console.log("state: #state=" + text + "&orientation=" + exports.puzzle_orientation());
+        } else if (event.key === 'z' || event.key === 'y') {
+            const move = event.key === 'z' ? instance.exports.undo_move() : instance.exports.redo_move();
+            if(move < 0) {
+                console.log("nothing to " + (event.key === 'z' ? "undo" : "redo"));
+            } else {
+                solver.postMessage({type: 'cancel'});
+                if(show_hints) {
+                    render(instance);
+                    showHints(instance);
+                    return;
+                }
+            }
+        } else if (event.key === 'n') {
+            const exports = instance.exports;
+            const length = exports.export_notation();
+            const text = new TextDecoder().decode(new Uint8Array(exports.memory.buffer, exports.notation_input(), length));
+            console.log("moves: #moves=" + encodeURIComponent(text));
+        } else if (event.key === 'v') {
+            saveSession(instance);
+        } else if (event.key === 'c') {
+            logCycles(instance);
+        } else if (event.key === 'g') {
+            show_hints = !show_hints;
+            if(show_hints) {
+                showHints(instance);
+            }
+        } else if (event.key === 'r') {
             if(rotating) {
                 return;
             }
+            // a solve of the old state is no use any more
+            solver.postMessage({type: 'cancel'});
 
             rotating = true;
             to_rotate = 0;
@@ -138,6 +209,13 @@ async function startDemo() {
 
             rotating = false;
 
+            if(show_hints) {
+                // the move is made by the render below, so hint after it
+                render(instance);
+                showHints(instance);
+                return;
+            }
+
 
         } else if (event.key === '/') {
             current_cube += 9;
@@ -160,6 +238,131 @@ async function startDemo() {
     })
 }
 
+// a page opened as ...#state=<216 digits>&orientation=<n> (what 'x' logs) starts from that state, and with
+// &moves=<notation> (what 'n' logs) plays those moves after it
+function importFromAddress(instance) {
+    const params = new URLSearchParams(window.location.hash.slice(1));
+    const text = params.get('state');
+    if(text === null) {
+        playNotation(instance, params.get('moves'));
+        return;
+    }
+    const exports = instance.exports;
+    const bytes = new TextEncoder().encode(text);
+    if(bytes.length > exports.state_input_size()) {
+        console.log("state: too long");
+        return;
+    }
+    new Uint8Array(exports.memory.buffer, exports.state_input(), bytes.length).set(bytes);
+    const result = exports.import_state(bytes.length, parseInt(params.get('orientation') || "0"));
+    if(result !== 0) {
+        console.log("state refused (" + result + "), see import.c");
+        return;
+    }
+    render(instance);
+    playNotation(instance, params.get('moves'));
+}
+
+// plays moves written as text (notation.c), all of them or none
+function playNotation(instance, text) {
+    if(text === null) {
+        return;
+    }
+    const exports = instance.exports;
+    const bytes = new TextEncoder().encode(text);
+    if(bytes.length > exports.notation_input_size()) {
+        console.log("moves: too long");
+        return;
+    }
+    new Uint8Array(exports.memory.buffer, exports.notation_input(), bytes.length).set(bytes);
+    const result = exports.play_notation(bytes.length);
+    if(result !== 0) {
+        console.log("moves refused (" + result + " at character " + exports.notation_error_offset() + "), see notation.c");
+        return;
+    }
+    render(instance);
+}
+
+// downloads the moves made since the puzzle was last reset, scrambled or imported, as a replay file (replay.c)
+function saveSession(instance) {
+    const exports = instance.exports;
+    const size = exports.session_save();
+    if(size < 0) {
+        console.log("session: too long to save");
+        return;
+    }
+    const bytes = new Uint8Array(exports.memory.buffer, exports.session_file(), size).slice();
+    const link = document.createElement('a');
+    link.href = URL.createObjectURL(new Blob([bytes], {type: 'application/octet-stream'}));
+    link.download = 'session.bin';
+    link.click();
+    URL.revokeObjectURL(link.href);
+    console.log("session: " + exports.session_moves() + " moves, " + size + " bytes");
+}
+
+// known algorithms ('l' looks the puzzle up) come from algorithms.bin, made by tools/alglib.c; without it 'l' finds none
+async function loadAlgorithms(instance) {
+    const response = await fetch('algorithms.bin');
+    if(!response.ok) {
+        return;
+    }
+    const bytes = new Uint8Array(await response.arrayBuffer());
+    const exports = instance.exports;
+    if(bytes.length > exports.algorithms_input_size()) {
+        console.log("algorithms.bin is too big to attach");
+        return;
+    }
+    new Uint8Array(exports.memory.buffer, exports.algorithms_input(), bytes.length).set(bytes);
+    if(exports.algorithms_attach(bytes.length) !== 0) {
+        console.log("algorithms.bin is not an algorithm library");
+    }
+}
+
+// logs the order and cycles of the selected move, which pressing 'r' that many times would show
+function logCycles(instance) {
+    const exports = instance.exports;
+    if(exports.cycles_select(current_face * 27 + current_cube) !== 0 || exports.cycles_analyze(1) !== 0) {
+        console.log("the selection makes no move");
+        return;
+    }
+    const classes = ["corners", "edges", "faces"];
+    let moved = [];
+    for(let k = 0; k < 3; k++) {
+        moved.push(exports.cycles_pieces_moved(k) + " " + classes[k] + " (" + exports.cycles_twisted(k) + " turned in place, " +
+            (exports.cycles_parity(k) ? "odd" : "even") + ")");
+    }
+    let periods = [];
+    for(let n = 0; n < exports.cycles_count(); n++) {
+        periods.push(exports.cycles_period(n));
+    }
+    console.log("order " + exports.cycles_order() + ": " + exports.cycles_stickers_moved() + " stickers, " + moved.join(", ") +
+        "; cycles of period " + periods.join(" "));
+}
+
+// logs the best few moves for the puzzle as it is now, and keeps the lookahead inside hint_time_ms
+function showHints(instance) {
+    const exports = instance.exports;
+    const start = performance.now();
+    const count = exports.suggest(hint_depth, hint_budget);
+    const elapsed = performance.now() - start;
+
+    if(elapsed > hint_time_ms) {
+        hint_budget = Math.max(32, Math.floor(hint_budget / 2));
+    } else if(elapsed < hint_time_ms / 4) {
+        hint_budget = Math.min(1 << 20, hint_budget * 2);
+    }
+
+    let lines = [];
+    for(let i = 0; i < Math.min(count, 3); i++) {
+        // the select that makes the move: face 0 for twists, cube 0 of the face moved in
+        const move = exports.suggestion_move(i);
+        const select = move < 27 ? move : (move - 26) * 27;
+        lines.push("face " + (Math.floor(select / 27) + 1) + " cube " + (select % 27) +
+            " (+" + exports.suggestion_gain(i) + " in " + exports.suggestion_depth(i) + ")");
+    }
+    console.log("hints, " + exports.suggestion_lookahead() + " moves ahead in " + elapsed.toFixed(2) + " ms: " + lines.join(", "));
+}
+
 function render(instance) {
     const pixels = instance.exports.render(dt, current_input, A, B, C, x, y, current_face * 27 + current_cube, to_rotate, angle_percent, type);
     const buffer = instance.exports.memory.buffer;
@@ -0,0 +1,349 @@
+//
+// Move log simplifier: rewrites a sequence of move ids (puzzle.c) into an
+// equivalent one that is never longer, in one pass and without ever building
+// a puzzle. Equivalent means the same stickers and the same orientation from
+// any start (which cube is mirrored when hidden may differ).
+//
+// Two rewrites run side by side and the shorter result wins:
+//      - runs: consecutive twists only ever turn the center cube, so a run of
+//        them is one of its 24 rotations and is written back as one twist or
+//        a doubled quarter turn. Consecutive move-ins are one of the 192
+//        orientations and are written back along a shortest path. A run that
+//        comes to nothing lets the runs on either side join.
+//      - cell twists: the twists as turns of physical cells, each cancelled
+//        or merged into an earlier one of the same cell when everything in
+//        between commutes with it (moves.c), then played back with the
+//        fewest move-ins and ended in the same orientation.
+//
+// Each move costs O(1) (the cell twist look back is capped at
+// SIMPLIFY_LOOK_BACK), so logs of any length simplify in linear time.
+//
+
+#ifndef SIMPLIFY_C
+#define SIMPLIFY_C
+
+#include "moves.c"
+
+#define NUM_CUBE_ROTATIONS 24
+#define SIMPLIFY_LOOK_BACK 8
+// scratch bytes a simplifier needs per move it may be given
+#define SIMPLIFY_SCRATCH_PER_MOVE 3
+
+#define TWIST_RUN 0
+#define MOVE_IN_RUN 1
+
+typedef struct {
+    uint8_t *run_kind;      // TWIST_RUN or MOVE_IN_RUN
+    uint8_t *run_value;     // cube rotation, or orientation reached from 0
+    int runs;
+    uint8_t *twists;        // cell twists so far, seen from orientation 0
+    int num_twists;
+    int orientation;        // where the moves so far took orientation 0
+    int capacity;
+    int pushed;
+} move_simplifier;
+
+// the rotations of one cube that the selects make, and how to write each back
+static uint8_t select_rotation[CUBES];
+static uint8_t rotation_product[NUM_CUBE_ROTATIONS][NUM_CUBE_ROTATIONS];
+static uint8_t rotation_moves[NUM_CUBE_ROTATIONS][2];
+static uint8_t rotation_length[NUM_CUBE_ROTATIONS];
+// shortest move-ins from orientation 0 to each orientation, last one first,
+// and the orientations by how far they are
+static uint8_t orientation_last_move_in[NUM_ORIENTATIONS];
+static uint8_t orientation_order[NUM_ORIENTATIONS];
+static uint8_t orientation_parent[NUM_ORIENTATIONS];
+static uint8_t orientation_depth[NUM_ORIENTATIONS];
+static int simplify_tables_ready;
+
+static int find_rotation(uint8_t perms[][NUM_STICKERS], int count, const uint8_t *perm) {
+    for(int r = 0; r < count; r++) {
+        int i;
+        for(i = 0; i < NUM_STICKERS && perms[r][i] == perm[i]; i++);
+        if(i == NUM_STICKERS) {
+            return r;
+        }
+    }
+    return -1;
+}
+
+void init_simplify_tables(void) {
+    static uint8_t perms[NUM_CUBE_ROTATIONS][NUM_STICKERS];
+    uint8_t product[NUM_STICKERS];
+    uint8_t *queue = orientation_order;
+    int count = 0, head = 0, tail = 0;
+
+    if(simplify_tables_ready) {
+        return;
+    }
+    init_move_tables();
+
+    // the identity (select 13) first, then every new rotation a select makes
+    for(int n = 0; n < CUBES; n++) {
+        int select = (CUBES / 2 + n) % CUBES;
+        int r = find_rotation(perms, count, twist_table[select]);
+
+        if(r < 0) {
+            r = count++;
+            for(int i = 0; i < NUM_STICKERS; i++) {
+                perms[r][i] = twist_table[select][i];
+            }
+            rotation_moves[r][0] = (uint8_t) select;
+            rotation_length[r] = select == CUBES / 2 ? 0 : 1;
+        }
+        select_rotation[select] = (uint8_t) r;
+    }
+    // the half turns, which take a quarter turn (below the core) twice
+    for(int select = 0; select < CUBES / 2; select++) {
+        for(int i = 0; i < NUM_STICKERS; i++) {
+            product[i] = twist_table[select][twist_table[select][i]];
+        }
+        if(find_rotation(perms, count, product) < 0 && count < NUM_CUBE_ROTATIONS) {
+            for(int i = 0; i < NUM_STICKERS; i++) {
+                perms[count][i] = product[i];
+            }
+            rotation_moves[count][0] = rotation_moves[count][1] = (uint8_t) select;
+            rotation_length[count++] = 2;
+        }
+    }
+
+    for(int a = 0; a < count; a++) {
+        for(int b = 0; b < count; b++) {
+            for(int i = 0; i < NUM_STICKERS; i++) {
+                product[i] = perms[a][perms[b][i]];
+            }
+            rotation_product[a][b] = (uint8_t) find_rotation(perms, count, product);
+        }
+    }
+
+    for(int o = 0; o < num_orientations; o++) {
+        orientation_depth[o] = 0xFF;
+    }
+    orientation_depth[0] = 0;
+    queue[tail++] = 0;
+    while(head < tail) {
+        int o = queue[head++];
+        for(int k = 1; k < SIDES - 1; k++) {
+            int next = orient_move_in[o][k];
+            if(orientation_depth[next] == 0xFF) {
+                orientation_depth[next] = (uint8_t) (orientation_depth[o] + 1);
+                orientation_parent[next] = (uint8_t) o;
+                orientation_last_move_in[next] = (uint8_t) (FIRST_MOVE_IN + k - 1);
+                queue[tail++] = (uint8_t) next;
+            }
+        }
+    }
+
+    simplify_tables_ready = 1;
+}
+
+/*
+ *  Function:    init_simplifier
+ *  ------------------------
+ *  Sets up a simplifier for at most `capacity` moves.
+ *
+ *  Input params:
+ *      move_simplifier *s:
+ *      uint8_t *scratch:   SIMPLIFY_SCRATCH_PER_MOVE * capacity bytes, used
+ *                          until simplifier_finish
+ *      int capacity:
+ */
+void init_simplifier(move_simplifier *s, uint8_t *scratch, int capacity) {
+    init_simplify_tables();
+
+    s->run_kind = scratch;
+    s->run_value = scratch + capacity;
+    s->twists = scratch + 2 * capacity;
+    s->runs = 0;
+    s->num_twists = 0;
+    s->orientation = 0;
+    s->capacity = capacity;
+    s->pushed = 0;
+}
+
+// adds a cell twist, merging it into an earlier one of its cell past twists it commutes with
+static void simplify_cell_twist(move_simplifier *s, int move) {
+    for(int i = s->num_twists - 1; i >= 0 && i >= s->num_twists - SIMPLIFY_LOOK_BACK; i--) {
+        int earlier = s->twists[i];
+
+        if(earlier / TWISTS_PER_CELL == move / TWISTS_PER_CELL) {
+            int merged = twist_product[earlier][move % TWISTS_PER_CELL];
+            if(merged == KEEP_BOTH) {
+                break;
+            }
+            if(merged != NO_TWIST) {
+                s->twists[i] = (uint8_t) merged;
+                return;
+            }
+            for(int k = i; k < s->num_twists - 1; k++) {
+                s->twists[k] = s->twists[k + 1];
+            }
+            s->num_twists--;
+            return;
+        }
+        if(!twist_commutes[earlier][move]) {
+            break;
+        }
+    }
+    s->twists[s->num_twists++] = (uint8_t) move;
+}
+
+/*
+ *  Function:    simplifier_push
+ *  ------------------------
+ *  Feeds the next move id of a log.
+ *
+ *  Return:
+ *      0, or -1 if the simplifier is full (the move is dropped)
+ */
+int simplifier_push(move_simplifier *s, int move) {
+    int kind = is_move_in(move) ? MOVE_IN_RUN : TWIST_RUN;
+    int top = s->runs - 1;
+
+    if(s->pushed == s->capacity) {
+        return -1;
+    }
+    s->pushed++;
+
+    if(kind == MOVE_IN_RUN) {
+        s->orientation = orient_move_in[s->orientation][move - FIRST_MOVE_IN + 1];
+    }
+    else if(move != CUBES / 2) {
+        simplify_cell_twist(s, view_twist[s->orientation][move]);
+    }
+
+    if(top >= 0 && s->run_kind[top] == kind) {
+        int value = s->run_value[top];
+        value = kind == MOVE_IN_RUN ? orient_move_in[value][move - FIRST_MOVE_IN + 1]
+                                    : rotation_product[value][select_rotation[move]];
+        s->run_value[top] = (uint8_t) value;
+        // a run that comes to nothing goes, so its neighbours join
+        if(value == 0) {
+            s->runs--;
+        }
+    }
+    else if(kind == MOVE_IN_RUN || select_rotation[move] != 0) {
+        s->run_kind[s->runs] = (uint8_t) kind;
+        s->run_value[s->runs] = kind == MOVE_IN_RUN ? orient_move_in[0][move - FIRST_MOVE_IN + 1]
+                                                    : select_rotation[move];
+        s->runs++;
+    }
+    return 0;
+}
+
+// writes the move-ins of a shortest path from orientation 0 to `target`
+static int write_move_ins(int target, uint8_t *out) {
+    int length = orientation_depth[target];
+    for(int i = length - 1; i >= 0; i--) {
+        out[i] = orientation_last_move_in[target];
+        target = orientation_parent[target];
+    }
+    return length;
+}
+
+// the cell twist rewrite, or -1 if it comes out longer than `limit`
+static int write_cell_twists(const move_simplifier *s, uint8_t *out, int limit) {
+    uint8_t path[MAX_CELL_TWIST_MOVES];
+    int orientation = 0, n = 0;
+
+    for(int i = 0; i < s->num_twists; i++) {
+        int written = cell_twist_moves(&orientation, s->twists[i], path);
+        if(written < 0 || n + written > limit) {
+            return -1;
+        }
+        for(int k = 0; k < written; k++) {
+            out[n++] = path[k];
+        }
+    }
+
+    // orientation 0 ended up at s->orientation, and this one has to as well:
+    // the move-ins turn the puzzle the same from everywhere, so the shortest
+    // path from 0 that does it from here is the one wanted
+    for(int n_target = 0; n_target < num_orientations; n_target++) {
+        int target = orientation_order[n_target];
+        int o = orientation, k;
+        uint8_t ins[NUM_ORIENTATIONS];
+        int length = write_move_ins(target, ins);
+
+        for(k = 0; k < length; k++) {
+            o = orient_move_in[o][ins[k] - FIRST_MOVE_IN + 1];
+        }
+        if(o != s->orientation) {
+            continue;
+        }
+        if(n + length > limit) {
+            return -1;
+        }
+        for(k = 0; k < length; k++) {
+            out[n++] = ins[k];
+        }
+        return n;
+    }
+    return -1;
+}
+
+/*
+ *  Function:    simplifier_finish
+ *  --------------------------
+ *  Writes the simplified log: the shorter of the two rewrites.
+ *
+ *  Input params:
+ *      const move_simplifier *s:
+ *      uint8_t *out:   room for as many moves as were pushed
+ *
+ *  Return:
+ *      the length of the simplified log, never more than the moves pushed
+ */
+int simplifier_finish(const move_simplifier *s, uint8_t *out) {
+    int n = 0;
+
+    for(int r = 0; r < s->runs; r++) {
+        n += s->run_kind[r] == MOVE_IN_RUN ? orientation_depth[s->run_value[r]] : rotation_length[s->run_value[r]];
+    }
+    if(n > 1) {
+        int shorter = write_cell_twists(s, out, n - 1);
+        if(shorter >= 0) {
+            return shorter;
+        }
+    }
+
+    n = 0;
+    for(int r = 0; r < s->runs; r++) {
+        int value = s->run_value[r];
+        if(s->run_kind[r] == MOVE_IN_RUN) {
+            n += write_move_ins(value, out + n);
+        }
+        else {
+            for(int k = 0; k < rotation_length[value]; k++) {
+                out[n++] = rotation_moves[value][k];
+            }
+        }
+    }
+    return n;
+}
+
+/*
+ *  Function:    simplify_moves
+ *  -----------------------
+ *  Simplifies a whole log at once.
+ *
+ *  Input params:
+ *      const uint8_t *moves:   the log
+ *      int length:
+ *      uint8_t *out:           length bytes, may be moves
+ *      uint8_t *scratch:       SIMPLIFY_SCRATCH_PER_MOVE * length bytes
+ *
+ *  Return:
+ *      the simplified length
+ */
+int simplify_moves(const uint8_t *moves, int length, uint8_t *out, uint8_t *scratch) {
+    move_simplifier s;
+
+    init_simplifier(&s, scratch, length);
+    for(int i = 0; i < length; i++) {
+        simplifier_push(&s, moves[i]);
+    }
+    return simplifier_finish(&s, out);
+}
+
+#endif // SIMPLIFY_C
@@ -0,0 +1,326 @@
+//
+// Symmetries of the puzzle: the 384 signed permutations of the 4 axes (192
+// rotations and as many mirror images). A symmetry maps pieces, stickers,
+// colors and twists onto each other, so relabelling a state by one
+// (conjugating it) gives a state exactly as far from solved. Searches and
+// caches can then keep one state per class, the canonical one, and tables
+// over a subset of pieces can keep one entry per class of their coordinates.
+//
+// Symmetry g sends axis a to sym_axis(g, a), with the sign flipped when bit a
+// of g % 16 is set; g / 16 is the rank of the axis permutation in twist_perm,
+// so 0 is the identity.
+//
+
+#ifndef SYMMETRY_C
+#define SYMMETRY_C
+
+#include "coord.c"
+
+#define NUM_SYMMETRIES 384
+
+// sym_piece[g][p]: piece (and position, they are numbered alike) p is sent to
+// sym_slot[g][p]: rank of where the slots of p land among the slots of sym_piece[g][p]
+static uint8_t sym_piece[NUM_SYMMETRIES][NUM_PIECES];
+static uint8_t sym_slot[NUM_SYMMETRIES][NUM_PIECES];
+static uint8_t sym_slot_inverse[NUM_SYMMETRIES][NUM_PIECES];
+static uint8_t sym_cell[NUM_SYMMETRIES][SIDES];
+static uint8_t sym_twist[NUM_SYMMETRIES][NUM_CELL_TWISTS];
+static uint16_t sym_inverse[NUM_SYMMETRIES];
+static int symmetry_tables_ready;
+
+int sym_axis(int g, int axis) {
+    return twist_perm[NUM_AXES][g / 16][axis];
+}
+
+int sym_sign(int g, int axis) {
+    return (g >> axis) & 1 ? -1 : 1;
+}
+
+void sym_point(int g, const int8_t *point, int8_t *out) {
+    for(int a = 0; a < NUM_AXES; a++) {
+        out[sym_axis(g, a)] = (int8_t) (sym_sign(g, a) * point[a]);
+    }
+}
+
+// g then h
+int sym_compose(int g, int h) {
+    uint8_t axes[NUM_AXES];
+    int signs = 0;
+
+    for(int a = 0; a < NUM_AXES; a++) {
+        int b = sym_axis(g, a);
+        axes[a] = (uint8_t) sym_axis(h, b);
+        if(sym_sign(g, a) * sym_sign(h, b) < 0) {
+            signs |= 1 << a;
+        }
+    }
+    return rank_twist(axes, NUM_AXES) * 16 + signs;
+}
+
+/*
+ *  Function:    sym_conjugate
+ *  ----------------------
+ *  Relabels a state by symmetry g: the piece at position X goes to position
+ *      g(X) as piece g(p), with its stickers following. The orientation is
+ *      kept, it is not part of what a symmetry relates.
+ *
+ *  Runtime Complexity: O(NUM_PIECES)
+ */
+void sym_conjugate(const cubie_state *state, int g, cubie_state *out) {
+    for(int piece = 0; piece < NUM_PIECES; piece++) {
+        int size = piece_size[piece];
+        int at = state->pos[piece];
+        int to = sym_piece[g][piece];
+        int twist = twist_compose[size][sym_slot[g][piece]][state->ori[piece]];
+
+        out->pos[to] = sym_piece[g][at];
+        out->ori[to] = twist_compose[size][twist][sym_slot_inverse[g][at]];
+    }
+    out->orientation = state->orientation;
+}
+
+void init_symmetry_tables(void) {
+    int8_t home[NUM_AXES], image[NUM_AXES];
+    uint8_t slots[MAX_PIECE_STICKERS], back[MAX_PIECE_STICKERS];
+    cubie_state solved, twisted, relabelled;
+
+    if(symmetry_tables_ready) {
+        return;
+    }
+    init_coord_tables();
+
+    for(int g = 0; g < NUM_SYMMETRIES; g++) {
+        for(int piece = 0; piece < NUM_PIECES; piece++) {
+            int size = piece_size[piece];
+            int t = 0;
+
+            for(int a = 0; a < NUM_AXES; a++) {
+                home[a] = piece_home[piece][a];
+            }
+            sym_point(g, home, image);
+            sym_piece[g][piece] = position_piece[point_key(image)];
+
+            // slot t faces the t-th axis the piece has a coordinate on
+            for(int a = 0; a < NUM_AXES; a++) {
+                if(home[a]) {
+                    slots[t] = (uint8_t) axis_slot(image, sym_axis(g, a));
+                    back[slots[t]] = (uint8_t) t;
+                    t++;
+                }
+            }
+            sym_slot[g][piece] = (uint8_t) rank_twist(slots, size);
+            sym_slot_inverse[g][piece] = (uint8_t) rank_twist(back, size);
+        }
+
+        for(int cell = 0; cell < SIDES; cell++) {
+            int axis = cell_axis[cell];
+            sym_cell[g][cell] = (uint8_t) axis_cell(sym_axis(g, axis), sym_sign(g, axis) * cell_sign[cell]);
+        }
+
+        for(int h = 0; h < NUM_SYMMETRIES; h++) {
+            if(sym_compose(g, h) == 0) {
+                sym_inverse[g] = (uint16_t) h;
+            }
+        }
+    }
+
+    // the twist a symmetry makes of a twist: the one that relabelled does the same
+    cubie_reset(&solved);
+    for(int m = 0; m < NUM_CELL_TWISTS; m++) {
+        twisted = solved;
+        cubie_twist(&twisted, m);
+
+        for(int g = 0; g < NUM_SYMMETRIES; g++) {
+            int first = sym_cell[g][m / TWISTS_PER_CELL] * TWISTS_PER_CELL;
+
+            sym_conjugate(&twisted, g, &relabelled);
+            sym_twist[g][m] = NO_TWIST;
+            for(int c = first; c < first + TWISTS_PER_CELL; c++) {
+                int i;
+                for(i = 0; i < NUM_PIECES; i++) {
+                    if(piece_move_pos[c][i] != relabelled.pos[i] || piece_move_twist[c][i] != relabelled.ori[i]) break;
+                }
+                if(i == NUM_PIECES) {
+                    sym_twist[g][m] = (uint8_t) c;
+                }
+            }
+        }
+    }
+
+    symmetry_tables_ready = 1;
+}
+
+/*
+ *  Function:    sym_canonical
+ *  ----------------------
+ *  Picks the representative of a state's class: of its NUM_SYMMETRIES
+ *      relabellings, the one whose (pos, ori) pairs, piece by piece, come
+ *      first. Relabellings are compared as they are made and dropped at the
+ *      first piece that is larger, so most cost a few pieces.
+ *
+ *  Input params:
+ *      const cubie_state *state:   state to reduce
+ *      cubie_state *out:           the canonical state (may be state)
+ *
+ *  Return:
+ *      the symmetry g with out = sym_conjugate(state, g). A solution s of out
+ *          solves state once every twist is sent through sym_inverse[g]
+ *          (see sym_map_twists).
+ */
+int sym_canonical(const cubie_state *state, cubie_state *out) {
+    uint8_t best_pos[NUM_PIECES], best_ori[NUM_PIECES];
+    int best = 0;
+
+    for(int q = 0; q < NUM_PIECES; q++) {
+        best_pos[q] = state->pos[q];
+        best_ori[q] = state->ori[q];
+    }
+
+    for(int g = 1; g < NUM_SYMMETRIES; g++) {
+        const uint8_t *from = sym_piece[sym_inverse[g]];
+        int q, smaller = 0;
+
+        for(q = 0; q < NUM_PIECES; q++) {
+            int piece = from[q];
+            int at = state->pos[piece];
+            int pos = sym_piece[g][at];
+
+            if(pos != best_pos[q]) {
+                smaller = pos < best_pos[q];
+                break;
+            }
+            int size = piece_size[piece];
+            int ori = twist_compose[size][twist_compose[size][sym_slot[g][piece]][state->ori[piece]]]
+                                   [sym_slot_inverse[g][at]];
+            if(ori != best_ori[q]) {
+                smaller = ori < best_ori[q];
+                break;
+            }
+        }
+        if(!smaller) {
+            continue;
+        }
+
+        cubie_state relabelled;
+        sym_conjugate(state, g, &relabelled);
+        for(q = 0; q < NUM_PIECES; q++) {
+            best_pos[q] = relabelled.pos[q];
+            best_ori[q] = relabelled.ori[q];
+        }
+        best = g;
+    }
+
+    for(int q = 0; q < NUM_PIECES; q++) {
+        out->pos[q] = best_pos[q];
+        out->ori[q] = best_ori[q];
+    }
+    out->orientation = state->orientation;
+    return best;
+}
+
+// number of states in the class of `state`: NUM_SYMMETRIES over how many symmetries leave it as it is
+int sym_class_size(const cubie_state *state) {
+    int fixed = 1;
+
+    for(int g = 1; g < NUM_SYMMETRIES; g++) {
+        const uint8_t *from = sym_piece[sym_inverse[g]];
+        int q;
+
+        for(q = 0; q < NUM_PIECES; q++) {
+            int piece = from[q];
+            int at = state->pos[piece];
+            int size = piece_size[piece];
+
+            if(sym_piece[g][at] != state->pos[q] ||
+               twist_compose[size][twist_compose[size][sym_slot[g][piece]][state->ori[piece]]]
+                            [sym_slot_inverse[g][at]] != state->ori[q]) {
+                break;
+            }
+        }
+        fixed += q == NUM_PIECES;
+    }
+    return NUM_SYMMETRIES / fixed;
+}
+
+// sends every twist of a sequence through symmetry g, in place
+void sym_map_twists(int g, uint8_t *twists, int length) {
+    for(int i = 0; i < length; i++) {
+        twists[i] = sym_twist[g][twists[i]];
+    }
+}
+
+/*
+ *  Function:    subset_symmetries
+ *  --------------------------
+ *  Lists the symmetries that send the pieces of a subset onto themselves (in
+ *      any order). Only those relate entries of a table over the subset.
+ *
+ *  Return:
+ *      the number of symmetries written to syms, at least 1 (the identity)
+ */
+int subset_symmetries(const coord_subset *subset, uint16_t *syms) {
+    int count = 0;
+
+    for(int g = 0; g < NUM_SYMMETRIES; g++) {
+        int i, j;
+        for(i = 0; i < subset->count; i++) {
+            for(j = 0; j < subset->count && subset->pieces[j] != sym_piece[g][subset->pieces[i]]; j++);
+            if(j == subset->count) break;
+        }
+        if(i == subset->count) {
+            syms[count++] = (uint16_t) g;
+        }
+    }
+    return count;
+}
+
+/*
+ *  Function:    sym_subset_rank
+ *  ------------------------
+ *  Symmetry reduced index of a subset's coordinates: the smallest subset_rank
+ *      among their relabellings by syms (from subset_symmetries). States
+ *      related by those symmetries share the index, so a table builder can
+ *      keep one entry per class.
+ *
+ *  Input params:
+ *      const coord_subset *subset:
+ *      const uint16_t *syms:       symmetries that keep the subset
+ *      int count:                  how many
+ *      const uint16_t *coords:     coordinates, as subset_coords gives them
+ *      int *sym:                   the symmetry that gave the index (may be NULL)
+ */
+uint64_t sym_subset_rank(const coord_subset *subset, const uint16_t *syms, int count, const uint16_t *coords,
+                         int *sym) {
+    int piece_class = subset->piece_class;
+    int twists = coord_twists(piece_class);
+    int size = class_stickers[piece_class];
+    int first = class_first[piece_class];
+    uint64_t best = UINT64_MAX;
+
+    for(int n = 0; n < count; n++) {
+        int g = syms[n];
+        uint16_t relabelled[MAX_SUBSET_PIECES];
+
+        for(int i = 0; i < subset->count; i++) {
+            int piece = subset->pieces[i];
+            int at = first + coords[i] / twists;
+            int twist = twist_compose[size][sym_slot[g][piece]][coords[i] % twists];
+            int j;
+
+            twist = twist_compose[size][twist][sym_slot_inverse[g][at]];
+            for(j = 0; subset->pieces[j] != sym_piece[g][piece]; j++);
+            relabelled[j] = (uint16_t) ((sym_piece[g][at] - first) * twists + twist);
+        }
+
+        uint64_t rank = subset_rank(subset, relabelled);
+        if(rank < best) {
+            best = rank;
+            if(sym != NULL) {
+                *sym = g;
+            }
+        }
+    }
+    return best;
+}
+
+#endif // SYMMETRY_C
@@ -0,0 +1,236 @@
+//
+// Builds an algorithm library (alglib.c) over the slabs of a few cells, saves
+// it as an image and attaches it again, then checks and times lookups: cases
+// made from the library's own algorithms must all be found and solved, and
+// random states of the scope show how often a known algorithm applies.
+//
+// Algorithms come from a file, one per line as cell twist ids, or else are
+// random words in the twists of the scope cells.
+//
+// Build: cc -O2 -o alglib tools/alglib.c
+// Usage: ./alglib [-c cell]... [-f file] [-n algorithms] [-a length] [-o image] [-t lookups] [-s seed]
+//      -c  a cell (0 - 7) whose slab is in the scope (default 0 and 1)
+//      -n  random algorithms when there is no file (default 64)
+//      -a  their length (default 8)
+//      -o  where to write the image
+//      -t  lookups to check and time (default 100000)
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../alglib.c"
+
+#define TABLE_MEGABYTES 64
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+// whether every position of the scope holds its own piece, turned right
+static int scope_solved(const alg_library *lib, const cubie_state *state) {
+    for(int piece = 0; piece < NUM_PIECES; piece++) {
+        if(lib->in_scope[piece] && (state->pos[piece] != piece || state->ori[piece] != 0)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// adds the algorithms of a file, one per line; returns how many were refused, -1 if it cannot be read
+static int add_file(alg_library *lib, const char *path) {
+    FILE *file = fopen(path, "r");
+    char line[1024];
+    int refused = 0;
+
+    if(file == NULL) {
+        return -1;
+    }
+    while(fgets(line, sizeof(line), file) != NULL) {
+        uint8_t twists[ALG_MAX_LENGTH + 1];
+        int length = 0;
+        char *at = line, *end;
+
+        if(line[0] == '#') {
+            continue;
+        }
+        for(long m = strtol(at, &end, 10); end != at && length <= ALG_MAX_LENGTH; m = strtol(at, &end, 10)) {
+            twists[length++] = (uint8_t) (m < 0 || m >= NUM_CELL_TWISTS ? NUM_CELL_TWISTS : m);
+            at = end;
+        }
+        if(length > 0 && alg_library_add(lib, twists, length) < 0) {
+            refused++;
+        }
+    }
+    fclose(file);
+    return refused;
+}
+
+int main(int argc, char **argv) {
+    static alg_library lib, attached;
+    uint8_t in_scope[NUM_PIECES] = {0};
+    const char *path = NULL, *out = NULL;
+    int count = 64, length = 8, lookups = 100000, cells = 0;
+    uint64_t seed = 1;
+    rng_state rng;
+
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            int cell = atoi(argv[++i]);
+            if(cell < 0 || cell >= SIDES) {
+                fprintf(stderr, "no cell %d\n", cell);
+                return 1;
+            }
+            alg_scope_add_cell(in_scope, cell);
+            cells++;
+        }
+        else if(strcmp(argv[i], "-f") == 0 && i + 1 < argc) path = argv[++i];
+        else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc) count = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-a") == 0 && i + 1 < argc) length = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc) out = argv[++i];
+        else if(strcmp(argv[i], "-t") == 0 && i + 1 < argc) lookups = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 0);
+        else {
+            fprintf(stderr, "usage: %s [-c cell]... [-f file] [-n algorithms] [-a length] [-o image] [-t lookups] "
+                            "[-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+    if(cells == 0) {
+        alg_scope_add_cell(in_scope, 0);
+        alg_scope_add_cell(in_scope, 1);
+    }
+    if(count < 0 || length < 1 || length > ALG_MAX_LENGTH || lookups < 0) {
+        fprintf(stderr, "bad arguments\n");
+        return 1;
+    }
+
+    uint64_t bytes = (uint64_t) TABLE_MEGABYTES << 20;
+    void *table = malloc(bytes), *attached_table = malloc(bytes);
+    if(table == NULL || attached_table == NULL || alg_library_init(&lib, table, bytes, in_scope) != 0) {
+        fprintf(stderr, "cannot set the library up\n");
+        return 1;
+    }
+
+    rng_seed(&rng, seed);
+    double begin = now();
+    if(path != NULL) {
+        int refused = add_file(&lib, path);
+        if(refused < 0) {
+            fprintf(stderr, "cannot read %s\n", path);
+            return 1;
+        }
+        if(refused > 0) {
+            printf("%d algorithms refused (they move pieces outside the scope, or the table is full)\n", refused);
+        }
+    }
+    else {
+        // a scope of one cell only has that cell's twists, and any word of them is one twist
+        int one_cell = lib.setups[0] / TWISTS_PER_CELL == lib.setups[lib.num_setups - 1] / TWISTS_PER_CELL;
+        if(one_cell) {
+            length = 1;
+        }
+        for(int n = 0; n < count; n++) {
+            uint8_t twists[ALG_MAX_LENGTH];
+            int last = NO_TWIST;
+
+            // a random word in the scope twists, never two of one cell in a row
+            for(int i = 0; i < length; i++) {
+                int m;
+                do {
+                    m = lib.setups[rng_below(&rng, (uint32_t) lib.num_setups)];
+                } while(!one_cell && last != NO_TWIST && m / TWISTS_PER_CELL == last / TWISTS_PER_CELL);
+                twists[i] = (uint8_t) m;
+                last = m;
+            }
+            if(alg_library_add(&lib, twists, length) == -2) {
+                fprintf(stderr, "the table is full\n");
+                return 1;
+            }
+        }
+    }
+    double built = now() - begin;
+    printf("%d algorithms, %d symmetries and %d setup twists keep the scope: %llu cases in %.3f s\n", lib.num_algs,
+           lib.num_syms, lib.num_setups, (unsigned long long) lib.count, built);
+
+    uint64_t size = alg_library_image_size(&lib);
+    uint8_t *image = malloc(size);
+    alg_library_image(&lib, image);
+    begin = now();
+    if(alg_library_attach(&attached, attached_table, bytes, image, size) != 0 || attached.count != lib.count) {
+        fprintf(stderr, "the image does not attach\n");
+        return 1;
+    }
+    printf("image: %.2f MB, attached in %.3f s\n", (double) size / (1 << 20), now() - begin);
+    if(out != NULL) {
+        FILE *file = fopen(out, "wb");
+        if(file == NULL || fwrite(image, 1, size, file) != size) {
+            fprintf(stderr, "cannot write %s\n", out);
+            return 1;
+        }
+        fclose(file);
+    }
+
+    // cases of the library's own algorithms: each one played backwards, in a random context
+    int failed = 0, longer = 0;
+    double looking = 0;
+    for(int n = 0; n < lookups && lib.num_algs > 0; n++) {
+        uint8_t answer[ALG_MAX_ANSWER];
+        int alg = (int) rng_below(&rng, (uint32_t) lib.num_algs);
+        int g = lib.syms[rng_below(&rng, (uint32_t) lib.num_syms)];
+        cubie_state state;
+
+        cubie_reset(&state);
+        for(int i = lib.alg_length[alg] - 1; i >= 0; i--) {
+            cubie_twist(&state, alg_twist_inverse[sym_twist[g][lib.algs[alg][i]]]);
+        }
+        if(rng_below(&rng, 2)) {
+            cubie_twist(&state, lib.setups[rng_below(&rng, (uint32_t) lib.num_setups)]);
+        }
+
+        begin = now();
+        int found = alg_lookup(&attached, &state, answer);
+        looking += now() - begin;
+        if(found < 0 && !scope_solved(&lib, &state)) {
+            failed++;
+            continue;
+        }
+        for(int i = 0; i < found; i++) {
+            cubie_twist(&state, answer[i]);
+        }
+        failed += !scope_solved(&lib, &state);
+        longer += found > lib.alg_length[alg] + 1;
+    }
+    printf("%d lookups of known cases: %d not solved, %d answers longer than the case, %.0f ns each\n", lookups,
+           failed, longer, lookups > 0 ? looking / lookups * 1e9 : 0);
+
+    // random states of the scope, to see how often the library knows one
+    int hits = 0;
+    for(int n = 0; n < lookups; n++) {
+        uint8_t answer[ALG_MAX_ANSWER];
+        cubie_state state;
+
+        cubie_reset(&state);
+        for(int i = 0; i < 2 * ALG_MAX_LENGTH; i++) {
+            cubie_twist(&state, lib.setups[rng_below(&rng, (uint32_t) lib.num_setups)]);
+        }
+        int found = alg_lookup(&attached, &state, answer);
+        if(found >= 0) {
+            hits++;
+            for(int i = 0; i < found; i++) {
+                cubie_twist(&state, answer[i]);
+            }
+            failed += !scope_solved(&lib, &state);
+        }
+    }
+    printf("%d random states of the scope: %d known\n", lookups, hits);
+
+    free(image);
+    free(table);
+    free(attached_table);
+    return failed != 0;
+}
@@ -0,0 +1,134 @@
+//
+// Runs a solve as a background job (job_threads.c) while the main thread
+// keeps a frame loop going, the way the page keeps rendering while
+// worker.js searches. Every frame polls the job and prints its progress;
+// with -c the job is cancelled after that many frames, as a move would. At
+// the end it reports how late frames ran and checks the job's answer
+// against ida_solve.
+//
+// Build: cc -O2 -pthread -o analyze tools/analyze.c
+// Usage: ./analyze [-l length] [-s seed] [-m max] [-f fps] [-c frames] [-p table.pdb]...
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../job_threads.c"
+#include "../scramble.c"
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static void sleep_until(double when) {
+    double left = when - now();
+    if(left > 0) {
+        struct timespec ts = {(time_t) left, (long) ((left - (double) (time_t) left) * 1e9)};
+        nanosleep(&ts, NULL);
+    }
+}
+
+int main(int argc, char **argv) {
+    static pattern_db tables[MAX_HEURISTICS];
+    static solve_job job;
+    heuristic heuristics[MAX_HEURISTICS];
+    int num_heuristics = 0, length = 5, max_depth = 8, fps = 60, cancel_after = -1;
+    uint64_t seed = 1;
+    uint8_t scramble_log[256], moves[IDA_MAX_DEPTH * MAX_CELL_TWIST_MOVES], solution[IDA_MAX_DEPTH];
+    cubie_state start;
+    job_thread thread;
+    rng_state rng;
+    puzzle p;
+
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-l") == 0 && i + 1 < argc) length = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 0);
+        else if(strcmp(argv[i], "-m") == 0 && i + 1 < argc) max_depth = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-f") == 0 && i + 1 < argc) fps = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-c") == 0 && i + 1 < argc) cancel_after = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-p") == 0 && i + 1 < argc && num_heuristics < MAX_HEURISTICS - 1) {
+            if(pdb_load(&tables[num_heuristics], argv[++i]) != 0) {
+                fprintf(stderr, "%s: not a pattern database\n", argv[i]);
+                return 1;
+            }
+            heuristics[num_heuristics].estimate = pdb_estimate;
+            heuristics[num_heuristics].data = &tables[num_heuristics];
+            num_heuristics++;
+        }
+        else {
+            fprintf(stderr, "usage: %s [-l length] [-s seed] [-m max] [-f fps] [-c frames] [-p table.pdb]...\n", argv[0]);
+            return 1;
+        }
+    }
+    if(length < 0 || length > 256 || fps < 1) {
+        fprintf(stderr, "bad arguments\n");
+        return 1;
+    }
+    heuristics[num_heuristics].estimate = misplaced_estimate;
+    heuristics[num_heuristics].data = NULL;
+    num_heuristics++;
+
+    reset_puzzle(&p);
+    rng_seed(&rng, seed);
+    scramble_puzzle(&p, &rng, length, SCRAMBLE_MOVE_INS, scramble_log);
+    puzzle_to_cubies(&p, &start);
+
+    job_start(&job, &start, heuristics, num_heuristics, max_depth);
+    if(job_thread_start(&thread, &job) != 0) {
+        fprintf(stderr, "cannot start a thread\n");
+        return 1;
+    }
+
+    double period = 1.0 / fps, begin = now(), next = begin + period, worst = 0;
+    int frames = 0, status = JOB_RUNNING;
+    while(status == JOB_RUNNING) {
+        sleep_until(next);
+        double late = now() - next;
+        if(late > worst) {
+            worst = late;
+        }
+        next += period;
+        frames++;
+
+        if(frames == cancel_after) {
+            job_thread_cancel(&thread);
+        }
+        status = job_thread_poll(&thread);
+        if(frames % fps == 0 || status != JOB_RUNNING) {
+            printf("frame %5d: bound %2d, %12llu nodes\n", frames, job.bound, (unsigned long long) job.nodes);
+        }
+    }
+    double seconds = now() - begin;
+    printf("%d frames in %.2f s (%.1f fps), latest frame %.2f ms late\n", frames, seconds, frames / seconds,
+           worst * 1e3);
+
+    if(status == JOB_CANCELLED) {
+        printf("cancelled\n");
+        return 0;
+    }
+    if(status == JOB_FAILED) {
+        printf("no solution within %d twists\n", max_depth);
+        return 1;
+    }
+
+    // the job searches like ida_solve does, so it has to agree with it exactly
+    ida_search search;
+    init_ida_search(&search, heuristics, num_heuristics);
+    int found = ida_solve(&search, &start, max_depth, solution);
+    int n = job_moves(&job, moves);
+    for(int i = 0; i < n; i++) {
+        apply_move(&p, moves[i]);
+    }
+    puzzle_to_cubies(&p, &start);
+    printf("solution (%d twists, %s, ida_solve: %d twists, %llu nodes):", job.solution_length,
+           cubie_solved(&start) ? "checked" : "DOES NOT SOLVE", found, (unsigned long long) search.stats.total);
+    for(int i = 0; i < n; i++) {
+        printf(" %d", moves[i]);
+    }
+    printf("\n");
+    return !cubie_solved(&start) || found != job.solution_length;
+}
@@ -0,0 +1,134 @@
+//
+// Checks the bitsliced batches of batch.c against one puzzle at a time, then
+// times them in sticker moves per second (one sticker of one puzzle moved
+// once).
+//
+// Build: cc -O2 -march=native -o batch_bench tools/batch_bench.c
+// Usage: ./batch_bench [-m moves] [-s seed]
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../batch.c"
+#include "../scramble.c"
+
+#define MAX_BENCH_MOVES 100000
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+// how many lanes disagree with the puzzles they were loaded from
+static int compare(const puzzle_batch *batch, const puzzle *puzzles) {
+    uint8_t colors[NUM_STICKERS];
+    uint64_t solved[BATCH_WORDS];
+    uint8_t counts[BATCH_LANES * SIDES];
+    int wrong = 0;
+
+    batch_solved(batch, solved);
+    batch_cube_correct(batch, counts);
+    for(int lane = 0; lane < BATCH_LANES; lane++) {
+        const puzzle *p = &puzzles[lane];
+        int is_solved = 1, bad = 0;
+
+        batch_get(batch, lane, colors);
+        for(int i = 0; i < NUM_STICKERS; i++) {
+            int color = p->stickers[orient_remap[p->orientation][i]];
+            bad |= colors[i] != color;
+            is_solved &= color == p->stickers[orient_remap[p->orientation][i - i % CUBES + CUBES / 2]];
+        }
+        for(int cube = 0; cube < SIDES; cube++) {
+            int right = 0;
+            for(int i = cube * CUBES; i < (cube + 1) * CUBES; i++) {
+                right += colors[i] == colors[cube * CUBES + CUBES / 2];
+            }
+            bad |= counts[lane * SIDES + cube] != right;
+        }
+        bad |= (int) ((solved[lane / 64] >> (lane % 64)) & 1) != is_solved;
+        wrong += bad;
+    }
+    return wrong;
+}
+
+int main(int argc, char **argv) {
+    static puzzle_batch batch;
+    static puzzle puzzles[BATCH_LANES];
+    static uint8_t moves[MAX_BENCH_MOVES];
+    int length = 10000, wrong;
+    uint64_t seed = 1;
+    rng_state rng;
+
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-m") == 0 && i + 1 < argc) length = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 0);
+        else {
+            fprintf(stderr, "usage: %s [-m moves] [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+    if(length < 1 || length > MAX_BENCH_MOVES) {
+        length = MAX_BENCH_MOVES;
+    }
+
+    rng_seed(&rng, seed);
+    batch_reset(&batch);
+    for(int lane = 0; lane < BATCH_LANES; lane++) {
+        reset_puzzle(&puzzles[lane]);
+        // leave a few solved, so batch_solved has something to find
+        if(lane % 17 != 0) {
+            scramble_puzzle(&puzzles[lane], &rng, 1 + lane % 30, SCRAMBLE_MOVE_INS, NULL);
+        }
+        batch_set(&batch, lane, &puzzles[lane]);
+    }
+    wrong = compare(&batch, puzzles);
+
+    scramble_moves(&rng, moves, length, SCRAMBLE_MOVE_INS);
+    for(int n = 0; n < 200 && n < length; n++) {
+        batch_apply_move(&batch, moves[n]);
+        for(int lane = 0; lane < BATCH_LANES; lane++) {
+            apply_move(&puzzles[lane], moves[n]);
+        }
+    }
+    wrong += compare(&batch, puzzles);
+    batch_apply_moves(&batch, moves, length);
+    for(int lane = 0; lane < BATCH_LANES; lane++) {
+        for(int n = 0; n < length; n++) {
+            apply_move(&puzzles[lane], moves[n]);
+        }
+    }
+    wrong += compare(&batch, puzzles);
+    printf("%d lanes, %d wrong\n", BATCH_LANES, wrong);
+
+    double start = now();
+    for(int n = 0; n < length; n++) {
+        batch_apply_move(&batch, moves[n]);
+    }
+    double seconds = now() - start;
+    double sticker_moves = (double) length * NUM_STICKERS * BATCH_LANES;
+    printf("move by move:   %8.2f G sticker moves/s (%.1f ns per batch move)\n", sticker_moves / seconds * 1e-9,
+           seconds / length * 1e9);
+
+    start = now();
+    batch_apply_moves(&batch, moves, length);
+    seconds = now() - start;
+    printf("whole sequence: %8.2f G sticker moves/s\n", sticker_moves / seconds * 1e-9);
+
+    uint64_t solved[BATCH_WORDS];
+    int rounds = 10000;
+    start = now();
+    for(int n = 0; n < rounds; n++) {
+        batch_solved(&batch, solved);
+    }
+    seconds = now() - start;
+    int count = 0;
+    for(int lane = 0; lane < BATCH_LANES; lane++) {
+        count += (int) ((solved[lane / 64] >> (lane % 64)) & 1);
+    }
+    printf("batch_solved:   %8.2f M puzzles/s (%d solved)\n", (double) rounds * BATCH_LANES / seconds * 1e-6, count);
+    return wrong != 0;
+}
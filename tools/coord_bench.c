@@ -0,0 +1,98 @@
+//
+// Benchmark of coordinate updates against the full piece permutation.
+//
+// Build: cc -O2 -o coord_bench tools/coord_bench.c
+// Usage: ./coord_bench [moves]
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../coord.c"
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+// same random twist sequence for every run, so the numbers compare
+static void fill_moves(uint8_t *moves, long count) {
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    for(long i = 0; i < count; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        moves[i] = (uint8_t) (seed % NUM_CELL_TWISTS);
+    }
+}
+
+static void report(const char *name, long moves, long updates, double seconds, uint64_t check) {
+    printf("%-28s %8.2f M ops/s  %9.2f M updates/s  (check %llx)\n", name,
+           moves / seconds * 1e-6, updates / seconds * 1e-6, (unsigned long long) check);
+}
+
+int main(int argc, char **argv) {
+    long count = argc > 1 ? atol(argv[1]) : 10000000;
+    uint8_t *moves = malloc((size_t) count);
+    cubie_state state;
+    coord_subset all[NUM_PIECE_CLASSES];
+    coord_subset corners;
+    uint16_t coords[NUM_PIECE_CLASSES][MAX_SUBSET_PIECES];
+    uint64_t check = 0;
+    double start;
+    long i;
+    int c;
+
+    if(moves == NULL) {
+        return 1;
+    }
+    fill_moves(moves, count);
+
+    start = now();
+    init_coord_tables();
+    printf("tables built in %.3f ms\n", (now() - start) * 1e3);
+
+    cubie_reset(&state);
+    start = now();
+    for(i = 0; i < count; i++) {
+        cubie_twist(&state, moves[i]);
+    }
+    check = state.pos[0] ^ state.ori[5];
+    report("cubie_twist (72 pieces)", count, count * NUM_PIECES, now() - start, check);
+
+    cubie_reset(&state);
+    for(c = 0; c < NUM_PIECE_CLASSES; c++) {
+        subset_of_class(&all[c], c, class_pieces[c], 1);
+        subset_coords(&all[c], &state, coords[c]);
+    }
+    start = now();
+    for(i = 0; i < count; i++) {
+        for(c = 0; c < NUM_PIECE_CLASSES; c++) {
+            subset_move(&all[c], coords[c], moves[i]);
+        }
+    }
+    check = coords[0][0] ^ coords[2][3];
+    report("coords (72 pieces)", count, count * NUM_PIECES, now() - start, check);
+
+    subset_of_class(&corners, CORNER_CLASS, 4, 1);
+    subset_coords(&corners, &state, coords[0]);
+    check = 0;
+    start = now();
+    for(i = 0; i < count; i++) {
+        subset_move(&corners, coords[0], moves[i]);
+        check += subset_rank(&corners, coords[0]);
+    }
+    report("4 corners + rank", count, count * corners.count, now() - start, check);
+
+    start = now();
+    for(i = 0; i < count; i++) {
+        subset_unrank(&corners, (uint64_t) i * 2654435761u % subset_size(&corners), coords[0]);
+        check += coords[0][1];
+    }
+    report("4 corners unrank", count, count, now() - start, check);
+
+    free(moves);
+    return 0;
+}
@@ -0,0 +1,144 @@
+//
+// Order and cycle structure of move sequences (cycles.c). Given a sequence,
+// prints its order, the cycles of pieces it makes and their parities.
+// Without one, analyses random sequences, checks every order that is small
+// enough by playing the sequence that many times on a puzzle, and times the
+// analysis.
+//
+// Build: cc -O2 -o cycles tools/cycles.c
+// Usage: ./cycles [-t] [-o orientation] [move]...
+//        ./cycles [-n sequences] [-l length] [-s seed] [-x max]
+//      -t  the numbers are cell twists (0 - 159), not move ids (0 - 32)
+//      -l  moves per random sequence (default 12)
+//      -x  largest order to check by playing it (default 20000)
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../cycles.c"
+#include "../scramble.c"
+
+#define MAX_SEQUENCE 1024
+
+static const char *class_names[NUM_PIECE_CLASSES] = {"corners", "edges", "faces"};
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static void print_report(const cycle_report *report) {
+    if(report->order == UINT64_MAX) {
+        printf("order: more than 2^64\n");
+    }
+    else {
+        printf("order: %llu", (unsigned long long) report->order);
+        if(report->repetitions > 1) {
+            printf(" (the orientation is back after %d plays)", report->repetitions);
+        }
+        printf("\n");
+    }
+    printf("stickers: %d moved in %d cycles, %s\n", report->stickers_moved, report->sticker_cycles,
+           report->sticker_parity ? "odd" : "even");
+    for(int piece_class = 0; piece_class < NUM_PIECE_CLASSES; piece_class++) {
+        printf("%s: %d moved, %d turned in place, %s", class_names[piece_class],
+               report->pieces_moved[piece_class], report->twisted[piece_class],
+               report->parity[piece_class] ? "odd" : "even");
+        for(int n = 0; n < report->num_cycles; n++) {
+            const piece_cycle *cycle = &report->cycles[n];
+            if(cycle->piece_class == piece_class) {
+                printf(" %d", cycle->length);
+                if(cycle->twist_order > 1) {
+                    printf("(x%d)", cycle->twist_order);
+                }
+            }
+        }
+        printf("\n");
+    }
+}
+
+// plays the sequence until the puzzle is back, up to max times; the count, or 0 if it is not back by then
+static uint64_t played_order(const uint8_t *moves, int length, int orientation, uint64_t max) {
+    puzzle p, start;
+
+    reset_puzzle(&start);
+    start.orientation = orientation;
+    p = start;
+    for(uint64_t n = 1; n <= max; n++) {
+        for(int i = 0; i < length; i++) {
+            apply_move(&p, moves[i]);
+        }
+        if(p.orientation == start.orientation && memcmp(p.stickers, start.stickers, NUM_STICKERS) == 0) {
+            return n;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    static cycle_report report;
+    uint8_t sequence[MAX_SEQUENCE];
+    int length = 0, twists = 0, orientation = 0, count = 10000, random_length = 12;
+    uint64_t seed = 1, max_played = 20000;
+    rng_state rng;
+
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-t") == 0) twists = 1;
+        else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc) orientation = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc) count = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-l") == 0 && i + 1 < argc) random_length = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 0);
+        else if(strcmp(argv[i], "-x") == 0 && i + 1 < argc) max_played = strtoull(argv[++i], NULL, 0);
+        else if(argv[i][0] >= '0' && argv[i][0] <= '9' && length < MAX_SEQUENCE) {
+            sequence[length++] = (uint8_t) atoi(argv[i]);
+        }
+        else {
+            fprintf(stderr, "usage: %s [-t] [-o orientation] [move]...\n"
+                            "       %s [-n sequences] [-l length] [-s seed] [-x max]\n", argv[0], argv[0]);
+            return 1;
+        }
+    }
+
+    if(length > 0) {
+        int result = twists ? analyze_twists(sequence, length, &report)
+                            : analyze_moves(sequence, length, orientation, &report);
+        if(result != 0) {
+            fprintf(stderr, "not a sequence of %s\n", twists ? "cell twists" : "move ids from that orientation");
+            return 1;
+        }
+        print_report(&report);
+        return 0;
+    }
+
+    if(count < 1 || random_length < 1 || random_length > MAX_SEQUENCE) {
+        fprintf(stderr, "bad arguments\n");
+        return 1;
+    }
+    rng_seed(&rng, seed);
+    init_scramble_tables();
+    double spent = 0;
+    int checked = 0, wrong = 0;
+    uint64_t largest = 0;
+    for(int n = 0; n < count; n++) {
+        scramble_moves(&rng, sequence, random_length, SCRAMBLE_MOVE_INS);
+
+        double begin = now();
+        analyze_moves(sequence, random_length, 0, &report);
+        spent += now() - begin;
+
+        if(report.order > largest) {
+            largest = report.order;
+        }
+        if(report.order <= max_played) {
+            checked++;
+            wrong += played_order(sequence, random_length, 0, report.order) != report.order;
+        }
+    }
+    printf("%d sequences of %d moves: %.2f us each, largest order %llu; %d orders checked by playing them, "
+           "%d wrong\n", count, random_length, spent / count * 1e6, (unsigned long long) largest, checked, wrong);
+    return wrong != 0;
+}
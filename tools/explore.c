@@ -0,0 +1,565 @@
+//
+// Breadth first explorer: counts the states at each distance (in cell
+// twists) from solved, either of a subset of pieces (coord.c) or of the
+// whole puzzle.
+//
+//      subset: 2 bits per entry of the subset index, unseen, done, or one of
+//              the two levels in flight (which swap meanings every depth).
+//              Threads take blocks of the table, expand the frontier entries
+//              in them and claim new ones with a compare and swap.
+//      whole puzzle: one state per symmetry class (symmetry.c), packed into
+//              RECORD_BYTES, in sorted level files. Threads read the frontier
+//              in blocks and expand it into buffers that are sorted and
+//              spilled to disk as runs whenever they fill. The runs are then
+//              merged, less the frontier and the level before it (the only
+//              ones a neighbour can already be on), in one sequential pass
+//              over every file, so only the buffers have to fit in memory.
+//
+// The histograms are a check on the move tables too: a subset has to reach
+// every entry of its index, and the whole puzzle as many states one twist
+// out as there are distinct twists.
+//
+// Build: cc -O2 -pthread -o explore tools/explore.c
+// Usage: ./explore -c corner|edge|face [-k count] [-n] [-d depth] [-j threads]
+//        ./explore [-d depth] [-j threads] [-m megabytes] [-t dir]
+//      -c  explore a subset of one piece class, chosen as pdb_build does
+//      -d  stop this many twists out (default: when nothing new turns up
+//          for a subset, 3 for the whole puzzle)
+//      -m  memory for the expansion buffers before they spill (default 1024)
+//      -t  directory for the level and run files (default /tmp)
+//
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../symmetry.c"
+
+#define MAX_THREADS 64
+#define MAX_EXPLORE_DEPTH 64
+
+// an entry is done (0), on one of the two levels in flight (1, 2) or unseen
+#define MARK_UNSEEN 3
+#define ENTRIES_PER_WORD 32
+#define LOW_BITS 0x5555555555555555ull
+#define BLOCK_WORDS 1024
+
+// corners need 2 bytes for a piece coordinate, the rest fit in one
+#define RECORD_BYTES (2 * NUM_CORNER_PIECES + NUM_PIECES - NUM_CORNER_PIECES)
+#define READ_BLOCK 256
+#define MAX_RUNS 4096
+
+typedef struct {
+    const coord_subset *subset;
+    uint64_t *marks;
+    uint64_t words;
+    int current;
+    int next;
+    int gather;             // look from the unseen entries instead of the frontier
+    uint64_t next_block;
+    uint64_t found;
+} subset_level;
+
+typedef struct {
+    pthread_mutex_t lock;
+    FILE *frontier;
+    FILE *runs[MAX_RUNS];
+    int num_runs;
+    const char *dir;
+    size_t buffer_records;
+    uint64_t spilled;
+} puzzle_level;
+
+typedef struct {
+    FILE *file;
+    uint8_t record[RECORD_BYTES];
+    int more;
+} record_stream;
+
+static const char *class_names[NUM_PIECE_CLASSES] = {"corner", "edge", "face"};
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static void fail(const char *what) {
+    fprintf(stderr, "explore: %s\n", what);
+    exit(1);
+}
+
+// sets entry i from unseen to `mark`, unless another thread got there first
+static int claim_entry(uint64_t *marks, uint64_t i, int mark) {
+    uint64_t *word = &marks[i / ENTRIES_PER_WORD];
+    int shift = (int) (i % ENTRIES_PER_WORD) * 2;
+    uint64_t old = __atomic_load_n(word, __ATOMIC_RELAXED);
+
+    while(((old >> shift) & 3) == MARK_UNSEEN) {
+        uint64_t marked = old & ~((uint64_t) (MARK_UNSEEN ^ mark) << shift);
+        if(__atomic_compare_exchange_n(word, &old, marked, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// one low bit for each entry of a word that holds `mark`
+static uint64_t entries_marked(uint64_t word, int mark) {
+    uint64_t differ = word ^ (LOW_BITS * (uint64_t) mark);
+    return ~(differ | differ >> 1) & LOW_BITS;
+}
+
+static int get_entry(uint64_t *marks, uint64_t i) {
+    return (int) ((__atomic_load_n(&marks[i / ENTRIES_PER_WORD], __ATOMIC_RELAXED) >> (i % ENTRIES_PER_WORD * 2)) & 3);
+}
+
+// expands the frontier entries of a word, and marks them done
+static uint64_t expand_word(subset_level *level, uint64_t w) {
+    const coord_subset *subset = level->subset;
+    uint16_t coords[MAX_SUBSET_PIECES], moved[MAX_SUBSET_PIECES];
+    // only this thread changes frontier entries of the word
+    uint64_t frontier = entries_marked(__atomic_load_n(&level->marks[w], __ATOMIC_RELAXED), level->current);
+    uint64_t found = 0;
+
+    for(int bit = 0; frontier != 0 && bit < 64; bit += 2) {
+        if(((frontier >> bit) & 1) == 0) {
+            continue;
+        }
+        subset_unrank(subset, w * ENTRIES_PER_WORD + (uint64_t) bit / 2, coords);
+        for(int m = 0; m < NUM_CELL_TWISTS; m++) {
+            for(int i = 0; i < subset->count; i++) {
+                moved[i] = coords[i];
+            }
+            subset_move(subset, moved, m);
+            found += (uint64_t) claim_entry(level->marks, subset_rank(subset, moved), level->next);
+        }
+    }
+    __atomic_fetch_and(&level->marks[w], ~(frontier * 3), __ATOMIC_RELAXED);
+    return found;
+}
+
+// the other way round: marks the unseen entries of a word that have a neighbour on the frontier
+static uint64_t gather_word(subset_level *level, uint64_t w) {
+    const coord_subset *subset = level->subset;
+    uint16_t coords[MAX_SUBSET_PIECES], moved[MAX_SUBSET_PIECES];
+    uint64_t unseen = entries_marked(__atomic_load_n(&level->marks[w], __ATOMIC_RELAXED), MARK_UNSEEN);
+    uint64_t found = 0;
+
+    for(int bit = 0; unseen != 0 && bit < 64; bit += 2) {
+        if(((unseen >> bit) & 1) == 0) {
+            continue;
+        }
+        subset_unrank(subset, w * ENTRIES_PER_WORD + (uint64_t) bit / 2, coords);
+        for(int m = 0; m < NUM_CELL_TWISTS; m++) {
+            for(int i = 0; i < subset->count; i++) {
+                moved[i] = coords[i];
+            }
+            subset_move(subset, moved, m);
+            if(get_entry(level->marks, subset_rank(subset, moved)) == level->current) {
+                found += (uint64_t) claim_entry(level->marks, w * ENTRIES_PER_WORD + (uint64_t) bit / 2, level->next);
+                break;
+            }
+        }
+    }
+    return found;
+}
+
+static void *explore_blocks(void *arg) {
+    subset_level *level = arg;
+    uint64_t found = 0;
+
+    for(;;) {
+        uint64_t first = __atomic_fetch_add(&level->next_block, 1, __ATOMIC_RELAXED) * BLOCK_WORDS;
+        if(first >= level->words) {
+            break;
+        }
+        for(uint64_t w = first; w < first + BLOCK_WORDS && w < level->words; w++) {
+            found += level->gather ? gather_word(level, w) : expand_word(level, w);
+        }
+    }
+
+    __atomic_fetch_add(&level->found, found, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+static int explore_subset(const coord_subset *subset, int max_depth, int threads) {
+    uint64_t entries = subset_size(subset);
+    uint64_t histogram[MAX_EXPLORE_DEPTH + 1] = {0};
+    uint16_t coords[MAX_SUBSET_PIECES];
+    pthread_t workers[MAX_THREADS];
+    subset_level level;
+    cubie_state solved;
+    uint64_t reached = 1;
+    int depth;
+
+    if(entries == 0 || entries > UINT64_MAX / 2) {
+        fail("subset too big to index");
+    }
+    level.subset = subset;
+    level.words = (entries + ENTRIES_PER_WORD - 1) / ENTRIES_PER_WORD;
+    level.marks = malloc((size_t) level.words * sizeof(uint64_t));
+    if(level.marks == NULL) {
+        fail("out of memory for the table");
+    }
+    printf("%s pieces:", class_names[subset->piece_class]);
+    for(int i = 0; i < subset->count; i++) {
+        printf(" %d", subset->pieces[i]);
+    }
+    printf("%s\nentries %llu, table %.2f MB\n", subset->track_twist ? "" : " (positions only)",
+           (unsigned long long) entries, (double) level.words * sizeof(uint64_t) / (1 << 20));
+
+    memset(level.marks, 0xFF, (size_t) level.words * sizeof(uint64_t));
+    // the padding past the last entry is never visited
+    for(uint64_t i = entries; i < level.words * ENTRIES_PER_WORD; i++) {
+        level.marks[i / ENTRIES_PER_WORD] &= ~((uint64_t) MARK_UNSEEN << (i % ENTRIES_PER_WORD * 2));
+    }
+    cubie_reset(&solved);
+    subset_coords(subset, &solved, coords);
+    claim_entry(level.marks, subset_rank(subset, coords), 1);
+    histogram[0] = 1;
+
+    double start = now();
+    for(depth = 0; depth < max_depth && histogram[depth] > 0; depth++) {
+        // the frontier is marked 1 on even depths and 2 on odd ones, and what it finds the other
+        level.current = 1 + depth % 2;
+        level.next = 3 - level.current;
+        // as in pdb_build, once the frontier outgrows what is left it is cheaper to ask every unseen entry
+        level.gather = histogram[depth] > entries - reached;
+        level.next_block = 0;
+        level.found = 0;
+        for(int t = 0; t < threads; t++) {
+            pthread_create(&workers[t], NULL, explore_blocks, &level);
+        }
+        for(int t = 0; t < threads; t++) {
+            pthread_join(workers[t], NULL);
+        }
+        if(level.gather) {
+            for(uint64_t w = 0; w < level.words; w++) {
+                level.marks[w] &= ~(entries_marked(level.marks[w], level.current) * 3);
+            }
+        }
+        histogram[depth + 1] = level.found;
+        reached += level.found;
+    }
+    double seconds = now() - start;
+
+    for(int d = 0; d <= depth; d++) {
+        if(histogram[d] > 0) {
+            printf("  %2d %14llu  %6.2f%%\n", d, (unsigned long long) histogram[d],
+                   100.0 * (double) histogram[d] / (double) entries);
+        }
+    }
+    printf("reached %llu of %llu entries in %.2f s on %d threads\n", (unsigned long long) reached,
+           (unsigned long long) entries, seconds, threads);
+    free(level.marks);
+    return depth == max_depth || reached == entries ? 0 : 1;
+}
+
+static void pack_state(const cubie_state *state, uint8_t *record) {
+    int n = 0;
+
+    for(int piece = 0; piece < NUM_PIECES; piece++) {
+        int coord = piece_coord(state, piece);
+        if(piece < FIRST_EDGE) {
+            record[n++] = (uint8_t) (coord >> 8);
+        }
+        record[n++] = (uint8_t) coord;
+    }
+}
+
+static void unpack_state(const uint8_t *record, cubie_state *state) {
+    int n = 0;
+
+    for(int piece = 0; piece < NUM_PIECES; piece++) {
+        int piece_class = piece_class_of(piece);
+        int coord = record[n++];
+        if(piece < FIRST_EDGE) {
+            coord = coord << 8 | record[n++];
+        }
+        state->pos[piece] = (uint8_t) (class_first[piece_class] + coord / coord_twists(piece_class));
+        state->ori[piece] = (uint8_t) (coord % coord_twists(piece_class));
+    }
+    state->orientation = 0;
+}
+
+static int compare_records(const void *a, const void *b) {
+    return memcmp(a, b, RECORD_BYTES);
+}
+
+// a temporary file in dir, gone once closed
+static FILE *open_spill(const char *dir) {
+    char path[4096];
+    FILE *file;
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/exploreXXXXXX", dir);
+    fd = mkstemp(path);
+    if(fd < 0) {
+        fail("cannot make a file in the spill directory");
+    }
+    unlink(path);
+    file = fdopen(fd, "w+b");
+    if(file == NULL) {
+        fail("cannot open a spill file");
+    }
+    setvbuf(file, NULL, _IOFBF, 1 << 20);
+    return file;
+}
+
+// sorts a buffer, drops repeats, and writes it out as one more run
+static void spill_run(puzzle_level *level, uint8_t *buffer, size_t count) {
+    size_t unique = 0;
+    FILE *run;
+
+    qsort(buffer, count, RECORD_BYTES, compare_records);
+    for(size_t i = 0; i < count; i++) {
+        if(unique == 0 || memcmp(buffer + (unique - 1) * RECORD_BYTES, buffer + i * RECORD_BYTES, RECORD_BYTES) != 0) {
+            memmove(buffer + unique * RECORD_BYTES, buffer + i * RECORD_BYTES, RECORD_BYTES);
+            unique++;
+        }
+    }
+
+    run = open_spill(level->dir);
+    if(fwrite(buffer, RECORD_BYTES, unique, run) != unique) {
+        fail("cannot write a run");
+    }
+    pthread_mutex_lock(&level->lock);
+    if(level->num_runs == MAX_RUNS) {
+        fail("too many runs, give it more memory (-m)");
+    }
+    level->runs[level->num_runs++] = run;
+    level->spilled += unique * RECORD_BYTES;
+    pthread_mutex_unlock(&level->lock);
+}
+
+static void *expand_puzzle(void *arg) {
+    puzzle_level *level = arg;
+    uint8_t *buffer = malloc(level->buffer_records * RECORD_BYTES);
+    uint8_t block[READ_BLOCK * RECORD_BYTES];
+    size_t count = 0, read;
+    cubie_state state, next;
+
+    if(buffer == NULL) {
+        fail("out of memory for the buffers");
+    }
+    for(;;) {
+        pthread_mutex_lock(&level->lock);
+        read = fread(block, RECORD_BYTES, READ_BLOCK, level->frontier);
+        pthread_mutex_unlock(&level->lock);
+        if(read == 0) {
+            break;
+        }
+
+        for(size_t r = 0; r < read; r++) {
+            unpack_state(block + r * RECORD_BYTES, &state);
+            for(int m = 0; m < NUM_CELL_TWISTS; m++) {
+                next = state;
+                cubie_twist(&next, m);
+                sym_canonical(&next, &next);
+                pack_state(&next, buffer + count * RECORD_BYTES);
+                if(++count == level->buffer_records) {
+                    spill_run(level, buffer, count);
+                    count = 0;
+                }
+            }
+        }
+    }
+    if(count > 0) {
+        spill_run(level, buffer, count);
+    }
+    free(buffer);
+    return NULL;
+}
+
+static void stream_next(record_stream *stream) {
+    stream->more = stream->file != NULL && fread(stream->record, RECORD_BYTES, 1, stream->file) == 1;
+}
+
+static void stream_open(record_stream *stream, FILE *file) {
+    stream->file = file;
+    if(file != NULL) {
+        rewind(file);
+    }
+    stream_next(stream);
+}
+
+// whether a sorted stream holds record, moving it up to there
+static int stream_holds(record_stream *stream, const uint8_t *record) {
+    while(stream->more && memcmp(stream->record, record, RECORD_BYTES) < 0) {
+        stream_next(stream);
+    }
+    return stream->more && memcmp(stream->record, record, RECORD_BYTES) == 0;
+}
+
+/*
+ *  Function:    merge_level
+ *  --------------------
+ *  Merges the sorted runs of an expansion into the next level file, less the
+ *      states already on the frontier or the level before it.
+ *
+ *  Return:
+ *      the number of classes written; positions gets the states they hold
+ */
+static uint64_t merge_level(puzzle_level *level, FILE *before, FILE *frontier, FILE *next, uint64_t *positions) {
+    static record_stream runs[MAX_RUNS];
+    record_stream old[2];
+    uint8_t last[RECORD_BYTES];
+    uint64_t classes = 0;
+    int have_last = 0;
+    cubie_state state;
+
+    for(int r = 0; r < level->num_runs; r++) {
+        stream_open(&runs[r], level->runs[r]);
+    }
+    stream_open(&old[0], before);
+    stream_open(&old[1], frontier);
+    *positions = 0;
+
+    for(;;) {
+        int smallest = -1;
+        for(int r = 0; r < level->num_runs; r++) {
+            if(runs[r].more && (smallest < 0 || memcmp(runs[r].record, runs[smallest].record, RECORD_BYTES) < 0)) {
+                smallest = r;
+            }
+        }
+        if(smallest < 0) {
+            break;
+        }
+        if(have_last && memcmp(runs[smallest].record, last, RECORD_BYTES) == 0) {
+            stream_next(&runs[smallest]);
+            continue;
+        }
+        memcpy(last, runs[smallest].record, RECORD_BYTES);
+        have_last = 1;
+        stream_next(&runs[smallest]);
+
+        if(stream_holds(&old[0], last) | stream_holds(&old[1], last)) {
+            continue;
+        }
+        if(fwrite(last, RECORD_BYTES, 1, next) != 1) {
+            fail("cannot write a level");
+        }
+        unpack_state(last, &state);
+        *positions += (uint64_t) sym_class_size(&state);
+        classes++;
+    }
+    fflush(next);
+    return classes;
+}
+
+static int explore_puzzle(int max_depth, int threads, long megabytes, const char *dir) {
+    static puzzle_level level;
+    pthread_t workers[MAX_THREADS];
+    uint8_t record[RECORD_BYTES];
+    uint64_t classes = 1, positions = 1, total = 1;
+    cubie_state solved;
+    FILE *before = NULL, *frontier, *next;
+
+    init_symmetry_tables();
+    pthread_mutex_init(&level.lock, NULL);
+    level.dir = dir;
+    level.buffer_records = (size_t) megabytes * (1 << 20) / (size_t) threads / RECORD_BYTES;
+    if(level.buffer_records < NUM_CELL_TWISTS) {
+        level.buffer_records = NUM_CELL_TWISTS;
+    }
+
+    cubie_reset(&solved);
+    sym_canonical(&solved, &solved);
+    pack_state(&solved, record);
+    frontier = open_spill(dir);
+    fwrite(record, RECORD_BYTES, 1, frontier);
+    fflush(frontier);
+
+    printf("depth        classes        positions       total     seconds  runs  spilled MB\n");
+    printf("  %2d %14llu %16llu %11llu\n", 0, 1ull, 1ull, 1ull);
+    for(int depth = 0; depth < max_depth && classes > 0; depth++) {
+        double start = now();
+
+        rewind(frontier);
+        level.frontier = frontier;
+        level.num_runs = 0;
+        level.spilled = 0;
+        for(int t = 0; t < threads; t++) {
+            pthread_create(&workers[t], NULL, expand_puzzle, &level);
+        }
+        for(int t = 0; t < threads; t++) {
+            pthread_join(workers[t], NULL);
+        }
+
+        next = open_spill(dir);
+        classes = merge_level(&level, before, frontier, next, &positions);
+        for(int r = 0; r < level.num_runs; r++) {
+            fclose(level.runs[r]);
+        }
+        if(before != NULL) {
+            fclose(before);
+        }
+        before = frontier;
+        frontier = next;
+        total += positions;
+
+        printf("  %2d %14llu %16llu %11llu %11.2f %5d %11.1f\n", depth + 1, (unsigned long long) classes,
+               (unsigned long long) positions, (unsigned long long) total, now() - start, level.num_runs,
+               (double) level.spilled / (1 << 20));
+        fflush(stdout);
+    }
+
+    if(before != NULL) {
+        fclose(before);
+    }
+    fclose(frontier);
+    return 0;
+}
+
+static int parse_class(const char *name) {
+    for(int c = 0; c < NUM_PIECE_CLASSES; c++) {
+        if(strcmp(name, class_names[c]) == 0) {
+            return c;
+        }
+    }
+    return -1;
+}
+
+static int usage(const char *name) {
+    fprintf(stderr, "usage: %s -c corner|edge|face [-k count] [-n] [-d depth] [-j threads]\n"
+                    "       %s [-d depth] [-j threads] [-m megabytes] [-t dir]\n", name, name);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    const char *dir = "/tmp";
+    int piece_class = -1, count = 3, track_twist = 1, max_depth = -1, threads = 1;
+    long megabytes = 1024;
+
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            piece_class = parse_class(argv[++i]);
+            if(piece_class < 0) return usage(argv[0]);
+        }
+        else if(strcmp(argv[i], "-k") == 0 && i + 1 < argc) count = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-n") == 0) track_twist = 0;
+        else if(strcmp(argv[i], "-d") == 0 && i + 1 < argc) max_depth = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-j") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-m") == 0 && i + 1 < argc) megabytes = atol(argv[++i]);
+        else if(strcmp(argv[i], "-t") == 0 && i + 1 < argc) dir = argv[++i];
+        else return usage(argv[0]);
+    }
+    if(threads < 1 || threads > MAX_THREADS || megabytes < 1 || max_depth > MAX_EXPLORE_DEPTH) {
+        return usage(argv[0]);
+    }
+
+    if(piece_class < 0) {
+        return explore_puzzle(max_depth < 0 ? 3 : max_depth, threads, megabytes, dir);
+    }
+    if(count < 1 || count > class_pieces[piece_class]) {
+        return usage(argv[0]);
+    }
+    coord_subset subset;
+    init_coord_tables();
+    subset_of_class(&subset, piece_class, count, track_twist);
+    return explore_subset(&subset, max_depth < 0 ? MAX_EXPLORE_DEPTH : max_depth, threads);
+}
@@ -0,0 +1,116 @@
+//
+// Checks the hints of hint.c against the same lookahead done one puzzle at a
+// time (apply_move and hint_score down every line), and times both at each
+// depth, so the budget that fits in a frame can be read off.
+//
+// Build: cc -O2 -march=native -o hint_bench tools/hint_bench.c
+// Usage: ./hint_bench [-n puzzles] [-l length] [-s seed]
+//      -n  scrambles to hint (default 200)
+//      -l  moves per scramble (default 3; the lookahead finds the way back
+//          from up to 3 twists, so more is the case of a real solve)
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../hint.c"
+#include "../scramble.c"
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+// the best score down every canonical line from p, into best[first move]
+static void scalar_lookahead(const puzzle *p, int depth, int max_depth, int first, int last, int run, hint *best) {
+    uint64_t next = depth == 0 ? next_moves(NUM_MOVES, 0) : next_moves(last, run);
+
+    for(int move = 0; move < NUM_MOVES; move++) {
+        if(!((next >> move) & 1)) {
+            continue;
+        }
+        puzzle q = *p;
+        apply_move(&q, move);
+        int f = depth == 0 ? move : first;
+        int score = hint_score(&q);
+        if(score > best[f].score) {
+            best[f].score = (int16_t) score;
+            best[f].depth = (uint8_t) (depth + 1);
+        }
+        if(depth + 1 < max_depth) {
+            scalar_lookahead(&q, depth + 1, max_depth, f, move, move == last ? run + 1 : 1, best);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    static hint_search search;
+    int count = 200, length = 3;
+    uint64_t seed = 1;
+    rng_state rng;
+
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-n") == 0 && i + 1 < argc) count = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-l") == 0 && i + 1 < argc) length = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 0);
+        else {
+            fprintf(stderr, "usage: %s [-n puzzles] [-l length] [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+    if(count < 1 || length < 0) {
+        fprintf(stderr, "bad arguments\n");
+        return 1;
+    }
+
+    puzzle *puzzles = malloc(sizeof(puzzle) * (size_t) count);
+    rng_seed(&rng, seed);
+    for(int i = 0; i < count; i++) {
+        reset_puzzle(&puzzles[i]);
+        scramble_puzzle(&puzzles[i], &rng, length, SCRAMBLE_MOVE_INS, NULL);
+    }
+    init_hint_tables();
+
+    int wrong = 0;
+    for(int depth = 1; depth <= HINT_MAX_DEPTH; depth++) {
+        double batched = 0, scalar = 0, worst = 0;
+        int solved = 0, better = 0;
+
+        for(int i = 0; i < count; i++) {
+            hint best[NUM_MOVES];
+
+            double start = now();
+            int n = hint_moves(&search, &puzzles[i], depth, UINT64_MAX);
+            double seconds = now() - start;
+            batched += seconds;
+            if(seconds > worst) {
+                worst = seconds;
+            }
+            solved += search.hints[0].score == HINT_MAX_SCORE;
+            better += search.hints[0].score > search.root_score;
+
+            for(int m = 0; m < NUM_MOVES; m++) {
+                best[m] = (hint) {(uint8_t) m, 0, -1, {0}};
+            }
+            start = now();
+            scalar_lookahead(&puzzles[i], 0, depth, 0, NUM_MOVES, 0, best);
+            scalar += now() - start;
+
+            for(int k = 0; k < n; k++) {
+                const hint *h = &search.hints[k];
+                wrong += h->score != best[h->move].score || h->depth != best[h->move].depth;
+            }
+        }
+        printf("depth %d: %5llu positions, %8.3f ms batched (worst %.3f), %8.3f ms one at a time, "
+               "%.1f M positions/s; top hint improves %d, solves %d of %d\n", depth,
+               (unsigned long long) search.evaluated, batched / count * 1e3, worst * 1e3, scalar / count * 1e3,
+               (double) search.evaluated * count / batched * 1e-6, better, solved, count);
+    }
+    printf("%d hints differ from the one at a time lookahead\n", wrong);
+
+    free(puzzles);
+    return wrong != 0;
+}
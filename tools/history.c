@@ -0,0 +1,160 @@
+//
+// Undo and redo (history.c). Plays a long random mix of moves, undos, redos
+// and jumps to random steps, checks the puzzle after each against the state
+// kept for every step of the same line, and times them. Then fills the
+// history past its capacity, so the oldest moves are dropped, and checks and
+// times jumps across all of it.
+//
+// Build: cc -O2 -o history tools/history.c
+// Usage: ./history [-n operations] [-c capacity] [-i interval] [-s seed]
+//      -n  operations (default 400000)
+//      -c  moves the history holds (default 131072)
+//      -i  moves between checkpoints (default 256)
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../history.c"
+
+#define PUSH 0
+#define UNDO 1
+#define REDO 2
+#define JUMP 3
+
+static const char *operation_names[4] = {"move", "undo", "redo", "jump"};
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static int same_puzzle(const puzzle *a, const puzzle *b) {
+    return a->orientation == b->orientation && a->last_move_in_axis == b->last_move_in_axis &&
+           memcmp(a->stickers, b->stickers, NUM_STICKERS) == 0;
+}
+
+int main(int argc, char **argv) {
+    static history h;
+    int operations = 400000;
+    uint32_t capacity = 131072, interval = HISTORY_INTERVAL;
+    uint64_t seed = 1;
+    rng_state rng;
+
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-n") == 0 && i + 1 < argc) operations = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-c") == 0 && i + 1 < argc) capacity = (uint32_t) atoi(argv[++i]);
+        else if(strcmp(argv[i], "-i") == 0 && i + 1 < argc) interval = (uint32_t) atoi(argv[++i]);
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 0);
+        else {
+            fprintf(stderr, "usage: %s [-n operations] [-c capacity] [-i interval] [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+    if(operations < 1 || interval == 0 || capacity < 2 * interval || capacity % interval != 0) {
+        fprintf(stderr, "bad arguments\n");
+        return 1;
+    }
+
+    uint8_t *moves = malloc(capacity);
+    puzzle *checkpoints = malloc(HISTORY_CHECKPOINTS(capacity, interval) * sizeof(puzzle));
+    // the state after every step of the current line, counted from the first move ever made
+    puzzle *line = malloc(((size_t) operations + 1) * sizeof(puzzle));
+    uint64_t line_length = 0, line_position = 0;
+    puzzle start;
+
+    if(moves == NULL || checkpoints == NULL || line == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    rng_seed(&rng, seed);
+    init_scramble_tables();
+    reset_puzzle(&start);
+    history_init(&h, &start, moves, capacity, checkpoints, interval);
+    line[0] = start;
+
+    double spent[4] = {0};
+    int counts[4] = {0}, wrong = 0;
+    for(int n = 0; n < operations; n++) {
+        uint32_t draw = rng_below(&rng, 100);
+        int operation = draw < 70 ? PUSH : draw < 85 ? UNDO : draw < 95 ? REDO : JUMP;
+        int move = (int) rng_below(&rng, NUM_MOVES);
+        uint32_t step = h.length > 0 ? rng_below(&rng, h.length + 1) : 0;
+
+        double begin = now();
+        switch(operation) {
+            case PUSH:
+                history_push(&h, move);
+                break;
+            case UNDO:
+                history_undo(&h);
+                break;
+            case REDO:
+                history_redo(&h);
+                break;
+            default:
+                history_jump(&h, step);
+        }
+        spent[operation] += now() - begin;
+        counts[operation]++;
+
+        switch(operation) {
+            case PUSH:
+                line[line_position + 1] = line[line_position];
+                apply_move(&line[line_position + 1], move);
+                line_length = ++line_position;
+                break;
+            case UNDO:
+                line_position -= line_position > h.dropped;
+                break;
+            case REDO:
+                line_position += line_position < line_length;
+                break;
+            default:
+                line_position = h.dropped + step;
+        }
+        wrong += h.dropped + h.position != line_position || !same_puzzle(&h.current, &line[line_position]);
+    }
+
+    printf("%d operations, %llu moves dropped to stay within %u, %.2f bytes per move kept:", operations,
+           (unsigned long long) h.dropped, capacity,
+           (double) (capacity + HISTORY_CHECKPOINTS(capacity, interval) * sizeof(puzzle)) / capacity);
+    for(int operation = 0; operation < 4; operation++) {
+        printf(" %s %.2f us,", operation_names[operation],
+               counts[operation] > 0 ? spent[operation] / counts[operation] * 1e6 : 0);
+    }
+    printf(" %d wrong\n", wrong);
+
+    // a full history, after half as many moves again were dropped: jumps cost the same however long it is
+    uint64_t filled = capacity + capacity / 2;
+    line = realloc(line, (filled + 1) * sizeof(puzzle));
+    if(line == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    history_init(&h, &start, moves, capacity, checkpoints, interval);
+    line[0] = start;
+    for(uint64_t i = 0; i < filled; i++) {
+        int move = (int) rng_below(&rng, NUM_MOVES);
+        history_push(&h, move);
+        line[i + 1] = line[i];
+        apply_move(&line[i + 1], move);
+    }
+    enum { JUMPS = 20000 };
+    uint32_t steps[JUMPS];
+    for(int n = 0; n < JUMPS; n++) {
+        steps[n] = rng_below(&rng, h.length + 1);
+    }
+    int wrong_jumps = 0;
+    double begin = now();
+    for(int n = 0; n < JUMPS; n++) {
+        history_jump(&h, steps[n]);
+        wrong_jumps += !same_puzzle(&h.current, &line[h.dropped + steps[n]]);
+    }
+    printf("%d jumps to random steps of %u moves (%llu dropped before them): %.2f us each, %d wrong\n", JUMPS,
+           h.length, (unsigned long long) h.dropped, (now() - begin) / JUMPS * 1e6, wrong_jumps);
+    return wrong != 0 || wrong_jumps != 0;
+}
@@ -0,0 +1,183 @@
+//
+// Bulk state import (import.c). With a file, reads every state in it and
+// prints how many were accepted and why the rest were refused. Without one,
+// checks the import on generated states: random reachable ones must all pass
+// (as text and packed), and states with pieces moved or turned at random
+// must pass exactly when the stabilizer chain of group.c holds them.
+//
+// Build: cc -O2 -o import tools/import.c
+// Usage: ./import [-f file] [-b] [-o orientation]
+//        ./import [-n states] [-s seed]
+//      -f  states, one text state per line (or packed ones back to back with -b)
+//      -n  states to generate of each kind (default 20000)
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../import.c"
+#include "../scramble.c"
+
+// why import_text refused a state, by its result (import.c)
+static const char *import_result_names[IMPORT_NUM_RESULTS] = {
+    "ok", "not 216 colors", "color counts", "pieces", "corner twist", "corner twist sum", "edge twist sum",
+    "face flip sum", "corner parity", "edge and face parity", "orientation"
+};
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static int import_file(const char *path, int binary, int orientation) {
+    FILE *file = fopen(path, binary ? "rb" : "r");
+    uint64_t results[IMPORT_NUM_RESULTS] = {0}, total = 0;
+    double spent = 0;
+    puzzle p;
+
+    if(file == NULL) {
+        fprintf(stderr, "cannot read %s\n", path);
+        return 1;
+    }
+    for(;;) {
+        char line[4096];
+        uint8_t packed[IMPORT_PACKED_BYTES];
+        int result;
+        double begin;
+
+        if(binary) {
+            if(fread(packed, 1, IMPORT_PACKED_BYTES, file) != IMPORT_PACKED_BYTES) {
+                break;
+            }
+            begin = now();
+            result = import_packed(packed, orientation, &p);
+        }
+        else {
+            if(fgets(line, sizeof(line), file) == NULL) {
+                break;
+            }
+            if(line[0] == '#' || line[0] == '\n') {
+                continue;
+            }
+            begin = now();
+            result = import_text(line, (int) strlen(line), orientation, &p);
+        }
+        spent += now() - begin;
+        results[result]++;
+        total++;
+    }
+    fclose(file);
+
+    printf("%llu states, %.2f us each:", (unsigned long long) total, total > 0 ? spent / total * 1e6 : 0);
+    for(int r = 0; r < IMPORT_NUM_RESULTS; r++) {
+        if(results[r] > 0) {
+            printf(" %s %llu,", import_result_names[r], (unsigned long long) results[r]);
+        }
+    }
+    printf("\n");
+    return 0;
+}
+
+// moves or turns a few pieces of a state at random, keeping every piece once
+static void corrupt(cubie_state *state, rng_state *rng) {
+    int changes = 1 + (int) rng_below(rng, 3);
+
+    for(int c = 0; c < changes; c++) {
+        int piece_class = (int) rng_below(rng, NUM_PIECE_CLASSES);
+        int first = class_first[piece_class], count = class_pieces[piece_class];
+        int a = first + (int) rng_below(rng, (uint32_t) count);
+
+        if(rng_below(rng, 2)) {
+            int b = first + (int) rng_below(rng, (uint32_t) count);
+            uint8_t at = state->pos[a];
+            state->pos[a] = state->pos[b];
+            state->pos[b] = at;
+        }
+        else {
+            state->ori[a] = (uint8_t) rng_below(rng, (uint32_t) twist_count[piece_size[a]]);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+    int binary = 0, orientation = 0, count = 20000;
+    uint64_t seed = 1;
+    rng_state rng;
+
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-f") == 0 && i + 1 < argc) path = argv[++i];
+        else if(strcmp(argv[i], "-b") == 0) binary = 1;
+        else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc) orientation = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc) count = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 0);
+        else {
+            fprintf(stderr, "usage: %s [-f file] [-b] [-o orientation]\n       %s [-n states] [-s seed]\n", argv[0],
+                    argv[0]);
+            return 1;
+        }
+    }
+    init_import_tables();
+    if(path != NULL) {
+        return import_file(path, binary, orientation);
+    }
+    if(count < 1) {
+        fprintf(stderr, "bad arguments\n");
+        return 1;
+    }
+    if(init_puzzle_chain() != 0) {
+        fprintf(stderr, "cannot build the stabilizer chain\n");
+        return 1;
+    }
+
+    rng_seed(&rng, seed);
+    int refused = 0;
+    double spent = 0;
+    for(int n = 0; n < count; n++) {
+        char text[NUM_STICKERS];
+        uint8_t packed[IMPORT_PACKED_BYTES];
+        puzzle p, text_p, packed_p;
+
+        random_puzzle(&p, &rng);
+        export_text(&p, text);
+        export_packed(&p, packed);
+        double begin = now();
+        int result = import_text(text, NUM_STICKERS, p.orientation, &text_p);
+        spent += now() - begin;
+        refused += result != IMPORT_OK || memcmp(text_p.stickers, p.stickers, NUM_STICKERS) != 0;
+        refused += import_packed(packed, p.orientation, &packed_p) != IMPORT_OK ||
+                   memcmp(packed_p.stickers, p.stickers, NUM_STICKERS) != 0;
+    }
+    printf("%d random reachable states: %d refused, %.2f us per text import\n", count, refused, spent / count * 1e6);
+
+    uint64_t results[IMPORT_NUM_RESULTS] = {0};
+    int disagree = 0;
+    for(int n = 0; n < count; n++) {
+        uint8_t colors[NUM_STICKERS], perm[NUM_STICKERS];
+        cubie_state state;
+        puzzle p;
+
+        reset_puzzle(&p);
+        random_puzzle(&p, &rng);
+        puzzle_to_cubies(&p, &state);
+        corrupt(&state, &rng);
+        cubies_to_stickers(&state, colors);
+
+        int result = import_stickers(colors, 0, &p);
+        state_perm(&state, perm);
+        disagree += (result == IMPORT_OK) != chain_contains(&puzzle_chain, perm);
+        results[result]++;
+    }
+    printf("%d states with pieces moved or turned at random: %d disagree with the stabilizer chain;", count,
+           disagree);
+    for(int r = 0; r < IMPORT_NUM_RESULTS; r++) {
+        if(results[r] > 0) {
+            printf(" %s %llu,", import_result_names[r], (unsigned long long) results[r]);
+        }
+    }
+    printf("\n");
+    return refused != 0 || disagree != 0;
+}
@@ -0,0 +1,323 @@
+//
+// Move notation (notation.c). With a file, parses it in pieces as they are
+// read, prints how many tokens and moves it holds and how fast it went, and
+// can write the moves straight to a replay file (replay.c). Without one,
+// checks that emitted moves parse back to the same ids, that every twist of
+// a cell around the center leaves the cell opposite it alone and keeps its
+// own stickers, and times parsing and emitting a large random text.
+//
+// Build: cc -O2 -o notation tools/notation.c
+// Usage: ./notation -f file [-o replay file]
+//        ./notation [-m megabytes] [-s seed]
+//      -m  size of the random text to time (default 64)
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../notation.c"
+#include "../replay.c"
+
+#define PIECE (1 << 20)
+
+// why a token was refused, by its result (notation.c)
+static const char *notation_result_names[NOTATION_NUM_RESULTS] = {
+    "ok", "character", "cell", "direction", "suffix", "twist of the hidden cell", "token too long"
+};
+
+// a letter for each side of the screen axes: axis * 2 + (sign > 0)
+static const char *twist_letters = "LRUDFB";
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static void file_sink(void *data, const uint8_t *bytes, uint32_t count) {
+    if(fwrite(bytes, 1, count, data) != count) {
+        fprintf(stderr, "cannot write the replay file\n");
+        exit(1);
+    }
+}
+
+// where a character offset of a file falls, as a line and column
+static void locate(const char *path, uint64_t offset, uint64_t *line, uint64_t *column) {
+    FILE *file = fopen(path, "r");
+    *line = 1;
+    *column = 1;
+    for(uint64_t i = 0; i < offset && file != NULL; i++) {
+        int c = fgetc(file);
+        if(c == EOF) {
+            break;
+        }
+        *column = c == '\n' ? 1 : *column + 1;
+        *line += c == '\n';
+    }
+    if(file != NULL) {
+        fclose(file);
+    }
+}
+
+static int parse_file(const char *path, const char *replay_path) {
+    static char text[PIECE];
+    static uint8_t moves[NOTATION_FEED_ROOM(PIECE)];
+    static replay_writer w;
+    FILE *file = fopen(path, "r"), *out = NULL;
+    notation_parser np;
+    uint64_t total = 0, bytes = 0;
+    double spent = 0;
+    size_t got;
+
+    if(file == NULL) {
+        fprintf(stderr, "cannot read %s\n", path);
+        return 1;
+    }
+    if(replay_path != NULL) {
+        puzzle start;
+        out = fopen(replay_path, "wb");
+        if(out == NULL) {
+            fprintf(stderr, "cannot write %s\n", replay_path);
+            return 1;
+        }
+        reset_puzzle(&start);
+        replay_start(&w, &start, 256, file_sink, out);
+    }
+
+    notation_parser_init(&np);
+    while((got = fread(text, 1, PIECE, file)) > 0 || !feof(file)) {
+        double begin = now();
+        int count = notation_feed(&np, text, (uint32_t) got, moves);
+        if(feof(file)) {
+            count += notation_finish(&np, moves + count);
+        }
+        spent += now() - begin;
+        bytes += got;
+        total += (uint64_t) count;
+        for(int i = 0; i < count && out != NULL; i++) {
+            replay_write(&w, moves[i]);
+        }
+        if(np.error != NOTATION_OK || feof(file)) {
+            break;
+        }
+    }
+    fclose(file);
+    if(out != NULL) {
+        replay_finish(&w);
+        fclose(out);
+    }
+
+    if(np.error != NOTATION_OK) {
+        uint64_t line, column;
+        locate(path, np.error_offset, &line, &column);
+        fprintf(stderr, "%s:%llu:%llu: bad %s\n", path, (unsigned long long) line, (unsigned long long) column,
+                notation_result_names[np.error]);
+    }
+    printf("%llu tokens, %llu moves%s, %.1f MB/s\n", (unsigned long long) np.tokens, (unsigned long long) total,
+           np.error != NOTATION_OK ? " before the bad token" : "", spent > 0 ? bytes / spent * 1e-6 : 0);
+    return np.error != NOTATION_OK;
+}
+
+// writes a random token: a twist of the center or a cell around it, with a suffix, or a move-in
+static int random_token(rng_state *rng, char *out) {
+    int n = 0;
+    uint32_t kind = rng_below(rng, 10);
+
+    if(kind == 0) {
+        out[n++] = '@';
+        out[n++] = twist_letters[rng_below(rng, 6)];
+        return n;
+    }
+    int cell = kind < 6 ? 0 : 1 + (int) rng_below(rng, 6);
+    int own_axis = cell > 0 ? cell_direction[cell] / 2 : -1;
+    int axes = 1 + (int) rng_below(rng, 3);
+    out[n++] = cell_letters[cell];
+    for(int axis = 0; axis < 3 && axes > 0; axis++) {
+        if(rng_below(rng, 3 - axis) < (uint32_t) axes) {
+            int sign = (int) rng_below(rng, 2);
+            out[n++] = axis == own_axis ? (sign ? 'O' : 'I') : twist_letters[axis * 2 + sign];
+            axes--;
+        }
+    }
+    uint32_t suffix = rng_below(rng, 4);
+    if(suffix == 1) {
+        out[n++] = '2';
+    }
+    if(suffix == 2) {
+        out[n++] = '\'';
+    }
+    return n;
+}
+
+// feeds a text to a parser in pieces of random sizes; the moves, or -1 if it is refused
+static int parse_in_pieces(const char *text, int length, uint8_t *moves, rng_state *rng) {
+    notation_parser np;
+    int count = 0;
+
+    notation_parser_init(&np);
+    for(int at = 0; at < length;) {
+        int piece = 1 + (int) rng_below(rng, 12);
+        if(piece > length - at) {
+            piece = length - at;
+        }
+        count += notation_feed(&np, text + at, (uint32_t) piece, moves + count);
+        at += piece;
+    }
+    count += notation_finish(&np, moves + count);
+    return np.error == NOTATION_OK ? count : -1;
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL, *replay_path = NULL;
+    uint64_t seed = 1;
+    int megabytes = 64;
+    rng_state rng;
+
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-f") == 0 && i + 1 < argc) path = argv[++i];
+        else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc) replay_path = argv[++i];
+        else if(strcmp(argv[i], "-m") == 0 && i + 1 < argc) megabytes = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 0);
+        else {
+            fprintf(stderr, "usage: %s -f file [-o replay file]\n       %s [-m megabytes] [-s seed]\n", argv[0],
+                    argv[0]);
+            return 1;
+        }
+    }
+    if(init_notation_tables() != 0) {
+        fprintf(stderr, "some turn is made by no twist\n");
+        return 1;
+    }
+    if(path != NULL) {
+        return parse_file(path, replay_path);
+    }
+    if(megabytes < 1) {
+        fprintf(stderr, "bad arguments\n");
+        return 1;
+    }
+    rng_seed(&rng, seed);
+
+    // emitted moves parse back to the same ids, however the text is cut
+    int wrong = 0;
+    for(int n = 0; n < 2000; n++) {
+        uint8_t moves[64], parsed[64 * NOTATION_MAX_TOKEN_MOVES];
+        char text[64 * NOTATION_MAX_TOKEN_CHARS];
+        int count = 1 + (int) rng_below(&rng, 64);
+
+        for(int i = 0; i < count; i++) {
+            moves[i] = (uint8_t) rng_below(&rng, NUM_MOVES);
+        }
+        int length = notation_emit(moves, count, text);
+        wrong += parse_in_pieces(text, length, parsed, &rng) != count || memcmp(parsed, moves, (size_t) count) != 0;
+    }
+    printf("2000 random move sequences emitted and parsed back: %d wrong\n", wrong);
+
+    // every twist of a cell: it keeps its own stickers, leaves the opposite cell alone, and its inverse undoes it
+    static const int opposite[SIDES] = {7, 6, 4, 5, 2, 3, 1, 0};
+    int twists = 0, bad_twists = 0;
+    for(int cell = 0; cell < NOTATION_TWIST_CELLS; cell++) {
+        for(int axis = 0; axis < CUBES; axis++) {
+            int v[3], own_axis = cell > 0 ? cell_direction[cell] / 2 : -1;
+            char token[2 * NOTATION_MAX_TOKEN + 2];
+            uint8_t moves[NOTATION_FEED_ROOM(2 * NOTATION_MAX_TOKEN + 2)];
+            int n = 0;
+
+            select_vector(axis, v);
+            if(axis == CUBES / 2) {
+                continue;
+            }
+            token[n++] = cell_letters[cell];
+            for(int a = 0; a < 3; a++) {
+                if(v[a] != 0) {
+                    token[n++] = a == own_axis ? ((v[a] > 0) == (cell_direction[cell] & 1) ? 'O' : 'I')
+                                               : twist_letters[a * 2 + (v[a] > 0)];
+                }
+            }
+            token[n++] = ' ';
+            int length = n;
+            for(int k = 0; k < n - 1; k++) {
+                token[length++] = token[k];
+            }
+            token[length++] = '\'';
+
+            puzzle p, start;
+            int orientation = (int) rng_below(&rng, (uint32_t) num_orientations);
+            for(int i = 0; i < NUM_STICKERS; i++) {
+                p.stickers[i] = (uint8_t) i;
+            }
+            p.orientation = orientation;
+            p.last_move_in_axis = NO_AXIS;
+            start = p;
+
+            int count = parse_in_pieces(token, length, moves, &rng);
+            if(count < 0) {
+                bad_twists++;
+                continue;
+            }
+            int half = count / 2;
+            for(int i = 0; i < half; i++) {
+                apply_move(&p, moves[i]);
+            }
+            int moved = 0;
+            for(int slot = 0; slot < CUBES; slot++) {
+                int at = orient_remap[orientation][cell * CUBES + slot];
+                int across = orient_remap[orientation][opposite[cell] * CUBES + slot];
+                bad_twists += p.stickers[across] != start.stickers[across];
+                bad_twists += (int) (p.stickers[at] / CUBES) != orient_remap[orientation][cell * CUBES] / CUBES;
+                moved += p.stickers[at] != start.stickers[at];
+            }
+            bad_twists += moved == 0;
+            for(int i = half; i < count; i++) {
+                apply_move(&p, moves[i]);
+            }
+            bad_twists += memcmp(p.stickers, start.stickers, NUM_STICKERS) != 0 || p.orientation != orientation;
+            twists++;
+        }
+    }
+    printf("%d cell twists checked: %d wrong\n", twists, bad_twists);
+
+    // speed, on a large random text
+    uint64_t size = (uint64_t) megabytes << 20;
+    char *text = malloc(size + 16);
+    uint8_t *moves = malloc(NOTATION_FEED_ROOM(size));
+    uint64_t length = 0;
+    if(text == NULL || moves == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    while(length < size) {
+        length += (uint64_t) random_token(&rng, text + length);
+        text[length++] = rng_below(&rng, 16) == 0 ? '\n' : ' ';
+    }
+
+    notation_parser np;
+    uint64_t count = 0;
+    double begin = now();
+    notation_parser_init(&np);
+    for(uint64_t at = 0; at < length; at += PIECE) {
+        uint32_t piece = (uint32_t) (length - at < PIECE ? length - at : PIECE);
+        count += (uint64_t) notation_feed(&np, text + at, piece, moves + count);
+    }
+    count += (uint64_t) notation_finish(&np, moves + count);
+    double parsing = now() - begin;
+    if(np.error != NOTATION_OK) {
+        fprintf(stderr, "the random text was refused: %s\n", notation_result_names[np.error]);
+        return 1;
+    }
+
+    uint64_t emit_moves = count < (size / NOTATION_MAX_TOKEN_CHARS) ? count : size / NOTATION_MAX_TOKEN_CHARS;
+    begin = now();
+    uint64_t emitted = 0;
+    for(uint64_t at = 0; at < emit_moves; at += 4096) {
+        int piece = (int) (emit_moves - at < 4096 ? emit_moves - at : 4096);
+        emitted += (uint64_t) notation_emit(moves + at, piece, text + emitted);
+    }
+    double emitting = now() - begin;
+
+    printf("%.0f MB, %llu tokens, %llu moves: parsed at %.0f MB/s (%.0f M moves/s), emitted at %.0f M moves/s\n",
+           length / 1048576.0, (unsigned long long) np.tokens, (unsigned long long) count, length / parsing * 1e-6,
+           count / parsing * 1e-6, emit_moves / emitting * 1e-6);
+    return wrong != 0 || bad_twists != 0;
+}
@@ -0,0 +1,139 @@
+//
+// Shortest sequences for partial goals (pattern.c): scrambles a few
+// puzzles and, for each, finds the fewest cell twists that show the pattern,
+// printing the time spent building tables and searching. Every puzzle after
+// the first finds the tables it needs in the cache.
+//
+// Build: cc -O2 -o pattern tools/pattern.c
+// Usage: ./pattern [-c cell]... [-k class]... [-n puzzles] [-l length] [-s seed] [-m max] [-t megabytes]
+//      -c  a cell (0 - 7) to solve
+//      -k  a class of pieces to place: 4, 3 or 2 (stickers per piece)
+//      -n  puzzles to scramble (default 5)
+//      -l  moves per scramble (default 8)
+//      -m  longest answer to look for (default 12)
+//      -t  table cache (default 64)
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../pattern.c"
+#include "../scramble.c"
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+    static pattern_goal goal;
+    static pattern_cache cache;
+    sticker_pattern pattern;
+    int count = 5, length = 8, max_depth = 12, asked = 0, failed = 0;
+    long megabytes = 64;
+    uint64_t seed = 1;
+    uint8_t solution[IDA_MAX_DEPTH], colors[NUM_STICKERS];
+    rng_state rng;
+
+    init_coord_tables();
+    pattern_clear(&pattern);
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            int cell = atoi(argv[++i]);
+            if(cell < 0 || cell >= SIDES) {
+                fprintf(stderr, "no cell %d\n", cell);
+                return 1;
+            }
+            pattern_add_cell(&pattern, cell);
+            asked = 1;
+        }
+        else if(strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+            int stickers = atoi(argv[++i]);
+            if(stickers < 2 || stickers > 4) {
+                fprintf(stderr, "pieces have 2, 3 or 4 stickers\n");
+                return 1;
+            }
+            pattern_add_class(&pattern, stickers == 4 ? CORNER_CLASS : stickers == 3 ? EDGE_CLASS : FACE_CLASS);
+            asked = 1;
+        }
+        else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc) count = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-l") == 0 && i + 1 < argc) length = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 0);
+        else if(strcmp(argv[i], "-m") == 0 && i + 1 < argc) max_depth = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-t") == 0 && i + 1 < argc) megabytes = atol(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [-c cell]... [-k class]... [-n puzzles] [-l length] [-s seed] [-m max] "
+                            "[-t megabytes]\n", argv[0]);
+            return 1;
+        }
+    }
+    if(!asked) {
+        pattern_add_cell(&pattern, 1);
+    }
+    if(count < 1 || length < 0 || megabytes < 1) {
+        fprintf(stderr, "bad arguments\n");
+        return 1;
+    }
+
+    void *memory = malloc((size_t) megabytes << 20);
+    if(memory == NULL) {
+        fprintf(stderr, "cannot allocate the cache\n");
+        return 1;
+    }
+    pattern_cache_init(&cache, memory, (uint64_t) megabytes << 20);
+
+    rng_seed(&rng, seed);
+    for(int n = 0; n < count; n++) {
+        ida_search search;
+        cubie_state start;
+        puzzle p;
+
+        reset_puzzle(&p);
+        scramble_puzzle(&p, &rng, length, SCRAMBLE_MOVE_INS, NULL);
+        puzzle_to_cubies(&p, &start);
+
+        double begin = now();
+        uint64_t built = cache.built;
+        if(pattern_prepare(&goal, &cache, &pattern) != 0) {
+            fprintf(stderr, "no state shows that pattern\n");
+            return 1;
+        }
+        double prepared = now() - begin;
+
+        begin = now();
+        pattern_search_init(&search, &goal);
+        int found = ida_solve(&search, &start, max_depth, solution);
+        double searched = now() - begin;
+
+        printf("puzzle %d: %llu tables built (%d groups, %d positions with a choice) in %.3f s, ", n,
+               (unsigned long long) (cache.built - built), goal.num_groups, goal.num_choices, prepared);
+        if(found < 0) {
+            printf("none within %d twists (%llu nodes, %.3f s)\n", max_depth, (unsigned long long) search.stats.total,
+                   searched);
+            continue;
+        }
+        for(int i = 0; i < found; i++) {
+            cubie_twist(&start, solution[i]);
+        }
+        cubies_to_stickers(&start, colors);
+        int shows = 1;
+        for(int s = 0; s < NUM_STICKERS; s++) {
+            shows &= pattern.target[s] == PATTERN_ANY || pattern.target[s] == colors[s];
+        }
+        failed += !shows;
+        printf("%d twists (%s, %llu nodes, %.3f s):", found, shows ? "checked" : "DOES NOT SHOW IT",
+               (unsigned long long) search.stats.total, searched);
+        for(int i = 0; i < found; i++) {
+            printf(" %d", solution[i]);
+        }
+        printf("\n");
+    }
+    printf("cache: %d tables, %.2f MB, %llu built, %llu reused\n", cache.count, (double) cache.used / (1 << 20),
+           (unsigned long long) cache.built, (unsigned long long) cache.reused);
+
+    free(memory);
+    return failed != 0;
+}
@@ -0,0 +1,166 @@
+//
+// Builds a pattern database for a set of pieces and writes it to a file, or
+// maps an existing file and reports on it.
+//
+// Build: cc -O2 -o pdb_build tools/pdb_build.c
+// Usage: ./pdb_build -c corner|edge|face [-k count] [-p piece,piece,...] [-n] -o file
+//        ./pdb_build -i file [-r samples]
+//      -k  track the first count pieces of the class (default 3)
+//      -p  track these pieces instead (global piece ids, see cubie.c)
+//      -n  positions only, ignore how the pieces are twisted
+//      -i  map a table and print its header, distribution and the average
+//          heuristic over random states
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../pdb.c"
+#include "../scramble.c"
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static const char *class_names[NUM_PIECE_CLASSES] = {"corner", "edge", "face"};
+
+static void print_report(const pattern_db *db) {
+    const pdb_header *header = &db->header;
+    double sum = 0;
+
+    printf("%s pieces:", class_names[header->piece_class]);
+    for(uint32_t i = 0; i < header->count; i++) {
+        printf(" %d", header->pieces[i]);
+    }
+    printf("%s\n", header->track_twist ? "" : " (positions only)");
+    printf("entries %llu, table %.2f MB\n", (unsigned long long) header->entries,
+           (double) (header->table_bytes + sizeof(pdb_header)) / (1 << 20));
+
+    for(int d = 0; d < PDB_HISTOGRAM; d++) {
+        if(header->histogram[d] == 0) {
+            continue;
+        }
+        sum += (double) d * (double) header->histogram[d];
+        printf("  %2d %14llu  %6.2f%%\n", d, (unsigned long long) header->histogram[d],
+               100.0 * (double) header->histogram[d] / (double) header->entries);
+    }
+    printf("average %.3f, max %u\n", sum / (double) header->entries, header->max_depth);
+}
+
+static int parse_class(const char *name) {
+    for(int c = 0; c < NUM_PIECE_CLASSES; c++) {
+        if(strcmp(name, class_names[c]) == 0) {
+            return c;
+        }
+    }
+    return -1;
+}
+
+static int usage(const char *name) {
+    fprintf(stderr, "usage: %s -c corner|edge|face [-k count] [-p pieces] [-n] -o file\n"
+                    "       %s -i file [-r samples]\n", name, name);
+    return 1;
+}
+
+static int inspect(const char *path, long samples) {
+    pattern_db db;
+    cubie_state state;
+    puzzle p;
+    rng_state rng;
+    double start = now(), sum = 0;
+
+    if(pdb_load(&db, path) != 0) {
+        fprintf(stderr, "%s: not a pattern database\n", path);
+        return 1;
+    }
+    printf("mapped %s in %.3f ms\n", path, (now() - start) * 1e3);
+    print_report(&db);
+
+    rng_seed(&rng, 1);
+    start = now();
+    for(long n = 0; n < samples; n++) {
+        random_puzzle(&p, &rng);
+        puzzle_to_cubies(&p, &state);
+        sum += pdb_lookup(&db, &state);
+    }
+    if(samples > 0) {
+        printf("random states: average %.3f over %ld (%.2f us per state and lookup)\n", sum / (double) samples,
+               samples, (now() - start) * 1e6 / (double) samples);
+    }
+
+    pdb_unload(&db);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    coord_subset subset;
+    pattern_db db;
+    const char *out = NULL, *in = NULL, *pieces = NULL;
+    int piece_class = -1, count = 3, track_twist = 1;
+    long samples = 10000;
+
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-c") == 0 && i + 1 < argc) piece_class = parse_class(argv[++i]);
+        else if(strcmp(argv[i], "-k") == 0 && i + 1 < argc) count = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-p") == 0 && i + 1 < argc) pieces = argv[++i];
+        else if(strcmp(argv[i], "-n") == 0) track_twist = 0;
+        else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc) out = argv[++i];
+        else if(strcmp(argv[i], "-i") == 0 && i + 1 < argc) in = argv[++i];
+        else if(strcmp(argv[i], "-r") == 0 && i + 1 < argc) samples = atol(argv[++i]);
+        else return usage(argv[0]);
+    }
+
+    if(in != NULL) {
+        return inspect(in, samples);
+    }
+    if(piece_class < 0 || out == NULL) {
+        return usage(argv[0]);
+    }
+
+    init_coord_tables();
+    if(pieces != NULL) {
+        char *list = strdup(pieces);
+        subset.piece_class = piece_class;
+        subset.track_twist = track_twist;
+        subset.count = 0;
+        for(char *token = strtok(list, ","); token != NULL; token = strtok(NULL, ",")) {
+            int piece = atoi(token);
+            if(subset.count == MAX_SUBSET_PIECES || piece < 0 || piece >= NUM_PIECES ||
+               piece_class_of(piece) != piece_class) {
+                fprintf(stderr, "piece %s is not a %s\n", token, class_names[piece_class]);
+                return 1;
+            }
+            subset.pieces[subset.count++] = (uint8_t) piece;
+        }
+        free(list);
+    }
+    else {
+        if(count < 1 || count > class_pieces[piece_class]) {
+            return usage(argv[0]);
+        }
+        subset_of_class(&subset, piece_class, count, track_twist);
+    }
+
+    uint64_t bytes = pdb_table_bytes(&subset);
+    uint8_t *table = bytes != 0 ? malloc((size_t) bytes) : NULL;
+    if(table == NULL) {
+        fprintf(stderr, "table too big (%llu bytes)\n", (unsigned long long) bytes);
+        return 1;
+    }
+
+    double start = now();
+    pdb_build(&db, &subset, table);
+    printf("built in %.2f s\n", now() - start);
+    print_report(&db);
+
+    if(pdb_save(&db, out) != 0) {
+        fprintf(stderr, "could not write %s\n", out);
+        return 1;
+    }
+    free(table);
+    return 0;
+}
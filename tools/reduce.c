@@ -0,0 +1,162 @@
+//
+// Builds the tables of the reduction solver (reduce.c), optionally writes them
+// to a file a later run can attach with -i, and solves random states with
+// them, and states a few random twists from solved.
+//
+// Build: cc -O2 -o reduce tools/reduce.c
+// Usage: ./reduce [-o file] [-i file] [-n count] [-s seed]
+//      -o  write the built tables to file
+//      -i  attach the tables in file instead of building them
+//      -n  random states to solve and check (default 1000)
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../reduce.c"
+#include "../scramble.c"
+
+#define MAX_SOLUTION (MAX_PHASE_WORD * MAX_CHAIN_LEVELS)
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static int attach_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    uint8_t *image;
+    long size;
+    int result = -1;
+
+    if(f == NULL) {
+        return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    image = malloc(size > 0 ? (size_t) size : 1);
+    if(image != NULL && fread(image, 1, (size_t) size, f) == (size_t) size) {
+        result = reduction_attach(image, (int) size);
+    }
+    free(image);
+    fclose(f);
+    return result;
+}
+
+static int write_file(const char *path) {
+    int size = reduction_image_size();
+    uint8_t *image = malloc((size_t) size);
+    FILE *f = fopen(path, "wb");
+    int result = -1;
+
+    if(image != NULL && f != NULL) {
+        reduction_image(image);
+        result = fwrite(image, 1, (size_t) size, f) == (size_t) size ? 0 : -1;
+        printf("wrote %s, %d bytes\n", path, size);
+    }
+    if(f != NULL && fclose(f) != 0) {
+        result = -1;
+    }
+    free(image);
+    return result;
+}
+
+int main(int argc, char **argv) {
+    static uint8_t twists[MAX_SOLUTION];
+    static uint8_t moves[MAX_SOLUTION * MAX_CELL_TWIST_MOVES];
+    const char *out = NULL, *in = NULL;
+    long count = 1000, total_twists = 0, total_moves = 0, failed = 0;
+    int longest = 0;
+    uint64_t seed = 1;
+    rng_state rng;
+    cubie_state state;
+    puzzle p;
+
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-o") == 0 && i + 1 < argc) out = argv[++i];
+        else if(strcmp(argv[i], "-i") == 0 && i + 1 < argc) in = argv[++i];
+        else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc) count = atol(argv[++i]);
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 0);
+        else {
+            fprintf(stderr, "usage: %s [-o file] [-i file] [-n count] [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    double start = now();
+    if(in != NULL ? attach_file(in) != 0 : init_reduction_tables() != 0) {
+        fprintf(stderr, in != NULL ? "%s: not reduction tables for this build\n" : "could not build the tables\n", in);
+        return 1;
+    }
+    printf("%s in %.2f s\n", in != NULL ? "attached" : "built", now() - start);
+    if(out != NULL && write_file(out) != 0) {
+        fprintf(stderr, "could not write %s\n", out);
+        return 1;
+    }
+
+    rng_seed(&rng, seed);
+    start = now();
+    for(long n = 0; n < count; n++) {
+        random_puzzle(&p, &rng);
+        puzzle_to_cubies(&p, &state);
+        int length = reduction_solve(&state, twists, MAX_SOLUTION);
+        if(length < 0) {
+            failed++;
+            continue;
+        }
+        for(int i = 0; i < length; i++) {
+            cubie_twist(&state, twists[i]);
+        }
+        failed += !cubie_solved(&state);
+        total_twists += length;
+        if(length > longest) {
+            longest = length;
+        }
+    }
+    double seconds = now() - start;
+    if(count > 0) {
+        printf("%ld random states: %.1f twists on average, %d at most, %.0f solves/s, %ld failed\n", count,
+               (double) total_twists / (double) count, longest, (double) count / seconds, failed);
+    }
+
+    // states a few twists from solved, which the bounded search gives a shortest solution
+    for(int twists_made = 1; twists_made <= REDUCTION_SEARCH_DEPTH + 1 && count > 0; twists_made++) {
+        long total = 0, longer = 0;
+        start = now();
+        for(int n = 0; n < 100; n++) {
+            cubie_reset(&state);
+            for(int i = 0; i < twists_made; i++) {
+                cubie_twist(&state, (int) rng_below(&rng, NUM_CELL_TWISTS));
+            }
+            int length = reduction_solve(&state, twists, MAX_SOLUTION);
+            for(int i = 0; i < length; i++) {
+                cubie_twist(&state, twists[i]);
+            }
+            failed += length < 0 || !cubie_solved(&state);
+            total += length;
+            longer += length > twists_made;
+        }
+        printf("%d random twists from solved: %.1f twists on average, %ld of 100 longer, %.2f ms each\n",
+               twists_made, total / 100.0, longer, (now() - start) * 10);
+    }
+
+    // the moves the front end would animate, played on the puzzle itself
+    for(long n = 0; n < count && n < 100; n++) {
+        random_puzzle(&p, &rng);
+        int length = reduction_solve_puzzle(&p, moves, MAX_SOLUTION * MAX_CELL_TWIST_MOVES);
+        for(int i = 0; i < length; i++) {
+            apply_move(&p, moves[i]);
+        }
+        puzzle_to_cubies(&p, &state);
+        failed += length < 0 || !cubie_solved(&state);
+        total_moves += length;
+    }
+    if(count > 0) {
+        printf("as move ids: %.1f on average\n", (double) total_moves / (double) (count < 100 ? count : 100));
+    }
+    return failed != 0;
+}
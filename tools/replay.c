@@ -0,0 +1,273 @@
+//
+// Replay files (replay.c). With a file, maps it, prints its layout and the
+// state at a position. Without one, writes random sessions and checks every
+// position of the short ones against playing their moves, then writes one
+// long session to a file, maps it, checks and times seeks to random
+// positions, and reads the same file cut short as one still being written.
+//
+// Build: cc -O2 -o replay tools/replay.c
+// Usage: ./replay -f file [-p position]
+//        ./replay [-n sessions] [-l length] [-m moves] [-i interval] [-o file] [-s seed]
+//      -n  short sessions, of 1 to `length` moves (defaults 500 and 600)
+//      -m  moves in the long session (default 2000000)
+//      -i  moves between snapshots (default 256)
+//      -o  where to write the long session (default replay.bin)
+//
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../replay.c"
+#include "../rng.c"
+
+typedef struct {
+    uint8_t *bytes;
+    uint64_t size;
+    uint64_t capacity;
+} buffer;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static void buffer_sink(void *data, const uint8_t *bytes, uint32_t count) {
+    buffer *b = data;
+    if(b->size + count > b->capacity) {
+        b->capacity = (b->size + count) * 2;
+        b->bytes = realloc(b->bytes, b->capacity);
+        if(b->bytes == NULL) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+    memcpy(b->bytes + b->size, bytes, count);
+    b->size += count;
+}
+
+static void file_sink(void *data, const uint8_t *bytes, uint32_t count) {
+    if(fwrite(bytes, 1, count, data) != count) {
+        fprintf(stderr, "cannot write the session\n");
+        exit(1);
+    }
+}
+
+static int same_puzzle(const puzzle *a, const puzzle *b) {
+    return a->orientation == b->orientation && a->last_move_in_axis == b->last_move_in_axis &&
+           memcmp(a->stickers, b->stickers, NUM_STICKERS) == 0;
+}
+
+static const uint8_t *map_file(const char *path, uint64_t *size) {
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+
+    if(fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+        fprintf(stderr, "cannot read %s\n", path);
+        return NULL;
+    }
+    void *data = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED) {
+        fprintf(stderr, "cannot map %s\n", path);
+        return NULL;
+    }
+    *size = (uint64_t) st.st_size;
+    return data;
+}
+
+static int show_file(const char *path, uint64_t position, int at_end) {
+    replay_reader r;
+    uint64_t size;
+    const uint8_t *data = map_file(path, &size);
+    char text[NUM_STICKERS + 1];
+    puzzle p;
+
+    if(data == NULL) {
+        return 1;
+    }
+    if(replay_open(&r, data, size) != 0) {
+        fprintf(stderr, "%s is not a replay file\n", path);
+        return 1;
+    }
+    printf("%llu moves, %llu blocks of %u moves, %.3f bytes per move%s\n", (unsigned long long) r.moves,
+           (unsigned long long) r.blocks, r.interval, r.moves > 0 ? (double) size / r.moves : 0,
+           r.finished ? "" : " (still being written)");
+    if(at_end) {
+        position = r.moves;
+    }
+    if(replay_seek(&r, position, &p) != 0) {
+        fprintf(stderr, "cannot seek to %llu\n", (unsigned long long) position);
+        return 1;
+    }
+    export_text(&p, text);
+    text[NUM_STICKERS] = '\0';
+    printf("after %llu moves: orientation %d\n%s\n", (unsigned long long) position, p.orientation, text);
+    return 0;
+}
+
+// starts a session and writes random moves to it, keeping them in moves (when given)
+static void write_session(replay_writer *w, const puzzle *start, uint64_t length, uint32_t interval,
+                          replay_sink sink, void *sink_data, rng_state *rng, uint8_t *moves) {
+    replay_start(w, start, interval, sink, sink_data);
+    for(uint64_t i = 0; i < length; i++) {
+        int move = (int) rng_below(rng, NUM_MOVES);
+        if(moves != NULL) {
+            moves[i] = (uint8_t) move;
+        }
+        replay_write(w, move);
+    }
+}
+
+// seeks to every position of a session and compares with playing its moves; the positions that differ
+static int check_every_position(const replay_reader *r, const puzzle *start, const uint8_t *moves) {
+    puzzle p = *start, seeked;
+    int wrong = 0;
+
+    for(uint64_t i = 0; i <= r->moves; i++) {
+        wrong += replay_seek(r, i, &seeked) != 0 || !same_puzzle(&seeked, &p) ||
+                 (i < r->moves && replay_move_at(r, i) != moves[i]);
+        if(i < r->moves) {
+            apply_move(&p, moves[i]);
+        }
+    }
+    return wrong;
+}
+
+int main(int argc, char **argv) {
+    static replay_writer w;
+    const char *path = NULL, *out = "replay.bin";
+    int sessions = 500, length = 600, at_end = 1;
+    uint64_t seed = 1, long_moves = 2000000, position = 0;
+    uint32_t interval = 256;
+    rng_state rng;
+
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-f") == 0 && i + 1 < argc) path = argv[++i];
+        else if(strcmp(argv[i], "-p") == 0 && i + 1 < argc) position = strtoull(argv[++i], NULL, 0), at_end = 0;
+        else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc) sessions = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-l") == 0 && i + 1 < argc) length = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-m") == 0 && i + 1 < argc) long_moves = strtoull(argv[++i], NULL, 0);
+        else if(strcmp(argv[i], "-i") == 0 && i + 1 < argc) interval = (uint32_t) atoi(argv[++i]);
+        else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc) out = argv[++i];
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 0);
+        else {
+            fprintf(stderr, "usage: %s -f file [-p position]\n"
+                            "       %s [-n sessions] [-l length] [-m moves] [-i interval] [-o file] [-s seed]\n",
+                    argv[0], argv[0]);
+            return 1;
+        }
+    }
+    init_puzzle_tables();
+    if(path != NULL) {
+        return show_file(path, position, at_end);
+    }
+    if(sessions < 0 || length < 1 || interval < 4 || interval > REPLAY_MAX_INTERVAL || interval % 4 != 0) {
+        fprintf(stderr, "bad arguments\n");
+        return 1;
+    }
+
+    rng_seed(&rng, seed);
+    buffer b = {NULL, 0, 0};
+    uint8_t *moves = malloc((size_t) length);
+    uint64_t total_moves = 0, total_bytes = 0;
+    int wrong = 0;
+    for(int n = 0; n < sessions; n++) {
+        uint64_t session_length = 1 + rng_below(&rng, (uint32_t) length);
+        replay_reader r;
+        puzzle start;
+
+        reset_puzzle(&start);
+        start.orientation = (int) rng_below(&rng, (uint32_t) num_orientations);
+        b.size = 0;
+        write_session(&w, &start, session_length, interval, buffer_sink, &b, &rng, moves);
+        replay_finish(&w);
+        total_moves += session_length;
+        total_bytes += b.size;
+        if(replay_open(&r, b.bytes, b.size) != 0 || !r.finished || r.moves != session_length) {
+            wrong++;
+            continue;
+        }
+        wrong += check_every_position(&r, &start, moves);
+    }
+    if(sessions > 0) {
+        printf("%d sessions of 1 - %d moves: %.1f bytes each, %.3f bytes per move; %d positions wrong\n", sessions,
+               length, (double) total_bytes / sessions, (double) total_bytes / total_moves, wrong);
+    }
+
+    // the long session, with the states at a few random positions kept to check seeks against
+    enum { CHECKS = 4096 };
+    static uint64_t check_at[CHECKS];
+    static puzzle check_state[CHECKS];
+    FILE *file = fopen(out, "wb");
+    puzzle start;
+
+    if(file == NULL) {
+        fprintf(stderr, "cannot write %s\n", out);
+        return 1;
+    }
+    for(int c = 0; c < CHECKS; c++) {
+        check_at[c] = (uint64_t) ((double) rng_next(&rng) / 18446744073709551616.0 * (double) (long_moves + 1));
+    }
+    for(int c = 1; c < CHECKS; c++) {
+        for(int d = c; d > 0 && check_at[d - 1] > check_at[d]; d--) {
+            uint64_t at = check_at[d];
+            check_at[d] = check_at[d - 1];
+            check_at[d - 1] = at;
+        }
+    }
+    reset_puzzle(&start);
+    double begin = now();
+    replay_start(&w, &start, interval, file_sink, file);
+    int next_check = 0;
+    for(uint64_t i = 0; i <= long_moves; i++) {
+        while(next_check < CHECKS && check_at[next_check] == i) {
+            check_state[next_check++] = w.state;
+        }
+        if(i < long_moves) {
+            replay_write(&w, (int) rng_below(&rng, NUM_MOVES));
+        }
+    }
+    replay_finish(&w);
+    double writing = now() - begin;
+    fclose(file);
+
+    uint64_t size;
+    const uint8_t *data = map_file(out, &size);
+    replay_reader r;
+    if(data == NULL || replay_open(&r, data, size) != 0 || r.moves != long_moves) {
+        fprintf(stderr, "cannot read back %s\n", out);
+        return 1;
+    }
+    int wrong_seeks = 0;
+    begin = now();
+    for(int c = 0; c < CHECKS; c++) {
+        puzzle p;
+        wrong_seeks += replay_seek(&r, check_at[c], &p) != 0 || !same_puzzle(&p, &check_state[c]);
+    }
+    double seeking = now() - begin;
+    printf("%llu moves in %s: %llu bytes, %.3f bytes per move, written at %.1f M moves/s; %d seeks, %.2f us each, "
+           "%d wrong\n", (unsigned long long) long_moves, out, (unsigned long long) size, (double) size / long_moves,
+           long_moves / writing * 1e-6, CHECKS, seeking / CHECKS * 1e6, wrong_seeks);
+
+    // the same file as one still being written: no trailer, the last block not there yet
+    replay_reader partial;
+    uint64_t cut = size - REPLAY_TRAILER_BYTES - 1;
+    int partial_wrong = replay_open(&partial, data, cut) != 0 || partial.finished ||
+                        partial.moves != long_moves / interval * interval;
+    for(int c = 0; c < CHECKS && !partial_wrong; c++) {
+        puzzle p;
+        if(check_at[c] <= partial.moves) {
+            partial_wrong += replay_seek(&partial, check_at[c], &p) != 0 || !same_puzzle(&p, &check_state[c]);
+        }
+    }
+    printf("cut short by %llu bytes: %llu moves readable, %d wrong\n", (unsigned long long) (size - cut),
+           (unsigned long long) partial.moves, partial_wrong);
+    return wrong != 0 || wrong_seeks != 0 || partial_wrong != 0;
+}
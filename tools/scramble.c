@@ -0,0 +1,113 @@
+//
+// Prints seeded scrambles, one per line, as move ids (see puzzle.c), or
+// times how fast they are made.
+//
+// Build: cc -O2 -o scramble tools/scramble.c
+// Usage: ./scramble [-n count] [-l length] [-s seed] [-t] [-r] [-b]
+//      -t  twists only, no move-ins
+//      -r  uniformly random states instead of move sequences, printed as
+//          the orientation followed by the 216 sticker colors
+//      -n  scrambles to print (default 1) or to time with -b (default 1000000)
+//      -b  benchmark instead of printing
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../scramble.c"
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static void print_state(const puzzle *p) {
+    printf("%d ", p->orientation);
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        putchar('0' + p->stickers[i]);
+    }
+    putchar('\n');
+}
+
+int main(int argc, char **argv) {
+    long count = -1;
+    int length = 40;
+    uint64_t seed = 1;
+    int flags = SCRAMBLE_MOVE_INS;
+    int random_states = 0, bench = 0;
+    uint8_t *moves;
+    rng_state rng;
+    puzzle p;
+
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-n") == 0 && i + 1 < argc) count = atol(argv[++i]);
+        else if(strcmp(argv[i], "-l") == 0 && i + 1 < argc) length = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 0);
+        else if(strcmp(argv[i], "-t") == 0) flags = 0;
+        else if(strcmp(argv[i], "-r") == 0) random_states = 1;
+        else if(strcmp(argv[i], "-b") == 0) bench = 1;
+        else {
+            fprintf(stderr, "usage: %s [-n count] [-l length] [-s seed] [-t] [-r] [-b]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if(count < 0) {
+        count = bench ? 1000000 : 1;
+    }
+    if(length < 1) {
+        fprintf(stderr, "length must be at least 1\n");
+        return 1;
+    }
+    moves = malloc((size_t) length);
+    if(moves == NULL) {
+        return 1;
+    }
+    rng_seed(&rng, seed);
+    reset_puzzle(&p);
+    init_scramble_tables();
+    if(random_states && init_puzzle_chain() != 0) {
+        fprintf(stderr, "could not build the stabilizer chain\n");
+        return 1;
+    }
+
+    if(bench) {
+        uint64_t check = 0;
+        double start = now();
+
+        for(long n = 0; n < count; n++) {
+            if(random_states) {
+                random_puzzle(&p, &rng);
+                check += p.stickers[n % NUM_STICKERS];
+            }
+            else {
+                scramble_moves(&rng, moves, length, flags);
+                check += moves[n % length];
+            }
+        }
+        double seconds = now() - start;
+        printf("%ld %s in %.3f s: %.3f M/s (check %llx)\n", count, random_states ? "random states" : "scrambles",
+               seconds, count / seconds * 1e-6, (unsigned long long) check);
+        free(moves);
+        return 0;
+    }
+
+    for(long n = 0; n < count; n++) {
+        if(random_states) {
+            random_puzzle(&p, &rng);
+            print_state(&p);
+            continue;
+        }
+        scramble_moves(&rng, moves, length, flags);
+        for(int i = 0; i < length; i++) {
+            printf(i ? " %d" : "%d", moves[i]);
+        }
+        putchar('\n');
+    }
+
+    free(moves);
+    return 0;
+}
@@ -0,0 +1,67 @@
+//
+// Simplifies move logs: reads one log per line (move ids separated by
+// spaces, as scramble prints them) and prints each one simplified, with the
+// totals on stderr.
+//
+// Build: cc -O2 -o simplify tools/simplify.c
+// Usage: ./simplify < logs.txt
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../simplify.c"
+
+#define MAX_LOG (1 << 20)
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+int main(void) {
+    static uint8_t moves[MAX_LOG];
+    static uint8_t scratch[SIMPLIFY_SCRATCH_PER_MOVE * MAX_LOG];
+    long logs = 0, before = 0, after = 0;
+    double seconds = 0;
+    int c = getchar();
+
+    init_simplify_tables();
+    while(c != EOF) {
+        int length = 0, value = -1;
+
+        for(; c != EOF && c != '\n'; c = getchar()) {
+            if(c >= '0' && c <= '9') {
+                value = (value < 0 ? 0 : value * 10) + c - '0';
+                continue;
+            }
+            if(value >= 0 && value < NUM_MOVES && length < MAX_LOG) {
+                moves[length++] = (uint8_t) value;
+            }
+            value = -1;
+        }
+        if(value >= 0 && value < NUM_MOVES && length < MAX_LOG) {
+            moves[length++] = (uint8_t) value;
+        }
+        c = getchar();
+
+        double start = now();
+        int simplified = simplify_moves(moves, length, moves, scratch);
+        seconds += now() - start;
+
+        for(int i = 0; i < simplified; i++) {
+            printf(i ? " %d" : "%d", moves[i]);
+        }
+        printf("\n");
+        logs++;
+        before += length;
+        after += simplified;
+    }
+
+    fprintf(stderr, "%ld logs, %ld moves down to %ld (%.1f%%), %.1f M moves/s\n", logs, before, after,
+            before > 0 ? 100.0 * (double) after / (double) before : 100.0,
+            seconds > 0 ? (double) before / seconds * 1e-6 : 0.0);
+    return 0;
+}
@@ -0,0 +1,137 @@
+//
+// Optimal (fewest twists) solver: IDA* on several threads, with the pattern
+// databases given on the command line as heuristics.
+//
+// Build: cc -O2 -pthread -o solve tools/solve.c
+// Usage: ./solve [-l length] [-s seed] [-j threads] [-d split] [-m max] [-p table.pdb]... [-i]
+//      -l, -s  solve a scramble of length random moves made with seed
+//      -i      solve the state on stdin instead, as printed by scramble -r
+//      -p      pattern database to use (repeatable); without any only the
+//              misplaced piece count is used
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../ida_threads.c"
+#include "../scramble.c"
+
+static int read_state(puzzle *p) {
+    char stickers[NUM_STICKERS + 1];
+    int orientation;
+
+    if(scanf("%d %216s", &orientation, stickers) != 2 || orientation < 0 || orientation >= num_orientations ||
+       strlen(stickers) != NUM_STICKERS) {
+        return -1;
+    }
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        if(stickers[i] < '0' || stickers[i] >= '0' + SIDES) {
+            return -1;
+        }
+        p->stickers[i] = (uint8_t) (stickers[i] - '0');
+    }
+    p->orientation = orientation;
+    p->last_move_in_axis = NO_AXIS;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    static pattern_db tables[MAX_HEURISTICS];
+    heuristic heuristics[MAX_HEURISTICS];
+    int num_heuristics = 0;
+    int length = 4, threads = 1, split_depth = 2, max_depth = 12, from_stdin = 0;
+    uint64_t seed = 1;
+    uint8_t solution[IDA_MAX_DEPTH];
+    uint8_t moves[IDA_MAX_DEPTH * MAX_CELL_TWIST_MOVES];
+    cubie_state start;
+    ida_stats stats;
+    rng_state rng;
+    puzzle p;
+
+    reset_puzzle(&p);
+    init_ida_tables();
+
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-l") == 0 && i + 1 < argc) length = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 0);
+        else if(strcmp(argv[i], "-j") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-d") == 0 && i + 1 < argc) split_depth = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-m") == 0 && i + 1 < argc) max_depth = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-i") == 0) from_stdin = 1;
+        else if(strcmp(argv[i], "-p") == 0 && i + 1 < argc && num_heuristics < MAX_HEURISTICS - 1) {
+            if(pdb_load(&tables[num_heuristics], argv[++i]) != 0) {
+                fprintf(stderr, "%s: not a pattern database\n", argv[i]);
+                return 1;
+            }
+            heuristics[num_heuristics].estimate = pdb_estimate;
+            heuristics[num_heuristics].data = &tables[num_heuristics];
+            num_heuristics++;
+        }
+        else {
+            fprintf(stderr, "usage: %s [-l length] [-s seed] [-j threads] [-d split] [-m max] [-p table.pdb]... [-i]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    heuristics[num_heuristics].estimate = misplaced_estimate;
+    heuristics[num_heuristics].data = NULL;
+    num_heuristics++;
+
+    if(from_stdin) {
+        if(read_state(&p) != 0) {
+            fprintf(stderr, "expected an orientation and %d sticker colors\n", NUM_STICKERS);
+            return 1;
+        }
+    }
+    else {
+        uint8_t scramble_log[256];
+        if(length > 256) length = 256;
+        rng_seed(&rng, seed);
+        scramble_puzzle(&p, &rng, length, SCRAMBLE_MOVE_INS, scramble_log);
+        printf("scramble:");
+        for(int i = 0; i < length; i++) {
+            printf(" %d", scramble_log[i]);
+        }
+        printf("\n");
+    }
+    if(puzzle_to_cubies(&p, &start) != 0) {
+        fprintf(stderr, "not a valid state\n");
+        return 1;
+    }
+
+    int found = ida_solve_parallel(&start, heuristics, num_heuristics, max_depth, threads, split_depth, solution, &stats);
+
+    printf("\n bound        nodes     seconds    M nodes/s\n");
+    double seconds = 0;
+    for(int d = stats.first_bound; d <= stats.last_bound; d++) {
+        double t = stats.iteration_seconds[d];
+        seconds += t;
+        printf(" %5d %12llu %11.3f %12.2f\n", d, (unsigned long long) stats.iteration_nodes[d], t,
+               t > 0 ? (double) stats.iteration_nodes[d] / t * 1e-6 : 0.0);
+    }
+    printf("\n depth        nodes\n");
+    for(int d = 0; d <= stats.last_bound; d++) {
+        printf(" %5d %12llu\n", d, (unsigned long long) stats.nodes[d]);
+    }
+    printf("\n%llu nodes in %.3f s on %d threads: %.2f M nodes/s, %llu steals\n", (unsigned long long) stats.total,
+           seconds, threads, seconds > 0 ? (double) stats.total / seconds * 1e-6 : 0.0,
+           (unsigned long long) stats.steals);
+
+    if(found < 0) {
+        printf("no solution within %d twists\n", max_depth);
+        return 1;
+    }
+
+    int n = solution_to_moves(p.orientation, solution, found, moves);
+    for(int i = 0; i < n; i++) {
+        apply_move(&p, moves[i]);
+    }
+    puzzle_to_cubies(&p, &start);
+    printf("solution (%d twists, %s):", found, cubie_solved(&start) ? "checked" : "DOES NOT SOLVE");
+    for(int i = 0; i < n; i++) {
+        printf(" %d", moves[i]);
+    }
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,427 @@
+//
+// Solver benchmark: writes a fixed corpus of scrambles and runs solvers over
+// it, so search numbers can be compared from one commit to the next.
+//
+// A corpus file is BENCH_MAGIC, a version byte, the deepest depth and the
+// scrambles per depth, then for every depth from 1 up and every scramble a
+// length byte and that many cell twists (one byte each). The twists are
+// drawn from the canonical masks of moves.c, so none cancel right away, but
+// a scramble can still be solvable in fewer.
+//
+// Each solver is a name and a function; add one to `solvers` to have it
+// measured. Built in:
+//      brute   depth first search of every canonical sequence, deepening
+//              one twist at a time, no heuristic
+//      ida     IDA* (ida.c) with the tables given by -p and the misplaced
+//              piece count
+//      reduce  the stabilizer chain solver (reduce.c), not optimal
+//
+// Every solution is replayed on its scramble. Results go to stdout as one
+// JSON object per line: one per solver and scramble ("solve"), then one per
+// solver and depth ("summary") and one per solver ("total"), with nodes,
+// nodes/s, solution lengths and the spread of solve times. A readable table
+// goes to stderr.
+//
+// Build: cc -O2 -o solve_bench tools/solve_bench.c
+// Usage: ./solve_bench -w corpus [-n depth] [-k count] [-s seed]
+//        ./solve_bench -r corpus [-a solver,...] [-x depth] [-p table.pdb]... [-i reduce.tables]
+//      -w  write a corpus: count scrambles (default 10) at each depth from 1
+//          to depth (default 6)
+//      -r  run the solvers named by -a (default brute,ida) over a corpus
+//      -x  skip scrambles deeper than this for the optimal solvers (default 3)
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../ida.c"
+#include "../reduce.c"
+#include "../scramble.c"
+
+#define BENCH_MAGIC "R4DBNCH"
+#define BENCH_VERSION 1
+#define MAX_BENCH_DEPTH 64
+#define MAX_BENCH_SCRAMBLES 65536
+#define MAX_BENCH_SOLUTION (MAX_PHASE_WORD * MAX_CHAIN_LEVELS)
+
+typedef int (*bench_solve_fn)(const void *data, const cubie_state *start, int max_depth, uint8_t *solution,
+                              int capacity, uint64_t *nodes);
+
+typedef struct {
+    const char *name;
+    bench_solve_fn solve;
+    const void *data;
+    int optimal;            // finds shortest solutions, so is only run up to -x
+} bench_solver;
+
+typedef struct {
+    int depth;
+    int length;
+    uint8_t twists[MAX_BENCH_DEPTH];
+} bench_scramble;
+
+typedef struct {
+    int count;
+    int solved;
+    uint64_t nodes;
+    double seconds;
+    long length;
+    double times[MAX_BENCH_SCRAMBLES];
+} bench_totals;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+// depth first below state, for a solution of exactly `left` more twists
+static int brute_search(const cubie_state *state, int depth, int left, int last, uint8_t *path, uint64_t *nodes) {
+    const twist_mask *allowed = next_twists(last);
+    cubie_state next;
+
+    (*nodes)++;
+    if(left == 0) {
+        return cubie_solved(state);
+    }
+    for(int m = 0; m < NUM_CELL_TWISTS; m++) {
+        if(!twist_in_mask(allowed, m)) {
+            continue;
+        }
+        next = *state;
+        cubie_twist(&next, m);
+        path[depth] = (uint8_t) m;
+        if(brute_search(&next, depth + 1, left - 1, m, path, nodes)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int brute_solve(const void *data, const cubie_state *start, int max_depth, uint8_t *solution, int capacity,
+                       uint64_t *nodes) {
+    (void) data;
+    for(int length = 0; length <= max_depth && length <= capacity; length++) {
+        if(brute_search(start, 0, length, START_OF_SEQUENCE, solution, nodes)) {
+            return length;
+        }
+    }
+    return -1;
+}
+
+static int ida_bench_solve(const void *data, const cubie_state *start, int max_depth, uint8_t *solution,
+                           int capacity, uint64_t *nodes) {
+    const heuristic *heuristics = data;
+    ida_search search;
+    int num_heuristics = 0;
+
+    while(heuristics[num_heuristics].estimate != NULL) {
+        num_heuristics++;
+    }
+    init_ida_search(&search, heuristics, num_heuristics);
+    int length = ida_solve(&search, start, max_depth < capacity ? max_depth : capacity, solution);
+    *nodes = search.stats.total;
+    return length;
+}
+
+static int reduce_bench_solve(const void *data, const cubie_state *start, int max_depth, uint8_t *solution,
+                              int capacity, uint64_t *nodes) {
+    (void) data;
+    (void) max_depth;
+    *nodes = 0;
+    return reduction_solve(start, solution, capacity);
+}
+
+static int write_corpus(const char *path, int max_depth, int per_depth, uint64_t seed) {
+    FILE *f = fopen(path, "wb");
+    uint8_t header[sizeof(BENCH_MAGIC) + 3];
+    uint8_t twists[MAX_BENCH_DEPTH];
+    rng_state rng;
+
+    if(f == NULL) {
+        fprintf(stderr, "cannot write %s\n", path);
+        return 1;
+    }
+    memcpy(header, BENCH_MAGIC, sizeof(BENCH_MAGIC));
+    header[sizeof(BENCH_MAGIC)] = BENCH_VERSION;
+    header[sizeof(BENCH_MAGIC) + 1] = (uint8_t) max_depth;
+    header[sizeof(BENCH_MAGIC) + 2] = (uint8_t) per_depth;
+    fwrite(header, 1, sizeof(header), f);
+
+    init_move_tables();
+    rng_seed(&rng, seed);
+    for(int depth = 1; depth <= max_depth; depth++) {
+        for(int n = 0; n < per_depth; n++) {
+            int last = START_OF_SEQUENCE;
+            for(int i = 0; i < depth; i++) {
+                const twist_mask *allowed = next_twists(last);
+                int m;
+                do {
+                    m = (int) rng_below(&rng, NUM_CELL_TWISTS);
+                } while(!twist_in_mask(allowed, m));
+                twists[i] = (uint8_t) m;
+                last = m;
+            }
+            fputc(depth, f);
+            fwrite(twists, 1, (size_t) depth, f);
+        }
+    }
+
+    if(fclose(f) != 0) {
+        fprintf(stderr, "cannot write %s\n", path);
+        return 1;
+    }
+    printf("wrote %d scrambles (depths 1 - %d) to %s\n", max_depth * per_depth, max_depth, path);
+    return 0;
+}
+
+// reads a corpus, returning the number of scrambles or -1
+static int read_corpus(const char *path, bench_scramble *scrambles) {
+    FILE *f = fopen(path, "rb");
+    uint8_t header[sizeof(BENCH_MAGIC) + 3];
+    int count = 0, length;
+
+    if(f == NULL) {
+        return -1;
+    }
+    if(fread(header, 1, sizeof(header), f) != sizeof(header) || memcmp(header, BENCH_MAGIC, sizeof(BENCH_MAGIC)) != 0 ||
+       header[sizeof(BENCH_MAGIC)] != BENCH_VERSION) {
+        fclose(f);
+        return -1;
+    }
+    while((length = fgetc(f)) != EOF) {
+        bench_scramble *s = &scrambles[count];
+        if(count == MAX_BENCH_SCRAMBLES || length > MAX_BENCH_DEPTH ||
+           fread(s->twists, 1, (size_t) length, f) != (size_t) length) {
+            fclose(f);
+            return -1;
+        }
+        s->depth = s->length = length;
+        for(int i = 0; i < length; i++) {
+            if(s->twists[i] >= NUM_CELL_TWISTS) {
+                fclose(f);
+                return -1;
+            }
+        }
+        count++;
+    }
+    fclose(f);
+    return count;
+}
+
+static int compare_times(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+// time below which a fraction q of the solves took
+static double percentile(const bench_totals *t, double q) {
+    int i = (int) (q * (double) (t->count - 1) + 0.5);
+    return t->count > 0 ? t->times[i] : 0.0;
+}
+
+static void add_solve(bench_totals *t, int solved, int length, uint64_t nodes, double seconds) {
+    t->times[t->count++] = seconds;
+    t->solved += solved;
+    t->length += solved ? length : 0;
+    t->nodes += nodes;
+    t->seconds += seconds;
+}
+
+static void print_summary(const char *solver, int depth, bench_totals *t) {
+    char label[16];
+
+    qsort(t->times, (size_t) t->count, sizeof(double), compare_times);
+    if(depth > 0) {
+        printf("{\"type\":\"summary\",\"solver\":\"%s\",\"depth\":%d,", solver, depth);
+    }
+    else {
+        printf("{\"type\":\"total\",\"solver\":\"%s\",", solver);
+    }
+    printf("\"count\":%d,\"solved\":%d,\"nodes\":%llu,"
+           "\"seconds\":%.6f,\"nodes_per_second\":%.0f,\"mean_length\":%.3f,\"p50\":%.6f,\"p90\":%.6f,"
+           "\"p99\":%.6f,\"max\":%.6f}\n",
+           t->count, t->solved, (unsigned long long) t->nodes, t->seconds,
+           t->seconds > 0 ? (double) t->nodes / t->seconds : 0.0,
+           t->solved > 0 ? (double) t->length / t->solved : 0.0, percentile(t, 0.5), percentile(t, 0.9),
+           percentile(t, 0.99), t->count > 0 ? t->times[t->count - 1] : 0.0);
+    snprintf(label, sizeof(label), depth > 0 ? "%d" : "all", depth);
+    fprintf(stderr, "%-8s %5s %6d %7d %14llu %10.3f %10.2f %8.2f %10.3f %10.3f\n", solver, label, t->count, t->solved,
+            (unsigned long long) t->nodes, t->seconds, t->seconds > 0 ? (double) t->nodes / t->seconds * 1e-6 : 0.0,
+            t->solved > 0 ? (double) t->length / t->solved : 0.0, percentile(t, 0.5) * 1e3,
+            t->count > 0 ? t->times[t->count - 1] * 1e3 : 0.0);
+}
+
+static int run_solver(const bench_solver *solver, const bench_scramble *scrambles, int count, int max_depth) {
+    static bench_totals by_depth, all;
+    static uint8_t solution[MAX_BENCH_SOLUTION];
+    cubie_state start, state;
+    int wrong = 0;
+
+    all.count = all.solved = 0;
+    all.nodes = 0;
+    all.seconds = 0;
+    all.length = 0;
+    for(int first = 0; first < count;) {
+        int depth = scrambles[first].depth, last = first;
+
+        by_depth.count = by_depth.solved = 0;
+        by_depth.nodes = 0;
+        by_depth.seconds = 0;
+        by_depth.length = 0;
+        for(; last < count && scrambles[last].depth == depth; last++) {
+            const bench_scramble *s = &scrambles[last];
+            uint64_t nodes = 0;
+
+            if(solver->optimal && depth > max_depth) {
+                continue;
+            }
+            cubie_reset(&start);
+            for(int i = 0; i < s->length; i++) {
+                cubie_twist(&start, s->twists[i]);
+            }
+
+            double begin = now();
+            int length = solver->solve(solver->data, &start, depth, solution, MAX_BENCH_SOLUTION, &nodes);
+            double seconds = now() - begin;
+
+            int solved = 0;
+            if(length >= 0) {
+                state = start;
+                for(int i = 0; i < length; i++) {
+                    cubie_twist(&state, solution[i]);
+                }
+                solved = cubie_solved(&state);
+                wrong += !solved;
+            }
+            add_solve(&by_depth, solved, length, nodes, seconds);
+            add_solve(&all, solved, length, nodes, seconds);
+            printf("{\"type\":\"solve\",\"solver\":\"%s\",\"index\":%d,\"depth\":%d,\"solved\":%d,\"length\":%d,"
+                   "\"nodes\":%llu,\"seconds\":%.6f}\n",
+                   solver->name, last, depth, solved, solved ? length : -1, (unsigned long long) nodes, seconds);
+        }
+        if(by_depth.count > 0) {
+            print_summary(solver->name, depth, &by_depth);
+        }
+        first = last;
+    }
+    print_summary(solver->name, 0, &all);
+    return wrong;
+}
+
+static int usage(const char *name) {
+    fprintf(stderr, "usage: %s -w corpus [-n depth] [-k count] [-s seed]\n"
+                    "       %s -r corpus [-a solver,...] [-x depth] [-p table.pdb]... [-i reduce.tables]\n",
+            name, name);
+    return 1;
+}
+
+static int attach_reduction(const char *path) {
+    FILE *f = fopen(path, "rb");
+    uint8_t *image;
+    long size;
+    int result = -1;
+
+    if(f == NULL) {
+        return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    image = malloc(size > 0 ? (size_t) size : 1);
+    if(image != NULL && fread(image, 1, (size_t) size, f) == (size_t) size) {
+        // the tables point into the image, so it stays
+        result = reduction_attach(image, (size_t) size);
+    }
+    fclose(f);
+    return result;
+}
+
+int main(int argc, char **argv) {
+    static pattern_db tables[MAX_HEURISTICS];
+    static bench_scramble scrambles[MAX_BENCH_SCRAMBLES];
+    heuristic heuristics[MAX_HEURISTICS + 1];
+    const char *out = NULL, *in = NULL, *names = "brute,ida", *reduce_tables = NULL;
+    int max_depth = 6, per_depth = 10, optimal_depth = 3, num_heuristics = 0, wrong = 0;
+    uint64_t seed = 1;
+
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-w") == 0 && i + 1 < argc) out = argv[++i];
+        else if(strcmp(argv[i], "-r") == 0 && i + 1 < argc) in = argv[++i];
+        else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc) max_depth = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-k") == 0 && i + 1 < argc) per_depth = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 0);
+        else if(strcmp(argv[i], "-a") == 0 && i + 1 < argc) names = argv[++i];
+        else if(strcmp(argv[i], "-x") == 0 && i + 1 < argc) optimal_depth = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-i") == 0 && i + 1 < argc) reduce_tables = argv[++i];
+        else if(strcmp(argv[i], "-p") == 0 && i + 1 < argc && num_heuristics < MAX_HEURISTICS - 1) {
+            if(pdb_load(&tables[num_heuristics], argv[++i]) != 0) {
+                fprintf(stderr, "%s: not a pattern database\n", argv[i]);
+                return 1;
+            }
+            heuristics[num_heuristics].estimate = pdb_estimate;
+            heuristics[num_heuristics].data = &tables[num_heuristics];
+            num_heuristics++;
+        }
+        else return usage(argv[0]);
+    }
+
+    if(out != NULL) {
+        if(max_depth < 1 || max_depth > MAX_BENCH_DEPTH || per_depth < 1 || per_depth > 255 ||
+           max_depth * per_depth > MAX_BENCH_SCRAMBLES) {
+            return usage(argv[0]);
+        }
+        return write_corpus(out, max_depth, per_depth, seed);
+    }
+    if(in == NULL) {
+        return usage(argv[0]);
+    }
+
+    int count = read_corpus(in, scrambles);
+    if(count < 0) {
+        fprintf(stderr, "%s: not a benchmark corpus\n", in);
+        return 1;
+    }
+    heuristics[num_heuristics].estimate = misplaced_estimate;
+    heuristics[num_heuristics].data = NULL;
+    heuristics[num_heuristics + 1].estimate = NULL;
+
+    const bench_solver solvers[] = {
+        {"brute", brute_solve, NULL, 1},
+        {"ida", ida_bench_solve, heuristics, 1},
+        {"reduce", reduce_bench_solve, NULL, 0},
+    };
+    const int num_solvers = (int) (sizeof(solvers) / sizeof(solvers[0]));
+
+    init_ida_tables();
+    fprintf(stderr, "%-8s %5s %6s %7s %14s %10s %10s %8s %10s %10s\n", "solver", "depth", "count", "solved", "nodes",
+            "seconds", "M nodes/s", "length", "p50 ms", "max ms");
+    for(const char *name = names; *name != '\0';) {
+        size_t span = strcspn(name, ",");
+        int s;
+
+        for(s = 0; s < num_solvers && (strlen(solvers[s].name) != span || strncmp(solvers[s].name, name, span) != 0);
+            s++);
+        if(s == num_solvers) {
+            fprintf(stderr, "no solver %.*s\n", (int) span, name);
+            return 1;
+        }
+        if(solvers[s].solve == reduce_bench_solve) {
+            double start = now();
+            if(reduce_tables != NULL ? attach_reduction(reduce_tables) != 0 : init_reduction_tables() != 0) {
+                fprintf(stderr, "no reduction tables\n");
+                return 1;
+            }
+            fprintf(stderr, "reduction tables ready in %.2f s\n", now() - start);
+        }
+        wrong += run_solver(&solvers[s], scrambles, count, optimal_depth);
+        name += span + (name[span] == ',');
+    }
+
+    if(wrong > 0) {
+        fprintf(stderr, "%d solutions did not solve their scramble\n", wrong);
+    }
+    return wrong != 0;
+}
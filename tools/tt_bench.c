@@ -0,0 +1,193 @@
+//
+// Checks the incremental sticker hash of zobrist.c against hashing from
+// scratch and times both, then has several threads hammer one transposition table
+// (ttable.c) at once and counts probes per second and entries read back
+// wrong.
+//
+// Build: cc -O2 -pthread -o tt_bench tools/tt_bench.c
+// Usage: ./tt_bench [-m megabytes] [-j threads] [-n operations] [-p percent] [-s seed]
+//      -m  table size (default 64)
+//      -j  most threads to run, timed at 1, 2, 4, ... up to it (default 4)
+//      -n  operations per thread (default 10000000)
+//      -p  percent of operations that are probes, the rest stores (default 80)
+//
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../zobrist.c"
+#include "../ttable.c"
+#include "../scramble.c"
+
+#define MAX_THREADS 64
+#define HASH_MOVES 1000000
+
+typedef struct {
+    trans_table *tt;
+    uint64_t seed;
+    uint64_t keys;          // distinct states the threads share
+    long operations;
+    int probe_percent;
+    uint64_t hits;
+    uint64_t probes;
+    uint64_t wrong;
+} bench_thread;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+// the state behind key k, and what is always stored for it
+static uint64_t key_hash(uint64_t k) {
+    return splitmix64(&k);
+}
+
+static void *hammer(void *arg) {
+    bench_thread *t = arg;
+    rng_state rng;
+    tt_result result;
+
+    rng_seed(&rng, t->seed);
+    for(long n = 0; n < t->operations; n++) {
+        uint64_t hash = key_hash(rng_next(&rng) % t->keys);
+        int value = (int) (hash >> 48) - 32768, depth = (int) (hash >> 8) & 0xFF, move = (int) (hash >> 16) & 0xFF;
+
+        if((int) (rng_next(&rng) % 100) < t->probe_percent) {
+            t->probes++;
+            if(tt_probe(t->tt, hash, &result)) {
+                t->hits++;
+                t->wrong += result.value != value || result.depth != depth || result.move != move ||
+                            result.bound != TT_EXACT;
+            }
+        }
+        else {
+            tt_store(t->tt, hash, value, depth, move, TT_EXACT);
+        }
+    }
+    return NULL;
+}
+
+static int check_hashes(uint64_t seed) {
+    static uint8_t moves[HASH_MOVES];
+    static uint8_t twists[HASH_MOVES];
+    rng_state rng;
+    puzzle p;
+    cubie_state state;
+    uint64_t hash, sum = 0;
+    int wrong = 0;
+
+    rng_seed(&rng, seed);
+    scramble_moves(&rng, moves, HASH_MOVES, SCRAMBLE_MOVE_INS);
+    for(int n = 0; n < HASH_MOVES; n++) {
+        twists[n] = (uint8_t) rng_below(&rng, NUM_CELL_TWISTS);
+    }
+
+    reset_puzzle(&p);
+    hash = puzzle_hash(&p);
+    for(int n = 0; n < 10000; n++) {
+        apply_move_hashed(&p, &hash, moves[n]);
+        wrong += hash != puzzle_hash(&p);
+    }
+    printf("incremental hashes: %d wrong\n", wrong);
+
+    double start = now();
+    for(int n = 0; n < HASH_MOVES; n++) {
+        apply_move_hashed(&p, &hash, moves[n]);
+    }
+    double incremental = now() - start;
+    start = now();
+    for(int n = 0; n < HASH_MOVES; n++) {
+        apply_move(&p, moves[n]);
+        sum += puzzle_hash(&p);
+    }
+    double scratch = now() - start;
+    printf("stickers: %7.2f M moves/s hashed as they go, %7.2f M/s moved then hashed\n",
+           HASH_MOVES / incremental * 1e-6, HASH_MOVES / scratch * 1e-6);
+
+    cubie_reset(&state);
+    start = now();
+    for(int n = 0; n < HASH_MOVES; n++) {
+        cubie_twist(&state, twists[n]);
+        sum += cubie_hash(&state);
+    }
+    printf("pieces:   %7.2f M twists/s twisted and hashed (%llx)\n", HASH_MOVES / (now() - start) * 1e-6,
+           (unsigned long long) (sum & 0xF));
+    return wrong;
+}
+
+int main(int argc, char **argv) {
+    static bench_thread threads[MAX_THREADS];
+    pthread_t workers[MAX_THREADS];
+    trans_table tt;
+    long megabytes = 64, operations = 10000000;
+    int max_threads = 4, probe_percent = 80, wrong;
+    uint64_t seed = 1;
+
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-m") == 0 && i + 1 < argc) megabytes = atol(argv[++i]);
+        else if(strcmp(argv[i], "-j") == 0 && i + 1 < argc) max_threads = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc) operations = atol(argv[++i]);
+        else if(strcmp(argv[i], "-p") == 0 && i + 1 < argc) probe_percent = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 0);
+        else {
+            fprintf(stderr, "usage: %s [-m megabytes] [-j threads] [-n operations] [-p percent] [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+    if(megabytes < 1 || max_threads < 1 || max_threads > MAX_THREADS || operations < 1) {
+        fprintf(stderr, "bad arguments\n");
+        return 1;
+    }
+
+    wrong = check_hashes(seed);
+
+    uint64_t bytes = (uint64_t) megabytes << 20;
+    void *memory = aligned_alloc(64, (size_t) bytes);
+    if(memory == NULL || tt_init(&tt, memory, bytes) != 0) {
+        fprintf(stderr, "cannot allocate the table\n");
+        return 1;
+    }
+    uint64_t entries = tt.buckets * TT_BUCKET;
+    printf("table: %llu entries in %ld MB, %d%% probes, twice as many states as entries\n",
+           (unsigned long long) entries, megabytes, probe_percent);
+
+    for(int count = 1;; count *= 2) {
+        uint64_t probes = 0, hits = 0, bad = 0;
+
+        if(count > max_threads) {
+            count = max_threads;
+        }
+        for(int t = 0; t < count; t++) {
+            threads[t] = (bench_thread) {&tt, seed + (uint64_t) t + 1, 2 * entries, operations, probe_percent, 0, 0, 0};
+        }
+        double start = now();
+        for(int t = 0; t < count; t++) {
+            pthread_create(&workers[t], NULL, hammer, &threads[t]);
+        }
+        for(int t = 0; t < count; t++) {
+            pthread_join(workers[t], NULL);
+        }
+        double seconds = now() - start;
+
+        for(int t = 0; t < count; t++) {
+            probes += threads[t].probes;
+            hits += threads[t].hits;
+            bad += threads[t].wrong;
+        }
+        printf("%2d threads: %8.2f M operations/s, %8.2f M probes/s, %5.1f%% hits, %llu read back wrong\n", count,
+               (double) operations * count / seconds * 1e-6, (double) probes / seconds * 1e-6,
+               probes > 0 ? 100.0 * (double) hits / (double) probes : 0.0, (unsigned long long) bad);
+        wrong += (int) bad;
+        if(count == max_threads) {
+            break;
+        }
+    }
+
+    free(memory);
+    return wrong != 0;
+}
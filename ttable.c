@@ -0,0 +1,155 @@
+//
+// Transposition table: a fixed size table of search results keyed by a 64
+// bit hash (zobrist.c) that any number of threads can share without locks.
+//
+// An entry is two words, the packed data and the hash XOR the data. Both are
+// written with plain stores, and a read only counts when the two XOR back to
+// the hash asked for, so an entry torn by two threads writing at once reads
+// as a miss, never as another state's data (Hyatt and Mann's lockless
+// hashing). Aligned 64 bit loads and stores are single accesses on every
+// target this builds for, and wasm has one thread anyway.
+//
+// Entries sit in buckets of TT_BUCKET, one cache line. A store takes the
+// entry that already holds its hash, else the one least worth keeping:
+// entries from earlier searches (tt_new_search) first, then the shallowest.
+//
+
+#ifndef TTABLE_C
+#define TTABLE_C
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TT_BUCKET 4
+
+// what a stored value is: exact, or only a bound on the real one
+#define TT_EXACT 0
+#define TT_LOWER 1
+#define TT_UPPER 2
+
+// data word: value (16 bits, signed), depth, move, bound, generation, used
+#define TT_USED ((uint64_t) 1 << 48)
+
+typedef struct {
+    uint64_t check;     // hash ^ data
+    uint64_t data;
+} tt_entry;
+
+typedef struct {
+    volatile tt_entry *entries;
+    uint64_t buckets;   // a power of two
+    int generation;
+} trans_table;
+
+typedef struct {
+    int value;
+    int depth;
+    int move;
+    int bound;
+} tt_result;
+
+/*
+ *  Function:    tt_init
+ *  ----------------
+ *  Sets up a table in `bytes` of caller memory (aligned to 64 bytes for one
+ *      bucket per cache line), using the largest power of two of buckets that
+ *      fits, and clears it.
+ *
+ *  Return:
+ *      0, or -1 if not even one bucket fits
+ */
+int tt_init(trans_table *tt, void *memory, uint64_t bytes) {
+    uint64_t buckets = 1;
+
+    if(bytes < sizeof(tt_entry) * TT_BUCKET) {
+        return -1;
+    }
+    while(buckets * 2 <= bytes / (sizeof(tt_entry) * TT_BUCKET)) {
+        buckets *= 2;
+    }
+    tt->entries = (volatile tt_entry *) memory;
+    tt->buckets = buckets;
+    tt->generation = 0;
+    for(uint64_t i = 0; i < buckets * TT_BUCKET; i++) {
+        tt->entries[i].check = 0;
+        tt->entries[i].data = 0;
+    }
+    return 0;
+}
+
+// starts a new search: what earlier ones stored stays readable, but goes first
+void tt_new_search(trans_table *tt) {
+    tt->generation = (tt->generation + 1) & 0xFF;
+}
+
+static uint64_t tt_pack(int value, int depth, int move, int bound, int generation) {
+    return (uint64_t) (uint16_t) value | (uint64_t) (depth & 0xFF) << 16 | (uint64_t) (move & 0xFF) << 24 |
+           (uint64_t) (bound & 0xFF) << 32 | (uint64_t) generation << 40 | TT_USED;
+}
+
+/*
+ *  Function:    tt_probe
+ *  -----------------
+ *  Looks a hash up.
+ *
+ *  Return:
+ *      1 with the entry in out, or 0 if the table does not hold the hash
+ */
+int tt_probe(const trans_table *tt, uint64_t hash, tt_result *out) {
+    volatile const tt_entry *bucket = tt->entries + (hash & (tt->buckets - 1)) * TT_BUCKET;
+
+    for(int i = 0; i < TT_BUCKET; i++) {
+        uint64_t data = bucket[i].data;
+        uint64_t check = bucket[i].check;
+
+        if((check ^ data) != hash || !(data & TT_USED)) {
+            continue;
+        }
+        out->value = (int16_t) (uint16_t) data;
+        out->depth = (int) (data >> 16) & 0xFF;
+        out->move = (int) (data >> 24) & 0xFF;
+        out->bound = (int) (data >> 32) & 0xFF;
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ *  Function:    tt_store
+ *  -----------------
+ *  Stores what a search found about a state.
+ *
+ *  Input params:
+ *      trans_table *tt:
+ *      uint64_t hash:      the state's hash
+ *      int value:          -32768 - 32767
+ *      int depth:          how deep the search below it went, 0 - 255
+ *      int move:           best move found, 0 - 255
+ *      int bound:          TT_EXACT, TT_LOWER or TT_UPPER
+ */
+void tt_store(trans_table *tt, uint64_t hash, int value, int depth, int move, int bound) {
+    volatile tt_entry *bucket = tt->entries + (hash & (tt->buckets - 1)) * TT_BUCKET;
+    int victim = 0, worst = 0x7FFFFFFF;
+
+    for(int i = 0; i < TT_BUCKET; i++) {
+        uint64_t data = bucket[i].data;
+        int keep;
+
+        if((bucket[i].check ^ data) == hash) {
+            victim = i;
+            break;
+        }
+        // empty slots are worth nothing, old ones less than any of this search
+        keep = !(data & TT_USED) ? -1 : (int) ((data >> 16) & 0xFF) + ((int) (data >> 40 & 0xFF) == tt->generation ? 256 : 0);
+        if(keep < worst) {
+            worst = keep;
+            victim = i;
+        }
+    }
+
+    uint64_t data = tt_pack(value, depth, move, bound, tt->generation);
+    bucket[victim].check = hash ^ data;
+    bucket[victim].data = data;
+}
+
+#endif // TTABLE_C
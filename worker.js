@@ -0,0 +1,60 @@
+// Solves for the page off the main thread, in a copy of out.wasm of its own.
+// The page posts {type: 'solve', stickers, orientation, maxDepth} and
+// {type: 'cancel'}; the worker steps the search a slice at a time, yielding
+// between slices so a cancel or a newer solve gets in, and posts 'progress'
+// after every slice and 'done' (with the move ids) or 'stopped' at the end:
+// status 'failed' when there is no solution within maxDepth, 'cancelled'
+// when a cancel or a newer solve ended it.
+
+const JOB_RUNNING = 1;
+const JOB_DONE = 2;
+const JOB_FAILED = 3;
+const SLICE = 20000;
+
+let instance = null;
+let current = 0;
+
+async function load() {
+    if(instance === null) {
+        const response = await fetch('out.wasm');
+        const bytes = await response.arrayBuffer();
+        instance = (await WebAssembly.instantiate(bytes)).instance;
+    }
+    return instance.exports;
+}
+
+async function solve(id, message) {
+    const wasm = await load();
+    if(id !== current) {
+        postMessage({type: 'stopped', status: 'cancelled'});
+        return;
+    }
+
+    new Uint8Array(wasm.memory.buffer, wasm.analysis_input(), message.stickers.length).set(message.stickers);
+    let status = wasm.analysis_start(message.orientation, message.maxDepth);
+    while(status === JOB_RUNNING) {
+        status = wasm.analysis_step(SLICE);
+        postMessage({type: 'progress', bound: wasm.analysis_bound(), nodes: wasm.analysis_nodes()});
+        await new Promise(resolve => setTimeout(resolve));
+        if(id !== current) {
+            postMessage({type: 'stopped', status: 'cancelled'});
+            return;
+        }
+    }
+
+    if(status === JOB_DONE) {
+        const length = wasm.analysis_length();
+        const moves = Array.from(new Uint8Array(wasm.memory.buffer, wasm.analysis_result(), length));
+        postMessage({type: 'done', moves: moves, nodes: wasm.analysis_nodes()});
+    } else {
+        postMessage({type: 'stopped', status: status === JOB_FAILED ? 'failed' : 'cancelled'});
+    }
+}
+
+onmessage = (event) => {
+    // a newer message ends whatever solve is in progress
+    current += 1;
+    if(event.data.type === 'solve') {
+        solve(current, event.data);
+    }
+};
@@ -0,0 +1,134 @@
+//
+// Zobrist hashing: a fixed random 64 bit key for every (place, content)
+// pair, and a state's hash is the XOR of the keys of what it holds. A move
+// only changes what it moves, so the hash follows it with two XORs per moved
+// item instead of a pass over the whole state.
+//
+//      stickers (puzzle.c):    key of (physical sticker, color), and of the
+//                              orientation. A twist moves 76 or 78 of the
+//                              216 stickers, a move-in none.
+//      pieces (cubie.c):       key of (piece, position) and of (piece,
+//                              twist). cubie_twist already passes over all
+//                              72 pieces, and hashing them again costs less
+//                              than the twist, so these are only hashed from
+//                              scratch.
+//
+// The keys come from a fixed seed, so hashes agree between runs and builds.
+//
+
+#ifndef ZOBRIST_C
+#define ZOBRIST_C
+
+#include "coord.c"
+#include "rng.c"
+
+#define ZOBRIST_SEED 0x2B0B815ull
+
+static uint64_t zobrist_sticker[NUM_STICKERS][SIDES];
+static uint64_t zobrist_orientation[NUM_ORIENTATIONS];
+static uint64_t zobrist_pos[NUM_PIECES][NUM_PIECES];
+static uint64_t zobrist_ori[NUM_PIECES][MAX_PIECE_TWISTS];
+// the view indices each select moves, so a twist only touches those
+static uint8_t twist_moved[CUBES][NUM_STICKERS];
+static uint8_t twist_moved_count[CUBES];
+static int zobrist_tables_ready;
+
+void init_zobrist_tables(void) {
+    rng_state rng;
+
+    if(zobrist_tables_ready) {
+        return;
+    }
+    init_coord_tables();
+
+    rng_seed(&rng, ZOBRIST_SEED);
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        for(int color = 0; color < SIDES; color++) {
+            zobrist_sticker[i][color] = rng_next(&rng);
+        }
+    }
+    for(int o = 0; o < NUM_ORIENTATIONS; o++) {
+        zobrist_orientation[o] = rng_next(&rng);
+    }
+    for(int piece = 0; piece < NUM_PIECES; piece++) {
+        for(int at = 0; at < NUM_PIECES; at++) {
+            zobrist_pos[piece][at] = rng_next(&rng);
+        }
+        for(int twist = 0; twist < MAX_PIECE_TWISTS; twist++) {
+            zobrist_ori[piece][twist] = rng_next(&rng);
+        }
+    }
+
+    for(int select = 0; select < CUBES; select++) {
+        int n = 0;
+        for(int i = 0; i < NUM_STICKERS; i++) {
+            if(twist_table[select][i] != i) {
+                twist_moved[select][n++] = (uint8_t) i;
+            }
+        }
+        twist_moved_count[select] = (uint8_t) n;
+    }
+
+    zobrist_tables_ready = 1;
+}
+
+// hash of a puzzle from scratch: its stickers and orientation (not how the hidden cube is drawn)
+uint64_t puzzle_hash(const puzzle *p) {
+    uint64_t hash;
+
+    init_zobrist_tables();
+    hash = zobrist_orientation[p->orientation];
+    for(int i = 0; i < NUM_STICKERS; i++) {
+        hash ^= zobrist_sticker[i][p->stickers[i]];
+    }
+    return hash;
+}
+
+/*
+ *  Function:    apply_move_hashed
+ *  --------------------------
+ *  apply_move, keeping `hash` (puzzle_hash of p) up to date. Only the
+ *      stickers the twist moves are read or written.
+ *
+ *  Runtime Complexity: O(stickers moved)
+ */
+void apply_move_hashed(puzzle *p, uint64_t *hash, int move) {
+    uint64_t h = *hash;
+
+    init_zobrist_tables();
+    if(is_move_in(move)) {
+        int before = p->orientation;
+        move_in(p, move - FIRST_MOVE_IN + 1);
+        h ^= zobrist_orientation[before] ^ zobrist_orientation[p->orientation];
+    }
+    else {
+        const uint8_t *remap = orient_remap[p->orientation];
+        const uint8_t *perm = twist_table[move];
+        const uint8_t *moved = twist_moved[move];
+        int count = twist_moved_count[move];
+        uint8_t colors[NUM_STICKERS];
+
+        for(int n = 0; n < count; n++) {
+            colors[n] = p->stickers[remap[perm[moved[n]]]];
+        }
+        for(int n = 0; n < count; n++) {
+            int at = remap[moved[n]];
+            h ^= zobrist_sticker[at][p->stickers[at]] ^ zobrist_sticker[at][colors[n]];
+            p->stickers[at] = colors[n];
+        }
+    }
+    *hash = h;
+}
+
+// hash of a piece state (the orientation is left out, like cubie_solved does)
+uint64_t cubie_hash(const cubie_state *state) {
+    uint64_t hash = 0;
+
+    init_zobrist_tables();
+    for(int piece = 0; piece < NUM_PIECES; piece++) {
+        hash ^= zobrist_pos[piece][state->pos[piece]] ^ zobrist_ori[piece][state->ori[piece]];
+    }
+    return hash;
+}
+
+#endif // ZOBRIST_C